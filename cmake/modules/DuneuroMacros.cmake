@@ -5,6 +5,14 @@ find_package(HDF5WRAP)
 find_package(Nifti)
 find_package(TBB)
 
+# optional blas implementation used for the batched transfer matrix products
+find_package(BLAS)
+set(HAVE_DUNEURO_BLAS ${BLAS_FOUND})
+if (BLAS_FOUND)
+  dune_register_package_flags(COMPILE_DEFINITIONS "ENABLE_DUNEURO_BLAS=1"
+    LIBRARIES ${BLAS_LIBRARIES})
+endif (BLAS_FOUND)
+
 # set(HAVE_TBB ${TBB_FOUND})
 # if (TBB_FOUND)
 #    link_libraries{PUBLIC TBB::tbb)
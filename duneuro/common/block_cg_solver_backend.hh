@@ -0,0 +1,349 @@
+#ifndef DUNEURO_BLOCK_CG_SOLVER_BACKEND_HH
+#define DUNEURO_BLOCK_CG_SOLVER_BACKEND_HH
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/timer.hh>
+
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/amg.hh>
+#include <dune/istl/preconditioners.hh>
+
+#include <dune/pdelab/backend/interface.hh>
+
+#include <duneuro/common/mixed_precision_amg.hh>
+#include <duneuro/common/sparse_direct_solver.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief result of a solve with several right hand sides
+   *
+   * iterations is the number of block iterations, i.e. the number of sweeps over the system
+   * matrix. The iterations needed by the individual right hand sides are stored in
+   * columnIterations.
+   */
+  struct BlockLinearSolverResult {
+    BlockLinearSolverResult()
+        : converged(false), iterations(0), elapsed(0.0), reduction(0.0), columnIterations()
+    {
+    }
+
+    bool converged;
+    unsigned int iterations;
+    double elapsed;
+    double reduction;
+    std::vector<unsigned int> columnIterations;
+  };
+
+  namespace BlockCGDetail
+  {
+    // compute y_j = A x_j for all active columns j, traversing the matrix only once
+    template <class Matrix, class Vector>
+    void fusedMV(const Matrix& A, const std::vector<Vector>& x, std::vector<Vector>& y,
+                 const std::vector<std::size_t>& active)
+    {
+      for (auto j : active) {
+        y[j] = 0.0;
+      }
+      for (auto row = A.begin(); row != A.end(); ++row) {
+        const auto rowIndex = row.index();
+        for (auto col = row->begin(); col != row->end(); ++col) {
+          for (auto j : active) {
+            col->umv(x[j][col.index()], y[j][rowIndex]);
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief sequential cg solver for several right hand sides, preconditioned by amg
+   *
+   * The right hand sides are iterated in lockstep: in every block iteration, the matrix is
+   * traversed only once to compute the matrix vector products of all active columns and a single
+   * amg hierarchy is used to precondition all of them. Columns that have reached the requested
+   * reduction are removed from the active set, the block iteration stops once every column has
+   * converged. Apart from that, every column performs the same recurrences as Dune::CGSolver.
+   *
+   * Only the matrix vector product is batched. The preconditioner is applied by one amg cycle per
+   * active column: the hierarchy is built once and shared by all columns, but the ssor smoothers
+   * and the coarse solver of dune-istl operate on a single vector, and a fused cycle would need a
+   * multi vector hierarchy of its own. Since the smoothers are sweeps over the level matrices, the
+   * cycles still traverse the hierarchy once per column.
+   *
+   * If a direct solver is given and accepts the matrix, all right hand sides are solved by a
+   * single sweep over its factorization instead.
+   */
+  template <class GO>
+  class ISTLBackend_SEQ_BlockCG_AMG_SSOR
+  {
+    using GFS = typename GO::Traits::TrialGridFunctionSpace;
+    using M = typename GO::Traits::Jacobian;
+    using V = typename GO::Traits::Domain;
+    using W = typename GO::Traits::Range;
+    using Matrix = Dune::PDELab::Backend::Native<M>;
+    using Vector = Dune::PDELab::Backend::Native<V>;
+    using Real = typename Dune::FieldTraits<typename V::ElementType>::real_type;
+    using Smoother = Dune::SeqSSOR<Matrix, Vector, Vector, 1>;
+    using Operator = Dune::MatrixAdapter<Matrix, Vector, Vector>;
+    using SmootherArgs = typename Dune::Amg::SmootherTraits<Smoother>::Arguments;
+    using AMG = Dune::Amg::AMG<Operator, Vector, Smoother>;
+    using Parameters = Dune::Amg::Parameters;
+    using Criterion =
+        Dune::Amg::CoarsenCriterion<Dune::Amg::SymmetricCriterion<Matrix, Dune::Amg::FirstDiagonal>>;
+
+  public:
+    using DirectSolver = SparseDirectSolver<Matrix, Vector>;
+    using MixedAMG = MixedPrecisionAMG<Matrix, Vector>;
+
+    explicit ISTLBackend_SEQ_BlockCG_AMG_SSOR(unsigned int maxiter = 5000, int verbose = 0,
+                                              bool reuse = true,
+                                              std::shared_ptr<DirectSolver> directSolver = nullptr)
+        : maxiter_(maxiter)
+        , verbose_(verbose)
+        , reuse_(reuse)
+        , firstapply_(true)
+        , params_(15, 2000)
+        , directSolver_(directSolver)
+    {
+      params_.setDefaultValuesIsotropic(GFS::Traits::GridViewType::Traits::Grid::dimension);
+      params_.setDebugLevel(verbose_);
+    }
+
+    ISTLBackend_SEQ_BlockCG_AMG_SSOR(const ISTLBackend_SEQ_BlockCG_AMG_SSOR& other)
+        : maxiter_(other.maxiter_)
+        , verbose_(other.verbose_)
+        , reuse_(other.reuse_)
+        , firstapply_(true)
+        , params_(other.params_)
+        , directSolver_(other.directSolver_)
+        , mixedPrecision_(other.mixedPrecision_)
+    {
+      // note: the amg hierarchy is bound to the operator of the copied backend and is rebuilt
+      // on the first call to apply
+    }
+
+    //! Set whether the AMG should be reused again during call to apply().
+    void setReuse(bool reuse)
+    {
+      reuse_ = reuse;
+    }
+
+    //! Return whether the AMG is reused during call to apply()
+    bool getReuse() const
+    {
+      return reuse_;
+    }
+
+    //! use a single precision amg preconditioner, see MixedPrecisionAMG
+    void setMixedPrecision(bool enable)
+    {
+      mixedPrecision_ = enable;
+    }
+
+    /*! \brief solve the given linear system for all right hand sides simultaneously
+
+      \param[in] A the given matrix
+      \param[out] z the solution vectors to be computed
+      \param[in] r right hand sides
+      \param[in] reduction to be achieved for every column
+    */
+    void apply(M& A, std::vector<V>& z, std::vector<W>& r, Real reduction)
+    {
+      using Dune::PDELab::Backend::native;
+      if (z.size() != r.size()) {
+        DUNE_THROW(Dune::Exception, "number of solutions (" << z.size()
+                                                            << ") does not match number of right "
+                                                               "hand sides ("
+                                                            << r.size() << ")");
+      }
+      Dune::Timer watch;
+      if (directSolver_ && directSolver_->factorize(native(A))) {
+        solveDirect(A, z, r, watch);
+        return;
+      }
+      if (!reuse_ || firstapply_) {
+        if (mixedPrecision_) {
+          amg_ = std::make_shared<MixedAMG>(native(A), params_);
+        } else {
+          operator_ = std::make_shared<Operator>(native(A));
+          SmootherArgs smootherArgs;
+          smootherArgs.iterations = 1;
+          smootherArgs.relaxationFactor = 1;
+          Criterion criterion(params_);
+          amg_ = std::make_shared<AMG>(*operator_, criterion, smootherArgs);
+        }
+        firstapply_ = false;
+        if (verbose_ > 0)
+          std::cout << "=== block AMG setup " << watch.elapsed() << " s" << std::endl;
+      }
+
+      const std::size_t k = z.size();
+      res_ = BlockLinearSolverResult();
+      res_.columnIterations.assign(k, 0);
+      if (k == 0) {
+        res_.converged = true;
+        return;
+      }
+
+      // work vectors
+      std::vector<Vector> x, b, p, q, w;
+      x.reserve(k);
+      for (std::size_t j = 0; j < k; ++j) {
+        x.emplace_back(native(z[j]));
+      }
+      b.reserve(k);
+      for (std::size_t j = 0; j < k; ++j) {
+        b.emplace_back(native(r[j]));
+      }
+      p = x;
+      q = x;
+      w = x;
+
+      std::vector<std::size_t> active(k);
+      std::iota(active.begin(), active.end(), 0);
+
+      // initial defects b_j -= A x_j
+      BlockCGDetail::fusedMV(native(A), x, q, active);
+      std::vector<Real> def0(k), def(k), rho(k);
+      for (std::size_t j = 0; j < k; ++j) {
+        b[j] -= q[j];
+        def0[j] = def[j] = b[j].two_norm();
+      }
+      active.erase(std::remove_if(active.begin(), active.end(),
+                                  [&](std::size_t j) { return def0[j] < 1e-30; }),
+                   active.end());
+
+      amg_->pre(x[0], b[0]);
+      for (auto j : active) {
+        p[j] = 0.0;
+        amg_->apply(p[j], b[j]);
+        rho[j] = p[j].dot(b[j]);
+      }
+
+      unsigned int it = 0;
+      for (; it < maxiter_ && !active.empty(); ++it) {
+        BlockCGDetail::fusedMV(native(A), p, q, active);
+        std::vector<std::size_t> stillActive;
+        for (auto j : active) {
+          Real alpha = rho[j] / p[j].dot(q[j]);
+          x[j].axpy(alpha, p[j]);
+          b[j].axpy(-alpha, q[j]);
+          def[j] = b[j].two_norm();
+          res_.columnIterations[j] = it + 1;
+          if (def[j] < def0[j] * reduction || def[j] < 1e-30) {
+            continue;
+          }
+          w[j] = 0.0;
+          amg_->apply(w[j], b[j]);
+          Real rhoNew = w[j].dot(b[j]);
+          Real beta = rhoNew / rho[j];
+          rho[j] = rhoNew;
+          p[j] *= beta;
+          p[j] += w[j];
+          stillActive.push_back(j);
+        }
+        active = std::move(stillActive);
+        if (verbose_ > 1)
+          std::cout << "=== block cg iteration " << it + 1 << " active columns: " << active.size()
+                    << std::endl;
+      }
+      amg_->post(x[0]);
+
+      for (std::size_t j = 0; j < k; ++j) {
+        native(z[j]) = x[j];
+        Real red = def0[j] > 0 ? def[j] / def0[j] : 0.0;
+        res_.reduction = std::max(res_.reduction, static_cast<double>(red));
+      }
+      res_.iterations = it;
+      res_.converged = active.empty();
+      res_.elapsed = watch.elapsed();
+      if (verbose_ > 0)
+        std::cout << "=== block cg: " << k << " right hand sides, " << res_.iterations
+                  << " block iterations, " << res_.elapsed << " s" << std::endl;
+    }
+
+    const BlockLinearSolverResult& result() const
+    {
+      return res_;
+    }
+
+    //! store information about the direct solver, if one is used
+    void report(DataTree dataTree) const
+    {
+      if (directSolver_) {
+        directSolver_->report(dataTree.sub("direct"));
+      }
+    }
+
+  private:
+    unsigned int maxiter_;
+    int verbose_;
+    bool reuse_;
+    bool firstapply_;
+    Parameters params_;
+    std::shared_ptr<Operator> operator_;
+    std::shared_ptr<Dune::Preconditioner<Vector, Vector>> amg_;
+    BlockLinearSolverResult res_;
+    std::shared_ptr<DirectSolver> directSolver_;
+    bool mixedPrecision_ = false;
+
+    void solveDirect(const M& A, std::vector<V>& z, const std::vector<W>& r,
+                     const Dune::Timer& watch)
+    {
+      using Dune::PDELab::Backend::native;
+      const std::size_t k = z.size();
+      std::vector<Vector> x, b;
+      x.reserve(k);
+      b.reserve(k);
+      for (std::size_t j = 0; j < k; ++j) {
+        x.emplace_back(native(z[j]));
+        b.emplace_back(native(r[j]));
+      }
+      directSolver_->solve(x, b);
+      res_ = BlockLinearSolverResult();
+      res_.columnIterations.assign(k, 1);
+      for (std::size_t j = 0; j < k; ++j) {
+        native(z[j]) = x[j];
+        // relative residual of the direct solution
+        const Real norm = b[j].two_norm();
+        native(A).mmv(x[j], b[j]);
+        const Real red = norm > 0 ? b[j].two_norm() / norm : 0.0;
+        res_.reduction = std::max(res_.reduction, static_cast<double>(red));
+      }
+      res_.iterations = 1;
+      res_.converged = true;
+      res_.elapsed = watch.elapsed();
+      if (verbose_ > 0)
+        std::cout << "=== direct solve: " << k << " right hand sides, " << res_.elapsed << " s"
+                  << std::endl;
+    }
+  };
+
+  /**
+   * \brief checks whether a solver backend wrapper provides a solver for several right hand sides
+   *
+   * Such a wrapper has to provide a method getBlock() returning a backend with an interface
+   * analogous to ISTLBackend_SEQ_BlockCG_AMG_SSOR.
+   */
+  template <class SolverBackend, class = void>
+  struct HasBlockSolverBackend : public std::false_type {
+  };
+
+  template <class SolverBackend>
+  struct HasBlockSolverBackend<SolverBackend,
+                               std::void_t<decltype(std::declval<SolverBackend&>().getBlock())>>
+      : public std::true_type {
+  };
+}
+
+#endif // DUNEURO_BLOCK_CG_SOLVER_BACKEND_HH
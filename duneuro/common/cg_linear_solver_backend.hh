@@ -0,0 +1,122 @@
+#ifndef DUNEURO_CG_LINEAR_SOLVER_BACKEND_HH
+#define DUNEURO_CG_LINEAR_SOLVER_BACKEND_HH
+
+#include <iostream>
+#include <memory>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/timer.hh>
+
+#include <dune/istl/solvers.hh>
+
+#include <dune/pdelab/backend/interface.hh>
+#include <dune/pdelab/backend/solver.hh>
+
+#include <duneuro/common/deflated_cg.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief interface of the linear solver backends used for cg discretizations
+   *
+   * A backend either solves the assembled system or, if matrixFree() returns true, a system
+   * given by an operator of its own, see residual and the apply method without a matrix. The
+   * backends are copied by clone, e.g. for the thread local backends of a
+   * tbb::enumerable_thread_specific. What the copies share is documented by each backend.
+   *
+   * If a deflation space is given, the iterative backends solve the systems by the deflated cg
+   * method, which grows the deflation space using the information of the previous solves. The
+   * deflation space is shared by all copies of the backend.
+   */
+  template <class GO>
+  class CGLinearSolverBackend : public Dune::PDELab::LinearResultStorage
+  {
+  protected:
+    using M = typename GO::Traits::Jacobian;
+    using V = typename GO::Traits::Domain;
+    using W = typename GO::Traits::Range;
+    using Matrix = Dune::PDELab::Backend::Native<M>;
+    using Vector = Dune::PDELab::Backend::Native<V>;
+    using Real = typename Dune::FieldTraits<typename V::ElementType>::real_type;
+
+  public:
+    using Deflation = DeflationSpace<Vector>;
+
+    CGLinearSolverBackend(unsigned int maxiter, int verbose, std::shared_ptr<Deflation> deflation)
+        : maxiter_(maxiter), verbose_(verbose), deflation_(deflation)
+    {
+    }
+
+    virtual ~CGLinearSolverBackend()
+    {
+    }
+
+    virtual std::unique_ptr<CGLinearSolverBackend> clone() const = 0;
+
+    /*! \brief solve the given linear system
+
+      \param[in] A the given matrix
+      \param[out] z the solution vector to be computed
+      \param[in] r right hand side
+      \param[in] reduction to be achieved
+    */
+    virtual void apply(M& A, V& z, W& r, Real reduction) = 0;
+
+    //! Return whether the backend solves without an assembled matrix
+    virtual bool matrixFree() const
+    {
+      return false;
+    }
+
+    //! r -= A x, using the operator of a matrix free backend
+    virtual void residual(const V& x, W& r)
+    {
+      DUNE_THROW(Dune::NotImplemented, "the solver backend requires an assembled matrix");
+    }
+
+    //! solve A z = r using the operator of a matrix free backend
+    virtual void apply(V& z, W& r, Real reduction)
+    {
+      DUNE_THROW(Dune::NotImplemented, "the solver backend requires an assembled matrix");
+    }
+
+    //! store additional information about the solves
+    virtual void report(DataTree dataTree) const
+    {
+    }
+
+  protected:
+    unsigned int maxiter_;
+    int verbose_;
+    std::shared_ptr<Deflation> deflation_;
+
+    // solve op z = r by cg, or by deflated cg if a deflation space is given
+    template <class Op, class Prec>
+    void solve(Op& op, Prec& prec, V& z, W& r, Real reduction, double setupTime)
+    {
+      using Dune::PDELab::Backend::native;
+      Dune::Timer watch;
+      Dune::InverseOperatorResult stat;
+      if (deflation_) {
+        DeflatedCGSolver<Op, Prec, Vector> solver(op, prec, *deflation_, reduction, maxiter_,
+                                                  verbose_);
+        solver.apply(native(z), native(r), stat);
+      } else {
+        Dune::CGSolver<Vector> solver(op, prec, reduction, maxiter_, verbose_);
+        solver.apply(native(z), native(r), stat);
+      }
+      double solveTime = watch.elapsed();
+      if (verbose_ > 0)
+        std::cout << "=== solving (reduction: " << reduction << ") " << solveTime << " s"
+                  << std::endl;
+      res.converged = stat.converged;
+      res.iterations = stat.iterations;
+      res.elapsed = setupTime + solveTime;
+      res.reduction = stat.reduction;
+      res.conv_rate = stat.conv_rate;
+    }
+  };
+}
+
+#endif // DUNEURO_CG_LINEAR_SOLVER_BACKEND_HH
@@ -10,7 +10,9 @@
 #include <duneuro/common/kdtree.hh>
 #include <duneuro/common/linear_problem_solver.hh>
 #include <duneuro/common/make_dof_vector.hh>
+#include <duneuro/common/p1_tetrahedron_stiffness_assembler.hh>
 #include <duneuro/common/random.hh>
+#include <duneuro/common/vector_initialization.hh>
 #include <duneuro/io/data_tree.hh>
 
 namespace duneuro
@@ -82,19 +84,68 @@ namespace duneuro
     {
       dataTree.set("degree", degree);
       dataTree.set("element_type", to_string(elementType));
+      if (config.get<bool>("closed_form_assembly", false)) {
+        if constexpr (elementType == ElementType::tetrahedron && degree == 1 && VC::dim == 3) {
+          linearSolver_.setJacobianAssembler([this](DataTree assemblerTree) {
+            using Assembler = P1TetrahedronStiffnessAssembler<typename Traits::Assembler::GO, VC>;
+            return Assembler(assembler_.getGO(), volumeConductor_).assemble(assemblerTree);
+          });
+        } else {
+          DUNE_THROW(Dune::NotImplemented,
+                     "closed form assembly is only available for linear elements on tetrahedra");
+        }
+      }
     }
 
+    /**
+     * \brief solve the system for the given right hand side
+     *
+     * The initial guess is chosen according to the sub tree "initialization" of the config, see
+     * duneuro::initialize. By default, a random initial guess is used. With type "constant" a
+     * deterministic initial guess is used, with type "given" the entries of solution are used as
+     * the initial guess.
+     */
     template <typename SolverBackend>
     void solve(SolverBackend& solverBackend, const typename Traits::RangeDOFVector& rightHandSide,
                typename Traits::DomainDOFVector& solution, const Dune::ParameterTree& config,
                DataTree dataTree = DataTree())
     {
       Dune::Timer timer;
-      randomize_uniform(Dune::PDELab::Backend::native(solution), DF(-1.0), DF(1.0));
+      initialize(Dune::PDELab::Backend::native(solution), config.hasSub("initialization") ?
+                                                              config.sub("initialization") :
+                                                              Dune::ParameterTree());
       linearSolver_.apply(solverBackend, solution, rightHandSide, config, dataTree);
       dataTree.set("time", timer.elapsed());
     }
 
+    /**
+     * \brief solve the system for several right hand sides at once
+     *
+     * The given solver backend has to be a block solver backend, e.g. the one returned by
+     * CGSolverBackend::getBlock().
+     */
+    template <typename BlockSolverBackend>
+    void solveBlock(BlockSolverBackend& solverBackend,
+                    const std::vector<typename Traits::RangeDOFVector>& rightHandSides,
+                    std::vector<typename Traits::DomainDOFVector>& solutions,
+                    const Dune::ParameterTree& config, DataTree dataTree = DataTree())
+    {
+      Dune::Timer timer;
+      for (auto& solution : solutions) {
+        initialize(Dune::PDELab::Backend::native(solution), config.hasSub("initialization") ?
+                                                                config.sub("initialization") :
+                                                                Dune::ParameterTree());
+      }
+      linearSolver_.applyBlock(solverBackend, solutions, rightHandSides, config, dataTree);
+      dataTree.set("time", timer.elapsed());
+    }
+
+    //! read the matrix from the given file or store it there, see LinearProblemSolver
+    void setJacobianCache(const std::string& filename)
+    {
+      linearSolver_.setJacobianCache(filename);
+    }
+
     const typename Traits::FunctionSpace& functionSpace() const
     {
       return functionSpace_;
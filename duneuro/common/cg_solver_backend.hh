@@ -1,18 +1,58 @@
 #ifndef DUNEURO_CG_SOLVER_BACKEND_HH
 #define DUNEURO_CG_SOLVER_BACKEND_HH
 
+#include <memory>
+
 #include <dune/pdelab/backend/istl.hh>
 
+#include <duneuro/common/block_cg_solver_backend.hh>
+#include <duneuro/common/cg_linear_solver_backend.hh>
 #include <duneuro/common/flags.hh>
+#include <duneuro/common/shared_amg_backend.hh>
+#include <duneuro/common/voxel_matrix_free_backend.hh>
 
 namespace duneuro
 {
   template <class Solver, ElementType elementType>
   struct CGSolverBackendTraits {
-    using SolverBackend =
-        Dune::PDELab::ISTLBackend_SEQ_CG_AMG_SSOR<typename Solver::Traits::Assembler::GO>;
+    using GO = typename Solver::Traits::Assembler::GO;
+    using SolverBackend = CGLinearSolverBackend<GO>;
+    using AMGSolverBackend = ISTLBackend_SEQ_CG_SharedAMG_SSOR<GO>;
+    using MixedPrecisionSolverBackend = ISTLBackend_SEQ_CG_MixedPrecisionAMG<GO>;
+    using DirectSolverBackend = ISTLBackend_SEQ_CG_Direct<GO>;
+    using MatrixFreeSolverBackend = ISTLBackend_SEQ_CG_VoxelMatrixFree<GO>;
+    using BlockSolverBackend = ISTLBackend_SEQ_BlockCG_AMG_SSOR<GO>;
   };
 
+  /**
+   * \brief solver backend for cg discretizations
+   *
+   * If share_amg_hierarchy is set in the config, all copies of this backend share one amg
+   * hierarchy. Use a copy of a single exemplar (and not independently constructed backends) for
+   * the thread local backends to profit from this.
+   *
+   * If deflation.enable is set, the systems are solved by the deflated cg method. The deflation
+   * space is shared by all copies of this backend and grows with every solve until it contains
+   * deflation.size vectors. In each solve, the first deflation.lanczos_vectors preconditioned
+   * residuals are used to compute deflation.vectors_per_solve new deflation vectors.
+   *
+   * If matrix_free.enable is set, the system matrix is not assembled. Instead, the solver applies
+   * the stencil of the voxel mesh, preconditioned by a two grid method with amg on the coarse
+   * level (matrix_free.preconditioner = two_grid, the default) or by the diagonal
+   * (matrix_free.preconditioner = jacobi). This requires a hexahedral voxel mesh without geometry
+   * adaption and linear elements. The block solver backend always uses the assembled matrix.
+   *
+   * If direct.enable is set, the assembled matrix is factorized once and all systems are solved
+   * using this factorization, see SparseDirectSolver for the options in the sub tree direct. The
+   * factorization is shared by all copies of this backend and by the block solver backend, which
+   * then solves all right hand sides of a block by one sweep over the factor. If the estimated
+   * memory of the factorization exceeds direct.max_memory, the iterative solvers are used.
+   *
+   * If mixed_precision.enable is set, the amg preconditioners are built and applied in single
+   * precision, while cg and its residuals stay in double precision. With
+   * mixed_precision.validate, every system is also solved with the double precision amg and the
+   * iteration counts of both are reported.
+   */
   template <class Solver, ElementType elementType>
   class CGSolverBackend
   {
@@ -20,23 +60,108 @@ namespace duneuro
     using Traits = CGSolverBackendTraits<Solver, elementType>;
 
     explicit CGSolverBackend(std::shared_ptr<Solver> solver, const Dune::ParameterTree& config)
-        : solverBackend_(config.get<unsigned int>("max_iterations", 5000),
-                         config.get<unsigned int>("verbose", 0), true, true)
+        : directSolver_(makeDirectSolver(config))
+        , solverBackend_(makeSolverBackend(*solver, config, directSolver_))
+        , blockSolverBackend_(config.get<unsigned int>("max_iterations", 5000),
+                              config.get<unsigned int>("verbose", 0), true, directSolver_)
+    {
+      blockSolverBackend_.setMixedPrecision(config.get<bool>("mixed_precision.enable", false));
+    }
+
+    CGSolverBackend(const CGSolverBackend& other)
+        : directSolver_(other.directSolver_)
+        , solverBackend_(other.solverBackend_->clone())
+        , blockSolverBackend_(other.blockSolverBackend_)
     {
     }
 
     const typename Traits::SolverBackend& get() const
     {
-      return solverBackend_;
+      return *solverBackend_;
     }
 
     typename Traits::SolverBackend& get()
     {
-      return solverBackend_;
+      return *solverBackend_;
+    }
+
+    const typename Traits::BlockSolverBackend& getBlock() const
+    {
+      return blockSolverBackend_;
+    }
+
+    typename Traits::BlockSolverBackend& getBlock()
+    {
+      return blockSolverBackend_;
     }
 
   private:
-    typename Traits::SolverBackend solverBackend_;
+    std::shared_ptr<typename Traits::DirectSolverBackend::DirectSolver> directSolver_;
+    std::unique_ptr<typename Traits::SolverBackend> solverBackend_;
+    typename Traits::BlockSolverBackend blockSolverBackend_;
+
+    static std::unique_ptr<typename Traits::SolverBackend> makeSolverBackend(
+        const Solver& solver, const Dune::ParameterTree& config,
+        std::shared_ptr<typename Traits::DirectSolverBackend::DirectSolver> directSolver)
+    {
+      const auto maxIterations = config.get<unsigned int>("max_iterations", 5000);
+      const auto verbose = config.get<unsigned int>("verbose", 0);
+      const bool shareHierarchy = config.get<bool>("share_amg_hierarchy", false);
+      if (config.get<bool>("matrix_free.enable", false)) {
+        return std::make_unique<typename Traits::MatrixFreeSolverBackend>(
+            makeMatrixFreeSetup(solver, config), maxIterations, verbose, makeDeflation(config));
+      }
+      std::unique_ptr<typename Traits::SolverBackend> iterative;
+      if (config.get<bool>("mixed_precision.enable", false)) {
+        iterative = std::make_unique<typename Traits::MixedPrecisionSolverBackend>(
+            maxIterations, verbose, shareHierarchy, makeDeflation(config),
+            config.get<bool>("mixed_precision.validate", false));
+      } else {
+        iterative = std::make_unique<typename Traits::AMGSolverBackend>(
+            maxIterations, verbose, shareHierarchy, makeDeflation(config));
+      }
+      if (directSolver) {
+        return std::make_unique<typename Traits::DirectSolverBackend>(
+            directSolver, std::move(iterative), verbose);
+      }
+      return iterative;
+    }
+
+    static std::shared_ptr<typename Traits::SolverBackend::Deflation>
+    makeDeflation(const Dune::ParameterTree& config)
+    {
+      if (!config.get<bool>("deflation.enable", false)) {
+        return nullptr;
+      }
+      return std::make_shared<typename Traits::SolverBackend::Deflation>(
+          config.get<std::size_t>("deflation.size", 16),
+          config.get<std::size_t>("deflation.lanczos_vectors", 20),
+          config.get<std::size_t>("deflation.vectors_per_solve", 4));
+    }
+
+    static std::shared_ptr<typename Traits::DirectSolverBackend::DirectSolver>
+    makeDirectSolver(const Dune::ParameterTree& config)
+    {
+      if (!config.get<bool>("direct.enable", false)) {
+        return nullptr;
+      }
+      if (config.get<bool>("matrix_free.enable", false)) {
+        DUNE_THROW(Dune::Exception, "the direct solver requires an assembled matrix");
+      }
+      return std::make_shared<typename Traits::DirectSolverBackend::DirectSolver>(
+          config.sub("direct"));
+    }
+
+    static std::shared_ptr<const typename Traits::MatrixFreeSolverBackend::MatrixFreeSetup>
+    makeMatrixFreeSetup(const Solver& solver, const Dune::ParameterTree& config)
+    {
+      if constexpr (elementType == ElementType::hexahedron) {
+        return std::make_shared<typename Traits::MatrixFreeSolverBackend::MatrixFreeSetup>(
+            solver.functionSpace().getGFS(), *solver.volumeConductor(), config);
+      } else {
+        DUNE_THROW(Dune::NotImplemented, "matrix free solver is only available for voxel meshes");
+      }
+    }
   };
 }
 
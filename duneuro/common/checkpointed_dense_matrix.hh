@@ -0,0 +1,258 @@
+#ifndef DUNEURO_CHECKPOINTED_DENSE_MATRIX_HH
+#define DUNEURO_CHECKPOINTED_DENSE_MATRIX_HH
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/parametertree.hh>
+
+#include <duneuro/common/dense_matrix.hh>
+#include <duneuro/common/mapped_dense_matrix.hh>
+#include <duneuro/common/matrix_utilities.hh>
+#include <duneuro/common/reduced_precision_dense_matrix.hh>
+
+namespace duneuro
+{
+  namespace CheckpointedDenseMatrixDetail
+  {
+    // header of a progress file. It is followed by one byte per row of the matrix, which is
+    // nonzero if the row has been finished.
+    struct Header {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t padding;
+      std::uint64_t rows;
+      std::uint64_t cols;
+      char key[64];
+    };
+
+    static const char magic[8] = {'D', 'U', 'N', 'E', 'U', 'R', 'O', 'P'};
+    static const std::uint32_t version = 1;
+
+    // write the pages containing [begin, begin + length) of a shared file mapping to the file
+    inline void syncRange(const void* begin, std::size_t length)
+    {
+      const std::uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+      const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(begin) / pageSize * pageSize;
+      const std::uintptr_t last = reinterpret_cast<std::uintptr_t>(begin) + length;
+      if (msync(reinterpret_cast<void*>(first), last - first, MS_SYNC) != 0) {
+        DUNE_THROW(Dune::IOError, "msync failed: " << MappedDenseMatrixDetail::errorString());
+      }
+    }
+
+    inline void setKey(Header& header, const std::string& key)
+    {
+      std::memset(header.key, 0, sizeof(header.key));
+      std::memcpy(header.key, key.data(), std::min(key.size(), sizeof(header.key) - 1));
+    }
+  }
+
+  /**
+   * \brief dense matrix which is computed row by row and can be resumed after an interruption
+   *
+   * Without checkpointing, this is a plain dense matrix created by make_dense_matrix from the
+   * storage config. If the key "checkpoint" of the storage config is true, the matrix is stored
+   * in the file "filename" (see make_mapped_dense_matrix) and the finished rows are recorded in
+   * the file "<filename>.progress". A row is only recorded after its entries have been written
+   * to the file, so that all recorded rows are valid after a crash or preemption. If both files
+   * exist and match the size of the matrix and the key "checkpoint_key", the computation is
+   * resumed and the recorded rows are skipped. The key should identify all data the matrix
+   * depends on. Rows can be set concurrently from several threads.
+   *
+   * If a column selection is given, only the entries columns[i] of each row are stored, as
+   * column i of the matrix.
+   *
+   * If the key "precision" of the storage config is float32 or int16, the rows are converted
+   * when they are set and stored in a ReducedPrecisionDenseMatrix, which has to be obtained by
+   * releaseReducedPrecision. Reduced precision matrices cannot be checkpointed.
+   */
+  template <class T>
+  class CheckpointedDenseMatrix
+  {
+  public:
+    CheckpointedDenseMatrix(std::size_t rows, std::size_t cols, const Dune::ParameterTree& config,
+                            std::shared_ptr<const std::vector<std::size_t>> columns = nullptr)
+        : columns_(columns)
+    {
+      if (columns_) {
+        cols = columns_->size();
+      }
+      const auto precision = config.get<std::string>("precision", "float64");
+      if (precision != "float64") {
+        if (config.get<bool>("checkpoint", false)) {
+          DUNE_THROW(Dune::NotImplemented,
+                     "checkpointing is not supported for reduced precision matrices");
+        }
+        reduced_ = std::make_unique<ReducedPrecisionDenseMatrix>(
+            rows, cols, dense_matrix_precision_from_string(precision), config);
+        return;
+      }
+      if (!config.get<bool>("checkpoint", false)) {
+        matrix_ = make_dense_matrix<T>(rows, cols, config);
+        return;
+      }
+      if (config.get<std::string>("type", "memory") != "file") {
+        DUNE_THROW(Dune::Exception, "checkpointing requires a file backed matrix storage");
+      }
+      filename_ = config.get<std::string>("filename");
+      openProgress(rows, cols, config.get<std::string>("checkpoint_key", ""));
+    }
+
+    CheckpointedDenseMatrix(const CheckpointedDenseMatrix&) = delete;
+    void operator=(const CheckpointedDenseMatrix&) = delete;
+
+    ~CheckpointedDenseMatrix()
+    {
+      if (progress_) {
+        munmap(progress_, progressLength_);
+      }
+    }
+
+    //! whether the row has been finished in a previous run
+    bool finished(std::size_t row) const
+    {
+      return progress_ && progress_[sizeof(CheckpointedDenseMatrixDetail::Header) + row] != 0;
+    }
+
+    //! number of rows which had been finished when the matrix was opened
+    std::size_t resumedRows() const
+    {
+      return resumedRows_;
+    }
+
+    //! set a row and record it as finished
+    template <int blockSize>
+    void setRow(std::size_t row, const Dune::BlockVector<Dune::FieldVector<T, blockSize>>& vector)
+    {
+      if (reduced_) {
+        reduced_->setRow(row, vector, columns_.get());
+        return;
+      }
+      if (columns_) {
+        T* matrixRow = matrix_->data() + row * matrix_->cols();
+        for (std::size_t i = 0; i < columns_->size(); ++i) {
+          const auto c = (*columns_)[i];
+          matrixRow[i] = vector[c / blockSize][c % blockSize];
+        }
+      } else {
+        set_matrix_row(*matrix_, row, vector);
+      }
+      if (progress_) {
+        using namespace CheckpointedDenseMatrixDetail;
+        syncRange(matrix_->data() + row * matrix_->cols(), matrix_->cols() * sizeof(T));
+        progress_[sizeof(Header) + row] = 1;
+        syncRange(progress_ + sizeof(Header) + row, 1);
+      }
+    }
+
+
+    /**
+     * \brief release the complete matrix
+     *
+     * A checkpointed matrix is reopened copy-on-write, so that later modifications of the
+     * returned matrix do not alter the checkpoint.
+     */
+    std::unique_ptr<DenseMatrix<T>> release()
+    {
+      if (reduced_) {
+        DUNE_THROW(Dune::Exception, "the matrix is stored in reduced precision");
+      }
+      if (!progress_) {
+        return std::move(matrix_);
+      }
+      matrix_.reset();
+      return open_mapped_dense_matrix<T>(filename_, false);
+    }
+
+    //! release the complete matrix, if it is stored in reduced precision
+    std::unique_ptr<ReducedPrecisionDenseMatrix> releaseReducedPrecision()
+    {
+      if (!reduced_) {
+        DUNE_THROW(Dune::Exception, "the matrix is not stored in reduced precision");
+      }
+      return std::move(reduced_);
+    }
+
+  private:
+    std::shared_ptr<const std::vector<std::size_t>> columns_;
+    std::unique_ptr<DenseMatrix<T>> matrix_;
+    std::unique_ptr<ReducedPrecisionDenseMatrix> reduced_;
+    std::string filename_;
+    char* progress_ = nullptr;
+    std::size_t progressLength_ = 0;
+    std::size_t resumedRows_ = 0;
+
+    void openProgress(std::size_t rows, std::size_t cols, const std::string& key)
+    {
+      using namespace CheckpointedDenseMatrixDetail;
+      const std::string progressFilename = filename_ + ".progress";
+      progressLength_ = sizeof(Header) + rows;
+      Header expected;
+      std::memset(&expected, 0, sizeof(Header));
+      std::memcpy(expected.magic, magic, sizeof(magic));
+      expected.version = version;
+      expected.rows = rows;
+      expected.cols = cols;
+      setKey(expected, key);
+
+      // resume, if both files exist and belong to this computation
+      int fd = open(progressFilename.c_str(), O_RDWR);
+      if (fd >= 0) {
+        Header header;
+        struct stat status;
+        bool matches = pread(fd, &header, sizeof(Header), 0) == static_cast<ssize_t>(sizeof(Header))
+                       && fstat(fd, &status) == 0
+                       && static_cast<std::size_t>(status.st_size) == progressLength_
+                       && std::memcmp(&header, &expected, sizeof(Header)) == 0;
+        if (matches) {
+          try {
+            matrix_ = open_mapped_dense_matrix<T>(filename_, true);
+            matches = matrix_->rows() == rows && matrix_->cols() == cols && matrix_->rowMajor();
+          } catch (Dune::IOError&) {
+            matches = false;
+          }
+        }
+        if (!matches) {
+          matrix_.reset();
+          close(fd);
+          fd = -1;
+        }
+      }
+      if (fd < 0) {
+        // start from scratch. A stale progress file is removed before the matrix is created, so
+        // that a valid progress file always refers to an initialized matrix
+        unlink(progressFilename.c_str());
+        matrix_ = make_mapped_dense_matrix<T>(filename_, rows, cols);
+        fd = open(progressFilename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate(fd, progressLength_) != 0
+            || pwrite(fd, &expected, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header))) {
+          if (fd >= 0)
+            close(fd);
+          DUNE_THROW(Dune::IOError, "could not initialize " << progressFilename << ": "
+                                                            << MappedDenseMatrixDetail::errorString());
+        }
+      }
+      void* address = mmap(nullptr, progressLength_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if (address == MAP_FAILED) {
+        DUNE_THROW(Dune::IOError, "could not map " << progressFilename << ": "
+                                                   << MappedDenseMatrixDetail::errorString());
+      }
+      progress_ = static_cast<char*>(address);
+      resumedRows_ = std::count_if(progress_ + sizeof(Header), progress_ + progressLength_,
+                                   [](char c) { return c != 0; });
+    }
+  };
+}
+
+#endif // DUNEURO_CHECKPOINTED_DENSE_MATRIX_HH
@@ -4,6 +4,7 @@
 #include <cassert> // provides assert
 
 #include <algorithm> // provides std::max, std::min
+#include <atomic> // provides std::atomic
 #include <string>
 #include <vector> // provides std::vector
 
@@ -401,8 +402,7 @@ namespace duneuro
       // face diameter
       RF h_F;
       edgenormprovider.edgeNorm(ig, h_F);
-      minH = std::min(h_F, minH);
-      maxH = std::max(h_F, maxH);
+      updateH(h_F);
       assert(h_F > 1e-20);
 
       auto weights = weighting(ig, A_s, A_n);
@@ -545,8 +545,7 @@ namespace duneuro
       // face diameter
       RF h_F;
       edgenormprovider.edgeNorm(ig, h_F);
-      minH = std::min(h_F, minH);
-      maxH = std::max(h_F, maxH);
+      updateH(h_F);
       assert(h_F > 1e-20);
 
       // compute weights
@@ -719,8 +718,7 @@ namespace duneuro
       // face diameter
       RF h_F;
       edgenormprovider.edgeNorm(ig, h_F, true);
-      minH = std::min(h_F, minH);
-      maxH = std::max(h_F, maxH);
+      updateH(h_F);
       assert(h_F > 1e-20);
 
       // compute weights
@@ -854,8 +852,7 @@ namespace duneuro
       // face diameter
       RF h_F;
       edgenormprovider.edgeNorm(ig, h_F, true);
-      minH = std::min(h_F, minH);
-      maxH = std::max(h_F, maxH);
+      updateH(h_F);
       assert(h_F > 1e-20);
 
       // compute weights
@@ -974,12 +971,12 @@ namespace duneuro
 
     Real getMinH() const
     {
-      return minH;
+      return minH.load();
     }
 
     Real getMaxH() const
     {
-      return maxH;
+      return maxH.load();
     }
 
     ConvectionDiffusion_DG_LocalOperator(const ConvectionDiffusion_DG_LocalOperator& other) =
@@ -1003,8 +1000,20 @@ namespace duneuro
     const int intorderadd;
     const int quadrature_factor;
 
-    mutable Real minH;
-    mutable Real maxH;
+    // the face diameter statistics are updated atomically, as the operator might be evaluated
+    // by several threads at once
+    mutable std::atomic<Real> minH;
+    mutable std::atomic<Real> maxH;
+
+    void updateH(Real h) const
+    {
+      Real current = minH.load();
+      while (h < current && !minH.compare_exchange_weak(current, h)) {
+      }
+      current = maxH.load();
+      while (h > current && !maxH.compare_exchange_weak(current, h)) {
+      }
+    }
   };
 }
 
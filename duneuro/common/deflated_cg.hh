@@ -0,0 +1,299 @@
+#ifndef DUNEURO_DEFLATED_CG_HH
+#define DUNEURO_DEFLATED_CG_HH
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+#include <dune/common/timer.hh>
+
+#include <dune/istl/solver.hh>
+
+#include <duneuro/common/symmetric_eigen_decomposition.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief subspace used to deflate the conjugate gradient method
+   *
+   * The space is spanned by the columns of W, which are kept orthonormal with respect to the
+   * energy inner product of the system matrix A, i.e. W^T A W = I. Besides W, the products A W
+   * are stored. The space is grown by harvesting approximate eigenvectors belonging to the
+   * smallest eigenvalues of the preconditioned operator from the lanczos information of previous
+   * solves, until maxSize vectors have been collected.
+   *
+   * The space can be shared by several solvers running concurrently: a solver obtains an
+   * immutable snapshot of the current basis and new vectors are added by replacing the snapshot.
+   * The products with A and the orthonormalization are computed without holding the lock, as the
+   * operator may run parallel loops itself, e.g. the matrix free VoxelStencil.
+   */
+  template <class Vector>
+  class DeflationSpace
+  {
+  public:
+    struct Basis {
+      std::vector<Vector> W;
+      std::vector<Vector> AW;
+    };
+
+    DeflationSpace(std::size_t maxSize, std::size_t lanczosVectors, std::size_t vectorsPerSolve)
+        : maxSize_(maxSize)
+        , lanczosVectors_(lanczosVectors)
+        , vectorsPerSolve_(vectorsPerSolve)
+        , basis_(std::make_shared<Basis>())
+    {
+    }
+
+    std::shared_ptr<const Basis> basis() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return basis_;
+    }
+
+    //! true if further vectors should be harvested
+    bool growing() const
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return basis_->W.size() < maxSize_;
+    }
+
+    std::size_t lanczosVectors() const
+    {
+      return lanczosVectors_;
+    }
+
+    /**
+     * \brief harvest ritz vectors from the lanczos information of a cg solve
+     *
+     * The i-th lanczos vector v[i] is the (deflated) preconditioned residual of the i-th
+     * iteration, scaled by the inverse square root of its inner product with the residual. alpha
+     * and beta are the coefficients of the corresponding cg iterations.
+     */
+    template <class Operator>
+    void harvest(const Operator& op, const std::vector<Vector>& v, const std::vector<double>& alpha,
+                 const std::vector<double>& beta)
+    {
+      const std::size_t m = std::min(v.size(), alpha.size());
+      if (m < 2 || !growing()) {
+        return;
+      }
+      // the lanczos tridiagonal matrix of the preconditioned operator
+      std::vector<double> t(m * m, 0.0);
+      for (std::size_t j = 0; j < m; ++j) {
+        t[j * m + j] = 1.0 / alpha[j] + (j > 0 ? beta[j - 1] / alpha[j - 1] : 0.0);
+        if (j + 1 < m) {
+          t[j * m + j + 1] = t[(j + 1) * m + j] = -std::sqrt(beta[j]) / alpha[j];
+        }
+      }
+      std::vector<double> eigenvalues, eigenvectors;
+      symmetric_eigen_decomposition(t, m, eigenvalues, eigenvectors);
+
+      // ritz vectors and their products with A
+      std::vector<Vector> u, Au;
+      u.reserve(vectorsPerSolve_);
+      Au.reserve(vectorsPerSolve_);
+      for (std::size_t k = 0; k < std::min(vectorsPerSolve_, m); ++k) {
+        u.emplace_back(v[0].N());
+        u.back() = 0.0;
+        for (std::size_t j = 0; j < m; ++j) {
+          u.back().axpy(eigenvectors[j * m + k], v[j]);
+        }
+        Au.emplace_back(v[0].N());
+        op.apply(u.back(), Au.back());
+      }
+
+      // extend the current snapshot and replace it, unless another solver has replaced it in the
+      // meantime. In that case, extend the new snapshot instead.
+      auto snapshot = basis();
+      while (snapshot->W.size() < maxSize_) {
+        auto extended = std::make_shared<Basis>(*snapshot);
+        for (std::size_t k = 0; k < u.size() && extended->W.size() < maxSize_; ++k) {
+          addVector(u[k], Au[k], *extended);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (basis_ == snapshot) {
+          basis_ = extended;
+          return;
+        }
+        snapshot = basis_;
+      }
+    }
+
+  private:
+    std::size_t maxSize_;
+    std::size_t lanczosVectors_;
+    std::size_t vectorsPerSolve_;
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Basis> basis_;
+
+    // orthonormalize u against the basis with respect to the energy inner product and add it,
+    // if it is not (numerically) contained in the span of the basis already. Au is the product
+    // of the system matrix with u.
+    static void addVector(Vector u, Vector Au, Basis& basis)
+    {
+      const double initialNorm = std::sqrt(std::max(u.dot(Au), 0.0));
+      if (initialNorm == 0.0) {
+        return;
+      }
+      // two passes of classical gram schmidt
+      for (unsigned int pass = 0; pass < 2; ++pass) {
+        for (std::size_t i = 0; i < basis.W.size(); ++i) {
+          const double c = basis.AW[i].dot(u);
+          u.axpy(-c, basis.W[i]);
+          Au.axpy(-c, basis.AW[i]);
+        }
+      }
+      const double norm = std::sqrt(std::max(u.dot(Au), 0.0));
+      if (norm < 1e-8 * initialNorm) {
+        return;
+      }
+      u /= norm;
+      Au /= norm;
+      basis.W.push_back(u);
+      basis.AW.push_back(Au);
+    }
+  };
+
+  /**
+   * \brief deflated preconditioned conjugate gradient method
+   *
+   * The components of the solution within a deflation space are computed by a galerkin
+   * projection, the cg iteration is restricted to the energy orthogonal complement of this space.
+   * If the deflation space is growing, the lanczos information of the first iterations is used to
+   * add approximate eigenvectors belonging to the smallest eigenvalues of the preconditioned
+   * operator. Without deflation vectors, the iteration is identical to Dune::CGSolver.
+   */
+  template <class Operator, class Preconditioner, class Vector>
+  class DeflatedCGSolver
+  {
+  public:
+    DeflatedCGSolver(const Operator& op, Preconditioner& prec, DeflationSpace<Vector>& space,
+                     double reduction, unsigned int maxit, int verbose)
+        : op_(op)
+        , prec_(prec)
+        , space_(space)
+        , basis_(space.basis())
+        , lanczosVectors_(space.growing() ? space.lanczosVectors() : 0)
+        , reduction_(reduction)
+        , maxit_(maxit)
+        , verbose_(verbose)
+    {
+    }
+
+    void apply(Vector& x, Vector& b, Dune::InverseOperatorResult& res)
+    {
+      res.clear();
+      Dune::Timer watch;
+      const auto& W = basis_->W;
+      const auto& AW = basis_->AW;
+      std::vector<double> coefficients(W.size());
+      // z <- z - W (AW)^T z, i.e. project onto the energy orthogonal complement of W
+      auto deflate = [&](Vector& z) {
+        for (std::size_t i = 0; i < W.size(); ++i) {
+          coefficients[i] = AW[i].dot(z);
+        }
+        for (std::size_t i = 0; i < W.size(); ++i) {
+          z.axpy(-coefficients[i], W[i]);
+        }
+      };
+
+      prec_.pre(x, b);
+      Vector r(b);
+      Vector q(b.N());
+      op_.apply(x, q);
+      r -= q;
+      const double def0 = r.two_norm();
+      // coarse correction: x <- x + W W^T r, afterwards W^T r = 0
+      for (std::size_t i = 0; i < W.size(); ++i) {
+        const double c = W[i].dot(r);
+        x.axpy(c, W[i]);
+        r.axpy(-c, AW[i]);
+      }
+      double def = r.two_norm();
+      if (def0 <= 1e-99 || def <= reduction_ * def0) {
+        prec_.post(x);
+        res.converged = true;
+        res.reduction = def0 > 1e-99 ? def / def0 : 0.0;
+        res.elapsed = watch.elapsed();
+        return;
+      }
+
+      Vector z(b.N());
+      Vector p(b.N());
+      z = 0.0;
+      prec_.apply(z, r);
+      deflate(z);
+      p = z;
+      double rho = r.dot(z);
+
+      std::vector<Vector> lanczos;
+      std::vector<double> alphas, betas;
+      if (lanczosVectors_ > 0 && rho > 0) {
+        lanczos.push_back(z);
+        lanczos.back() /= std::sqrt(rho);
+      }
+
+      unsigned int i = 1;
+      for (; i <= maxit_; ++i) {
+        op_.apply(p, q);
+        const double alpha = rho / p.dot(q);
+        x.axpy(alpha, p);
+        r.axpy(-alpha, q);
+        def = r.two_norm();
+        if (verbose_ > 1) {
+          std::cout << "=== deflated cg iteration " << i << " defect " << def << std::endl;
+        }
+        if (lanczos.size() > alphas.size()) {
+          alphas.push_back(alpha);
+        }
+        if (def < reduction_ * def0) {
+          break;
+        }
+        z = 0.0;
+        prec_.apply(z, r);
+        deflate(z);
+        const double rhoNew = r.dot(z);
+        const double beta = rhoNew / rho;
+        p *= beta;
+        p += z;
+        rho = rhoNew;
+        if (lanczos.size() == alphas.size() && lanczos.size() > 0
+            && lanczos.size() < lanczosVectors_ && rho > 0) {
+          betas.push_back(beta);
+          lanczos.push_back(z);
+          lanczos.back() /= std::sqrt(rho);
+        }
+      }
+      prec_.post(x);
+
+      res.iterations = std::min(i, maxit_);
+      res.reduction = def / def0;
+      res.converged = def < reduction_ * def0;
+      res.conv_rate = std::pow(res.reduction, 1.0 / std::max(res.iterations, 1));
+      res.elapsed = watch.elapsed();
+      if (verbose_ > 0) {
+        std::cout << "=== deflated cg: " << W.size() << " deflation vectors, " << res.iterations
+                  << " iterations, reduction " << res.reduction << std::endl;
+      }
+      if (lanczos.size() > 1) {
+        space_.harvest(op_, lanczos, alphas, betas);
+      }
+    }
+
+  private:
+    const Operator& op_;
+    Preconditioner& prec_;
+    DeflationSpace<Vector>& space_;
+    std::shared_ptr<const typename DeflationSpace<Vector>::Basis> basis_;
+    std::size_t lanczosVectors_;
+    double reduction_;
+    unsigned int maxit_;
+    int verbose_;
+  };
+}
+
+#endif // DUNEURO_DEFLATED_CG_HH
@@ -1,6 +1,7 @@
 #ifndef DUNEURO_DENSE_MATRIX_HH
 #define DUNEURO_DENSE_MATRIX_HH
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -8,6 +9,15 @@
 
 namespace duneuro
 {
+  /**
+   * \brief order of the entries of a dense matrix in memory
+   *
+   * Row major matrices store each row contiguously, column major matrices each column. For a
+   * transfer matrix, whose columns belong to the degrees of freedom, the column major layout
+   * stores the values of all sensors for a degree of freedom next to each other.
+   */
+  enum class DenseMatrixLayout { rowMajor, columnMajor };
+
   template <class T>
   class DenseMatrixStorageInterface
   {
@@ -67,20 +77,31 @@ namespace duneuro
   class DenseMatrix
   {
   public:
-    DenseMatrix(std::size_t rows, std::size_t cols, T init = T(0))
+    DenseMatrix(std::size_t rows, std::size_t cols, T init = T(0),
+                DenseMatrixLayout layout = DenseMatrixLayout::rowMajor)
         : rows_(rows)
         , columns_(cols)
+        , layout_(layout)
         , data_(std::make_shared<StdVectorDenseMatrixStorage<T>>(rows * cols, init))
     {
     }
 
-    explicit DenseMatrix(std::size_t rows, std::size_t cols, T* data)
+    explicit DenseMatrix(std::size_t rows, std::size_t cols, T* data,
+                         DenseMatrixLayout layout = DenseMatrixLayout::rowMajor)
         : rows_(rows)
         , columns_(cols)
+        , layout_(layout)
         , data_(std::make_shared<RawNonOwningDenseMatrixStorage<T>>(data))
     {
     }
 
+    explicit DenseMatrix(std::size_t rows, std::size_t cols,
+                         std::shared_ptr<DenseMatrixStorageInterface<T>> storage,
+                         DenseMatrixLayout layout = DenseMatrixLayout::rowMajor)
+        : rows_(rows), columns_(cols), layout_(layout), data_(storage)
+    {
+    }
+
     const T& operator()(std::size_t r, std::size_t c) const
     {
       return data_->data()[linear_index(r, c)];
@@ -101,6 +122,16 @@ namespace duneuro
       return columns_;
     }
 
+    DenseMatrixLayout layout() const
+    {
+      return layout_;
+    }
+
+    bool rowMajor() const
+    {
+      return layout_ == DenseMatrixLayout::rowMajor;
+    }
+
     const T* data() const
     {
       return data_->data();
@@ -111,14 +142,33 @@ namespace duneuro
       return data_->data();
     }
 
+    /**
+     * \brief key of the selection of columns the matrix has been computed for
+     *
+     * Transfer matrices restricted to a source space store the key of the source space, so that
+     * they are not applied using the columns of another one. The key is 0 if the matrix stores all
+     * columns or if the selection is unknown.
+     */
+    std::uint64_t columnKey() const
+    {
+      return columnKey_;
+    }
+
+    void setColumnKey(std::uint64_t key)
+    {
+      columnKey_ = key;
+    }
+
   private:
     std::size_t linear_index(std::size_t r, std::size_t c) const
     {
-      return r * columns_ + c;
+      return layout_ == DenseMatrixLayout::rowMajor ? r * columns_ + c : c * rows_ + r;
     }
     std::size_t rows_;
     std::size_t columns_;
+    DenseMatrixLayout layout_;
     std::shared_ptr<DenseMatrixStorageInterface<T>> data_;
+    std::uint64_t columnKey_ = 0;
   };
 }
 
@@ -0,0 +1,110 @@
+#ifndef DUNEURO_DENSE_MATRIX_LAYOUT_HH
+#define DUNEURO_DENSE_MATRIX_LAYOUT_HH
+
+#if HAVE_TBB
+#include <tbb/blocked_range2d.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/parametertree.hh>
+
+#include <duneuro/common/dense_matrix.hh>
+#include <duneuro/common/mapped_dense_matrix.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief parse a dense matrix layout
+   *
+   * Accepts "row_major" and "column_major". For transfer matrices, whose rows belong to the
+   * sensors and whose columns belong to the degrees of freedom, "sensor_major" and "dof_major"
+   * are accepted as synonyms.
+   */
+  inline DenseMatrixLayout dense_matrix_layout_from_string(const std::string& name)
+  {
+    if (name == "row_major" || name == "sensor_major") {
+      return DenseMatrixLayout::rowMajor;
+    } else if (name == "column_major" || name == "dof_major") {
+      return DenseMatrixLayout::columnMajor;
+    } else {
+      DUNE_THROW(Dune::Exception, "unknown dense matrix layout \"" << name << "\"");
+    }
+  }
+
+  inline std::string to_string(DenseMatrixLayout layout)
+  {
+    return layout == DenseMatrixLayout::rowMajor ? "row_major" : "column_major";
+  }
+
+  /**
+   * \brief copy a dense matrix into a new matrix with the given layout
+   *
+   * The entries of the returned matrix equal those of the input, only their order in memory
+   * differs. If the layouts differ, the copy is a transposition, which is performed in square
+   * tiles so that both the reads and the writes stay within a few cache lines. With tbb, the
+   * tiles are processed in parallel, using config["numberOfThreads"] threads if given. The new
+   * matrix is created by make_dense_matrix from config.sub("storage"), so it can also be
+   * written to a file backed matrix.
+   */
+  template <class T>
+  std::unique_ptr<DenseMatrix<T>> convert_dense_matrix_layout(const DenseMatrix<T>& matrix,
+                                                              DenseMatrixLayout layout,
+                                                              const Dune::ParameterTree& config
+                                                              = Dune::ParameterTree())
+  {
+    const std::size_t rows = matrix.rows();
+    const std::size_t cols = matrix.cols();
+    auto result = make_dense_matrix<T>(
+        rows, cols, config.hasSub("storage") ? config.sub("storage") : Dune::ParameterTree(),
+        layout);
+    result->setColumnKey(matrix.columnKey());
+    const T* input = matrix.data();
+    T* output = result->data();
+    if (matrix.layout() == layout) {
+      std::copy(input, input + rows * cols, output);
+      return result;
+    }
+    // the input is an n x m matrix stored contiguously along m, the output its transpose
+    const std::size_t n = matrix.rowMajor() ? rows : cols;
+    const std::size_t m = matrix.rowMajor() ? cols : rows;
+    const std::size_t tileSize = config.get<std::size_t>("tile_size", 64);
+    auto transposeTile = [&](std::size_t iBegin, std::size_t iEnd, std::size_t jBegin,
+                             std::size_t jEnd) {
+      for (std::size_t i = iBegin; i < iEnd; ++i) {
+        const T* in = input + i * m;
+        for (std::size_t j = jBegin; j < jEnd; ++j) {
+          output[j * n + i] = in[j];
+        }
+      }
+    };
+#if HAVE_TBB
+    int nr_threads = config.hasKey("numberOfThreads") ? config.get<int>("numberOfThreads")
+                                                      : tbb::task_arena::automatic;
+    tbb::task_arena arena(nr_threads);
+    arena.execute([&] {
+      tbb::parallel_for(
+          tbb::blocked_range2d<std::size_t>(0, n, tileSize, 0, m, tileSize),
+          [&](const tbb::blocked_range2d<std::size_t>& range) {
+            transposeTile(range.rows().begin(), range.rows().end(), range.cols().begin(),
+                          range.cols().end());
+          });
+    });
+#else
+    for (std::size_t iBegin = 0; iBegin < n; iBegin += tileSize) {
+      for (std::size_t jBegin = 0; jBegin < m; jBegin += tileSize) {
+        transposeTile(iBegin, std::min(n, iBegin + tileSize), jBegin,
+                      std::min(m, jBegin + tileSize));
+      }
+    }
+#endif
+    return result;
+  }
+}
+
+#endif // DUNEURO_DENSE_MATRIX_LAYOUT_HH
@@ -14,6 +14,7 @@
 #include <duneuro/common/linear_problem_solver.hh>
 #include <duneuro/common/penalty_flux_weighting.hh>
 #include <duneuro/common/random.hh>
+#include <duneuro/common/vector_initialization.hh>
 #include <duneuro/io/data_tree.hh>
 
 namespace duneuro
@@ -101,7 +102,9 @@ namespace duneuro
                DataTree dataTree = DataTree())
     {
       Dune::Timer timer;
-      randomize_uniform(Dune::PDELab::Backend::native(solution), DF(-1.0), DF(1.0));
+      initialize(Dune::PDELab::Backend::native(solution), config.hasSub("initialization") ?
+                                                              config.sub("initialization") :
+                                                              Dune::ParameterTree());
       linearSolver_.apply(solverBackend, solution, rightHandSide, config, dataTree);
       dataTree.set("time", timer.elapsed());
     }
@@ -116,6 +119,12 @@ namespace duneuro
       dataTree.set("time", timer.elapsed());
     }
 
+    //! read the matrix from the given file or store it there, see LinearProblemSolver
+    void setJacobianCache(const std::string& filename)
+    {
+      linearSolver_.setJacobianCache(filename);
+    }
+
     const typename Traits::FunctionSpace& functionSpace() const
     {
       return functionSpace_;
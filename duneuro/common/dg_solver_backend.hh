@@ -1,20 +1,88 @@
 #ifndef DUNEURO_DG_SOLVER_BACKEND_HH
 #define DUNEURO_DG_SOLVER_BACKEND_HH
 
+#include <memory>
+
 #include <dune/pdelab/backend/istl/seq_amg_dg_backend.hh>
 
 #include <duneuro/common/cg_first_order_space.hh>
+#include <duneuro/common/seq_amg_dg_mixed_precision_backend.hh>
+#include <duneuro/io/data_tree.hh>
 
 namespace duneuro
 {
+  /**
+   * \brief selects between the double and the mixed precision amg backend for dg
+   *
+   * If mixed_precision.enable is set in the config, the amg in the cg subspace is built and
+   * applied in single precision, see ISTLBackend_SEQ_MixedPrecisionAMG_4_DG. Otherwise, the
+   * pdelab backend is used.
+   */
+  template <class DGGO, class CGGFS>
+  class DGAMGSolverBackend : public Dune::PDELab::LinearResultStorage
+  {
+    using M = typename DGGO::Traits::Jacobian;
+    using V = typename DGGO::Traits::Domain;
+    using W = typename DGGO::Traits::Range;
+    using Real = typename Dune::FieldTraits<typename V::ElementType>::real_type;
+
+  public:
+    using DoubleBackend =
+        Dune::PDELab::ISTLBackend_SEQ_AMG_4_DG<DGGO, CGGFS, Dune::PDELab::CG2DGProlongation,
+                                               Dune::SeqSSOR, Dune::CGSolver>;
+    using MixedPrecisionBackend =
+        ISTLBackend_SEQ_MixedPrecisionAMG_4_DG<DGGO, CGGFS, Dune::PDELab::CG2DGProlongation>;
+
+    DGAMGSolverBackend(DGGO& dggo, const CGGFS& cggfs, const Dune::ParameterTree& config)
+    {
+      if (config.get<bool>("mixed_precision.enable", false)) {
+        mixedPrecisionBackend_ = std::make_unique<MixedPrecisionBackend>(dggo, cggfs, config);
+      } else {
+        doubleBackend_ = std::make_unique<DoubleBackend>(dggo, cggfs, config);
+      }
+    }
+
+    //! Set whether the AMG should be reused again during call to apply().
+    void setReuse(bool reuse)
+    {
+      if (mixedPrecisionBackend_) {
+        mixedPrecisionBackend_->setReuse(reuse);
+      } else {
+        doubleBackend_->setReuse(reuse);
+      }
+    }
+
+    void apply(M& A, V& z, W& r, Real reduction)
+    {
+      if (mixedPrecisionBackend_) {
+        mixedPrecisionBackend_->apply(A, z, r, reduction);
+        res = mixedPrecisionBackend_->result();
+      } else {
+        doubleBackend_->apply(A, z, r, reduction);
+        res = doubleBackend_->result();
+      }
+    }
+
+    //! store the iteration counts of the mixed precision backend, if it is used
+    void report(DataTree dataTree) const
+    {
+      if (mixedPrecisionBackend_) {
+        mixedPrecisionBackend_->report(dataTree);
+      }
+    }
+
+  private:
+    std::unique_ptr<DoubleBackend> doubleBackend_;
+    std::unique_ptr<MixedPrecisionBackend> mixedPrecisionBackend_;
+  };
+
   template <typename Solver, ElementType elementType>
   struct DGSolverBackendTraits {
     using FirstOrderSpace = CGFirstOrderSpace<typename Solver::Traits::VolumeConductor::GridView,
                                               BasicTypeFromElementType<elementType>::value,
                                               Dune::SolverCategory::sequential>;
-    using SolverBackend = Dune::PDELab::ISTLBackend_SEQ_AMG_4_DG<
-        typename Solver::Traits::Assembler::GO, typename FirstOrderSpace::GFS,
-        Dune::PDELab::CG2DGProlongation, Dune::SeqSSOR, Dune::CGSolver>;
+    using SolverBackend =
+        DGAMGSolverBackend<typename Solver::Traits::Assembler::GO, typename FirstOrderSpace::GFS>;
   };
 
   template <typename Solver, ElementType elementType>
@@ -36,6 +104,7 @@ namespace duneuro
         : solver_(other.solver_)
         , firstOrderSpace_(other.firstOrderSpace_)
         , solverBackend_(*solver_->assembler(), firstOrderSpace_.getGFS(), other.config_)
+        , config_(other.config_)
     {
       init();
     }
@@ -1,7 +1,8 @@
 #ifndef DUNEURO_EDGEHOPPING_HH
 #define DUNEURO_EDGEHOPPING_HH
 
-#include <set>
+#include <algorithm>
+#include <vector>
 
 #include <dune/common/float_cmp.hh>
 #include <dune/common/fvector.hh>
@@ -55,7 +56,8 @@ namespace duneuro
     Entity findEntityImpl(const GlobalCoordinate& global, const Entity& start) const
     {
       using ElementIndex = typename GV::IndexSet::IndexType;
-      std::set<ElementIndex> visited = {gridView_.indexSet().index(start)};
+      // usually only a few elements are visited, so a linear search is cheaper than a set
+      std::vector<ElementIndex> visited = {gridView_.indexSet().index(start)};
       Entity current = start;
       bool foundNext = true;
       bool boundaryIntersectionFound = false;
@@ -68,9 +70,9 @@ namespace duneuro
             if (!i.boundary()) {
               const auto& out = i.outside();
               ElementIndex outIndex = gridView_.indexSet().index(out);
-              if (visited.find(outIndex) == visited.end()) {
+              if (std::find(visited.begin(), visited.end(), outIndex) == visited.end()) {
                 current = out;
-                visited.insert(outIndex);
+                visited.push_back(outIndex);
                 foundNext = true;
                 break;
               }
@@ -1,12 +1,100 @@
 #ifndef DUNEURO_ELEMENT_NEIGHBORHOOD_MAP_HH
 #define DUNEURO_ELEMENT_NEIGHBORHOOD_MAP_HH
 
-#include <set>
+#if HAVE_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+#include <vector>
 
 #include <dune/grid/common/scsgmapper.hh>
 
 namespace duneuro
 {
+  namespace ElementNeighborhoodMapDetail
+  {
+    // compressed sparse row storage of a graph: the neighbors of node i are
+    // indices[offsets[i]], ..., indices[offsets[i+1]-1]
+    template <class I>
+    struct CompressedAdjacency {
+      std::vector<std::size_t> offsets;
+      std::vector<I> indices;
+
+      struct Range {
+        const I* first;
+        const I* last;
+
+        const I* begin() const
+        {
+          return first;
+        }
+        const I* end() const
+        {
+          return last;
+        }
+        std::size_t size() const
+        {
+          return last - first;
+        }
+      };
+
+      Range operator[](std::size_t i) const
+      {
+        return {indices.data() + offsets[i], indices.data() + offsets[i + 1]};
+      }
+
+      std::size_t size() const
+      {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+      }
+    };
+
+    // apply f(i) for all i in [0, n), in parallel if tbb is available
+    template <class F>
+    void forEachIndex(std::size_t n, F&& f)
+    {
+#if HAVE_TBB
+      tbb::parallel_for(tbb::blocked_range<std::size_t>(0, n),
+                        [&](const tbb::blocked_range<std::size_t>& range) {
+                          for (std::size_t i = range.begin(); i != range.end(); ++i) {
+                            f(i);
+                          }
+                        });
+#else
+      for (std::size_t i = 0; i < n; ++i) {
+        f(i);
+      }
+#endif
+    }
+
+    // call f such that a thread waiting for a parallel loop inside f only executes tasks of that
+    // loop. Otherwise it may pick up a task of an enclosing parallel loop, e.g. of a transfer
+    // matrix sweep, which deadlocks if that task acquires a lock the waiting thread holds.
+    template <class F>
+    void isolate(F&& f)
+    {
+#if HAVE_TBB
+      tbb::this_task_arena::isolate([&] { f(); });
+#else
+      f();
+#endif
+    }
+  }
+
+  /**
+   * \brief adjacency information of the elements of a grid view
+   *
+   * The adjacency between elements sharing a vertex and between elements sharing an intersection
+   * is computed once and stored in compressed sparse row format over element indices. The
+   * index based methods can be used to grow element patches by scanning these arrays, without
+   * reconstructing entities. The entity based methods are provided for convenience.
+   */
   template <class GV>
   class ElementNeighborhoodMap
   {
@@ -14,26 +102,111 @@ namespace duneuro
     using Entity = typename GV::template Codim<0>::Entity;
     using Vertex = typename GV::template Codim<GV::dimension>::Entity;
     using EntitySeed = typename Entity::EntitySeed;
+    using Index = typename GV::IndexSet::IndexType;
+    using Adjacency = ElementNeighborhoodMapDetail::CompressedAdjacency<Index>;
+    using IndexRange = typename Adjacency::Range;
 
     explicit ElementNeighborhoodMap(const GV& gv)
         : gridView_(gv)
         , elementMapper_(gridView_)
         , vertexMapper_(gridView_)
-        , vertexToElements_(vertexMapper_.size())
+        , elementSeeds_(elementMapper_.size())
     {
+      const std::size_t numberOfElements = elementMapper_.size();
+      const std::size_t numberOfVertices = vertexMapper_.size();
+
+      // a single pass over the grid collecting the vertices and intersection neighbors of each
+      // element. All further work only operates on index arrays
+      Adjacency elementToVertices;
+      std::vector<std::vector<Index>> vertices(numberOfElements);
+      std::vector<std::vector<Index>> intersectionNeighbors(numberOfElements);
       for (const auto& e : elements(gridView_)) {
+        auto index = elementMapper_.index(e);
+        elementSeeds_[index] = e.seed();
         for (unsigned int i = 0; i < e.subEntities(GV::dimension); ++i) {
-          unsigned int vertexIndex = vertexMapper_.subIndex(e, i, GV::dimension);
-          vertexToElements_[vertexIndex].push_back(e.seed());
+          vertices[index].push_back(vertexMapper_.subIndex(e, i, GV::dimension));
+        }
+        for (const auto& intersection : Dune::intersections(gridView_, e)) {
+          if (intersection.neighbor()) {
+            intersectionNeighbors[index].push_back(elementMapper_.index(intersection.outside()));
+          }
         }
       }
+      flatten(vertices, elementToVertices);
+      flatten(intersectionNeighbors, intersectionNeighbors_);
+
+      // invert the element to vertex relation
+      vertexToElements_.offsets.assign(numberOfVertices + 1, 0);
+      for (auto v : elementToVertices.indices) {
+        ++vertexToElements_.offsets[v + 1];
+      }
+      std::partial_sum(vertexToElements_.offsets.begin(), vertexToElements_.offsets.end(),
+                       vertexToElements_.offsets.begin());
+      vertexToElements_.indices.resize(elementToVertices.indices.size());
+      {
+        std::vector<std::size_t> position(vertexToElements_.offsets.begin(),
+                                          vertexToElements_.offsets.end() - 1);
+        for (std::size_t e = 0; e < numberOfElements; ++e) {
+          for (auto v : elementToVertices[e]) {
+            vertexToElements_.indices[position[v]++] = e;
+          }
+        }
+      }
+
+      // elements sharing at least one vertex, computed in parallel
+      std::vector<std::vector<Index>> vertexNeighbors(numberOfElements);
+      ElementNeighborhoodMapDetail::forEachIndex(numberOfElements, [&](std::size_t e) {
+        auto& neighbors = vertexNeighbors[e];
+        for (auto v : elementToVertices[e]) {
+          const auto range = vertexToElements_[v];
+          neighbors.insert(neighbors.end(), range.begin(), range.end());
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+      });
+      flatten(vertexNeighbors, vertexNeighbors_);
+    }
+
+    //! index of the given element, as used by the index based methods
+    Index index(const Entity& element) const
+    {
+      return elementMapper_.index(element);
+    }
+
+    //! reconstruct the element with the given index
+    Entity element(Index index) const
+    {
+      return gridView_.grid().entity(elementSeeds_[index]);
+    }
+
+    std::size_t size() const
+    {
+      return elementSeeds_.size();
+    }
+
+    //! indices of the elements containing the given vertex
+    IndexRange elementsOfVertex(Index vertex) const
+    {
+      return vertexToElements_[vertex];
+    }
+
+    //! indices of the elements sharing a vertex with the given element, including the element itself
+    IndexRange vertexNeighbors(Index element) const
+    {
+      return vertexNeighbors_[element];
+    }
+
+    //! indices of the elements sharing an intersection with the given element
+    IndexRange intersectionNeighbors(Index element) const
+    {
+      return intersectionNeighbors_[element];
     }
 
     template <typename I>
     void getNeighborsOfVertex(unsigned int vertex, I out) const
     {
-      for (const auto& es : vertexToElements_[vertex]) {
-        *out++ = gridView_.grid().entity(es);
+      for (auto e : elementsOfVertex(vertex)) {
+        *out++ = element(e);
       }
     }
 
@@ -50,29 +223,18 @@ namespace duneuro
     }
 
     template <typename I>
-    void getVertexNeighbors(const Entity& element, I out) const
-    {
-      const auto& geo = element.geometry();
-      std::set<typename GV::IndexSet::IndexType> usedElements;
-      unsigned int corners = geo.corners();
-      for (unsigned int i = 0; i < corners; ++i) {
-        auto vertexIndex = vertexMapper_.subIndex(element, i, GV::dimension);
-        for (const auto& es : vertexToElements_[vertexIndex]) {
-          const auto& candidate = gridView_.grid().entity(es);
-          if (usedElements.insert(elementMapper_.index(candidate)).second) {
-            *out++ = candidate;
-          }
-        }
+    void getVertexNeighbors(const Entity& entity, I out) const
+    {
+      for (auto e : vertexNeighbors(index(entity))) {
+        *out++ = element(e);
       }
     }
 
     template <typename I>
-    void getIntersectionNeighbors(const Entity& element, I out) const
+    void getIntersectionNeighbors(const Entity& entity, I out) const
     {
-      for (const auto& intersection : Dune::intersections(gridView_, element)) {
-        if (intersection.neighbor()) {
-          *out++ = intersection.outside();
-        }
+      for (auto e : intersectionNeighbors(index(entity))) {
+        *out++ = element(e);
       }
     }
 
@@ -85,7 +247,24 @@ namespace duneuro
     GV gridView_;
     Dune::SingleCodimSingleGeomTypeMapper<GV, 0> elementMapper_;
     Dune::SingleCodimSingleGeomTypeMapper<GV, GV::dimension> vertexMapper_;
-    std::vector<std::vector<EntitySeed>> vertexToElements_;
+    std::vector<EntitySeed> elementSeeds_;
+    Adjacency vertexToElements_;
+    Adjacency vertexNeighbors_;
+    Adjacency intersectionNeighbors_;
+
+    static void flatten(std::vector<std::vector<Index>>& lists, Adjacency& adjacency)
+    {
+      adjacency.offsets.assign(lists.size() + 1, 0);
+      for (std::size_t i = 0; i < lists.size(); ++i) {
+        adjacency.offsets[i + 1] = adjacency.offsets[i] + lists[i].size();
+      }
+      adjacency.indices.resize(adjacency.offsets.back());
+      ElementNeighborhoodMapDetail::forEachIndex(lists.size(), [&](std::size_t i) {
+        std::copy(lists[i].begin(), lists[i].end(),
+                  adjacency.indices.begin() + adjacency.offsets[i]);
+        std::vector<Index>().swap(lists[i]);
+      });
+    }
   };
 }
 
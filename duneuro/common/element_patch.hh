@@ -1,7 +1,11 @@
 #ifndef DUNEURO_ELEMENT_PATCH_HH
 #define DUNEURO_ELEMENT_PATCH_HH
 
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include <dune/common/parametertree.hh>
@@ -49,6 +53,7 @@ namespace duneuro
     using Intersection = typename GV::Intersection;
     using ElementMapper = Dune::SingleCodimSingleGeomTypeMapper<GV, 0>;
     using VertexMapper = Dune::SingleCodimSingleGeomTypeMapper<GV, GV::dimension>;
+    using Index = typename ElementNeighborhoodMap<GV>::Index;
 
     template <typename ElementSearch>
     ElementPatch(std::shared_ptr<ElementNeighborhoodMap<GV>> elementNeighborhoodMap,
@@ -72,25 +77,25 @@ namespace duneuro
 
     void extend(ElementPatchExtension extension)
     {
-      std::vector<Element> candidates;
-      switch (extension) {
-      case ElementPatchExtension::vertex:
-        for (const auto& element : elements_) {
-          elementNeighborhoodMap_->getVertexNeighbors(element, std::back_inserter(candidates));
-        }
-        break;
-      case ElementPatchExtension::intersection:
-        for (const auto& element : elements_) {
-          elementNeighborhoodMap_->getIntersectionNeighbors(element,
-                                                            std::back_inserter(candidates));
-        }
-        break;
+      // collect the candidates using the precomputed adjacency of the element indices. Entities
+      // are only reconstructed for candidates which are not yet part of the patch
+      std::vector<Index> candidates;
+      for (auto index : indices_) {
+        const auto neighbors = extension == ElementPatchExtension::vertex ?
+                                   elementNeighborhoodMap_->vertexNeighbors(index) :
+                                   elementNeighborhoodMap_->intersectionNeighbors(index);
+        candidates.insert(candidates.end(), neighbors.begin(), neighbors.end());
       }
-      for (const auto& candidate : candidates) {
-        auto index = elementMapper_.index(candidate);
-        if ((elementIndices_.count(index) == 0) && elementFilter_(candidate)) {
-          elements_.push_back(candidate);
-          elementIndices_.insert(index);
+      std::unordered_set<Index> rejected;
+      for (auto index : candidates) {
+        if (elementIndices_.count(index) > 0 || rejected.count(index) > 0) {
+          continue;
+        }
+        auto candidate = elementNeighborhoodMap_->element(index);
+        if (elementFilter_(candidate)) {
+          insert(index, candidate);
+        } else {
+          rejected.insert(index);
         }
       }
     }
@@ -122,6 +127,12 @@ namespace duneuro
       return elements_;
     }
 
+    //! indices of the patch elements with respect to the element neighborhood map
+    const std::vector<Index>& elementIndices() const
+    {
+      return indices_;
+    }
+
     bool contains(const Element& element) const
     {
       return elementIndices_.count(elementMapper_.index(element)) > 0;
@@ -163,25 +174,17 @@ namespace duneuro
 
         // we essentially need to perfrom one additional vertex
         // extension and simply store the new elements inside the
-        // array
-
-        // we first get all elements that share a vertex with one
-        // element in the current patch. Note that candidates get
-        // included mutliple times
-        std::vector<Element> candidates;
-        for(const auto& element : elements_) {
-          elementNeighborhoodMap_->getVertexNeighbors(element, std::back_inserter(candidates));
-        }
-
-        // we now check all candidates to see if they are new additions
-        std::set<std::size_t> visitedTransitionElementIndices;
-        for(const auto& candidate : candidates) {
-          auto index = elementMapper_.index(candidate);
-          // check if candidate is not in inner region as was not already included earlier
-          if(elementIndices_.count(index) == 0 &&
-            visitedTransitionElementIndices.count(index) == 0) {
-            transitionElements_->push_back(candidate);
-            visitedTransitionElementIndices.insert(index);
+        // array. We iterate over all elements that share a vertex
+        // with one element in the current patch. Note that candidates
+        // are visited mutliple times
+        std::unordered_set<Index> visitedTransitionElementIndices;
+        for(auto index : indices_) {
+          for(auto candidate : elementNeighborhoodMap_->vertexNeighbors(index)) {
+            // check if candidate is not in inner region as was not already included earlier
+            if(elementIndices_.count(candidate) == 0 &&
+              visitedTransitionElementIndices.insert(candidate).second) {
+              transitionElements_->push_back(elementNeighborhoodMap_->element(candidate));
+            }
           }
         }
       }
@@ -198,16 +201,23 @@ namespace duneuro
 
     Element element_of_start_position_;
     std::vector<Element> elements_;
-    std::set<std::size_t> elementIndices_;
+    std::vector<Index> indices_;
+    std::unordered_set<Index> elementIndices_;
     std::shared_ptr<std::vector<Element>> transitionElements_;
 
+    void insert(Index index, const Element& element)
+    {
+      elements_.push_back(element);
+      indices_.push_back(index);
+      elementIndices_.insert(index);
+    }
+
     template <typename ElementSearch>
     void initializeSingleElement(const ElementSearch& elementSearch, const Coordinate& position)
     {
       element_of_start_position_ = elementSearch.findEntity(position);
       if (elementFilter_(element_of_start_position_)) {
-        elements_.push_back(element_of_start_position_);
-        elementIndices_.insert(elementMapper_.index(element_of_start_position_));
+        insert(elementMapper_.index(element_of_start_position_), element_of_start_position_);
       }
     }
 
@@ -229,16 +239,12 @@ namespace duneuro
           minCorner = i;
         }
       }
-      // retrieve elements belonging to that corner
-      std::vector<Element> candidates;
-      elementNeighborhoodMap_->getNeighborsOfVertex(
-          vertexMapper_.subIndex(element_of_start_position_, minCorner, GV::dimension),
-          std::back_inserter(candidates));
-      // filter them and push them to the list
-      for (const auto& e : candidates) {
+      // retrieve elements belonging to that corner, filter them and push them to the list
+      for (auto index : elementNeighborhoodMap_->elementsOfVertex(
+               vertexMapper_.subIndex(element_of_start_position_, minCorner, GV::dimension))) {
+        auto e = elementNeighborhoodMap_->element(index);
         if (elementFilter_(e)) {
-          elements_.push_back(e);
-          elementIndices_.insert(elementMapper_.index(e));
+          insert(index, e);
         }
       }
     }
@@ -0,0 +1,171 @@
+#ifndef DUNEURO_FINGERPRINT_HH
+#define DUNEURO_FINGERPRINT_HH
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parametertree.hh>
+
+#include <dune/grid/common/rangegenerators.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief 64 bit FNV-1a hash of a sequence of values
+   *
+   * The fingerprint is used to identify a model, e.g. to check if a previously computed
+   * transfer matrix can be reused. Values are hashed by their binary representation, so the
+   * fingerprint is only comparable between runs on the same platform.
+   */
+  class Fingerprint
+  {
+  public:
+    Fingerprint() : hash_(14695981039346656037ull)
+    {
+    }
+
+    void addBytes(const void* data, std::size_t size)
+    {
+      const unsigned char* bytes = static_cast<const unsigned char*>(data);
+      for (std::size_t i = 0; i < size; ++i) {
+        hash_ ^= bytes[i];
+        hash_ *= 1099511628211ull;
+      }
+    }
+
+    template <class T>
+    std::enable_if_t<std::is_arithmetic<T>::value> add(const T& value)
+    {
+      addBytes(&value, sizeof(T));
+    }
+
+    void add(const std::string& value)
+    {
+      add(value.size());
+      addBytes(value.data(), value.size());
+    }
+
+    void add(const char* value)
+    {
+      add(std::string(value));
+    }
+
+    template <class T, int n>
+    void add(const Dune::FieldVector<T, n>& value)
+    {
+      for (int i = 0; i < n; ++i) {
+        add(value[i]);
+      }
+    }
+
+    template <class T, int n, int m>
+    void add(const Dune::FieldMatrix<T, n, m>& value)
+    {
+      for (int i = 0; i < n; ++i) {
+        add(value[i]);
+      }
+    }
+
+    template <class T>
+    void add(const std::vector<T>& values)
+    {
+      add(values.size());
+      for (const auto& v : values) {
+        add(v);
+      }
+    }
+
+    /**
+     * \brief add all keys and values of the given tree
+     *
+     * Keys are processed in sorted order, so the result does not depend on the order in which
+     * the tree has been filled. Keys and sub trees whose name is contained in skip are ignored.
+     */
+    void add(const Dune::ParameterTree& tree, const std::vector<std::string>& skip = {})
+    {
+      auto valueKeys = tree.getValueKeys();
+      valueKeys.erase(std::remove_if(valueKeys.begin(), valueKeys.end(),
+                                     [&](const std::string& key) {
+                                       return std::find(skip.begin(), skip.end(), key)
+                                              != skip.end();
+                                     }),
+                      valueKeys.end());
+      std::sort(valueKeys.begin(), valueKeys.end());
+      add(valueKeys.size());
+      for (const auto& key : valueKeys) {
+        add(key);
+        add(tree[key]);
+      }
+      auto subKeys = tree.getSubKeys();
+      std::sort(subKeys.begin(), subKeys.end());
+      for (const auto& key : subKeys) {
+        if (std::find(skip.begin(), skip.end(), key) != skip.end()) {
+          continue;
+        }
+        add(key);
+        add(tree.sub(key));
+      }
+    }
+
+    std::uint64_t value() const
+    {
+      return hash_;
+    }
+
+    //! hexadecimal representation of the hash value
+    std::string str() const
+    {
+      std::stringstream stream;
+      stream << std::hex << std::setw(16) << std::setfill('0') << hash_;
+      return stream.str();
+    }
+
+  private:
+    std::uint64_t hash_;
+  };
+
+  /**
+   * \brief add the geometry and conductivities of a volume conductor to a fingerprint
+   *
+   * This includes the vertex coordinates, the element to vertex relation, the element labels and
+   * the tensors of all labels in use.
+   */
+  template <class VC>
+  void addVolumeConductor(Fingerprint& fingerprint, const VC& volumeConductor)
+  {
+    const auto& gridView = volumeConductor.gridView();
+    const auto& indexSet = gridView.indexSet();
+    const int dim = VC::GridView::dimension;
+    fingerprint.add(gridView.size(dim));
+    for (const auto& vertex : vertices(gridView)) {
+      fingerprint.add(indexSet.index(vertex));
+      fingerprint.add(vertex.geometry().center());
+    }
+    fingerprint.add(gridView.size(0));
+    std::map<std::size_t, typename VC::TensorType> tensors;
+    for (const auto& element : elements(gridView)) {
+      for (unsigned int i = 0; i < element.subEntities(dim); ++i) {
+        fingerprint.add(indexSet.subIndex(element, i, dim));
+      }
+      auto label = volumeConductor.label(element);
+      fingerprint.add(label);
+      tensors.emplace(label, volumeConductor.tensor(element));
+    }
+    for (const auto& entry : tensors) {
+      fingerprint.add(entry.first);
+      fingerprint.add(entry.second);
+    }
+    // the user visible vertex ids determine the column order of the transfer matrices
+    fingerprint.add(volumeConductor.vertexIds());
+  }
+}
+
+#endif // DUNEURO_FINGERPRINT_HH
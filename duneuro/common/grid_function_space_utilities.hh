@@ -1,6 +1,10 @@
 #ifndef DUNEURO_GRID_FUNCTION_SPACE_UTILITIES_HH
 #define DUNEURO_GRID_FUNCTION_SPACE_UTILITIES_HH
 
+#include <dune/common/exceptions.hh>
+
+#include <dune/pdelab/gridfunctionspace/lfsindexcache.hh>
+#include <dune/pdelab/gridfunctionspace/localfunctionspace.hh>
 #include <dune/pdelab/gridfunctionspace/powergridfunctionspace.hh>
 
 namespace duneuro
@@ -63,6 +67,40 @@ namespace duneuro
     return std::make_shared<Dune::PDELab::PowerGridFunctionSpace<GFS, 6, Backend, OrderingTag>>(
         *(gfss[0]), *(gfss[1]), *(gfss[2]), *(gfss[3]), *(gfss[4]), *(gfss[5]), backend, tag);
   }
+
+  /**
+   * \brief check that the degrees of freedom of a scalar function space are the vertex indices
+   *
+   * Kernels working directly on the mesh use the vertex index of the grid view as the index of
+   * the degree of freedom. Throws if the function space does not have one degree of freedom per
+   * vertex or if the indices on the first element do not coincide with the vertex indices.
+   */
+  template <class GFS>
+  void check_vertex_dof_ordering(const GFS& gfs)
+  {
+    const auto& gv = gfs.gridView();
+    enum { dim = GFS::Traits::GridViewType::dimension };
+    if (gfs.globalSize() != static_cast<std::size_t>(gv.size(dim))) {
+      DUNE_THROW(Dune::Exception, "expected one degree of freedom per vertex, but the function "
+                                  "space has "
+                                      << gfs.globalSize() << " for " << gv.size(dim)
+                                      << " vertices");
+    }
+    if (gv.size(0) == 0) {
+      return;
+    }
+    using LFS = Dune::PDELab::LocalFunctionSpace<GFS>;
+    LFS lfs(gfs);
+    Dune::PDELab::LFSIndexCache<LFS> cache(lfs);
+    const auto& element = *gv.template begin<0>();
+    lfs.bind(element);
+    cache.update();
+    for (unsigned int i = 0; i < cache.size(); ++i) {
+      if (cache.containerIndex(i)[0] != gv.indexSet().subIndex(element, i, dim)) {
+        DUNE_THROW(Dune::Exception, "the degrees of freedom are not ordered like the vertices");
+      }
+    }
+  }
 }
 
 #endif // DUNEURO_GRID_FUNCTION_SPACE_UTILITIES_HH
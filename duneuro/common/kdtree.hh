@@ -1,9 +1,19 @@
 #ifndef DUNEURO_KDTREE_HH
 #define DUNEURO_KDTREE_HH
 
-#include <memory>
+#if HAVE_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
 
-#include <dune/common/float_cmp.hh>
 #include <dune/common/fvector.hh>
 
 #include <dune/grid/common/rangegenerators.hh>
@@ -14,98 +24,105 @@ namespace duneuro
 {
   namespace KDTreeDetail
   {
-    // simple node in the kd tree. The axis is determined by depth % dim
-    struct Node {
-      std::size_t location;
-      std::unique_ptr<Node> left;
-      std::unique_ptr<Node> right;
-    };
-
-    // print the sub tree at the given node
-    static inline void print(const Node& node, const std::string& prefix = "")
+    // Reorder the points in [low, high) such that the median with respect to the axis
+    // depth % dim is located at (low + high) / 2, all points left of it are not larger and all
+    // points right of it are not smaller along this axis. The subtrees are then constructed
+    // recursively. The tree is thus stored implicitly in the point array: the node of a range is
+    // its middle element, the children are the ranges left and right of it.
+    template <class T, int dim>
+    void construct(std::vector<Dune::FieldVector<T, dim>>& points, std::vector<std::size_t>& order,
+                   std::size_t low, std::size_t high, unsigned int depth)
     {
-      std::cout << prefix << node.location << "\n";
-      if (node.left)
-        print(*node.left, prefix + " ");
-      else
-        std::cout << prefix << " None\n";
-      if (node.right)
-        print(*node.right, prefix + " ");
-      else
-        std::cout << prefix << " None\n";
+      if (high - low <= 1) {
+        return;
+      }
+      const unsigned int axis = depth % dim;
+      const std::size_t mid = (low + high) / 2;
+      std::nth_element(order.begin() + low, order.begin() + mid, order.begin() + high,
+                       [&points, axis](std::size_t a, std::size_t b) {
+                         return points[a][axis] < points[b][axis];
+                       });
+      construct(points, order, low, mid, depth + 1);
+      construct(points, order, mid + 1, high, depth + 1);
     }
 
-    // compare field vectors their coordinate of a given axis
-    struct AxisComparator {
-      unsigned int axis;
-
-      template <class T, int dim>
-      bool operator()(const Dune::FieldVector<T, dim>& a, const Dune::FieldVector<T, dim>& b) const
-      {
-        return Dune::FloatCmp::lt(a[axis], b[axis]);
+    // find the point closest to x within the subtree given by [low, high)
+    template <class T, int dim>
+    void nearest(const std::vector<Dune::FieldVector<T, dim>>& points, std::size_t low,
+                 std::size_t high, unsigned int depth, const Dune::FieldVector<T, dim>& x,
+                 std::size_t& best, T& bestDistance)
+    {
+      if (low >= high) {
+        return;
       }
-
-      template <class T, int dim, class D>
-      bool operator()(const std::pair<Dune::FieldVector<T, dim>, D>& a,
-                      const std::pair<Dune::FieldVector<T, dim>, D>& b) const
-      {
-        return Dune::FloatCmp::lt(a.first[axis], b.first[axis]);
+      const unsigned int axis = depth % dim;
+      const std::size_t mid = (low + high) / 2;
+      const T distance = (points[mid] - x).two_norm2();
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        best = mid;
       }
-    };
-
-    // construct the kd-tree at the given depth representing a given interval
-    template <class T, int dim, class D>
-    std::unique_ptr<Node> construct(std::vector<std::pair<Dune::FieldVector<T, dim>, D>>& points,
-                                    std::size_t low, std::size_t high, unsigned int depth)
-    {
-      AxisComparator comparator{depth % dim};
-
-      // sort elements such that all elements lower than pivot are left and the others right of
-      // pivot
-      std::size_t pivot = (low + high) / 2;
-      std::swap(points[pivot], points[high]);
-      std::size_t store = low;
-      for (std::size_t i = low; i < high; ++i) {
-        if (comparator(points[i], points[high])) {
-          std::swap(points[i], points[store]);
-          ++store;
+      const T diff = x[axis] - points[mid][axis];
+      // descend into the half containing x first. The other half only has to be checked if it
+      // might contain a closer point, which is decided using the distance found in the first half
+      if (diff < 0) {
+        nearest(points, low, mid, depth + 1, x, best, bestDistance);
+        if (diff * diff < bestDistance) {
+          nearest(points, mid + 1, high, depth + 1, x, best, bestDistance);
+        }
+      } else {
+        nearest(points, mid + 1, high, depth + 1, x, best, bestDistance);
+        if (diff * diff < bestDistance) {
+          nearest(points, low, mid, depth + 1, x, best, bestDistance);
         }
       }
-      std::swap(points[high], points[store]);
+    }
 
-      // construct node for the pivot element and create its subtrees if necessary
-      auto node = std::make_unique<Node>();
-      node->location = store;
-      if (low < store) {
-        node->left = construct(points, low, store - 1, depth + 1);
-      }
-      if (store < high) {
-        node->right = construct(points, store + 1, high, depth + 1);
+    // print the sub tree given by [low, high)
+    template <class T, int dim>
+    void print(const std::vector<Dune::FieldVector<T, dim>>& points, std::size_t low,
+               std::size_t high, const std::string& prefix = "")
+    {
+      if (low >= high) {
+        std::cout << prefix << "None\n";
+        return;
       }
-      return node;
+      const std::size_t mid = (low + high) / 2;
+      std::cout << prefix << mid << "\n";
+      print(points, low, mid, prefix + " ");
+      print(points, mid + 1, high, prefix + " ");
     }
 
-    // find an element which is close to the element containing x
-    template <class T, int dim, class D>
-    std::size_t find(const Node& node,
-                     const std::vector<std::pair<Dune::FieldVector<T, dim>, D>>& points,
-                     const Dune::FieldVector<T, dim>& x, unsigned int depth)
+    // interleave the bits of the quantized coordinates, i.e. compute the position of x on a
+    // z-order curve through the bounding box [lower, upper]
+    template <class T, int dim>
+    std::uint64_t mortonCode(const Dune::FieldVector<T, dim>& x,
+                             const Dune::FieldVector<T, dim>& lower,
+                             const Dune::FieldVector<T, dim>& upper)
     {
-      // we do not check back up the tree since we are only interested in an approximate nearest
-      // neighbor
-      if (AxisComparator{depth % dim}(x, points[node.location].first)) {
-        if (node.left) {
-          return find(*node.left, points, x, depth + 1);
-        }
-      } else {
-        if (node.right) {
-          return find(*node.right, points, x, depth + 1);
+      const unsigned int bits = 63 / dim;
+      const std::uint64_t maxCell = (std::uint64_t(1) << bits) - 1;
+      std::uint64_t code = 0;
+      for (unsigned int d = 0; d < dim; ++d) {
+        T extent = upper[d] - lower[d];
+        T relative = extent > 0 ? (x[d] - lower[d]) / extent : T(0);
+        relative = std::min(std::max(relative, T(0)), T(1));
+        std::uint64_t cell = static_cast<std::uint64_t>(relative * maxCell);
+        for (unsigned int b = 0; b < bits; ++b) {
+          code |= ((cell >> b) & std::uint64_t(1)) << (b * dim + d);
         }
       }
-      return node.location;
+      return code;
     }
   }
 
+  /**
+   * \brief kd-tree of the element centers of a grid view
+   *
+   * The tree is stored implicitly in flat arrays of the element centers and seeds, no nodes are
+   * allocated. find performs an exact nearest neighbor search, i.e. it returns the element whose
+   * center is closest to the given point.
+   */
   template <class GV>
   class KDTree
   {
@@ -117,31 +134,45 @@ namespace duneuro
 
     explicit KDTree(const GV& gridView) : gridView_(gridView)
     {
+      std::vector<Coordinate> centers;
+      std::vector<ElementSeed> seeds;
       for (const auto& element : elements(gridView)) {
-        seeds_.emplace_back(element.geometry().center(), element.seed());
+        centers.push_back(element.geometry().center());
+        seeds.push_back(element.seed());
+      }
+      std::vector<std::size_t> order(centers.size());
+      std::iota(order.begin(), order.end(), 0);
+      KDTreeDetail::construct(centers, order, 0, order.size(), 0);
+      centers_.reserve(centers.size());
+      seeds_.reserve(seeds.size());
+      for (auto index : order) {
+        centers_.push_back(centers[index]);
+        seeds_.push_back(seeds[index]);
       }
-      root_ = KDTreeDetail::construct(seeds_, 0, seeds_.size() - 1, 0);
     }
 
     ElementSeed find(const Coordinate& x) const
     {
-      return seeds_[KDTreeDetail::find(*root_, seeds_, x, 0)].second;
+      std::size_t best = 0;
+      Real bestDistance = std::numeric_limits<Real>::max();
+      KDTreeDetail::nearest(centers_, 0, centers_.size(), 0, x, best, bestDistance);
+      return seeds_[best];
     }
 
     void print() const
     {
       std::cout << "points:\n";
-      for (unsigned int i = 0; i < seeds_.size(); ++i) {
-        std::cout << i << "  center: " << seeds_[i].first << "\n";
+      for (unsigned int i = 0; i < centers_.size(); ++i) {
+        std::cout << i << "  center: " << centers_[i] << "\n";
       }
       std::cout << "nodes:\n";
-      KDTreeDetail::print(*root_);
+      KDTreeDetail::print(centers_, 0, centers_.size());
     }
 
   private:
     GV gridView_;
-    std::vector<std::pair<Coordinate, ElementSeed>> seeds_;
-    std::unique_ptr<KDTreeDetail::Node> root_;
+    std::vector<Coordinate> centers_;
+    std::vector<ElementSeed> seeds_;
   };
 
   template <class GV>
@@ -162,7 +193,7 @@ namespace duneuro
 
     /** \brief find the entity containing global
      *
-     * The method first searches an entity which is close to the entity containing global. It then
+     * The method first searches the entity whose center is closest to global. It then
      * uses edgehopping for the rest of the way
      */
     Entity findEntity(const GlobalCoordinate& global) const
@@ -171,6 +202,47 @@ namespace duneuro
       return edgeHopping_.findEntity(global, gridView_.grid().entity(seed));
     }
 
+    /** \brief find the entities containing the given points
+     *
+     * The points are processed in the order of a space filling curve, so that subsequent
+     * searches traverse similar parts of the tree. If tbb is available, the searches are
+     * performed in parallel. The result is ordered as the given points.
+     */
+    std::vector<Entity> findEntities(const std::vector<GlobalCoordinate>& points) const
+    {
+      std::vector<Entity> result(points.size());
+      if (points.empty()) {
+        return result;
+      }
+      GlobalCoordinate lower = points[0];
+      GlobalCoordinate upper = points[0];
+      for (const auto& p : points) {
+        for (unsigned int d = 0; d < dim; ++d) {
+          lower[d] = std::min(lower[d], p[d]);
+          upper[d] = std::max(upper[d], p[d]);
+        }
+      }
+      std::vector<std::pair<std::uint64_t, std::size_t>> order(points.size());
+      for (std::size_t i = 0; i < points.size(); ++i) {
+        order[i] = {KDTreeDetail::mortonCode(points[i], lower, upper), i};
+      }
+      std::sort(order.begin(), order.end());
+#if HAVE_TBB
+      tbb::parallel_for(tbb::blocked_range<std::size_t>(0, order.size(), 64),
+                        [&](const tbb::blocked_range<std::size_t>& range) {
+                          for (std::size_t i = range.begin(); i != range.end(); ++i) {
+                            const auto index = order[i].second;
+                            result[index] = findEntity(points[index]);
+                          }
+                        });
+#else
+      for (const auto& entry : order) {
+        result[entry.second] = findEntity(points[entry.second]);
+      }
+#endif
+      return result;
+    }
+
   private:
     GV gridView_;
     EdgeHopping<GV> edgeHopping_;
@@ -1,10 +1,15 @@
 #ifndef DUNEURO_STATIONARYLINEARPROBLEM_HH
 #define DUNEURO_STATIONARYLINEARPROBLEM_HH
 
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 #include <dune/common/float_cmp.hh>
 #include <dune/common/parametertree.hh>
@@ -17,6 +22,8 @@
 #include <dune/pdelab/constraints/common/constraints.hh>
 #include <dune/pdelab/stationary/linearproblem.hh>
 
+#include <duneuro/common/mapped_sparse_matrix.hh>
+#include <duneuro/common/parallel_jacobian_assembler.hh>
 #include <duneuro/io/data_tree.hh>
 
 namespace duneuro
@@ -73,6 +80,37 @@ namespace duneuro
     struct IllegalEntryException : public Dune::Exception {
     };
 
+    // solver backends providing matrixFree(), residual(x, r) and apply(z, r, reduction) can solve
+    // without an assembled matrix
+    template <class LS, class = void>
+    struct IsMatrixFreeBackend : std::false_type {
+    };
+
+    template <class LS>
+    struct IsMatrixFreeBackend<LS, std::void_t<decltype(std::declval<const LS&>().matrixFree())>>
+        : std::true_type {
+    };
+
+    // solver backends providing report(dataTree) store additional information, e.g. about a
+    // direct solver
+    template <class LS, class = void>
+    struct HasBackendReport : std::false_type {
+    };
+
+    template <class LS>
+    struct HasBackendReport<
+        LS, std::void_t<decltype(std::declval<const LS&>().report(std::declval<DataTree>()))>>
+        : std::true_type {
+    };
+
+    template <class LS>
+    void reportBackend(const LS& ls, DataTree dataTree)
+    {
+      if constexpr (HasBackendReport<LS>::value) {
+        ls.report(dataTree.sub("solver_backend"));
+      }
+    }
+
     template <class T, int N, class F>
     void assertEachEntry(const Dune::BCRSMatrix<Dune::FieldMatrix<T, N, N>>& m, F predicate)
     {
@@ -166,6 +204,8 @@ namespace duneuro
      * keep_matrix                | true          | keep matrix between calls to apply() (but
      * reassemble values every time)
      * verbosity                  | 1             | control amount of debug output
+     * parallel_assembly          | false         | assemble the matrix using
+     * ParallelJacobianAssembler
      *
      * Apart from reduction, all parameters have a default value and are optional.
      * The actual reduction for a call to apply() is calculated as r =
@@ -178,9 +218,37 @@ namespace duneuro
         , _fixedDOFEntry(params.get<typename M::field_type>("fixedDOFEntry", 1.0))
         , _verbose(params.get<int>("verbosity", 1))
         , _debug(params.get<bool>("debug", false))
+        , _parallelAssembly(params.get<bool>("parallel_assembly", false))
     {
     }
 
+    using JacobianAssembler = std::function<std::unique_ptr<M>(DataTree)>;
+
+    /**
+     * \brief replace the assembly of the matrix by the grid operator
+     *
+     * The given function has to return the matrix of the grid operator. It is used instead of
+     * GO::jacobian, e.g. for specialized kernels. The first dof is still fixed by this class.
+     */
+    void setJacobianAssembler(JacobianAssembler assembler)
+    {
+      _jacobianAssembler = assembler;
+    }
+
+    /**
+     * \brief store the assembled matrix in the given file and reuse it in later runs
+     *
+     * If the file exists when the matrix is needed, the matrix is read from it instead of being
+     * assembled. Otherwise the assembled matrix is written to it. The matrix is stored before the
+     * first dof is fixed. The filename has to identify the grid operator and its data, e.g. by a
+     * fingerprint of the volume conductor and the solver configuration. An empty filename
+     * disables the cache.
+     */
+    void setJacobianCache(const std::string& filename)
+    {
+      _jacobianCache = filename;
+    }
+
     template <class LS>
     void apply(LS& ls, DV& x, const Dune::ParameterTree& config, DataTree dataTree = DataTree())
     {
@@ -195,38 +263,14 @@ namespace duneuro
     void apply(LS& ls, DV& x, const RV& rightHandSide, const Dune::ParameterTree& config,
                DataTree dataTree = DataTree())
     {
-      Dune::Timer timer(false);
-      {
-        std::lock_guard<std::mutex> lock(_jacobian_mutex);
-        if (!_jacobian) {
-          timer.start();
-          _jacobian = std::make_unique<M>(_go);
-          timer.stop();
-          if (_go.trialGridFunctionSpace().gridView().comm().rank() == 0 && _verbose >= 1)
-            std::cout << "=== matrix setup (max) " << timer.lastElapsed() << " s" << std::endl;
-          dataTree.set("time_matrix_setup", timer.lastElapsed());
-          timer.start();
-          (*_jacobian) = typename M::field_type(0.0);
-          _go.jacobian(x, *_jacobian);
-          if (_fixFirstDOF) {
-            TSSLPDetail::fixFirstDOF(Dune::PDELab::Backend::native(*_jacobian), _fixedDOFEntry);
-          }
-          if (_debug) {
-            TSSLPDetail::SymmetryStatistics<typename M::field_type> statistics(
-                Dune::PDELab::Backend::native(*_jacobian));
-            statistics.print();
-            try {
-              TSSLPDetail::assertEachEntry(Dune::PDELab::Backend::native(*_jacobian),
-                                           [](typename M::field_type v) { return !std::isnan(v); });
-            } catch (TSSLPDetail::IllegalEntryException& ex) {
-              std::cout << "Illegal entry found:\n" << ex.what() << "\n";
-            }
-            std::cout << Dune::PDELab::Backend::native(*_jacobian)[0][0] << "\n";
-          }
-          timer.stop();
-          dataTree.set("time_matrix_assembly", timer.lastElapsed());
+      if constexpr (TSSLPDetail::IsMatrixFreeBackend<LS>::value) {
+        if (ls.matrixFree()) {
+          applyMatrixFree(ls, x, rightHandSide, config, dataTree);
+          return;
         }
       }
+      Dune::Timer timer(false);
+      assembleJacobian(x, dataTree);
 
       // transform rhs to discrete residuum
       RV r(rightHandSide);
@@ -244,6 +288,7 @@ namespace duneuro
       dataTree.set("reduction", ls.result().reduction);
       dataTree.set("conv_rate", ls.result().conv_rate);
       dataTree.set("time_solution", timer.lastElapsed());
+      TSSLPDetail::reportBackend(ls, dataTree);
       // and update
       timer.start();
       x -= z;
@@ -251,6 +296,60 @@ namespace duneuro
       dataTree.set("time", timer.elapsed());
     }
 
+    /**
+     * \brief solve the linear system for several right hand sides at once
+     *
+     * The block solver backend ls has to provide an apply method taking vectors of solutions and
+     * right hand sides, e.g. ISTLBackend_SEQ_BlockCG_AMG_SSOR. The given solutions are used as
+     * initial guesses.
+     */
+    template <class LS>
+    void applyBlock(LS& ls, std::vector<DV>& x, const std::vector<RV>& rightHandSides,
+                    const Dune::ParameterTree& config, DataTree dataTree = DataTree())
+    {
+      if (x.size() != rightHandSides.size()) {
+        DUNE_THROW(Dune::Exception, "number of solutions (" << x.size()
+                                                            << ") does not match number of right "
+                                                               "hand sides ("
+                                                            << rightHandSides.size() << ")");
+      }
+      if (x.size() == 0) {
+        return;
+      }
+      Dune::Timer timer(false);
+      assembleJacobian(x[0], dataTree);
+
+      // transform rhs to discrete residua
+      std::vector<RV> r(rightHandSides);
+      for (std::size_t j = 0; j < r.size(); ++j) {
+        Dune::PDELab::Backend::native(*_jacobian)
+            .mmv(Dune::PDELab::Backend::native(x[j]), Dune::PDELab::Backend::native(r[j]));
+        r[j] *= -1.0;
+      }
+      // compute corrections
+      timer.start();
+      std::vector<DV> z(x.size(), DV(_go.trialGridFunctionSpace(), 0.0));
+      ls.apply(*_jacobian, z, r, config.get<typename RV::ElementType>("reduction"));
+      timer.stop();
+      const auto& result = ls.result();
+      dataTree.set("block_size", x.size());
+      dataTree.set("iterations", result.iterations);
+      dataTree.set("converged", result.converged);
+      dataTree.set("reduction", result.reduction);
+      for (std::size_t j = 0; j < result.columnIterations.size(); ++j) {
+        dataTree.set("iterations_column_" + std::to_string(j), result.columnIterations[j]);
+      }
+      dataTree.set("time_solution", timer.lastElapsed());
+      TSSLPDetail::reportBackend(ls, dataTree);
+      // and update
+      timer.start();
+      for (std::size_t j = 0; j < x.size(); ++j) {
+        x[j] -= z[j];
+      }
+      timer.stop();
+      dataTree.set("time", timer.elapsed());
+    }
+
     //! Discard the stored Jacobian matrix.
     void discardMatrix()
     {
@@ -260,6 +359,138 @@ namespace duneuro
     }
 
   private:
+    template <class LS>
+    void applyMatrixFree(LS& ls, DV& x, const RV& rightHandSide,
+                         const Dune::ParameterTree& config, DataTree dataTree)
+    {
+      Dune::Timer timer(false);
+      // r = b - A x
+      RV r(rightHandSide);
+      ls.residual(x, r);
+      timer.start();
+      DV z(_go.trialGridFunctionSpace(), 0.0);
+      ls.apply(z, r, config.get<typename RV::ElementType>("reduction"));
+      timer.stop();
+      dataTree.set("iterations", ls.result().iterations);
+      dataTree.set("reduction", ls.result().reduction);
+      dataTree.set("conv_rate", ls.result().conv_rate);
+      dataTree.set("time_solution", timer.lastElapsed());
+      timer.start();
+      x += z;
+      timer.stop();
+      dataTree.set("time", timer.elapsed());
+    }
+
+    bool readJacobianCache(DataTree dataTree)
+    {
+      if (_jacobianCache.empty()) {
+        return false;
+      }
+      dataTree.set("filename", _jacobianCache);
+      if (!std::ifstream(_jacobianCache).good()) {
+        dataTree.set("hit", false);
+        return false;
+      }
+      if constexpr (IsPDELabGridOperator<GO>::value) {
+        Dune::Timer timer;
+        auto container = read_mapped_sparse_matrix<Dune::PDELab::Backend::Native<M>>(
+            _jacobianCache);
+        const auto& gfs = _go.trialGridFunctionSpace();
+        if (container->N() != gfs.globalSize() || container->M() != gfs.globalSize()) {
+          DUNE_THROW(Dune::Exception, "matrix in " << _jacobianCache << " has size "
+                                                   << container->N() << "x" << container->M()
+                                                   << ", but the function space has "
+                                                   << gfs.globalSize() << " dofs");
+        }
+        _jacobian = std::make_unique<M>();
+        _jacobian->attach(container);
+        dataTree.set("hit", true);
+        dataTree.set("time_read", timer.elapsed());
+        if (_go.trialGridFunctionSpace().gridView().comm().rank() == 0 && _verbose >= 1)
+          std::cout << "=== matrix read from " << _jacobianCache << " " << timer.elapsed()
+                    << " s" << std::endl;
+        return true;
+      } else {
+        DUNE_THROW(Dune::NotImplemented,
+                   "the jacobian cache is only available for pdelab grid operators");
+      }
+    }
+
+    void writeJacobianCache(DataTree dataTree)
+    {
+      if (_jacobianCache.empty()) {
+        return;
+      }
+      Dune::Timer timer;
+      write_mapped_sparse_matrix(_jacobianCache, Dune::PDELab::Backend::native(*_jacobian));
+      dataTree.set("time_write", timer.elapsed());
+    }
+
+    // the matrix is assembled by the first call, which may happen within a parallel loop over
+    // several solves. Assemblers running parallel loops themselves have to isolate them, see
+    // ElementNeighborhoodMapDetail::isolate, as this thread holds the lock while waiting.
+    void assembleJacobian(const DV& x, DataTree dataTree)
+    {
+      Dune::Timer timer(false);
+      {
+        std::lock_guard<std::mutex> lock(_jacobian_mutex);
+        if (!_jacobian) {
+          auto cacheTree = dataTree.sub("jacobian_cache");
+          if (!readJacobianCache(cacheTree)) {
+            if (_jacobianAssembler) {
+              timer.start();
+              _jacobian = _jacobianAssembler(dataTree.sub("jacobian_assembler"));
+              timer.stop();
+              if (_go.trialGridFunctionSpace().gridView().comm().rank() == 0 && _verbose >= 1)
+                std::cout << "=== specialized matrix setup and assembly " << timer.lastElapsed()
+                          << " s" << std::endl;
+            } else if (_parallelAssembly) {
+              if constexpr (IsPDELabGridOperator<GO>::value) {
+                timer.start();
+                _jacobian = ParallelJacobianAssembler<GO>(_go).assemble(
+                    x, dataTree.sub("parallel_assembly"));
+                timer.stop();
+                if (_go.trialGridFunctionSpace().gridView().comm().rank() == 0 && _verbose >= 1)
+                  std::cout << "=== parallel matrix setup and assembly " << timer.lastElapsed()
+                            << " s" << std::endl;
+              } else {
+                DUNE_THROW(Dune::NotImplemented,
+                           "parallel assembly is only available for pdelab grid operators");
+              }
+            } else {
+              timer.start();
+              _jacobian = std::make_unique<M>(_go);
+              timer.stop();
+              if (_go.trialGridFunctionSpace().gridView().comm().rank() == 0 && _verbose >= 1)
+                std::cout << "=== matrix setup (max) " << timer.lastElapsed() << " s" << std::endl;
+              dataTree.set("time_matrix_setup", timer.lastElapsed());
+              timer.start();
+              (*_jacobian) = typename M::field_type(0.0);
+              _go.jacobian(x, *_jacobian);
+            }
+            writeJacobianCache(cacheTree);
+          }
+          if (_fixFirstDOF) {
+            TSSLPDetail::fixFirstDOF(Dune::PDELab::Backend::native(*_jacobian), _fixedDOFEntry);
+          }
+          if (_debug) {
+            TSSLPDetail::SymmetryStatistics<typename M::field_type> statistics(
+                Dune::PDELab::Backend::native(*_jacobian));
+            statistics.print();
+            try {
+              TSSLPDetail::assertEachEntry(Dune::PDELab::Backend::native(*_jacobian),
+                                           [](typename M::field_type v) { return !std::isnan(v); });
+            } catch (TSSLPDetail::IllegalEntryException& ex) {
+              std::cout << "Illegal entry found:\n" << ex.what() << "\n";
+            }
+            std::cout << Dune::PDELab::Backend::native(*_jacobian)[0][0] << "\n";
+          }
+          timer.stop();
+          dataTree.set("time_matrix_assembly", timer.lastElapsed());
+        }
+      }
+    }
+
     std::mutex _jacobian_mutex;
     const GO& _go;
     std::unique_ptr<M> _jacobian;
@@ -268,6 +499,9 @@ namespace duneuro
     Result _res;
     int _verbose;
     bool _debug;
+    bool _parallelAssembly = false;
+    JacobianAssembler _jacobianAssembler;
+    std::string _jacobianCache;
   };
 }
 
@@ -0,0 +1,483 @@
+#ifndef DUNEURO_LOW_RANK_DENSE_MATRIX_HH
+#define DUNEURO_LOW_RANK_DENSE_MATRIX_HH
+
+#if HAVE_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parametertree.hh>
+#include <dune/common/timer.hh>
+
+#include <dune/istl/bvector.hh>
+
+#include <duneuro/common/dense_matrix.hh>
+#include <duneuro/common/mapped_dense_matrix.hh>
+#include <duneuro/common/matrix_utilities.hh>
+#include <duneuro/common/sparse_vector_container.hh>
+#include <duneuro/common/symmetric_eigen_decomposition.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief rows x cols matrix stored as the product U V of a rows x rank matrix U with
+   * orthonormal columns and a rank x cols matrix V
+   *
+   * The product with a vector x is computed as U (V x), which only touches rank instead of rows
+   * entries per column. The matrices are created by make_low_rank_approximation.
+   */
+  class LowRankDenseMatrix
+  {
+  public:
+    LowRankDenseMatrix(std::unique_ptr<DenseMatrix<double>> u,
+                       std::unique_ptr<DenseMatrix<double>> v)
+        : u_(std::move(u)), v_(std::move(v))
+    {
+      if (u_->cols() != v_->rows()) {
+        DUNE_THROW(Dune::Exception, "the factors of a low rank matrix do not match: "
+                                        << u_->cols() << " columns of U, " << v_->rows()
+                                        << " rows of V");
+      }
+    }
+
+    std::size_t rows() const
+    {
+      return u_->rows();
+    }
+
+    std::size_t cols() const
+    {
+      return v_->cols();
+    }
+
+    std::size_t rank() const
+    {
+      return u_->cols();
+    }
+
+    //! key of the selection of columns, stored by V, see DenseMatrix::columnKey
+    std::uint64_t columnKey() const
+    {
+      return v_->columnKey();
+    }
+
+    void setColumnKey(std::uint64_t key)
+    {
+      v_->setColumnKey(key);
+    }
+
+    const DenseMatrix<double>& u() const
+    {
+      return *u_;
+    }
+
+    const DenseMatrix<double>& v() const
+    {
+      return *v_;
+    }
+
+    DenseMatrix<double>& v()
+    {
+      return *v_;
+    }
+
+    //! memory used by both factors in bytes
+    std::size_t memory() const
+    {
+      return (rows() + cols()) * rank() * sizeof(double);
+    }
+
+    double operator()(std::size_t r, std::size_t c) const
+    {
+      double sum = 0.0;
+      for (std::size_t i = 0; i < rank(); ++i) {
+        sum += (*u_)(r, i) * (*v_)(i, c);
+      }
+      return sum;
+    }
+
+    //! compute U y for the given vector y of size rank()
+    std::vector<double> expand(const std::vector<double>& y) const
+    {
+      std::vector<double> output(rows(), 0.0);
+      for (std::size_t r = 0; r < rows(); ++r) {
+        for (std::size_t i = 0; i < rank(); ++i) {
+          output[r] += (*u_)(r, i) * y[i];
+        }
+      }
+      return output;
+    }
+
+  private:
+    std::unique_ptr<DenseMatrix<double>> u_;
+    std::unique_ptr<DenseMatrix<double>> v_;
+  };
+
+  namespace LowRankDetail
+  {
+    // strides of a dense matrix, entry (r, c) is data()[r * row + c * col]
+    struct Strides {
+      std::size_t row;
+      std::size_t col;
+    };
+
+    inline Strides strides(const DenseMatrix<double>& matrix)
+    {
+      if (matrix.rowMajor()) {
+        return {matrix.cols(), 1};
+      }
+      return {1, matrix.rows()};
+    }
+
+    // call f(block, begin, end, local) for the blocks [begin, end) of columns. local is a thread
+    // local accumulator, which is initialized with init. The sum over all threads is returned.
+    template <class F>
+    std::vector<double> forEachColumnBlock(std::size_t cols, const Dune::ParameterTree& config,
+                                           const std::vector<double>& init, F&& f)
+    {
+      const std::size_t blockSize = config.get<std::size_t>("block_size", 1024);
+      const std::size_t numberOfBlocks = (cols + blockSize - 1) / blockSize;
+      auto block = [&](std::size_t b, std::vector<double>& local) {
+        f(b, b * blockSize, std::min(cols, (b + 1) * blockSize), local);
+      };
+#if HAVE_TBB
+      tbb::enumerable_thread_specific<std::vector<double>> locals(init);
+      int nr_threads = config.hasKey("numberOfThreads") ? config.get<int>("numberOfThreads")
+                                                        : tbb::task_arena::automatic;
+      tbb::task_arena arena(nr_threads);
+      arena.execute([&] {
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, numberOfBlocks, 1),
+                          [&](const tbb::blocked_range<std::size_t>& range) {
+                            auto& local = locals.local();
+                            for (std::size_t b = range.begin(); b != range.end(); ++b) {
+                              block(b, local);
+                            }
+                          });
+      });
+      std::vector<double> result(init);
+      for (const auto& local : locals) {
+        for (std::size_t i = 0; i < result.size(); ++i) {
+          result[i] += local[i] - init[i];
+        }
+      }
+      return result;
+#else
+      std::vector<double> result(init);
+      for (std::size_t b = 0; b < numberOfBlocks; ++b) {
+        block(b, result);
+      }
+      return result;
+#endif
+    }
+
+    // the columns of a dense matrix starting at begin, as operand of dense_block_product: the
+    // block is data, stored column major with leading dimension ld, or its transpose if
+    // transposed is set, as a row major matrix is the transpose of a column major one
+    struct ColumnBlock {
+      const double* data;
+      std::size_t ld;
+      bool transposed;
+    };
+
+    inline ColumnBlock columnBlock(const DenseMatrix<double>& matrix, std::size_t begin)
+    {
+      if (matrix.rowMajor()) {
+        return {matrix.data() + begin, matrix.cols(), true};
+      }
+      return {matrix.data() + begin * matrix.rows(), matrix.rows(), false};
+    }
+
+    // compute A Omega for a gaussian random cols x l matrix Omega, which is generated block by
+    // block from the given seed and never stored. The result (rows x l, column major) is followed
+    // by the squared frobenius norm of A.
+    inline std::vector<double> sketch(const DenseMatrix<double>& a, std::size_t l,
+                                      unsigned int seed, const Dune::ParameterTree& config)
+    {
+      const std::size_t m = a.rows();
+      const auto s = strides(a);
+      const double* data = a.data();
+      return forEachColumnBlock(
+          a.cols(), config, std::vector<double>(m * l + 1, 0.0),
+          [&](std::size_t b, std::size_t begin, std::size_t end, std::vector<double>& y) {
+            const std::size_t w = end - begin;
+            std::mt19937 generator(seed + 7919 * b);
+            std::normal_distribution<double> normal;
+            std::vector<double> omega(w * l);
+            for (auto& value : omega) {
+              value = normal(generator);
+            }
+            const auto block = columnBlock(a, begin);
+            dense_block_product(block.transposed, false, m, l, w, block.data, block.ld,
+                                omega.data(), w, 1.0, y.data(), m);
+            double normSquared = 0.0;
+            for (std::size_t r = 0; r < m; ++r) {
+              for (std::size_t c = begin; c < end; ++c) {
+                const double value = data[r * s.row + c * s.col];
+                normSquared += value * value;
+              }
+            }
+            y[m * l] += normSquared;
+          });
+    }
+
+    // compute A A^T X for a rows x l matrix X (column major) without storing A^T X
+    inline std::vector<double> gram(const DenseMatrix<double>& a, const std::vector<double>& x,
+                                    std::size_t l, const Dune::ParameterTree& config)
+    {
+      const std::size_t m = a.rows();
+      return forEachColumnBlock(
+          a.cols(), config, std::vector<double>(m * l, 0.0),
+          [&](std::size_t, std::size_t begin, std::size_t end, std::vector<double>& y) {
+            const std::size_t w = end - begin;
+            const auto block = columnBlock(a, begin);
+            // Z = A(:, begin:end)^T X, Y += A(:, begin:end) Z
+            std::vector<double> z(w * l);
+            dense_block_product(!block.transposed, false, w, l, m, block.data, block.ld, x.data(),
+                                m, 0.0, z.data(), w);
+            dense_block_product(block.transposed, false, m, l, w, block.data, block.ld, z.data(),
+                                w, 1.0, y.data(), m);
+          });
+    }
+
+    // append the columns of the rows x l matrix y (column major) to the orthonormal basis q of k
+    // columns (column major). The bulk of y is removed by one block classical gram schmidt step
+    // against q, then each column is orthogonalized against all columns of the basis, including
+    // the ones appended before, by two passes of modified gram schmidt. Columns which are
+    // numerically dependent are dropped. Returns the number of appended columns.
+    inline std::size_t extendBasis(std::vector<double>& q, std::size_t k, std::size_t m,
+                                   std::vector<double> y, std::size_t l)
+    {
+      double maxNorm = 0.0;
+      for (std::size_t j = 0; j < l; ++j) {
+        double norm = 0.0;
+        for (std::size_t r = 0; r < m; ++r) {
+          norm += y[j * m + r] * y[j * m + r];
+        }
+        maxNorm = std::max(maxNorm, std::sqrt(norm));
+      }
+      if (k > 0) {
+        // W = -Q^T Y, Y += Q W
+        std::vector<double> w(k * l);
+        dense_block_product(true, false, k, l, m, q.data(), m, y.data(), m, 0.0, w.data(), k);
+        for (auto& value : w) {
+          value = -value;
+        }
+        dense_block_product(false, false, m, l, k, q.data(), m, w.data(), k, 1.0, y.data(), m);
+      }
+      q.reserve(q.size() + m * l);
+      std::size_t appended = 0;
+      for (std::size_t j = 0; j < l; ++j) {
+        double* v = y.data() + j * m;
+        for (unsigned int pass = 0; pass < 2; ++pass) {
+          for (std::size_t i = 0; i < k + appended; ++i) {
+            const double* qi = q.data() + i * m;
+            double dot = 0.0;
+            for (std::size_t r = 0; r < m; ++r) {
+              dot += qi[r] * v[r];
+            }
+            for (std::size_t r = 0; r < m; ++r) {
+              v[r] -= dot * qi[r];
+            }
+          }
+        }
+        double norm = 0.0;
+        for (std::size_t r = 0; r < m; ++r) {
+          norm += v[r] * v[r];
+        }
+        norm = std::sqrt(norm);
+        if (norm <= 1e-12 * maxNorm || norm == 0.0) {
+          continue;
+        }
+        for (std::size_t r = 0; r < m; ++r) {
+          q.push_back(v[r] / norm);
+        }
+        ++appended;
+      }
+      return appended;
+    }
+  }
+
+  /**
+   * \brief compute a low rank approximation of a dense matrix using a randomized svd
+   *
+   * The range of A is sampled by Y = (A A^T)^q A Omega for a gaussian random matrix Omega with
+   * rank + oversampling columns and q = power_iterations. With an orthonormal basis Q of Y and
+   * the eigen decomposition Q^T A A^T Q = P S^2 P^T, the approximation is U V with U = Q P_k and
+   * V = U^T A, where P_k contains the eigenvectors of the k largest eigenvalues. The rank k is
+   * the smallest one for which the relative error in the frobenius norm, which is computed
+   * exactly as sqrt(|A|^2 - sum_{i<=k} s_i^2) / |A|, does not exceed the given tolerance. If the
+   * sample is too small to reach the tolerance, it is doubled, up to the number of rows of A:
+   * only the new samples are drawn, orthogonalized against Q and appended to it, and A A^T Q is
+   * only computed for the new columns of Q.
+   *
+   * A is only accessed in blocks of block_size columns, each pass over A is parallelized with
+   * tbb, and Omega and A^T Q are never stored. The products with the blocks of A are computed by
+   * dense_block_product, i.e. by dgemm if duneuro has been configured with blas. U is stored
+   * column major, V is created by make_dense_matrix from config.sub("storage"). Config keys:
+   * tolerance, initial_rank (default 32), oversampling (default 10), power_iterations
+   * (default 1), seed (default 0), block_size (default 1024), numberOfThreads.
+   */
+  inline std::unique_ptr<LowRankDenseMatrix>
+  make_low_rank_approximation(const DenseMatrix<double>& a, const Dune::ParameterTree& config,
+                              DataTree dataTree = DataTree())
+  {
+    using namespace LowRankDetail;
+    Dune::Timer timer;
+    const double tolerance = config.get<double>("tolerance");
+    const std::size_t oversampling = config.get<std::size_t>("oversampling", 10);
+    const unsigned int powerIterations = config.get<unsigned int>("power_iterations", 1);
+    const unsigned int seed = config.get<unsigned int>("seed", 0);
+    const std::size_t m = a.rows();
+    std::size_t newSamples =
+        std::min(m, config.get<std::size_t>("initial_rank", 32) + oversampling);
+
+    // orthonormal basis Q of the sampled range and A A^T Q, both column major
+    std::vector<double> q, g;
+    std::vector<double> eigenvalues, eigenvectors;
+    std::size_t sampleSize = 0;
+    std::size_t l = 0;
+    std::size_t rank = 0;
+    double normSquared = 0.0;
+    double errorSquared = 0.0;
+    unsigned int passes = 0;
+    for (unsigned int round = 0;; ++round) {
+      // new samples of the range, independent of the ones of the previous rounds
+      auto y = sketch(a, newSamples, seed + 104729 * round, config);
+      if (round == 0) {
+        normSquared = y.back();
+      }
+      y.pop_back();
+      ++passes;
+      std::size_t columns = newSamples;
+      for (unsigned int i = 0; i < powerIterations; ++i) {
+        std::vector<double> basis;
+        columns = extendBasis(basis, 0, m, std::move(y), columns);
+        y = gram(a, basis, columns, config);
+        ++passes;
+      }
+      sampleSize += newSamples;
+      const std::size_t added = extendBasis(q, l, m, std::move(y), columns);
+      if (added > 0) {
+        const std::vector<double> newBasis(q.begin() + l * m, q.end());
+        const auto newGram = gram(a, newBasis, added, config);
+        g.insert(g.end(), newGram.begin(), newGram.end());
+        ++passes;
+        l += added;
+      }
+      // Q^T A A^T Q and its eigen decomposition
+      std::vector<double> c(l * l);
+      dense_block_product(true, false, l, l, m, q.data(), m, g.data(), m, 0.0, c.data(), l);
+      for (std::size_t i = 0; i < l; ++i) {
+        for (std::size_t j = i + 1; j < l; ++j) {
+          c[i * l + j] = c[j * l + i] = 0.5 * (c[i * l + j] + c[j * l + i]);
+        }
+      }
+      symmetric_eigen_decomposition(c, l, eigenvalues, eigenvectors);
+      // eigenvalues are ascending, find the smallest rank reaching the tolerance
+      const double allowed = tolerance * tolerance * normSquared;
+      errorSquared = normSquared;
+      rank = 0;
+      while (rank < l && errorSquared > allowed) {
+        errorSquared -= std::max(0.0, eigenvalues[l - 1 - rank]);
+        ++rank;
+      }
+      if (errorSquared <= allowed || sampleSize >= m || l >= m) {
+        break;
+      }
+      newSamples = std::min(m - sampleSize, sampleSize);
+    }
+
+    // U = Q P_k, columns ordered by descending singular values
+    std::vector<double> p(l * rank);
+    for (std::size_t i = 0; i < rank; ++i) {
+      for (std::size_t j = 0; j < l; ++j) {
+        p[i * l + j] = eigenvectors[j * l + (l - 1 - i)];
+      }
+    }
+    auto u = std::make_unique<DenseMatrix<double>>(m, rank, 0.0, DenseMatrixLayout::columnMajor);
+    dense_block_product(false, false, m, rank, l, q.data(), m, p.data(), l, 0.0, u->data(), m);
+    // V = U^T A, written block by block. V is row major, so its block is the transpose of a
+    // column major block and V(:, begin:end)^T = A(:, begin:end)^T U is computed instead
+    auto v = make_dense_matrix<double>(
+        rank, a.cols(), config.hasSub("storage") ? config.sub("storage") : Dune::ParameterTree());
+    {
+      const double* uData = u->data();
+      double* vData = v->data();
+      const std::size_t cols = a.cols();
+      auto project = [&](std::size_t, std::size_t begin, std::size_t end, std::vector<double>&) {
+        const auto block = columnBlock(a, begin);
+        dense_block_product(!block.transposed, false, end - begin, rank, m, block.data, block.ld,
+                            uData, m, 0.0, vData + begin, cols);
+      };
+      forEachColumnBlock(a.cols(), config, std::vector<double>(), project);
+      ++passes;
+    }
+    v->setColumnKey(a.columnKey());
+    auto result = std::make_unique<LowRankDenseMatrix>(std::move(u), std::move(v));
+    dataTree.set("rank", rank);
+    dataTree.set("sample_size", sampleSize);
+    dataTree.set("passes", passes);
+    dataTree.set("relative_error",
+                 normSquared > 0.0 ? std::sqrt(std::max(0.0, errorSquared) / normSquared) : 0.0);
+    dataTree.set("memory", result->memory());
+    dataTree.set("memory_uncompressed", a.rows() * a.cols() * sizeof(double));
+    dataTree.set("time", timer.elapsed());
+    return result;
+  }
+
+  template <int blockSize>
+  std::vector<double>
+  matrix_dense_vector_product(const LowRankDenseMatrix& matrix,
+                              const Dune::BlockVector<Dune::FieldVector<double, blockSize>>& vector)
+  {
+    return matrix.expand(matrix_dense_vector_product(matrix.v(), vector));
+  }
+
+  inline void matrix_dense_panel_product(const LowRankDenseMatrix& matrix, const double* panel,
+                                         std::size_t numberOfVectors, double* output)
+  {
+    std::vector<double> reduced(matrix.rank() * numberOfVectors);
+    matrix_dense_panel_product(matrix.v(), panel, numberOfVectors, reduced.data());
+    matrix_dense_panel_product(matrix.u(), reduced.data(), numberOfVectors, output);
+  }
+
+  inline std::vector<double> matrix_sparse_vector_product(const LowRankDenseMatrix& matrix,
+                                                          const CompactSparseVector<double>& vector)
+  {
+    return matrix.expand(matrix_sparse_vector_product(matrix.v(), vector));
+  }
+
+  template <class I, class F>
+  std::vector<double> matrix_sparse_vector_product(const LowRankDenseMatrix& matrix,
+                                                   const SparseVectorContainer<I, double>& vector,
+                                                   F toFlat)
+  {
+    CompactSparseVector<double> compact;
+    compact_sparse_vector(vector, toFlat, compact);
+    return matrix_sparse_vector_product(matrix, compact);
+  }
+
+  inline std::vector<std::vector<double>>
+  matrix_sparse_vectors_product(const LowRankDenseMatrix& matrix,
+                                const std::vector<CompactSparseVector<double>>& vectors)
+  {
+    auto output = matrix_sparse_vectors_product(matrix.v(), vectors);
+    for (auto& vector : output) {
+      vector = matrix.expand(vector);
+    }
+    return output;
+  }
+}
+
+#endif // DUNEURO_LOW_RANK_DENSE_MATRIX_HH
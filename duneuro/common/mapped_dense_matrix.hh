@@ -0,0 +1,257 @@
+#ifndef DUNEURO_MAPPED_DENSE_MATRIX_HH
+#define DUNEURO_MAPPED_DENSE_MATRIX_HH
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/parametertree.hh>
+
+#include <duneuro/common/dense_matrix.hh>
+
+namespace duneuro
+{
+  namespace MappedDenseMatrixDetail
+  {
+    // header at the beginning of a mapped matrix file. The entries are stored in the given layout
+    // (0: row major, 1: column major), starting at dataOffset bytes from the beginning of the
+    // file. Files written before the layout was recorded have a zero byte there, i.e. row major.
+    struct Header {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byteOrder;
+      std::uint32_t scalarSize;
+      char scalarKind;
+      char layout;
+      char padding[2];
+      std::uint64_t rows;
+      std::uint64_t cols;
+      std::uint64_t dataOffset;
+    };
+
+    static const char magic[8] = {'D', 'U', 'N', 'E', 'U', 'R', 'O', 'M'};
+    static const std::uint32_t version = 1;
+    static const std::uint32_t byteOrder = 0x01020304;
+    // keep the data page aligned
+    static const std::uint64_t dataOffset = 4096;
+
+    template <class T>
+    char scalarKind()
+    {
+      return std::is_floating_point<T>::value ? 'f' : (std::is_signed<T>::value ? 'i' : 'u');
+    }
+
+    inline char layoutByte(DenseMatrixLayout layout)
+    {
+      return layout == DenseMatrixLayout::rowMajor ? 0 : 1;
+    }
+
+    inline std::string errorString()
+    {
+      return std::strerror(errno);
+    }
+  }
+
+  /**
+   * \brief dense matrix storage inside a memory mapping
+   *
+   * The mapping is either backed by a file or anonymous. File backed mappings allow several
+   * processes to share a single copy of a matrix in the page cache and allow writing matrices
+   * which are larger than the main memory. Anonymous mappings are shared with forked child
+   * processes. The mapping is released when the storage is destroyed.
+   */
+  template <class T>
+  class MappedDenseMatrixStorage : public DenseMatrixStorageInterface<T>
+  {
+  public:
+    MappedDenseMatrixStorage(void* address, std::size_t length, std::size_t offset)
+        : address_(address), length_(length), offset_(offset)
+    {
+    }
+
+    MappedDenseMatrixStorage(const MappedDenseMatrixStorage&) = delete;
+    void operator=(const MappedDenseMatrixStorage&) = delete;
+
+    virtual T* data() override
+    {
+      return reinterpret_cast<T*>(static_cast<char*>(address_) + offset_);
+    }
+
+    virtual const T* data() const override
+    {
+      return reinterpret_cast<const T*>(static_cast<const char*>(address_) + offset_);
+    }
+
+    //! write modified pages of a file backed mapping back to the file
+    void sync()
+    {
+      if (msync(address_, length_, MS_SYNC) != 0) {
+        DUNE_THROW(Dune::IOError, "msync failed: " << MappedDenseMatrixDetail::errorString());
+      }
+    }
+
+    ~MappedDenseMatrixStorage()
+    {
+      munmap(address_, length_);
+    }
+
+  private:
+    void* address_;
+    std::size_t length_;
+    std::size_t offset_;
+  };
+
+  /**
+   * \brief create a dense matrix in an anonymous shared mapping
+   *
+   * The entries are initialized with zero.
+   */
+  template <class T>
+  std::unique_ptr<DenseMatrix<T>>
+  make_anonymous_mapped_dense_matrix(std::size_t rows, std::size_t cols,
+                                     DenseMatrixLayout layout = DenseMatrixLayout::rowMajor)
+  {
+    std::size_t length = std::max<std::size_t>(rows * cols * sizeof(T), 1);
+    void* address =
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (address == MAP_FAILED) {
+      DUNE_THROW(Dune::Exception,
+                 "could not create anonymous mapping: " << MappedDenseMatrixDetail::errorString());
+    }
+    return std::make_unique<DenseMatrix<T>>(
+        rows, cols, std::make_shared<MappedDenseMatrixStorage<T>>(address, length, 0), layout);
+  }
+
+  /**
+   * \brief create a file backed dense matrix
+   *
+   * An existing file is overwritten. The entries are initialized with zero and every
+   * modification of the matrix is written to the file.
+   */
+  template <class T>
+  std::unique_ptr<DenseMatrix<T>>
+  make_mapped_dense_matrix(const std::string& filename, std::size_t rows, std::size_t cols,
+                           DenseMatrixLayout layout = DenseMatrixLayout::rowMajor)
+  {
+    using namespace MappedDenseMatrixDetail;
+    int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      DUNE_THROW(Dune::IOError, "could not create " << filename << ": " << errorString());
+    }
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byteOrder = byteOrder;
+    header.scalarSize = sizeof(T);
+    header.scalarKind = scalarKind<T>();
+    header.layout = layoutByte(layout);
+    header.rows = rows;
+    header.cols = cols;
+    header.dataOffset = dataOffset;
+    std::size_t length = dataOffset + rows * cols * sizeof(T);
+    if (ftruncate(fd, length) != 0
+        || pwrite(fd, &header, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header))) {
+      close(fd);
+      DUNE_THROW(Dune::IOError, "could not initialize " << filename << ": " << errorString());
+    }
+    void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+      DUNE_THROW(Dune::IOError, "could not map " << filename << ": " << errorString());
+    }
+    return std::make_unique<DenseMatrix<T>>(
+        rows, cols, std::make_shared<MappedDenseMatrixStorage<T>>(address, length, dataOffset),
+        layout);
+  }
+
+  /**
+   * \brief open a file backed dense matrix
+   *
+   * If writable is true, modifications of the matrix are written to the file. Otherwise the file
+   * is mapped copy-on-write: unmodified pages are shared with all other processes mapping the
+   * same file, modifications only affect the returned matrix.
+   */
+  template <class T>
+  std::unique_ptr<DenseMatrix<T>> open_mapped_dense_matrix(const std::string& filename,
+                                                           bool writable = false)
+  {
+    using namespace MappedDenseMatrixDetail;
+    int fd = open(filename.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+      DUNE_THROW(Dune::IOError, "could not open " << filename << ": " << errorString());
+    }
+    Header header;
+    struct stat status;
+    if (pread(fd, &header, sizeof(Header), 0) != static_cast<ssize_t>(sizeof(Header))
+        || fstat(fd, &status) != 0) {
+      close(fd);
+      DUNE_THROW(Dune::IOError, "could not read header of " << filename);
+    }
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) {
+      close(fd);
+      DUNE_THROW(Dune::IOError, filename << " is not a mapped dense matrix file");
+    }
+    if (header.byteOrder != byteOrder || header.scalarSize != sizeof(T)
+        || header.scalarKind != scalarKind<T>()) {
+      close(fd);
+      DUNE_THROW(Dune::IOError, "the scalar type or byte order of " << filename
+                                                                    << " does not match");
+    }
+    if (header.layout != 0 && header.layout != 1) {
+      close(fd);
+      DUNE_THROW(Dune::IOError, "unknown layout of " << filename);
+    }
+    std::size_t length = header.dataOffset + header.rows * header.cols * sizeof(T);
+    if (static_cast<std::size_t>(status.st_size) < length) {
+      close(fd);
+      DUNE_THROW(Dune::IOError, filename << " is truncated");
+    }
+    void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                         writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+      DUNE_THROW(Dune::IOError, "could not map " << filename << ": " << errorString());
+    }
+    return std::make_unique<DenseMatrix<T>>(
+        header.rows, header.cols,
+        std::make_shared<MappedDenseMatrixStorage<T>>(address, length, header.dataOffset),
+        header.layout == 0 ? DenseMatrixLayout::rowMajor : DenseMatrixLayout::columnMajor);
+  }
+
+  /**
+   * \brief create a zero initialized dense matrix with the storage given in the config
+   *
+   * The key "type" selects the storage: "memory" (default), "anonymous" or "file". For file
+   * backed storage, the file is given by the key "filename".
+   */
+  template <class T>
+  std::unique_ptr<DenseMatrix<T>>
+  make_dense_matrix(std::size_t rows, std::size_t cols, const Dune::ParameterTree& config,
+                    DenseMatrixLayout layout = DenseMatrixLayout::rowMajor)
+  {
+    auto type = config.get<std::string>("type", "memory");
+    if (type == "memory") {
+      return std::make_unique<DenseMatrix<T>>(rows, cols, T(0), layout);
+    } else if (type == "anonymous") {
+      return make_anonymous_mapped_dense_matrix<T>(rows, cols, layout);
+    } else if (type == "file") {
+      return make_mapped_dense_matrix<T>(config.get<std::string>("filename"), rows, cols,
+                                         layout);
+    } else {
+      DUNE_THROW(Dune::Exception, "unknown dense matrix storage \"" << type << "\"");
+    }
+  }
+}
+
+#endif // DUNEURO_MAPPED_DENSE_MATRIX_HH
@@ -0,0 +1,248 @@
+#ifndef DUNEURO_MAPPED_SPARSE_MATRIX_HH
+#define DUNEURO_MAPPED_SPARSE_MATRIX_HH
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/fmatrix.hh>
+
+#include <dune/istl/bcrsmatrix.hh>
+
+#include <duneuro/common/temporary_file.hh>
+
+namespace duneuro
+{
+  namespace MappedSparseMatrixDetail
+  {
+    // header at the beginning of a sparse matrix file. It is followed by the row offsets
+    // (rows + 1 entries), the column indices (nonzeros entries), both stored as 64 bit unsigned
+    // integers, and the blocks of the matrix, each stored row wise. The sections start at the
+    // given offsets from the beginning of the file.
+    struct Header {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byteOrder;
+      std::uint32_t scalarSize;
+      char scalarKind;
+      char padding[3];
+      std::uint32_t blockRows;
+      std::uint32_t blockCols;
+      std::uint64_t rows;
+      std::uint64_t cols;
+      std::uint64_t nonzeros;
+      std::uint64_t rowOffsetsOffset;
+      std::uint64_t columnsOffset;
+      std::uint64_t valuesOffset;
+    };
+
+    static const char magic[8] = {'D', 'U', 'N', 'E', 'U', 'R', 'O', 'S'};
+    static const std::uint32_t version = 1;
+    static const std::uint32_t byteOrder = 0x01020304;
+    static const std::uint64_t alignment = 64;
+
+    inline std::uint64_t align(std::uint64_t offset)
+    {
+      return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    template <class T>
+    char scalarKind()
+    {
+      return std::is_floating_point<T>::value ? 'f' : (std::is_signed<T>::value ? 'i' : 'u');
+    }
+
+    inline std::string errorString()
+    {
+      return std::strerror(errno);
+    }
+
+    // read only mapping of a whole file, released on destruction
+    class ReadOnlyMapping
+    {
+    public:
+      explicit ReadOnlyMapping(const std::string& filename)
+      {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+          DUNE_THROW(Dune::IOError, "could not open " << filename << ": " << errorString());
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0) {
+          close(fd);
+          DUNE_THROW(Dune::IOError, "could not stat " << filename << ": " << errorString());
+        }
+        length_ = status.st_size;
+        if (length_ < sizeof(Header)) {
+          close(fd);
+          DUNE_THROW(Dune::IOError, filename << " is truncated");
+        }
+        address_ = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (address_ == MAP_FAILED) {
+          DUNE_THROW(Dune::IOError, "could not map " << filename << ": " << errorString());
+        }
+      }
+
+      ReadOnlyMapping(const ReadOnlyMapping&) = delete;
+      void operator=(const ReadOnlyMapping&) = delete;
+
+      ~ReadOnlyMapping()
+      {
+        munmap(address_, length_);
+      }
+
+      template <class T>
+      const T* at(std::uint64_t offset) const
+      {
+        return reinterpret_cast<const T*>(static_cast<const char*>(address_) + offset);
+      }
+
+      std::size_t length() const
+      {
+        return length_;
+      }
+
+    private:
+      void* address_;
+      std::size_t length_;
+    };
+  }
+
+  /**
+   * \brief write a block sparse matrix to a binary file
+   *
+   * The matrix is written to a temporary file which is then moved to the given filename, so that
+   * concurrent readers never see an incomplete file. An existing file is replaced.
+   */
+  template <class T, int n, int m, class A>
+  void write_mapped_sparse_matrix(const std::string& filename,
+                                  const Dune::BCRSMatrix<Dune::FieldMatrix<T, n, m>, A>& matrix)
+  {
+    using namespace MappedSparseMatrixDetail;
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byteOrder = byteOrder;
+    header.scalarSize = sizeof(T);
+    header.scalarKind = scalarKind<T>();
+    header.blockRows = n;
+    header.blockCols = m;
+    header.rows = matrix.N();
+    header.cols = matrix.M();
+    header.nonzeros = matrix.nonzeroes();
+    header.rowOffsetsOffset = align(sizeof(Header));
+    header.columnsOffset =
+        align(header.rowOffsetsOffset + (header.rows + 1) * sizeof(std::uint64_t));
+    header.valuesOffset = align(header.columnsOffset + header.nonzeros * sizeof(std::uint64_t));
+
+    std::vector<std::uint64_t> rowOffsets;
+    std::vector<std::uint64_t> columns;
+    std::vector<T> values;
+    rowOffsets.reserve(header.rows + 1);
+    columns.reserve(header.nonzeros);
+    values.reserve(header.nonzeros * n * m);
+    rowOffsets.push_back(0);
+    for (auto row = matrix.begin(); row != matrix.end(); ++row) {
+      for (auto entry = row->begin(); entry != row->end(); ++entry) {
+        columns.push_back(entry.index());
+        for (int i = 0; i < n; ++i) {
+          for (int j = 0; j < m; ++j) {
+            values.push_back((*entry)[i][j]);
+          }
+        }
+      }
+      rowOffsets.push_back(columns.size());
+    }
+
+    // concurrent writers of the same file each use their own temporary file
+    TemporaryFile temporary(filename);
+    {
+      std::ofstream stream(temporary.name(), std::ios::binary | std::ios::trunc);
+      auto writeAt = [&](std::uint64_t offset, const void* data, std::size_t size) {
+        stream.seekp(offset);
+        stream.write(static_cast<const char*>(data), size);
+      };
+      writeAt(0, &header, sizeof(Header));
+      writeAt(header.rowOffsetsOffset, rowOffsets.data(),
+              rowOffsets.size() * sizeof(std::uint64_t));
+      writeAt(header.columnsOffset, columns.data(), columns.size() * sizeof(std::uint64_t));
+      writeAt(header.valuesOffset, values.data(), values.size() * sizeof(T));
+      if (!stream) {
+        DUNE_THROW(Dune::IOError, "could not write " << temporary.name());
+      }
+    }
+    temporary.publish();
+  }
+
+  /**
+   * \brief read a block sparse matrix written by write_mapped_sparse_matrix
+   *
+   * The file is mapped into memory and the pattern and values are copied directly into a newly
+   * created matrix, without any parsing. Block size, scalar type and byte order have to match.
+   */
+  template <class Matrix>
+  std::shared_ptr<Matrix> read_mapped_sparse_matrix(const std::string& filename)
+  {
+    using namespace MappedSparseMatrixDetail;
+    using Block = typename Matrix::block_type;
+    using T = typename Matrix::field_type;
+    const int n = Block::rows;
+    const int m = Block::cols;
+    ReadOnlyMapping mapping(filename);
+    const Header& header = *mapping.template at<Header>(0);
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version) {
+      DUNE_THROW(Dune::IOError, filename << " is not a sparse matrix file");
+    }
+    if (header.byteOrder != byteOrder || header.scalarSize != sizeof(T)
+        || header.scalarKind != scalarKind<T>() || header.blockRows != std::uint32_t(n)
+        || header.blockCols != std::uint32_t(m)) {
+      DUNE_THROW(Dune::IOError, "the block type or byte order of " << filename
+                                                                   << " does not match");
+    }
+    if (mapping.length() < header.valuesOffset + header.nonzeros * n * m * sizeof(T)) {
+      DUNE_THROW(Dune::IOError, filename << " is truncated");
+    }
+    const std::uint64_t* rowOffsets = mapping.template at<std::uint64_t>(header.rowOffsetsOffset);
+    const std::uint64_t* columns = mapping.template at<std::uint64_t>(header.columnsOffset);
+    const T* values = mapping.template at<T>(header.valuesOffset);
+    if (rowOffsets[header.rows] != header.nonzeros) {
+      DUNE_THROW(Dune::IOError, filename << " is corrupt");
+    }
+
+    auto matrix =
+        std::make_shared<Matrix>(header.rows, header.cols, header.nonzeros, Matrix::row_wise);
+    for (auto row = matrix->createbegin(); row != matrix->createend(); ++row) {
+      for (auto k = rowOffsets[row.index()]; k < rowOffsets[row.index() + 1]; ++k) {
+        row.insert(columns[k]);
+      }
+    }
+    std::size_t k = 0;
+    for (auto row = matrix->begin(); row != matrix->end(); ++row) {
+      for (auto entry = row->begin(); entry != row->end(); ++entry, ++k) {
+        const T* block = values + k * n * m;
+        for (int i = 0; i < n; ++i) {
+          for (int j = 0; j < m; ++j) {
+            (*entry)[i][j] = block[i * m + j];
+          }
+        }
+      }
+    }
+    return matrix;
+  }
+}
+
+#endif // DUNEURO_MAPPED_SPARSE_MATRIX_HH
@@ -1,7 +1,9 @@
 #ifndef DUNEURO_MATRIX_UTILITIES_HH
 #define DUNEURO_MATRIX_UTILITIES_HH
 
+#include <algorithm>
 #include <cstdlib>
+#include <type_traits>
 #include <vector>
 #include <numeric>
 
@@ -12,6 +14,14 @@
 
 #include <duneuro/common/dense_matrix.hh>
 
+#if HAVE_DUNEURO_BLAS
+extern "C" {
+void dgemm_(const char* transa, const char* transb, const int* m, const int* n, const int* k,
+            const double* alpha, const double* a, const int* lda, const double* b, const int* ldb,
+            const double* beta, double* c, const int* ldc);
+}
+#endif
+
 namespace duneuro
 {
   template <class M, class V>
@@ -78,22 +88,162 @@ namespace duneuro
     return out;
   }
 
-  template <class T, int blockSize>
+  template <class S, class T, int blockSize>
   std::vector<T>
-  matrix_dense_vector_product(const DenseMatrix<T>& matrix,
+  matrix_dense_vector_product(const DenseMatrix<S>& matrix,
                               const Dune::BlockVector<Dune::FieldVector<T, blockSize>>& vector)
   {
     std::vector<T> output(matrix.rows(), T(0));
+    if (!matrix.rowMajor()) {
+      // add the contiguous columns belonging to the nonzero entries
+      const std::size_t rows = matrix.rows();
+      for (std::size_t cb = 0; cb < vector.N(); ++cb) {
+        for (std::size_t bi = 0; bi < blockSize; ++bi) {
+          const T value = vector[cb][bi];
+          if (value == T(0))
+            continue;
+          const S* column = matrix.data() + (cb * blockSize + bi) * rows;
+          for (std::size_t k = 0; k < rows; ++k) {
+            output[k] += T(column[k]) * value;
+          }
+        }
+      }
+      return output;
+    }
     for (std::size_t k = 0; k < matrix.rows(); ++k) {
       for (std::size_t cb = 0; cb < vector.N(); ++cb) {
         for (std::size_t bi = 0; bi < blockSize; ++bi) {
-          output[k] += matrix(k, cb * blockSize + bi) * vector[cb][bi];
+          output[k] += T(matrix(k, cb * blockSize + bi)) * vector[cb][bi];
         }
       }
     }
     return output;
   }
 
+  /**
+   * \brief compute C = op(A) op(B) + beta C for column major blocks
+   *
+   * The arguments follow the conventions of the blas routine dgemm: C is m x n, op(A) is m x k
+   * and op(B) is k x n, op(X) is X^T if the corresponding flag is set. Each block is given by a
+   * pointer to its first entry and the distance of its columns (leading dimension), so that
+   * blocks of larger matrices and, by transposing, row major blocks can be passed. If duneuro has
+   * been configured with blas, dgemm is used. Otherwise, the loops are ordered such that the
+   * columns of A are traversed contiguously.
+   */
+  inline void dense_block_product(bool transA, bool transB, std::size_t m, std::size_t n,
+                                  std::size_t k, const double* a, std::size_t lda, const double* b,
+                                  std::size_t ldb, double beta, double* c, std::size_t ldc)
+  {
+    if (m == 0 || n == 0) {
+      return;
+    }
+#if HAVE_DUNEURO_BLAS
+    if (k > 0) {
+      const char opA = transA ? 'T' : 'N';
+      const char opB = transB ? 'T' : 'N';
+      const int im = m;
+      const int in = n;
+      const int ik = k;
+      const double alpha = 1.0;
+      const int ilda = lda;
+      const int ildb = ldb;
+      const int ildc = ldc;
+      dgemm_(&opA, &opB, &im, &in, &ik, &alpha, a, &ilda, b, &ildb, &beta, c, &ildc);
+      return;
+    }
+#endif
+    auto opB = [&](std::size_t p, std::size_t j) {
+      return transB ? b[j + p * ldb] : b[p + j * ldb];
+    };
+    for (std::size_t j = 0; j < n; ++j) {
+      double* column = c + j * ldc;
+      for (std::size_t i = 0; i < m; ++i) {
+        column[i] = beta == 0.0 ? 0.0 : beta * column[i];
+      }
+      if (transA) {
+        // entry i of the column is the dot product of column i of A with column j of op(B)
+        for (std::size_t i = 0; i < m; ++i) {
+          const double* aColumn = a + i * lda;
+          double sum = 0.0;
+          for (std::size_t p = 0; p < k; ++p) {
+            sum += aColumn[p] * opB(p, j);
+          }
+          column[i] += sum;
+        }
+      } else {
+        for (std::size_t p = 0; p < k; ++p) {
+          const double weight = opB(p, j);
+          if (weight == 0.0)
+            continue;
+          const double* aColumn = a + p * lda;
+          for (std::size_t i = 0; i < m; ++i) {
+            column[i] += aColumn[i] * weight;
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief compute the product of a dense matrix with a panel of dense vectors
+   *
+   * The panel contains numberOfVectors vectors of size matrix.cols(), stored column major, i.e.
+   * vector j starts at panel + j * matrix.cols(). The result is stored column major as well,
+   * vector j of the result starts at output + j * matrix.rows(). If duneuro has been configured
+   * with blas, the product is computed by dgemm. Otherwise a blocked kernel is used which reuses
+   * every loaded part of a matrix row for all vectors of the panel. For column major matrices,
+   * every result vector is accumulated from the contiguous matrix columns. Matrices stored in a
+   * lower precision S are widened to the precision T of the panel while accumulating.
+   */
+  template <class S, class T>
+  void matrix_dense_panel_product(const DenseMatrix<S>& matrix, const T* panel,
+                                  std::size_t numberOfVectors, T* output)
+  {
+    const std::size_t rows = matrix.rows();
+    const std::size_t cols = matrix.cols();
+#if HAVE_DUNEURO_BLAS
+    if constexpr (std::is_same<S, double>::value && std::is_same<T, double>::value) {
+      // a row major matrix is the transpose of a column major cols x rows matrix
+      dense_block_product(matrix.rowMajor(), false, rows, numberOfVectors, cols, matrix.data(),
+                          matrix.rowMajor() ? cols : rows, panel, cols, 0.0, output, rows);
+      return;
+    }
+#endif
+    std::fill(output, output + rows * numberOfVectors, T(0));
+    if (!matrix.rowMajor()) {
+      for (std::size_t j = 0; j < numberOfVectors; ++j) {
+        const T* vector = panel + j * cols;
+        T* result = output + j * rows;
+        for (std::size_t c = 0; c < cols; ++c) {
+          const T value = vector[c];
+          if (value == T(0))
+            continue;
+          const S* column = matrix.data() + c * rows;
+          for (std::size_t row = 0; row < rows; ++row) {
+            result[row] += T(column[row]) * value;
+          }
+        }
+      }
+      return;
+    }
+    // part of a matrix row and the corresponding part of the panel processed at once
+    const std::size_t tileSize = 512;
+    for (std::size_t tileBegin = 0; tileBegin < cols; tileBegin += tileSize) {
+      const std::size_t tileEnd = std::min(cols, tileBegin + tileSize);
+      for (std::size_t row = 0; row < rows; ++row) {
+        const S* matrixRow = matrix.data() + row * cols;
+        for (std::size_t j = 0; j < numberOfVectors; ++j) {
+          const T* vector = panel + j * cols;
+          T sum(0);
+          for (std::size_t c = tileBegin; c < tileEnd; ++c) {
+            sum += T(matrixRow[c]) * vector[c];
+          }
+          output[j * rows + row] += sum;
+        }
+      }
+    }
+  }
+
   template <class T, int blockSize>
   void set_matrix_row(DenseMatrix<T>& matrix, std::size_t row,
                       const Dune::BlockVector<Dune::FieldVector<T, blockSize>>& vector)
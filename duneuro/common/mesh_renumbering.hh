@@ -0,0 +1,506 @@
+#ifndef DUNEURO_MESH_RENUMBERING_HH
+#define DUNEURO_MESH_RENUMBERING_HH
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/timer.hh>
+
+#include <duneuro/common/element_neighborhood_map.hh>
+#include <duneuro/common/fitted_driver_data.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  namespace MeshRenumberingDetail
+  {
+    using Adjacency = ElementNeighborhoodMapDetail::CompressedAdjacency<std::size_t>;
+
+    // graph of the vertices which share an element, without self loops
+    inline Adjacency vertexAdjacency(std::size_t numberOfVertices,
+                                     const std::vector<std::vector<unsigned int>>& elements)
+    {
+      std::vector<std::vector<std::size_t>> lists(numberOfVertices);
+      for (const auto& element : elements) {
+        for (auto v : element) {
+          if (v >= numberOfVertices) {
+            DUNE_THROW(Dune::Exception, "element references vertex "
+                                            << v << ", but only " << numberOfVertices
+                                            << " vertices are given");
+          }
+          for (auto w : element) {
+            if (v != w) {
+              lists[v].push_back(w);
+            }
+          }
+        }
+      }
+      Adjacency graph;
+      graph.offsets.assign(numberOfVertices + 1, 0);
+      for (std::size_t v = 0; v < numberOfVertices; ++v) {
+        auto& list = lists[v];
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        graph.offsets[v + 1] = graph.offsets[v] + list.size();
+      }
+      graph.indices.reserve(graph.offsets.back());
+      for (auto& list : lists) {
+        graph.indices.insert(graph.indices.end(), list.begin(), list.end());
+        std::vector<std::size_t>().swap(list);
+      }
+      return graph;
+    }
+
+    // transform the coordinates of a point on a 2^bits lattice to the transposed hilbert index, see
+    // J. Skilling, Programming the Hilbert curve, AIP Conf. Proc. 707, 2004
+    template <int dim>
+    std::uint64_t hilbertKey(std::array<std::uint32_t, dim> x, int bits)
+    {
+      const std::uint32_t m = std::uint32_t(1) << (bits - 1);
+      for (std::uint32_t q = m; q > 1; q >>= 1) {
+        const std::uint32_t p = q - 1;
+        for (int i = 0; i < dim; ++i) {
+          if (x[i] & q) {
+            x[0] ^= p;
+          } else {
+            const std::uint32_t t = (x[0] ^ x[i]) & p;
+            x[0] ^= t;
+            x[i] ^= t;
+          }
+        }
+      }
+      for (int i = 1; i < dim; ++i) {
+        x[i] ^= x[i - 1];
+      }
+      std::uint32_t t = 0;
+      for (std::uint32_t q = m; q > 1; q >>= 1) {
+        if (x[dim - 1] & q) {
+          t ^= q - 1;
+        }
+      }
+      for (int i = 0; i < dim; ++i) {
+        x[i] ^= t;
+      }
+      // interleave the bits of the transposed index
+      std::uint64_t key = 0;
+      for (int b = bits - 1; b >= 0; --b) {
+        for (int i = 0; i < dim; ++i) {
+          key = (key << 1) | ((x[i] >> b) & 1);
+        }
+      }
+      return key;
+    }
+  }
+
+  //! bandwidth and profile of a symmetric sparsity pattern
+  struct BandwidthStatistics {
+    std::size_t bandwidth = 0;
+    std::size_t profile = 0;
+  };
+
+  /**
+   * \brief compute bandwidth and profile of a graph after renumbering
+   *
+   * newIndex[i] is the new index of node i. The profile is the sum over all rows of the distance
+   * between the diagonal and the first entry of the row.
+   */
+  inline BandwidthStatistics
+  bandwidth_statistics(const MeshRenumberingDetail::Adjacency& graph,
+                       const std::vector<std::size_t>& newIndex)
+  {
+    BandwidthStatistics statistics;
+    for (std::size_t i = 0; i < graph.size(); ++i) {
+      const std::size_t row = newIndex[i];
+      std::size_t first = row;
+      for (auto j : graph[i]) {
+        const std::size_t col = newIndex[j];
+        first = std::min(first, col);
+        statistics.bandwidth = std::max(statistics.bandwidth, row > col ? row - col : col - row);
+      }
+      statistics.profile += row - first;
+    }
+    return statistics;
+  }
+
+  /**
+   * \brief reverse cuthill mckee ordering of a graph
+   *
+   * Returns the old index for each new index. Each connected component is traversed in breadth
+   * first order, starting at a pseudo peripheral node and visiting the neighbors of a node by
+   * increasing degree. The resulting order is reversed.
+   */
+  inline std::vector<std::size_t>
+  reverse_cuthill_mckee_ordering(const MeshRenumberingDetail::Adjacency& graph)
+  {
+    const std::size_t n = graph.size();
+    auto degree = [&](std::size_t v) { return graph[v].size(); };
+    std::vector<std::size_t> byDegree(n);
+    std::iota(byDegree.begin(), byDegree.end(), 0);
+    std::stable_sort(byDegree.begin(), byDegree.end(),
+                     [&](std::size_t a, std::size_t b) { return degree(a) < degree(b); });
+
+    std::vector<std::size_t> order;
+    order.reserve(n);
+    std::vector<bool> visited(n, false);
+    // levels of a breadth first search restricted to unvisited nodes, stamped to avoid resets
+    std::vector<std::size_t> stamp(n, std::numeric_limits<std::size_t>::max());
+    std::size_t currentStamp = 0;
+    std::vector<std::size_t> queue;
+    auto lastLevel = [&](std::size_t root, std::vector<std::size_t>& last) {
+      ++currentStamp;
+      queue.assign(1, root);
+      stamp[root] = currentStamp;
+      std::size_t levels = 0;
+      std::size_t begin = 0;
+      while (begin < queue.size()) {
+        const std::size_t end = queue.size();
+        last.assign(queue.begin() + begin, queue.begin() + end);
+        for (std::size_t i = begin; i < end; ++i) {
+          for (auto w : graph[queue[i]]) {
+            if (!visited[w] && stamp[w] != currentStamp) {
+              stamp[w] = currentStamp;
+              queue.push_back(w);
+            }
+          }
+        }
+        begin = end;
+        ++levels;
+      }
+      return levels;
+    };
+
+    std::vector<std::size_t> last, neighbors;
+    for (auto seed : byDegree) {
+      if (visited[seed]) {
+        continue;
+      }
+      // pseudo peripheral node: move to a node of minimal degree in the last level as long as
+      // the eccentricity grows
+      std::size_t root = seed;
+      std::size_t eccentricity = lastLevel(root, last);
+      for (unsigned int iteration = 0; iteration < 8; ++iteration) {
+        auto candidate = *std::min_element(last.begin(), last.end(), [&](auto a, auto b) {
+          return degree(a) < degree(b);
+        });
+        std::vector<std::size_t> candidateLast;
+        const std::size_t candidateEccentricity = lastLevel(candidate, candidateLast);
+        if (candidateEccentricity <= eccentricity) {
+          break;
+        }
+        root = candidate;
+        eccentricity = candidateEccentricity;
+        last.swap(candidateLast);
+      }
+      std::size_t begin = order.size();
+      order.push_back(root);
+      visited[root] = true;
+      while (begin < order.size()) {
+        const std::size_t v = order[begin++];
+        neighbors.clear();
+        for (auto w : graph[v]) {
+          if (!visited[w]) {
+            visited[w] = true;
+            neighbors.push_back(w);
+          }
+        }
+        std::stable_sort(neighbors.begin(), neighbors.end(),
+                         [&](std::size_t a, std::size_t b) { return degree(a) < degree(b); });
+        order.insert(order.end(), neighbors.begin(), neighbors.end());
+      }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+  }
+
+  /**
+   * \brief nested dissection ordering of a graph, e.g. for a sparse cholesky factorization
+   *
+   * Returns the old index for each new index. A part of the graph is split by a level of a
+   * breadth first search from a pseudo peripheral node, chosen such that about half of the
+   * nodes lie before it. The nodes before and after the level are ordered recursively, followed
+   * by the nodes of the level which are adjacent to the nodes after it, as these separate both
+   * halves. Disconnected parts are ordered separately, parts with at most leafSize nodes keep
+   * their order. For the graphs of finite element meshes this yields far less fill in than a
+   * bandwidth reducing ordering, see A. George, Nested dissection of a regular finite element
+   * mesh, SIAM J. Numer. Anal. 10(2), 1973.
+   */
+  inline std::vector<std::size_t>
+  nested_dissection_ordering(const MeshRenumberingDetail::Adjacency& graph,
+                             std::size_t leafSize = 64)
+  {
+    const std::size_t n = graph.size();
+    const std::size_t none = std::numeric_limits<std::size_t>::max();
+    // the nodes of the part currently split are marked with its id, the levels of a breadth
+    // first search are stamped to avoid resets
+    std::vector<std::size_t> part(n, 0);
+    std::size_t currentPart = 0;
+    std::vector<std::size_t> stamp(n, none), level(n, 0);
+    std::size_t currentStamp = 0;
+    std::vector<std::size_t> queue;
+    // breadth first search within the current part. Returns the number of levels, queue
+    // contains the reached nodes ordered by level
+    auto search = [&](std::size_t root) {
+      ++currentStamp;
+      queue.assign(1, root);
+      stamp[root] = currentStamp;
+      level[root] = 0;
+      for (std::size_t i = 0; i < queue.size(); ++i) {
+        const std::size_t v = queue[i];
+        for (auto w : graph[v]) {
+          if (part[w] == currentPart && stamp[w] != currentStamp) {
+            stamp[w] = currentStamp;
+            level[w] = level[v] + 1;
+            queue.push_back(w);
+          }
+        }
+      }
+      return level[queue.back()] + 1;
+    };
+    auto partDegree = [&](std::size_t v) {
+      std::size_t degree = 0;
+      for (auto w : graph[v]) {
+        degree += part[w] == currentPart;
+      }
+      return degree;
+    };
+
+    // the order is filled from the back: a separator is placed behind both halves, which are
+    // processed depth first, the second half before the first
+    std::vector<std::size_t> order(n);
+    std::size_t back = n;
+    std::vector<std::vector<std::size_t>> stack(1, std::vector<std::size_t>(n));
+    std::iota(stack[0].begin(), stack[0].end(), 0);
+    while (!stack.empty()) {
+      std::vector<std::size_t> nodes = std::move(stack.back());
+      stack.pop_back();
+      ++currentPart;
+      for (auto v : nodes) {
+        part[v] = currentPart;
+      }
+      std::size_t levels = nodes.empty() ? 0 : search(nodes[0]);
+      if (queue.size() < nodes.size()) {
+        // split off the connected component of the first node
+        std::vector<std::size_t> rest;
+        rest.reserve(nodes.size() - queue.size());
+        for (auto v : nodes) {
+          if (stamp[v] != currentStamp) {
+            rest.push_back(v);
+          }
+        }
+        stack.push_back(std::move(rest));
+        stack.push_back(queue);
+        continue;
+      }
+      if (nodes.size() > leafSize) {
+        // pseudo peripheral node: move to a node of minimal degree in the last level as long as
+        // the eccentricity grows
+        for (unsigned int iteration = 0; iteration < 8; ++iteration) {
+          std::size_t candidate = queue.back();
+          for (auto it = queue.rbegin(); it != queue.rend() && level[*it] == levels - 1; ++it) {
+            if (partDegree(*it) < partDegree(candidate)) {
+              candidate = *it;
+            }
+          }
+          const std::size_t root = queue[0];
+          const std::size_t candidateLevels = search(candidate);
+          if (candidateLevels <= levels) {
+            if (candidateLevels < levels) {
+              search(root);
+            }
+            break;
+          }
+          levels = candidateLevels;
+        }
+      }
+      if (nodes.size() <= leafSize || levels < 3) {
+        for (std::size_t i = nodes.size(); i-- > 0;) {
+          order[--back] = nodes[i];
+        }
+        continue;
+      }
+      // separating level: the first one reaching half of the nodes, excluding the first and
+      // the last level so that both halves are non empty
+      std::size_t separator = 1;
+      for (std::size_t i = 0; i < queue.size(); ++i) {
+        if (2 * (i + 1) >= queue.size()) {
+          separator = level[queue[i]];
+          break;
+        }
+      }
+      separator = std::min(std::max(separator, std::size_t(1)), levels - 2);
+      std::vector<std::size_t> first, second, separatorNodes;
+      for (auto v : queue) {
+        if (level[v] < separator) {
+          first.push_back(v);
+        } else if (level[v] > separator) {
+          second.push_back(v);
+        } else {
+          // nodes of the level without a neighbor in the next level do not separate anything
+          bool separating = false;
+          for (auto w : graph[v]) {
+            separating |= part[w] == currentPart && level[w] > separator;
+          }
+          (separating ? separatorNodes : first).push_back(v);
+        }
+      }
+      for (std::size_t i = separatorNodes.size(); i-- > 0;) {
+        order[--back] = separatorNodes[i];
+      }
+      stack.push_back(std::move(first));
+      stack.push_back(std::move(second));
+    }
+    return order;
+  }
+
+  /**
+   * \brief order points along a hilbert space filling curve
+   *
+   * Returns the old index for each new index. The bounding box of the points is mapped to a
+   * lattice with 2^(63/dim) nodes per direction.
+   */
+  template <class Coordinate>
+  std::vector<std::size_t> hilbert_ordering(const std::vector<Coordinate>& points)
+  {
+    enum { dim = Coordinate::dimension };
+    const int bits = 63 / dim;
+    std::vector<std::size_t> order(points.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (points.empty()) {
+      return order;
+    }
+    Coordinate lower = points[0], upper = points[0];
+    for (const auto& p : points) {
+      for (int d = 0; d < dim; ++d) {
+        lower[d] = std::min(lower[d], p[d]);
+        upper[d] = std::max(upper[d], p[d]);
+      }
+    }
+    double extent = 0.0;
+    for (int d = 0; d < dim; ++d) {
+      extent = std::max<double>(extent, upper[d] - lower[d]);
+    }
+    const double scale =
+        extent > 0.0 ? (std::ldexp(1.0, bits) - 1.0) / extent : 0.0;
+    std::vector<std::uint64_t> keys(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      std::array<std::uint32_t, dim> x;
+      for (int d = 0; d < dim; ++d) {
+        x[d] = static_cast<std::uint32_t>((points[i][d] - lower[d]) * scale);
+      }
+      keys[i] = MeshRenumberingDetail::hilbertKey<dim>(x, bits);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+    return order;
+  }
+
+  template <int dim>
+  struct RenumberedMesh {
+    //! the renumbered mesh
+    FittedDriverData<dim> data;
+    //! index of each renumbered vertex in the original mesh
+    std::vector<std::size_t> originalVertex;
+  };
+
+  /**
+   * \brief renumber the vertices and elements of a mesh
+   *
+   * type is either "rcm" (reverse cuthill mckee ordering of the vertex graph, elements sorted by
+   * their first vertex) or "hilbert" (vertices and element centers sorted along a hilbert curve).
+   * Bandwidth and profile of the vertex graph before and after the renumbering are stored in the
+   * data tree.
+   */
+  template <int dim>
+  RenumberedMesh<dim> renumber_mesh(const FittedDriverData<dim>& data, const std::string& type,
+                                    DataTree dataTree = DataTree())
+  {
+    Dune::Timer timer;
+    const std::size_t numberOfVertices = data.nodes.size();
+    const std::size_t numberOfElements = data.elements.size();
+    const auto graph = MeshRenumberingDetail::vertexAdjacency(numberOfVertices, data.elements);
+
+    RenumberedMesh<dim> result;
+    if (type == "rcm") {
+      result.originalVertex = reverse_cuthill_mckee_ordering(graph);
+    } else if (type == "hilbert") {
+      result.originalVertex = hilbert_ordering(data.nodes);
+    } else {
+      DUNE_THROW(Dune::Exception, "unknown renumbering \"" << type << "\"");
+    }
+    std::vector<std::size_t> newVertex(numberOfVertices);
+    for (std::size_t i = 0; i < numberOfVertices; ++i) {
+      newVertex[result.originalVertex[i]] = i;
+    }
+
+    std::vector<std::size_t> identity(numberOfVertices);
+    std::iota(identity.begin(), identity.end(), 0);
+    const auto before = bandwidth_statistics(graph, identity);
+    const auto after = bandwidth_statistics(graph, newVertex);
+
+    std::vector<std::size_t> originalElement;
+    if (type == "hilbert") {
+      std::vector<typename FittedDriverData<dim>::Coordinate> centers(numberOfElements);
+      for (std::size_t e = 0; e < numberOfElements; ++e) {
+        centers[e] = 0.0;
+        for (auto v : data.elements[e]) {
+          centers[e] += data.nodes[v];
+        }
+        centers[e] /= data.elements[e].size();
+      }
+      originalElement = hilbert_ordering(centers);
+    } else {
+      std::vector<std::size_t> firstVertex(numberOfElements, numberOfVertices);
+      for (std::size_t e = 0; e < numberOfElements; ++e) {
+        for (auto v : data.elements[e]) {
+          firstVertex[e] = std::min(firstVertex[e], newVertex[v]);
+        }
+      }
+      originalElement.resize(numberOfElements);
+      std::iota(originalElement.begin(), originalElement.end(), 0);
+      std::stable_sort(originalElement.begin(), originalElement.end(),
+                       [&](std::size_t a, std::size_t b) { return firstVertex[a] < firstVertex[b]; });
+    }
+
+    auto& out = result.data;
+    out.nodes.reserve(numberOfVertices);
+    for (auto v : result.originalVertex) {
+      out.nodes.push_back(data.nodes[v]);
+    }
+    out.elements.reserve(numberOfElements);
+    for (auto e : originalElement) {
+      std::vector<unsigned int> element;
+      element.reserve(data.elements[e].size());
+      for (auto v : data.elements[e]) {
+        element.push_back(newVertex[v]);
+      }
+      out.elements.push_back(std::move(element));
+    }
+    if (data.labels.size() == numberOfElements) {
+      out.labels.reserve(numberOfElements);
+      for (auto e : originalElement) {
+        out.labels.push_back(data.labels[e]);
+      }
+    } else {
+      out.labels = data.labels;
+    }
+    out.conductivities = data.conductivities;
+    out.tensors = data.tensors;
+
+    dataTree.set("type", type);
+    dataTree.set("bandwidth_before", before.bandwidth);
+    dataTree.set("profile_before", before.profile);
+    dataTree.set("bandwidth", after.bandwidth);
+    dataTree.set("profile", after.profile);
+    dataTree.set("time", timer.elapsed());
+    return result;
+  }
+}
+
+#endif // DUNEURO_MESH_RENUMBERING_HH
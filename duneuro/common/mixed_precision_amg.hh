@@ -0,0 +1,173 @@
+#ifndef DUNEURO_MIXED_PRECISION_AMG_HH
+#define DUNEURO_MIXED_PRECISION_AMG_HH
+
+#include <memory>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/amg.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvercategory.hh>
+#include <dune/istl/solvers.hh>
+
+#include <duneuro/common/shared_amg_hierarchy.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief amg preconditioner running in a lower precision than the outer solver
+   *
+   * The matrix is copied to the field type LowReal (float by default) and the amg hierarchy and
+   * the ssor smoothers are built for this copy. When the preconditioner is applied, the defect
+   * is converted to LowReal, the amg cycle is performed in LowReal and the correction is
+   * converted back. The outer krylov method, and thus the residuals, stay in the precision of
+   * Vector. As the preconditioner only has to be a rough approximation of the inverse, the
+   * iteration counts are usually unaffected, while the memory of the hierarchy and the memory
+   * traffic of the preconditioner are halved.
+   *
+   * If a SharedAMGHierarchy is given, the single precision copy of the matrix and the coarsened
+   * matrices are stored in it and built by the first instance using it. Only the smoothers, the
+   * coarse level solver and the work vectors are then created per instance.
+   *
+   * Like Dune::Amg::AMG, pre and post do not use their arguments, so the preconditioner can be
+   * used as the subspace correction of Dune::PDELab::SeqDGAMGPrec.
+   */
+  template <class Matrix, class Vector, class LowReal = float>
+  class MixedPrecisionAMG : public Dune::Preconditioner<Vector, Vector>
+  {
+  public:
+    using MatrixBlock = typename Matrix::block_type;
+    using VectorBlock = typename Vector::block_type;
+    using LowMatrix = Dune::BCRSMatrix<Dune::FieldMatrix<LowReal, MatrixBlock::rows,
+                                                         MatrixBlock::cols>>;
+    using LowVector = Dune::BlockVector<Dune::FieldVector<LowReal, VectorBlock::dimension>>;
+    using Operator = Dune::MatrixAdapter<LowMatrix, LowVector, LowVector>;
+    using Smoother = Dune::SeqSSOR<LowMatrix, LowVector, LowVector, 1>;
+    using SmootherArgs = typename Dune::Amg::SmootherTraits<Smoother>::Arguments;
+    using AMG = Dune::Amg::AMG<Operator, LowVector, Smoother>;
+    using Criterion = Dune::Amg::CoarsenCriterion<
+        Dune::Amg::SymmetricCriterion<LowMatrix, Dune::Amg::FirstDiagonal>>;
+
+    using OperatorHierarchy = typename AMG::OperatorHierarchy;
+    using Hierarchy = SharedAMGHierarchy<Operator, OperatorHierarchy>;
+
+    MixedPrecisionAMG(const Matrix& matrix, const Dune::Amg::Parameters& parameters,
+                      unsigned int smootherIterations = 1, double relaxationFactor = 1.0)
+        : matrix_(convert(matrix)), x_(matrix.M()), d_(matrix.N())
+    {
+      operator_ = std::make_unique<Operator>(*matrix_);
+      Criterion criterion(parameters);
+      amg_ = std::make_unique<AMG>(*operator_, criterion,
+                                   makeSmootherArgs(smootherIterations, relaxationFactor));
+    }
+
+    MixedPrecisionAMG(const Matrix& matrix, const Dune::Amg::Parameters& parameters,
+                      std::shared_ptr<Hierarchy> hierarchy, unsigned int smootherIterations = 1,
+                      double relaxationFactor = 1.0)
+        : x_(matrix.M()), d_(matrix.N()), hierarchy_(hierarchy)
+    {
+      Criterion criterion(parameters);
+      auto& matrices = hierarchy_->buildOwned([&]() { return convert(matrix); }, criterion,
+                                              parameters.debugLevel());
+      const auto& coarseMatrix = matrices.matrices().coarsest()->getmat();
+      coarseOperator_ = std::make_unique<Operator>(coarseMatrix);
+      coarseSmoother_ = std::make_unique<Smoother>(coarseMatrix, 1, 1.0);
+      // the amg takes ownership of the coarse solver
+      auto coarseSolver =
+          std::make_unique<CoarseSolver>(*coarseOperator_, *coarseSmoother_, 1e-2, 1000, 0);
+      amg_ = std::make_unique<AMG>(matrices, *coarseSolver.release(),
+                                   makeSmootherArgs(smootherIterations, relaxationFactor),
+                                   parameters);
+    }
+
+    virtual void pre(Vector&, Vector&) override
+    {
+      x_ = 0.0;
+      d_ = 0.0;
+      amg_->pre(x_, d_);
+    }
+
+    virtual void apply(Vector& v, const Vector& d) override
+    {
+      for (std::size_t i = 0; i < d.N(); ++i) {
+        for (int k = 0; k < VectorBlock::dimension; ++k) {
+          d_[i][k] = static_cast<LowReal>(d[i][k]);
+        }
+      }
+      x_ = 0.0;
+      amg_->apply(x_, d_);
+      for (std::size_t i = 0; i < v.N(); ++i) {
+        for (int k = 0; k < VectorBlock::dimension; ++k) {
+          v[i][k] = x_[i][k];
+        }
+      }
+    }
+
+    virtual void post(Vector&) override
+    {
+      amg_->post(x_);
+    }
+
+    virtual Dune::SolverCategory::Category category() const override
+    {
+      return Dune::SolverCategory::sequential;
+    }
+
+    //! memory in bytes of the low precision copy of the matrix
+    std::size_t matrixMemory() const
+    {
+      const auto& matrix = hierarchy_ ? hierarchy_->matrix() : *matrix_;
+      return matrix.nonzeroes() * (sizeof(typename LowMatrix::block_type) + sizeof(std::size_t));
+    }
+
+  private:
+    using CoarseSolver = Dune::BiCGSTABSolver<LowVector>;
+
+    std::shared_ptr<const LowMatrix> matrix_;
+    LowVector x_;
+    LowVector d_;
+    std::shared_ptr<Hierarchy> hierarchy_;
+    std::unique_ptr<Operator> operator_;
+    std::unique_ptr<Operator> coarseOperator_;
+    std::unique_ptr<Smoother> coarseSmoother_;
+    std::unique_ptr<AMG> amg_;
+
+    static std::shared_ptr<const LowMatrix> convert(const Matrix& matrix)
+    {
+      auto result = std::make_shared<LowMatrix>(matrix.N(), matrix.M(), matrix.nonzeroes(),
+                                                LowMatrix::row_wise);
+      for (auto row = result->createbegin(); row != result->createend(); ++row) {
+        const auto& source = matrix[row.index()];
+        for (auto col = source.begin(); col != source.end(); ++col) {
+          row.insert(col.index());
+        }
+      }
+      for (auto row = matrix.begin(); row != matrix.end(); ++row) {
+        auto target = (*result)[row.index()].begin();
+        for (auto col = row->begin(); col != row->end(); ++col, ++target) {
+          for (int i = 0; i < MatrixBlock::rows; ++i) {
+            for (int j = 0; j < MatrixBlock::cols; ++j) {
+              (*target)[i][j] = static_cast<LowReal>((*col)[i][j]);
+            }
+          }
+        }
+      }
+      return result;
+    }
+
+    static SmootherArgs makeSmootherArgs(unsigned int iterations, double relaxationFactor)
+    {
+      SmootherArgs smootherArgs;
+      smootherArgs.iterations = iterations;
+      smootherArgs.relaxationFactor = relaxationFactor;
+      return smootherArgs;
+    }
+  };
+}
+
+#endif // DUNEURO_MIXED_PRECISION_AMG_HH
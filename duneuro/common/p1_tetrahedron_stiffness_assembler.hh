@@ -0,0 +1,249 @@
+#ifndef DUNEURO_P1_TETRAHEDRON_STIFFNESS_ASSEMBLER_HH
+#define DUNEURO_P1_TETRAHEDRON_STIFFNESS_ASSEMBLER_HH
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/timer.hh>
+
+#include <duneuro/common/element_neighborhood_map.hh>
+#include <duneuro/common/grid_function_space_utilities.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief closed form assembly of the stiffness matrix of piecewise linear elements on tetrahedra
+   *
+   * For a tetrahedron with vertices p_0, ..., p_3 and a constant conductivity tensor sigma, the
+   * element matrix is |T| G^T sigma G, where the columns of G are the constant gradients of the
+   * barycentric coordinates. The connectivity, the vertex coordinates and the tensors are gathered
+   * once into flat arrays. The element matrices are then computed for batches of elements, storing
+   * the intermediate results lane by lane so that the loops over a batch can be vectorized, and are
+   * added directly to the rows of the matrix. No local function spaces are bound during the
+   * assembly.
+   *
+   * The result coincides with the matrix assembled by the ConvectionDiffusionFEM local operator
+   * for the problem ConvectionDiffusionCGDefaultParameter, i.e. without convection, reaction and
+   * dirichlet boundary terms.
+   *
+   * Like ParallelJacobianAssembler, the assembly is isolated from enclosing parallel loops, see
+   * ElementNeighborhoodMapDetail::isolate, as it is called lazily by LinearProblemSolver while
+   * holding its lock.
+   */
+  template <class GO, class VC>
+  class P1TetrahedronStiffnessAssembler
+  {
+  public:
+    using GFS = typename GO::Traits::TrialGridFunctionSpace;
+    using GridView = typename GFS::Traits::GridViewType;
+    using Jacobian = typename GO::Traits::Jacobian;
+    using Matrix = Dune::PDELab::Backend::Native<Jacobian>;
+    using Real = typename Matrix::field_type;
+    using Index = std::size_t;
+    enum { dim = GridView::dimension };
+    static_assert(dim == 3, "the closed form assembly is only implemented for tetrahedra");
+    static_assert(Matrix::block_type::rows == 1 && Matrix::block_type::cols == 1,
+                  "the closed form assembly requires a scalar matrix");
+
+    P1TetrahedronStiffnessAssembler(const GO& go, std::shared_ptr<const VC> volumeConductor)
+        : go_(go), volumeConductor_(volumeConductor)
+    {
+    }
+
+    std::unique_ptr<Jacobian> assemble(DataTree dataTree = DataTree()) const
+    {
+      std::unique_ptr<Jacobian> jacobian;
+      ElementNeighborhoodMapDetail::isolate([&] { jacobian = assembleIsolated(dataTree); });
+      return jacobian;
+    }
+
+    std::unique_ptr<Jacobian> assembleIsolated(DataTree dataTree) const
+    {
+      Dune::Timer timer;
+      const auto& gv = go_.trialGridFunctionSpace().gridView();
+      const auto& indexSet = gv.indexSet();
+      const std::size_t numberOfVertices = gv.size(dim);
+      const std::size_t numberOfElements = gv.size(0);
+
+      std::vector<Real> coordinates(dim * numberOfVertices);
+      for (const auto& vertex : Dune::vertices(gv)) {
+        const auto position = vertex.geometry().corner(0);
+        const auto v = indexSet.index(vertex);
+        for (unsigned int k = 0; k < dim; ++k) {
+          coordinates[dim * v + k] = position[k];
+        }
+      }
+      std::vector<Index> connectivity(4 * numberOfElements);
+      // upper triangle of the symmetric tensors
+      std::vector<Real> tensors(6 * numberOfElements);
+      for (const auto& element : Dune::elements(gv)) {
+        if (!element.type().isTetrahedron()) {
+          DUNE_THROW(Dune::Exception, "closed form assembly requires a tetrahedral mesh");
+        }
+        const auto e = indexSet.index(element);
+        for (unsigned int i = 0; i < 4; ++i) {
+          connectivity[4 * e + i] = indexSet.subIndex(element, i, dim);
+        }
+        const auto& sigma = volumeConductor_->tensor(element);
+        Real* t = &tensors[6 * e];
+        t[0] = sigma[0][0];
+        t[1] = sigma[0][1];
+        t[2] = sigma[0][2];
+        t[3] = sigma[1][1];
+        t[4] = sigma[1][2];
+        t[5] = sigma[2][2];
+      }
+      check_vertex_dof_ordering(go_.trialGridFunctionSpace());
+      dataTree.set("time_gather", timer.lap());
+
+      // sparsity pattern: each vertex couples to the vertices of its elements
+      std::vector<std::vector<Index>> elementsOfVertex(numberOfVertices);
+      for (std::size_t e = 0; e < numberOfElements; ++e) {
+        for (unsigned int i = 0; i < 4; ++i) {
+          elementsOfVertex[connectivity[4 * e + i]].push_back(e);
+        }
+      }
+      std::vector<std::vector<Index>> rows(numberOfVertices);
+      std::size_t nonzeros = 0;
+      ElementNeighborhoodMapDetail::forEachIndex(numberOfVertices, [&](std::size_t v) {
+        auto& columns = rows[v];
+        for (auto e : elementsOfVertex[v]) {
+          columns.insert(columns.end(), &connectivity[4 * e], &connectivity[4 * e] + 4);
+        }
+        std::sort(columns.begin(), columns.end());
+        columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+        std::vector<Index>().swap(elementsOfVertex[v]);
+      });
+      for (const auto& columns : rows) {
+        nonzeros += columns.size();
+      }
+      auto container =
+          std::make_shared<Matrix>(numberOfVertices, numberOfVertices, nonzeros, Matrix::row_wise);
+      for (auto row = container->createbegin(); row != container->createend(); ++row) {
+        for (auto c : rows[row.index()]) {
+          row.insert(c);
+        }
+        std::vector<Index>().swap(rows[row.index()]);
+      }
+      *container = 0.0;
+      dataTree.set("time_pattern", timer.lap());
+      dataTree.set("nonzeros", nonzeros);
+
+      Batch batch;
+      for (std::size_t first = 0; first < numberOfElements; first += batchSize) {
+        const std::size_t lanes = std::min<std::size_t>(batchSize, numberOfElements - first);
+        batch.compute(coordinates, connectivity, tensors, first, lanes);
+        for (std::size_t l = 0; l < lanes; ++l) {
+          const Index* dofs = &connectivity[4 * (first + l)];
+          for (unsigned int i = 0; i < 4; ++i) {
+            auto& row = (*container)[dofs[i]];
+            for (unsigned int j = 0; j < 4; ++j) {
+              row[dofs[j]] += batch.entry(i, j, l);
+            }
+          }
+        }
+      }
+      dataTree.set("time_assembly", timer.lap());
+
+      auto jacobian = std::make_unique<Jacobian>();
+      jacobian->attach(container);
+      return jacobian;
+    }
+
+    // element matrices of a batch of tetrahedra. All arrays are indexed by the lane last.
+    struct Batch {
+      Real x[4][dim][batchSize];
+      Real gradient[4][dim][batchSize];
+      Real flux[4][dim][batchSize];
+      Real volume[batchSize];
+      Real sigma[6][batchSize];
+      Real matrix[4][4][batchSize];
+
+      void compute(const std::vector<Real>& coordinates, const std::vector<Index>& connectivity,
+                   const std::vector<Real>& tensors, std::size_t first, std::size_t lanes)
+      {
+        // gather. Unused lanes repeat the last element to keep the arithmetic finite.
+        for (std::size_t l = 0; l < batchSize; ++l) {
+          const std::size_t e = first + std::min(l, lanes - 1);
+          for (unsigned int i = 0; i < 4; ++i) {
+            const Real* p = &coordinates[dim * connectivity[4 * e + i]];
+            for (unsigned int k = 0; k < dim; ++k) {
+              x[i][k][l] = p[k];
+            }
+          }
+          for (unsigned int k = 0; k < 6; ++k) {
+            sigma[k][l] = tensors[6 * e + k];
+          }
+        }
+
+        // jacobian J = [p1-p0, p2-p0, p3-p0]. The gradients of the barycentric coordinates
+        // lambda_1, lambda_2, lambda_3 are the rows of J^{-1}, i.e. the columns of the cofactor
+        // matrix divided by det(J). c_ij denotes the cofactor of a_ij.
+        for (std::size_t l = 0; l < batchSize; ++l) {
+          const Real a00 = x[1][0][l] - x[0][0][l], a01 = x[2][0][l] - x[0][0][l],
+                     a02 = x[3][0][l] - x[0][0][l];
+          const Real a10 = x[1][1][l] - x[0][1][l], a11 = x[2][1][l] - x[0][1][l],
+                     a12 = x[3][1][l] - x[0][1][l];
+          const Real a20 = x[1][2][l] - x[0][2][l], a21 = x[2][2][l] - x[0][2][l],
+                     a22 = x[3][2][l] - x[0][2][l];
+          const Real c00 = a11 * a22 - a12 * a21, c01 = a12 * a20 - a10 * a22,
+                     c02 = a10 * a21 - a11 * a20;
+          const Real c10 = a02 * a21 - a01 * a22, c11 = a00 * a22 - a02 * a20,
+                     c12 = a01 * a20 - a00 * a21;
+          const Real c20 = a01 * a12 - a02 * a11, c21 = a02 * a10 - a00 * a12,
+                     c22 = a00 * a11 - a01 * a10;
+          const Real det = a00 * c00 + a01 * c01 + a02 * c02;
+          const Real invDet = Real(1.0) / det;
+          gradient[1][0][l] = c00 * invDet;
+          gradient[1][1][l] = c10 * invDet;
+          gradient[1][2][l] = c20 * invDet;
+          gradient[2][0][l] = c01 * invDet;
+          gradient[2][1][l] = c11 * invDet;
+          gradient[2][2][l] = c21 * invDet;
+          gradient[3][0][l] = c02 * invDet;
+          gradient[3][1][l] = c12 * invDet;
+          gradient[3][2][l] = c22 * invDet;
+          for (unsigned int k = 0; k < dim; ++k) {
+            gradient[0][k][l] = -gradient[1][k][l] - gradient[2][k][l] - gradient[3][k][l];
+          }
+          volume[l] = std::abs(det) / Real(6.0);
+        }
+
+        // flux sigma * gradient, scaled with the volume
+        for (unsigned int i = 0; i < 4; ++i) {
+          for (std::size_t l = 0; l < batchSize; ++l) {
+            const Real g0 = gradient[i][0][l], g1 = gradient[i][1][l], g2 = gradient[i][2][l];
+            flux[i][0][l] = volume[l] * (sigma[0][l] * g0 + sigma[1][l] * g1 + sigma[2][l] * g2);
+            flux[i][1][l] = volume[l] * (sigma[1][l] * g0 + sigma[3][l] * g1 + sigma[4][l] * g2);
+            flux[i][2][l] = volume[l] * (sigma[2][l] * g0 + sigma[4][l] * g1 + sigma[5][l] * g2);
+          }
+        }
+
+        for (unsigned int i = 0; i < 4; ++i) {
+          for (unsigned int j = i; j < 4; ++j) {
+            for (std::size_t l = 0; l < batchSize; ++l) {
+              matrix[i][j][l] = gradient[i][0][l] * flux[j][0][l]
+                                + gradient[i][1][l] * flux[j][1][l]
+                                + gradient[i][2][l] * flux[j][2][l];
+            }
+          }
+        }
+      }
+
+      Real entry(unsigned int i, unsigned int j, std::size_t l) const
+      {
+        return i <= j ? matrix[i][j][l] : matrix[j][i][l];
+      }
+    };
+
+    const GO& go_;
+    std::shared_ptr<const VC> volumeConductor_;
+  };
+}
+
+#endif // DUNEURO_P1_TETRAHEDRON_STIFFNESS_ASSEMBLER_HH
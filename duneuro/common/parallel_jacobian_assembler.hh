@@ -0,0 +1,384 @@
+#ifndef DUNEURO_PARALLEL_JACOBIAN_ASSEMBLER_HH
+#define DUNEURO_PARALLEL_JACOBIAN_ASSEMBLER_HH
+
+#if HAVE_TBB
+#include <tbb/enumerable_thread_specific.h>
+#endif
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include <dune/common/timer.hh>
+
+#include <dune/pdelab/gridfunctionspace/lfsindexcache.hh>
+#include <dune/pdelab/gridfunctionspace/localfunctionspace.hh>
+#include <dune/pdelab/gridfunctionspace/localvector.hh>
+#include <dune/pdelab/gridoperator/common/localassemblerenginebase.hh>
+#include <dune/pdelab/gridoperator/common/localmatrix.hh>
+#include <dune/pdelab/gridoperator/gridoperator.hh>
+#include <dune/pdelab/localoperator/callableadapters.hh>
+
+#include <duneuro/common/element_neighborhood_map.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  template <class GO>
+  struct IsPDELabGridOperator : std::false_type {
+  };
+
+  template <class GFSU, class GFSV, class LOP, class MB, class DF, class RF, class JF, class CU,
+            class CV>
+  struct IsPDELabGridOperator<Dune::PDELab::GridOperator<GFSU, GFSV, LOP, MB, DF, RF, JF, CU, CV>>
+      : std::true_type {
+    using LocalOperator = LOP;
+  };
+
+  /**
+   * \brief threaded assembly of the jacobian of a galerkin grid operator
+   *
+   * The sparsity pattern is computed from the element to degree of freedom relation, each row is
+   * set up independently. The elements are then colored such that elements of the same color do
+   * not write into the same matrix rows. The elements of one color are assembled in parallel,
+   * each thread using its own local function spaces and, if it is copyable, its own copy of the
+   * local operator. The element matrices are scattered directly into the global matrix without
+   * locking.
+   *
+   * Skeleton terms are assembled from the element with the lower index, writing to the rows of
+   * both elements. Constraints are not applied, so this assembler may only be used for function
+   * spaces without constraints. For these, the result is identical to GO::jacobian.
+   *
+   * The assembly is isolated from enclosing parallel loops, see
+   * ElementNeighborhoodMapDetail::isolate, as LinearProblemSolver assembles lazily and under a
+   * lock, e.g. from within the parallel sweep over the electrodes.
+   */
+  template <class GO>
+  class ParallelJacobianAssembler
+  {
+  public:
+    using GFS = typename GO::Traits::TrialGridFunctionSpace;
+    using GridView = typename GFS::Traits::GridViewType;
+    using LOP = typename IsPDELabGridOperator<GO>::LocalOperator;
+    using Jacobian = typename GO::Traits::Jacobian;
+    using Matrix = Dune::PDELab::Backend::Native<Jacobian>;
+    using Domain = typename GO::Traits::Domain;
+    using LFS = Dune::PDELab::LocalFunctionSpace<GFS>;
+    using LFSCache = Dune::PDELab::LFSIndexCache<LFS>;
+    using Index = std::size_t;
+    using Adjacency = ElementNeighborhoodMapDetail::CompressedAdjacency<Index>;
+
+    static_assert(std::is_same<typename GO::Traits::TrialGridFunctionSpace,
+                               typename GO::Traits::TestGridFunctionSpace>::value,
+                  "the parallel jacobian assembler requires a galerkin grid operator");
+
+    explicit ParallelJacobianAssembler(const GO& go) : go_(go)
+    {
+    }
+
+    std::unique_ptr<Jacobian> assemble(const Domain& x, DataTree dataTree = DataTree()) const
+    {
+      std::unique_ptr<Jacobian> jacobian;
+      ElementNeighborhoodMapDetail::isolate([&] { jacobian = assembleIsolated(x, dataTree); });
+      return jacobian;
+    }
+
+  private:
+    std::unique_ptr<Jacobian> assembleIsolated(const Domain& x, DataTree dataTree) const
+    {
+      Dune::Timer timer;
+      const auto& gfs = go_.trialGridFunctionSpace();
+      ElementNeighborhoodMap<GridView> neighborhood(gfs.gridView());
+      const std::size_t numberOfElements = neighborhood.size();
+
+      // block row indices of the degrees of freedom of each element
+      std::vector<std::vector<Index>> dofLists(numberOfElements);
+      forEachElement(neighborhood, [&](ThreadData& data, std::size_t e, const auto& element) {
+        data.lfs_s.bind(element);
+        data.cache_s.update();
+        auto& dofs = dofLists[e];
+        for (std::size_t i = 0; i < data.cache_s.size(); ++i) {
+          const auto& ci = data.cache_s.containerIndex(i);
+          dofs.push_back(ci[ci.size() - 1]);
+        }
+        std::sort(dofs.begin(), dofs.end());
+        dofs.erase(std::unique(dofs.begin(), dofs.end()), dofs.end());
+      });
+      Adjacency elementDofs = flatten(dofLists);
+      Domain tmp(gfs, 0.0);
+      const std::size_t numberOfRows = Dune::PDELab::Backend::native(tmp).N();
+      Adjacency dofElements = invert(elementDofs, numberOfRows);
+
+      // rows written when visiting an element: its own rows and, if skeleton terms are present,
+      // the rows of the neighbors whose intersection is visited from this element
+      std::vector<std::vector<Index>> writeLists(numberOfElements);
+      ElementNeighborhoodMapDetail::forEachIndex(numberOfElements, [&](std::size_t e) {
+        auto& rows = writeLists[e];
+        rows.assign(elementDofs[e].begin(), elementDofs[e].end());
+        if (doSkeleton) {
+          for (auto n : neighborhood.intersectionNeighbors(e)) {
+            if (visitSkeleton(e, n)) {
+              rows.insert(rows.end(), elementDofs[n].begin(), elementDofs[n].end());
+            }
+          }
+          std::sort(rows.begin(), rows.end());
+          rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+        }
+      });
+      Adjacency elementWrites = flatten(writeLists);
+
+      // sparsity pattern: row r couples to all dofs of the elements containing r and, with
+      // skeleton terms, to the dofs of their intersection neighbors
+      std::vector<std::vector<Index>> rowLists(numberOfRows);
+      ElementNeighborhoodMapDetail::forEachIndex(numberOfRows, [&](std::size_t r) {
+        auto& columns = rowLists[r];
+        for (auto e : dofElements[r]) {
+          columns.insert(columns.end(), elementDofs[e].begin(), elementDofs[e].end());
+          if (doSkeleton) {
+            for (auto n : neighborhood.intersectionNeighbors(e)) {
+              columns.insert(columns.end(), elementDofs[n].begin(), elementDofs[n].end());
+            }
+          }
+        }
+        std::sort(columns.begin(), columns.end());
+        columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+      });
+      Adjacency pattern = flatten(rowLists);
+      auto container = std::make_shared<Matrix>(numberOfRows, numberOfRows,
+                                                pattern.indices.size(), Matrix::row_wise);
+      for (auto row = container->createbegin(); row != container->createend(); ++row) {
+        for (auto c : pattern[row.index()]) {
+          row.insert(c);
+        }
+      }
+      *container = 0.0;
+      auto jacobian = std::make_unique<Jacobian>();
+      jacobian->attach(container);
+      dataTree.set("time_pattern", timer.lap());
+      dataTree.set("nonzeros", pattern.indices.size());
+
+      auto colors = color(elementWrites, invert(elementWrites, numberOfRows));
+      dataTree.set("colors", colors.size());
+      dataTree.set("time_coloring", timer.lap());
+
+      for (const auto& elements : colors) {
+        forEachElement(elements, neighborhood, [&](ThreadData& data, std::size_t e,
+                                                   const auto& element) {
+          assembleElement(data, neighborhood, e, element, x, *jacobian);
+        });
+      }
+      dataTree.set("time_assembly", timer.lap());
+      return jacobian;
+    }
+
+    using JF = typename Jacobian::field_type;
+    using DF = typename Domain::ElementType;
+    using LocalMatrix = Dune::PDELab::LocalMatrix<JF>;
+    using LocalVector = Dune::PDELab::LocalVector<DF, Dune::PDELab::TrialSpaceTag>;
+
+    static const bool doSkeleton = LOP::doAlphaSkeleton;
+    static const bool doBoundary = LOP::doAlphaBoundary;
+
+    struct ThreadData {
+      ThreadData(const GFS& gfs, const LOP& exemplar)
+          : lop(exemplar), lfs_s(gfs), cache_s(lfs_s), lfs_n(gfs), cache_n(lfs_n)
+      {
+      }
+
+      ThreadData(const ThreadData& other)
+          : ThreadData(other.lfs_s.gridFunctionSpace(), other.lop)
+      {
+      }
+
+      // local operators which can be copied are copied for each thread, e.g. to have thread local
+      // basis caches. Others have to be safe for concurrent evaluation.
+      std::conditional_t<std::is_copy_constructible<LOP>::value, LOP, const LOP&> lop;
+      LFS lfs_s;
+      LFSCache cache_s;
+      LFS lfs_n;
+      LFSCache cache_n;
+      LocalVector x_s, x_n;
+      LocalMatrix m_ss, m_sn, m_ns, m_nn;
+    };
+
+    const GO& go_;
+
+    static bool visitSkeleton(std::size_t e, std::size_t n)
+    {
+      return LOP::doSkeletonTwoSided || e < n;
+    }
+
+    static Adjacency flatten(std::vector<std::vector<Index>>& lists)
+    {
+      Adjacency result;
+      result.offsets.assign(lists.size() + 1, 0);
+      for (std::size_t i = 0; i < lists.size(); ++i) {
+        result.offsets[i + 1] = result.offsets[i] + lists[i].size();
+      }
+      result.indices.resize(result.offsets.back());
+      ElementNeighborhoodMapDetail::forEachIndex(lists.size(), [&](std::size_t i) {
+        std::copy(lists[i].begin(), lists[i].end(), result.indices.begin() + result.offsets[i]);
+        std::vector<Index>().swap(lists[i]);
+      });
+      return result;
+    }
+
+    static Adjacency invert(const Adjacency& adjacency, std::size_t size)
+    {
+      Adjacency result;
+      result.offsets.assign(size + 1, 0);
+      for (auto v : adjacency.indices) {
+        ++result.offsets[v + 1];
+      }
+      std::partial_sum(result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+      result.indices.resize(adjacency.indices.size());
+      std::vector<std::size_t> position(result.offsets.begin(), result.offsets.end() - 1);
+      for (std::size_t i = 0; i < adjacency.size(); ++i) {
+        for (auto v : adjacency[i]) {
+          result.indices[position[v]++] = i;
+        }
+      }
+      return result;
+    }
+
+    // greedy coloring of the elements, such that no two elements of the same color write to the
+    // same row
+    static std::vector<std::vector<Index>> color(const Adjacency& elementWrites,
+                                                 const Adjacency& rowWriters)
+    {
+      const std::size_t numberOfElements = elementWrites.size();
+      std::vector<std::size_t> colorOf(numberOfElements, std::size_t(-1));
+      std::vector<std::size_t> forbidden;
+      std::vector<std::vector<Index>> colors;
+      for (std::size_t e = 0; e < numberOfElements; ++e) {
+        for (auto r : elementWrites[e]) {
+          for (auto other : rowWriters[r]) {
+            auto c = colorOf[other];
+            if (c != std::size_t(-1)) {
+              forbidden[c] = e;
+            }
+          }
+        }
+        std::size_t c = 0;
+        while (c < colors.size() && forbidden[c] == e) {
+          ++c;
+        }
+        if (c == colors.size()) {
+          colors.emplace_back();
+          forbidden.push_back(std::size_t(-1));
+        }
+        colorOf[e] = c;
+        colors[c].push_back(e);
+      }
+      return colors;
+    }
+
+    template <class F>
+    void forEachElement(const ElementNeighborhoodMap<GridView>& neighborhood, F&& f) const
+    {
+      std::vector<Index> all(neighborhood.size());
+      std::iota(all.begin(), all.end(), 0);
+      forEachElement(all, neighborhood, f);
+    }
+
+    // apply f(threadData, index, element) to the given elements, in parallel if tbb is available
+    template <class F>
+    void forEachElement(const std::vector<Index>& elements,
+                        const ElementNeighborhoodMap<GridView>& neighborhood, F&& f) const
+    {
+      const auto& lop = go_.localAssembler().localOperator();
+#if HAVE_TBB
+      tbb::enumerable_thread_specific<ThreadData> threadData(go_.trialGridFunctionSpace(), lop);
+      ElementNeighborhoodMapDetail::forEachIndex(elements.size(), [&](std::size_t i) {
+        f(threadData.local(), elements[i], neighborhood.element(elements[i]));
+      });
+#else
+      ThreadData threadData(go_.trialGridFunctionSpace(), lop);
+      for (auto e : elements) {
+        f(threadData, e, neighborhood.element(e));
+      }
+#endif
+    }
+
+    static void readLocal(const LFSCache& cache, const Domain& x, LocalVector& xl)
+    {
+      xl.assign(cache.size(), 0.0);
+      for (std::size_t i = 0; i < cache.size(); ++i) {
+        xl.base()[i] = x[cache.containerIndex(i)];
+      }
+    }
+
+    static void scatter(const LFSCache& rowCache, const LFSCache& colCache, const LocalMatrix& m,
+                        Jacobian& jacobian)
+    {
+      for (std::size_t i = 0; i < rowCache.size(); ++i) {
+        for (std::size_t j = 0; j < colCache.size(); ++j) {
+          jacobian(rowCache.containerIndex(i), colCache.containerIndex(j)) +=
+              m(rowCache.localFunctionSpace(), i, colCache.localFunctionSpace(), j);
+        }
+      }
+    }
+
+    template <class Element>
+    void assembleElement(ThreadData& d, const ElementNeighborhoodMap<GridView>& neighborhood,
+                         std::size_t e, const Element& element, const Domain& x,
+                         Jacobian& jacobian) const
+    {
+      using Dune::PDELab::LocalAssemblerCallSwitch;
+      d.lfs_s.bind(element);
+      d.cache_s.update();
+      readLocal(d.cache_s, x, d.x_s);
+
+      d.m_ss.assign(d.cache_s.size(), d.cache_s.size(), 0.0);
+      {
+        Dune::PDELab::ElementGeometry<Element> eg(element);
+        auto view = d.m_ss.weightedAccumulationView(1.0);
+        LocalAssemblerCallSwitch<LOP, LOP::doAlphaVolume>::jacobian_volume(d.lop, eg, d.lfs_s,
+                                                                           d.x_s, d.lfs_s, view);
+      }
+
+      if (doSkeleton || doBoundary) {
+        const auto& gv = go_.trialGridFunctionSpace().gridView();
+        for (const auto& is : Dune::intersections(gv, element)) {
+          Dune::PDELab::IntersectionGeometry<typename GridView::Intersection> ig(
+              is, is.indexInInside());
+          if (is.neighbor()) {
+            if (!doSkeleton) {
+              continue;
+            }
+            const auto outside = is.outside();
+            const auto n = neighborhood.index(outside);
+            if (!visitSkeleton(e, n)) {
+              continue;
+            }
+            d.lfs_n.bind(outside);
+            d.cache_n.update();
+            readLocal(d.cache_n, x, d.x_n);
+            d.m_sn.assign(d.cache_s.size(), d.cache_n.size(), 0.0);
+            d.m_ns.assign(d.cache_n.size(), d.cache_s.size(), 0.0);
+            d.m_nn.assign(d.cache_n.size(), d.cache_n.size(), 0.0);
+            auto view_ss = d.m_ss.weightedAccumulationView(1.0);
+            auto view_sn = d.m_sn.weightedAccumulationView(1.0);
+            auto view_ns = d.m_ns.weightedAccumulationView(1.0);
+            auto view_nn = d.m_nn.weightedAccumulationView(1.0);
+            LocalAssemblerCallSwitch<LOP, LOP::doAlphaSkeleton>::jacobian_skeleton(
+                d.lop, ig, d.lfs_s, d.x_s, d.lfs_s, d.lfs_n, d.x_n, d.lfs_n, view_ss, view_sn,
+                view_ns, view_nn);
+            scatter(d.cache_s, d.cache_n, d.m_sn, jacobian);
+            scatter(d.cache_n, d.cache_s, d.m_ns, jacobian);
+            scatter(d.cache_n, d.cache_n, d.m_nn, jacobian);
+          } else if (is.boundary() && doBoundary) {
+            auto view = d.m_ss.weightedAccumulationView(1.0);
+            LocalAssemblerCallSwitch<LOP, LOP::doAlphaBoundary>::jacobian_boundary(
+                d.lop, ig, d.lfs_s, d.x_s, d.lfs_s, view);
+          }
+        }
+      }
+      scatter(d.cache_s, d.cache_s, d.m_ss, jacobian);
+    }
+  };
+}
+
+#endif // DUNEURO_PARALLEL_JACOBIAN_ASSEMBLER_HH
@@ -0,0 +1,172 @@
+#ifndef DUNEURO_PATCH_LOCAL_FUNCTION_HH
+#define DUNEURO_PATCH_LOCAL_FUNCTION_HH
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <dune/pdelab/gridfunctionspace/localfunctionspace.hh>
+#include <dune/pdelab/gridfunctionspace/lfsindexcache.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief finite element function with a sparse, patch local coefficient vector
+   *
+   * The cutoff function chi of the localized subtraction approach is a finite element function
+   * whose coefficients only differ from zero on the dofs of the patch elements. Instead of a
+   * coefficient vector on the whole grid function space, only the non zero coefficients are
+   * stored, keyed by their container index. Setting up chi is thus linear in the size of the
+   * patch and independent of the number of dofs of the grid function space.
+   *
+   * The local functions provide the subset of the interface of the local functions of
+   * Dune::PDELab::DiscreteGridViewFunction used by the localized subtraction operators.
+   */
+  template <class GFS, class RF>
+  class PatchLocalFunction
+  {
+  public:
+    using GridFunctionSpace = GFS;
+    using LFS = Dune::PDELab::LocalFunctionSpace<GFS>;
+    using LFSCache = Dune::PDELab::LFSIndexCache<LFS>;
+    using ContainerIndex = typename LFSCache::ContainerIndex;
+    using Element = typename GFS::Traits::GridViewType::template Codim<0>::Entity;
+    using LocalBasisTraits =
+        typename LFS::Traits::FiniteElementType::Traits::LocalBasisType::Traits;
+    using Domain = typename LocalBasisTraits::DomainType;
+    enum { dim = LocalBasisTraits::dimDomain };
+    using Range = RF;
+    using DerivativeRange = Dune::FieldMatrix<RF, 1, dim>;
+
+    explicit PatchLocalFunction(const GFS& gfs) : gfs_(gfs)
+    {
+    }
+
+    //! remove all coefficients, i.e. reset the function to zero
+    void clear()
+    {
+      coefficients_.clear();
+    }
+
+    void reserve(std::size_t size)
+    {
+      coefficients_.reserve(size);
+    }
+
+    //! set the coefficient of the dof with the given container index
+    void set(const ContainerIndex& index, RF value)
+    {
+      coefficients_[index] = value;
+    }
+
+    RF coefficient(const ContainerIndex& index) const
+    {
+      auto it = coefficients_.find(index);
+      return it == coefficients_.end() ? RF(0.0) : it->second;
+    }
+
+    //! number of stored, i.e. potentially non zero, coefficients
+    std::size_t size() const
+    {
+      return coefficients_.size();
+    }
+
+    const GFS& gridFunctionSpace() const
+    {
+      return gfs_;
+    }
+
+    // common part of the local function and its derivative: binds a local function space and
+    // gathers the local coefficients from the sparse storage
+    class LocalFunctionBase
+    {
+    public:
+      explicit LocalFunctionBase(const PatchLocalFunction& function)
+          : function_(&function)
+          , lfs_(std::make_unique<LFS>(function.gridFunctionSpace()))
+          , cache_(std::make_unique<LFSCache>(*lfs_))
+      {
+      }
+
+      void bind(const Element& element)
+      {
+        element_ = element;
+        lfs_->bind(element);
+        cache_->update();
+        localCoefficients_.resize(cache_->size());
+        for (std::size_t i = 0; i < cache_->size(); ++i) {
+          localCoefficients_[i] = function_->coefficient(cache_->containerIndex(i));
+        }
+      }
+
+    protected:
+      const PatchLocalFunction* function_;
+      std::unique_ptr<LFS> lfs_;
+      std::unique_ptr<LFSCache> cache_;
+      Element element_;
+      std::vector<RF> localCoefficients_;
+    };
+
+    class LocalFunction : public LocalFunctionBase
+    {
+    public:
+      using LocalFunctionBase::LocalFunctionBase;
+
+      Range operator()(const Domain& local) const
+      {
+        const auto& basis = this->lfs_->finiteElement().localBasis();
+        basis.evaluateFunction(local, values_);
+        Range result(0.0);
+        for (std::size_t i = 0; i < this->localCoefficients_.size(); ++i) {
+          result += this->localCoefficients_[i] * values_[i][0];
+        }
+        return result;
+      }
+
+    private:
+      mutable std::vector<typename LocalBasisTraits::RangeType> values_;
+    };
+
+    class LocalDerivativeFunction : public LocalFunctionBase
+    {
+    public:
+      using LocalFunctionBase::LocalFunctionBase;
+
+      DerivativeRange operator()(const Domain& local) const
+      {
+        const auto& basis = this->lfs_->finiteElement().localBasis();
+        basis.evaluateJacobian(local, jacobians_);
+        Dune::FieldVector<RF, dim> referenceGradient(0.0);
+        for (std::size_t i = 0; i < this->localCoefficients_.size(); ++i) {
+          referenceGradient.axpy(this->localCoefficients_[i], jacobians_[i][0]);
+        }
+        DerivativeRange result;
+        this->element_.geometry().jacobianInverseTransposed(local).mv(referenceGradient, result[0]);
+        return result;
+      }
+
+    private:
+      mutable std::vector<typename LocalBasisTraits::JacobianType> jacobians_;
+    };
+
+    LocalFunction localFunction() const
+    {
+      return LocalFunction(*this);
+    }
+
+    LocalDerivativeFunction localDerivativeFunction() const
+    {
+      return LocalDerivativeFunction(*this);
+    }
+
+  private:
+    const GFS& gfs_;
+    std::unordered_map<ContainerIndex, RF> coefficients_;
+  };
+}
+
+#endif // DUNEURO_PATCH_LOCAL_FUNCTION_HH
@@ -43,6 +43,19 @@ namespace duneuro
     std::uniform_real_distribution<T> dist(low, high);
     random_detail::randomize_uniform(vector, [&]() { return dist(mt); });
   }
+
+  /**
+   * replaces the entries of a vector by unform random values in [low,high), using a generator
+   * initialized with the given seed. The result is reproducible.
+   */
+  template <class T, int N>
+  void randomize_uniform_seeded(Dune::BlockVector<Dune::FieldVector<T, N>>& vector,
+                                unsigned int seed, T low = T(0.0), T high = T(1.0))
+  {
+    std::mt19937 mt(seed);
+    std::uniform_real_distribution<T> dist(low, high);
+    random_detail::randomize_uniform(vector, [&]() { return dist(mt); });
+  }
 }
 
 #endif // DUNEURO_RANDOM_HH
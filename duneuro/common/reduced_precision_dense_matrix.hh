@@ -0,0 +1,291 @@
+#ifndef DUNEURO_REDUCED_PRECISION_DENSE_MATRIX_HH
+#define DUNEURO_REDUCED_PRECISION_DENSE_MATRIX_HH
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parametertree.hh>
+
+#include <dune/istl/bvector.hh>
+
+#include <duneuro/common/dense_matrix.hh>
+#include <duneuro/common/mapped_dense_matrix.hh>
+#include <duneuro/common/matrix_utilities.hh>
+#include <duneuro/common/sparse_vector_container.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  enum class DenseMatrixPrecision { float32, int16 };
+
+  inline DenseMatrixPrecision dense_matrix_precision_from_string(const std::string& name)
+  {
+    if (name == "float32") {
+      return DenseMatrixPrecision::float32;
+    } else if (name == "int16") {
+      return DenseMatrixPrecision::int16;
+    } else {
+      DUNE_THROW(Dune::Exception, "unknown reduced dense matrix precision \"" << name << "\"");
+    }
+  }
+
+  inline std::string to_string(DenseMatrixPrecision precision)
+  {
+    return precision == DenseMatrixPrecision::float32 ? "float32" : "int16";
+  }
+
+  /**
+   * \brief row major dense matrix of doubles stored in a reduced precision
+   *
+   * The entries are stored either as single precision floats or as 16 bit integers with one
+   * scaling factor per row: entry (r, c) is scale(r) * stored(r, c), where the scale maps the
+   * entry of largest magnitude of the row to 32767. The entries are converted when a row is set.
+   * For every row, the largest error introduced by the conversion relative to the largest
+   * magnitude of the row is recorded. As the error is measured against the largest entry of the
+   * row, it bounds the error of the product of the row with any vector relative to the product
+   * of the absolute values.
+   *
+   * The products with vectors below convert the entries back to double while accumulating. The
+   * stored entries are created by make_dense_matrix, so they can be kept in memory, in an
+   * anonymous mapping or in a file.
+   */
+  class ReducedPrecisionDenseMatrix
+  {
+  public:
+    ReducedPrecisionDenseMatrix(std::size_t rows, std::size_t cols, DenseMatrixPrecision precision,
+                                const Dune::ParameterTree& storageConfig = Dune::ParameterTree())
+        : precision_(precision), scales_(rows, 1.0), errors_(rows, 0.0)
+    {
+      if (precision_ == DenseMatrixPrecision::float32) {
+        float_ = make_dense_matrix<float>(rows, cols, storageConfig);
+      } else {
+        int16_ = make_dense_matrix<std::int16_t>(rows, cols, storageConfig);
+      }
+    }
+
+    std::size_t rows() const
+    {
+      return scales_.size();
+    }
+
+    std::size_t cols() const
+    {
+      return visit([](const auto& values) { return values.cols(); });
+    }
+
+    DenseMatrixPrecision precision() const
+    {
+      return precision_;
+    }
+
+    //! key of the selection of columns, see DenseMatrix::columnKey
+    std::uint64_t columnKey() const
+    {
+      return visit([](const auto& values) { return values.columnKey(); });
+    }
+
+    void setColumnKey(std::uint64_t key)
+    {
+      visit([&](auto& values) { values.setColumnKey(key); });
+    }
+
+    double scale(std::size_t row) const
+    {
+      return scales_[row];
+    }
+
+    //! largest conversion error of the row relative to its entry of largest magnitude
+    double maxRelativeError(std::size_t row) const
+    {
+      return errors_[row];
+    }
+
+    //! memory used by the stored entries in bytes
+    std::size_t memory() const
+    {
+      return visit([](const auto& values) {
+        return values.rows() * values.cols() * sizeof(*values.data());
+      });
+    }
+
+    double operator()(std::size_t r, std::size_t c) const
+    {
+      return scales_[r] * visit([&](const auto& values) { return double(values(r, c)); });
+    }
+
+    /**
+     * \brief convert and store a row
+     *
+     * If columns is given, entry (*columns)[i] of the vector is stored in column i, otherwise
+     * the vector has to contain an entry for every column. Different rows can be set
+     * concurrently.
+     */
+    template <int blockSize>
+    void setRow(std::size_t row, const Dune::BlockVector<Dune::FieldVector<double, blockSize>>& vector,
+                const std::vector<std::size_t>* columns = nullptr)
+    {
+      const std::size_t cols = this->cols();
+      if (row >= rows()) {
+        DUNE_THROW(Dune::Exception, "tried to set row " << row << " but only " << rows()
+                                                        << " rows are present");
+      }
+      if (!columns && vector.dim() != cols) {
+        DUNE_THROW(Dune::Exception, "tried to set row with " << vector.dim()
+                                                             << " entries, but row has actually "
+                                                             << cols << " entries");
+      }
+      auto entry = [&](std::size_t i) {
+        const std::size_t c = columns ? (*columns)[i] : i;
+        return vector[c / blockSize][c % blockSize];
+      };
+      double maxAbs = 0.0;
+      for (std::size_t i = 0; i < cols; ++i) {
+        maxAbs = std::max(maxAbs, std::abs(entry(i)));
+      }
+      double maxError = 0.0;
+      if (precision_ == DenseMatrixPrecision::float32) {
+        float* stored = float_->data() + row * cols;
+        for (std::size_t i = 0; i < cols; ++i) {
+          const double value = entry(i);
+          stored[i] = static_cast<float>(value);
+          maxError = std::max(maxError, std::abs(double(stored[i]) - value));
+        }
+        scales_[row] = 1.0;
+      } else {
+        const double limit = std::numeric_limits<std::int16_t>::max();
+        const double scale = maxAbs > 0.0 ? maxAbs / limit : 1.0;
+        std::int16_t* stored = int16_->data() + row * cols;
+        for (std::size_t i = 0; i < cols; ++i) {
+          const double value = entry(i);
+          const double quantized = std::max(-limit, std::min(limit, std::round(value / scale)));
+          stored[i] = static_cast<std::int16_t>(quantized);
+          maxError = std::max(maxError, std::abs(quantized * scale - value));
+        }
+        scales_[row] = scale;
+      }
+      errors_[row] = maxAbs > 0.0 ? maxError / maxAbs : 0.0;
+    }
+
+    //! call f with the matrix of stored entries, either a DenseMatrix<float> or DenseMatrix<int16_t>
+    template <class F>
+    decltype(auto) visit(F&& f) const
+    {
+      if (precision_ == DenseMatrixPrecision::float32) {
+        return f(static_cast<const DenseMatrix<float>&>(*float_));
+      } else {
+        return f(static_cast<const DenseMatrix<std::int16_t>&>(*int16_));
+      }
+    }
+
+    template <class F>
+    decltype(auto) visit(F&& f)
+    {
+      if (precision_ == DenseMatrixPrecision::float32) {
+        return f(*float_);
+      } else {
+        return f(*int16_);
+      }
+    }
+
+    //! multiply entry r of each of the numberOfVectors consecutive vectors of size rows() by scale(r)
+    void scaleRows(double* vectors, std::size_t numberOfVectors = 1) const
+    {
+      if (precision_ == DenseMatrixPrecision::float32) {
+        return;
+      }
+      for (std::size_t j = 0; j < numberOfVectors; ++j) {
+        for (std::size_t r = 0; r < rows(); ++r) {
+          vectors[j * rows() + r] *= scales_[r];
+        }
+      }
+    }
+
+    //! store the precision, the memory and the conversion error of each row
+    void report(DataTree dataTree) const
+    {
+      dataTree.set("type", to_string(precision_));
+      dataTree.set("memory", memory());
+      double maxError = 0.0;
+      for (std::size_t r = 0; r < rows(); ++r) {
+        dataTree.set("row_" + std::to_string(r) + ".max_relative_error", errors_[r]);
+        maxError = std::max(maxError, errors_[r]);
+      }
+      dataTree.set("max_relative_error", maxError);
+    }
+
+  private:
+    DenseMatrixPrecision precision_;
+    std::unique_ptr<DenseMatrix<float>> float_;
+    std::unique_ptr<DenseMatrix<std::int16_t>> int16_;
+    std::vector<double> scales_;
+    std::vector<double> errors_;
+  };
+
+  template <int blockSize>
+  void set_matrix_row(ReducedPrecisionDenseMatrix& matrix, std::size_t row,
+                      const Dune::BlockVector<Dune::FieldVector<double, blockSize>>& vector)
+  {
+    matrix.setRow(row, vector);
+  }
+
+  template <int blockSize>
+  std::vector<double>
+  matrix_dense_vector_product(const ReducedPrecisionDenseMatrix& matrix,
+                              const Dune::BlockVector<Dune::FieldVector<double, blockSize>>& vector)
+  {
+    auto output =
+        matrix.visit([&](const auto& values) { return matrix_dense_vector_product(values, vector); });
+    matrix.scaleRows(output.data());
+    return output;
+  }
+
+  inline void matrix_dense_panel_product(const ReducedPrecisionDenseMatrix& matrix,
+                                         const double* panel, std::size_t numberOfVectors,
+                                         double* output)
+  {
+    matrix.visit([&](const auto& values) {
+      matrix_dense_panel_product(values, panel, numberOfVectors, output);
+    });
+    matrix.scaleRows(output, numberOfVectors);
+  }
+
+  inline std::vector<double> matrix_sparse_vector_product(const ReducedPrecisionDenseMatrix& matrix,
+                                                          const CompactSparseVector<double>& vector)
+  {
+    auto output = matrix.visit(
+        [&](const auto& values) { return matrix_sparse_vector_product(values, vector); });
+    matrix.scaleRows(output.data());
+    return output;
+  }
+
+  template <class I, class F>
+  std::vector<double> matrix_sparse_vector_product(const ReducedPrecisionDenseMatrix& matrix,
+                                                   const SparseVectorContainer<I, double>& vector,
+                                                   F toFlat)
+  {
+    CompactSparseVector<double> compact;
+    compact_sparse_vector(vector, toFlat, compact);
+    return matrix_sparse_vector_product(matrix, compact);
+  }
+
+  inline std::vector<std::vector<double>>
+  matrix_sparse_vectors_product(const ReducedPrecisionDenseMatrix& matrix,
+                                const std::vector<CompactSparseVector<double>>& vectors)
+  {
+    auto output = matrix.visit(
+        [&](const auto& values) { return matrix_sparse_vectors_product(values, vectors); });
+    for (auto& vector : output) {
+      matrix.scaleRows(vector.data());
+    }
+    return output;
+  }
+}
+
+#endif // DUNEURO_REDUCED_PRECISION_DENSE_MATRIX_HH
@@ -0,0 +1,238 @@
+#ifndef DUNEURO_SEQ_AMG_DG_MIXED_PRECISION_BACKEND_HH
+#define DUNEURO_SEQ_AMG_DG_MIXED_PRECISION_BACKEND_HH
+
+#include <iostream>
+#include <memory>
+
+#include <dune/common/parametertree.hh>
+#include <dune/common/timer.hh>
+
+#include <dune/istl/matrixmatrix.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/amg.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+
+#include <dune/pdelab/backend/istl/bcrsmatrixbackend.hh>
+#include <dune/pdelab/backend/istl/seq_amg_dg_backend.hh>
+#include <dune/pdelab/backend/solver.hh>
+#include <dune/pdelab/gridoperator/gridoperator.hh>
+
+#include <duneuro/common/mixed_precision_amg.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief sequential cg solver for dg discretizations, preconditioned by amg in the cg subspace
+   * using single precision
+   *
+   * The setup follows Dune::PDELab::ISTLBackend_SEQ_AMG_4_DG: the dg matrix is projected to the
+   * first order cg subspace by the triple product P^T A P, where P is the prolongation from the
+   * cg to the dg space, and the hybrid preconditioner Dune::PDELab::SeqDGAMGPrec combines an
+   * ssor smoother on the dg level with an amg in the cg subspace. The amg is a
+   * MixedPrecisionAMG, i.e. its hierarchy and smoothers use single precision, while the dg
+   * smoother, cg and the residuals stay in double precision.
+   *
+   * If mixed_precision.validate is set in the config, every system is additionally solved with
+   * a double precision amg in the cg subspace and the iteration counts of both are reported.
+   */
+  template <class DGGO, class CGGFS, class TransferLOP>
+  class ISTLBackend_SEQ_MixedPrecisionAMG_4_DG : public Dune::PDELab::LinearResultStorage
+  {
+    using GFS = typename DGGO::Traits::TrialGridFunctionSpace;
+    using M = typename DGGO::Traits::Jacobian;
+    using V = typename DGGO::Traits::Domain;
+    using W = typename DGGO::Traits::Range;
+    using Matrix = Dune::PDELab::Backend::Native<M>;
+    using Vector = Dune::PDELab::Backend::Native<V>;
+    using field_type = typename Vector::field_type;
+    using Real = typename Dune::FieldTraits<typename V::ElementType>::real_type;
+
+    // prolongation from the cg to the dg space
+    using EmptyTransformation = Dune::PDELab::EmptyTransformation;
+    using PMBE = Dune::PDELab::ISTL::BCRSMatrixBackend<>;
+    using PGO = Dune::PDELab::GridOperator<CGGFS, GFS, TransferLOP, PMBE, field_type, field_type,
+                                           field_type, EmptyTransformation, EmptyTransformation>;
+    using P = Dune::PDELab::Backend::Native<typename PGO::Jacobian>;
+
+    // matrix and vectors in the cg subspace
+    using PTADG = typename Dune::TransposedMatMultMatResult<P, Matrix>::type;
+    using CGMatrix = typename Dune::MatMultMatResult<PTADG, P>::type;
+    using CGVector = Dune::BlockVector<Dune::FieldVector<field_type, P::block_type::cols>>;
+
+    using DGPrec = Dune::SeqSSOR<Matrix, Vector, Vector, 1>;
+    using MixedAMG = MixedPrecisionAMG<CGMatrix, CGVector>;
+    using CGOperator = Dune::MatrixAdapter<CGMatrix, CGVector, CGVector>;
+    using CGSmoother = Dune::SeqSSOR<CGMatrix, CGVector, CGVector, 1>;
+    using AMG = Dune::Amg::AMG<CGOperator, CGVector, CGSmoother>;
+    using Criterion = Dune::Amg::CoarsenCriterion<
+        Dune::Amg::SymmetricCriterion<CGMatrix, Dune::Amg::FirstDiagonal>>;
+
+  public:
+    ISTLBackend_SEQ_MixedPrecisionAMG_4_DG(DGGO& dggo, const CGGFS& cggfs,
+                                           const Dune::ParameterTree& params)
+        : dggo_(dggo)
+        , cggfs_(cggfs)
+        , verbose_(params.get<int>("verbose", 0))
+        , maxiter_(params.get<unsigned int>("max_iterations", 5000))
+        , cgSmootherIterations_(params.get<unsigned int>("cg_smoother_iterations", 1))
+        , dgSmootherIterations_(params.get<unsigned int>("dg_smoother_iterations", 2))
+        , validate_(params.get<bool>("mixed_precision.validate", false))
+        , reuse_(false)
+        , firstapply_(true)
+        , params_(15, 2000)
+    {
+      params_.setDefaultValuesIsotropic(GFS::Traits::GridViewType::dimension);
+      params_.setDebugLevel(verbose_);
+    }
+
+    //! Set whether the AMG should be reused again during call to apply().
+    void setReuse(bool reuse)
+    {
+      reuse_ = reuse;
+    }
+
+    //! Return whether the AMG is reused during call to apply()
+    bool getReuse() const
+    {
+      return reuse_;
+    }
+
+    /*! \brief solve the given linear system
+
+      \param[in] A the given matrix
+      \param[out] z the solution vector to be computed
+      \param[in] r right hand side
+      \param[in] reduction to be achieved
+    */
+    void apply(M& A, V& z, W& r, Real reduction)
+    {
+      using Dune::PDELab::Backend::native;
+      // the solver overwrites the right hand side, keep copies for the validation solve
+      std::unique_ptr<Vector> z0;
+      std::unique_ptr<Vector> r0;
+      if (validate_) {
+        z0 = std::make_unique<Vector>(native(z));
+        r0 = std::make_unique<Vector>(native(r));
+      }
+      Dune::Timer watch;
+      double setupTime = 0.0;
+      if (!reuse_ || firstapply_) {
+        setup(native(A));
+        firstapply_ = false;
+        setupTime = watch.elapsed();
+        if (verbose_ > 0)
+          std::cout << "=== mixed precision AMG setup " << setupTime << " s" << std::endl;
+      } else if (verbose_ > 0) {
+        std::cout << "=== reuse CG matrix, SKIPPING AMG setup " << std::endl;
+      }
+      solve(native(A), *mixedAMG_, native(z), native(r), reduction, setupTime);
+      mixedIterations_ = res.iterations;
+      if (validate_) {
+        const auto mixedResult = res;
+        watch.reset();
+        setupTime = 0.0;
+        if (!amg_) {
+          cgOperator_ = std::make_shared<CGOperator>(acg_);
+          Criterion criterion(params_);
+          amg_ = std::make_shared<AMG>(*cgOperator_, criterion, smootherArgs());
+          setupTime = watch.elapsed();
+        }
+        solve(native(A), *amg_, *z0, *r0, reduction, setupTime);
+        doubleIterations_ = res.iterations;
+        doubleTime_ = res.elapsed;
+        if (verbose_ > 0)
+          std::cout << "=== mixed precision: " << mixedIterations_ << " iterations, double: "
+                    << doubleIterations_ << " iterations" << std::endl;
+        res = mixedResult;
+      }
+    }
+
+    //! store the iteration counts and the memory of the single precision cg subspace matrix
+    void report(DataTree dataTree) const
+    {
+      auto sub = dataTree.sub("mixed_precision");
+      sub.set("preconditioner_matrix_memory", mixedAMG_ ? mixedAMG_->matrixMemory() : 0);
+      sub.set("iterations", mixedIterations_);
+      if (validate_) {
+        sub.set("iterations_double", doubleIterations_);
+        sub.set("time_double", doubleTime_);
+      }
+    }
+
+  private:
+    DGGO& dggo_;
+    const CGGFS& cggfs_;
+    int verbose_;
+    unsigned int maxiter_;
+    unsigned int cgSmootherIterations_;
+    unsigned int dgSmootherIterations_;
+    bool validate_;
+    bool reuse_;
+    bool firstapply_;
+    Dune::Amg::Parameters params_;
+    std::shared_ptr<P> pmatrix_;
+    CGMatrix acg_;
+    std::shared_ptr<MixedAMG> mixedAMG_;
+    std::shared_ptr<CGOperator> cgOperator_;
+    std::shared_ptr<AMG> amg_;
+    unsigned int mixedIterations_ = 0;
+    unsigned int doubleIterations_ = 0;
+    double doubleTime_ = 0.0;
+
+    typename Dune::Amg::SmootherTraits<CGSmoother>::Arguments smootherArgs() const
+    {
+      typename Dune::Amg::SmootherTraits<CGSmoother>::Arguments args;
+      args.iterations = cgSmootherIterations_;
+      args.relaxationFactor = 1.0;
+      return args;
+    }
+
+    void setup(const Matrix& A)
+    {
+      using Dune::PDELab::Backend::native;
+      if (!pmatrix_) {
+        TransferLOP lop;
+        PMBE mbe(27);
+        EmptyTransformation cc;
+        PGO pgo(cggfs_, cc, dggo_.trialGridFunctionSpace(), cc, lop, mbe);
+        typename PGO::Domain cgx(cggfs_, 0.0);
+        typename PGO::Jacobian pmat(pgo);
+        pgo.jacobian(cgx, pmat);
+        pmatrix_ = std::make_shared<P>(native(pmat));
+      }
+      PTADG ptadg;
+      Dune::transposeMatMultMat(ptadg, *pmatrix_, A);
+      Dune::matMultMat(acg_, ptadg, *pmatrix_);
+      mixedAMG_ = std::make_shared<MixedAMG>(acg_, params_, cgSmootherIterations_);
+      amg_.reset();
+      cgOperator_.reset();
+    }
+
+    template <class CGPrec>
+    void solve(const Matrix& A, CGPrec& cgprec, Vector& z, Vector& r, Real reduction,
+               double setupTime)
+    {
+      Dune::Timer watch;
+      Dune::MatrixAdapter<Matrix, Vector, Vector> op(A);
+      DGPrec dgprec(A, 1, 1.0);
+      Dune::PDELab::SeqDGAMGPrec<Matrix, DGPrec, CGPrec, P> hybridprec(
+          A, dgprec, cgprec, *pmatrix_, dgSmootherIterations_, dgSmootherIterations_);
+      Dune::CGSolver<Vector> solver(op, hybridprec, reduction, maxiter_, verbose_);
+      Dune::InverseOperatorResult stat;
+      solver.apply(z, r, stat);
+      double solveTime = watch.elapsed();
+      if (verbose_ > 0)
+        std::cout << "=== solving (reduction: " << reduction << ") " << solveTime << " s"
+                  << std::endl;
+      res.converged = stat.converged;
+      res.iterations = stat.iterations;
+      res.elapsed = setupTime + solveTime;
+      res.reduction = stat.reduction;
+      res.conv_rate = stat.conv_rate;
+    }
+  };
+}
+
+#endif // DUNEURO_SEQ_AMG_DG_MIXED_PRECISION_BACKEND_HH
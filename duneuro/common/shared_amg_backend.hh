@@ -0,0 +1,361 @@
+#ifndef DUNEURO_SHARED_AMG_BACKEND_HH
+#define DUNEURO_SHARED_AMG_BACKEND_HH
+
+#include <iostream>
+#include <memory>
+
+#include <dune/common/timer.hh>
+
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/amg.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+#if HAVE_SUPERLU
+#include <dune/istl/superlu.hh>
+#endif
+
+#include <dune/pdelab/backend/interface.hh>
+#include <dune/pdelab/backend/istl/seqistlsolverbackend.hh>
+
+#include <duneuro/common/cg_linear_solver_backend.hh>
+#include <duneuro/common/mixed_precision_amg.hh>
+#include <duneuro/common/shared_amg_hierarchy.hh>
+#include <duneuro/common/sparse_direct_solver.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief sequential cg solver preconditioned by amg with an optionally shared hierarchy
+   *
+   * If neither the hierarchy is shared nor a deflation space is given, the assembled system is
+   * solved by an instance of Dune::PDELab::ISTLBackend_SEQ_CG_AMG_SSOR with reuse enabled, so
+   * the default solve path is the one of pdelab. If the hierarchy is shared, copies of this
+   * backend (e.g. the thread local backends of a tbb::enumerable_thread_specific created from an
+   * exemplar) use a single SharedAMGHierarchy, which is built by the first copy calling apply.
+   * Only the smoothers, the coarse level solver and the work vectors are created per copy. As
+   * with the pdelab backend, copies made after the first call to apply share the complete amg
+   * instance.
+   */
+  template <class GO>
+  class ISTLBackend_SEQ_CG_SharedAMG_SSOR : public CGLinearSolverBackend<GO>
+  {
+    using BaseT = CGLinearSolverBackend<GO>;
+
+  protected:
+    using GFS = typename GO::Traits::TrialGridFunctionSpace;
+    using typename BaseT::M;
+    using typename BaseT::V;
+    using typename BaseT::W;
+    using typename BaseT::Matrix;
+    using typename BaseT::Vector;
+    using typename BaseT::Real;
+    using Smoother = Dune::SeqSSOR<Matrix, Vector, Vector, 1>;
+    using Operator = Dune::MatrixAdapter<Matrix, Vector, Vector>;
+    using SmootherArgs = typename Dune::Amg::SmootherTraits<Smoother>::Arguments;
+    using AMG = Dune::Amg::AMG<Operator, Vector, Smoother>;
+    using OperatorHierarchy = typename AMG::OperatorHierarchy;
+    using Parameters = Dune::Amg::Parameters;
+    using Criterion =
+        Dune::Amg::CoarsenCriterion<Dune::Amg::SymmetricCriterion<Matrix, Dune::Amg::FirstDiagonal>>;
+#if HAVE_SUPERLU
+    using CoarseSolver = Dune::SuperLU<Matrix>;
+#else
+    using CoarseSolver = Dune::BiCGSTABSolver<Vector>;
+#endif
+    enum { dim = GFS::Traits::GridViewType::dimension };
+
+  public:
+    using Hierarchy = SharedAMGHierarchy<Operator, OperatorHierarchy>;
+    using typename BaseT::Deflation;
+    using BaseT::apply;
+
+    explicit ISTLBackend_SEQ_CG_SharedAMG_SSOR(unsigned int maxiter = 5000, int verbose = 0,
+                                               bool shareHierarchy = false,
+                                               std::shared_ptr<Deflation> deflation = nullptr)
+        : BaseT(maxiter, verbose, deflation)
+        , shareHierarchy_(shareHierarchy)
+        , params_(15, 2000)
+        , hierarchy_(std::make_shared<Hierarchy>())
+        , defaultBackend_(maxiter, verbose, true, true)
+    {
+      params_.setDefaultValuesIsotropic(dim);
+      params_.setDebugLevel(this->verbose_);
+    }
+
+    virtual std::unique_ptr<BaseT> clone() const override
+    {
+      return std::make_unique<ISTLBackend_SEQ_CG_SharedAMG_SSOR>(*this);
+    }
+
+    //! Return whether the amg hierarchy is shared between copies of this backend
+    bool sharesHierarchy() const
+    {
+      return shareHierarchy_;
+    }
+
+    virtual void apply(M& A, V& z, W& r, Real reduction) override
+    {
+      if (!shareHierarchy_ && !this->deflation_) {
+        defaultBackend_.apply(A, z, r, reduction);
+        this->res = defaultBackend_.result();
+        return;
+      }
+      solveAMG(A, z, r, reduction);
+    }
+
+  protected:
+    bool shareHierarchy_;
+    Parameters params_;
+
+    // solve the assembled system using the double precision amg of this backend
+    void solveAMG(M& A, V& z, W& r, Real reduction)
+    {
+      using Dune::PDELab::Backend::native;
+      double setupTime = setupAMG(A);
+      Operator op(native(A));
+      this->solve(op, *amg_, z, r, reduction, setupTime);
+    }
+
+  private:
+    std::shared_ptr<Hierarchy> hierarchy_;
+    std::shared_ptr<Operator> operator_;
+    std::shared_ptr<Operator> coarseOperator_;
+    std::shared_ptr<Smoother> coarseSmoother_;
+    std::shared_ptr<AMG> amg_;
+    Dune::PDELab::ISTLBackend_SEQ_CG_AMG_SSOR<GO> defaultBackend_;
+
+    double setupAMG(const M& A)
+    {
+      using Dune::PDELab::Backend::native;
+      if (amg_) {
+        if (this->verbose_ > 0)
+          std::cout << "=== reuse AMG, SKIPPING AMG setup " << std::endl;
+        return 0.0;
+      }
+      Dune::Timer watch;
+      SmootherArgs smootherArgs;
+      smootherArgs.iterations = 1;
+      smootherArgs.relaxationFactor = 1;
+      Criterion criterion(params_);
+      if (shareHierarchy_) {
+        auto& matrices = hierarchy_->build(native(A), criterion, this->verbose_);
+        const auto& coarseMatrix = matrices.matrices().coarsest()->getmat();
+#if HAVE_SUPERLU
+        auto coarseSolver = std::make_unique<CoarseSolver>(coarseMatrix, false);
+#else
+        coarseOperator_ = std::make_shared<Operator>(coarseMatrix);
+        coarseSmoother_ = std::make_shared<Smoother>(coarseMatrix, 1, 1.0);
+        auto coarseSolver =
+            std::make_unique<CoarseSolver>(*coarseOperator_, *coarseSmoother_, 1e-2, 1000, 0);
+#endif
+        // the amg takes ownership of the coarse solver
+        amg_ = std::make_shared<AMG>(matrices, *coarseSolver.release(), smootherArgs, params_);
+      } else {
+        operator_ = std::make_shared<Operator>(native(A));
+        amg_ = std::make_shared<AMG>(*operator_, criterion, smootherArgs);
+      }
+      double setupTime = watch.elapsed();
+      if (this->verbose_ > 0)
+        std::cout << "=== AMG setup " << setupTime << " s" << std::endl;
+      return setupTime;
+    }
+  };
+
+  /**
+   * \brief sequential cg solver preconditioned by amg in single precision
+   *
+   * The amg hierarchy and its smoothers are built in single precision while cg and its
+   * residuals stay in double precision, see MixedPrecisionAMG. If the hierarchy is shared, the
+   * single precision copy of the matrix and its hierarchy are shared by all copies of the
+   * backend, otherwise they are built per copy. If validation is enabled, each system is
+   * additionally solved with the double precision amg of ISTLBackend_SEQ_CG_SharedAMG_SSOR, so
+   * that the iteration counts of both modes can be compared in the report.
+   */
+  template <class GO>
+  class ISTLBackend_SEQ_CG_MixedPrecisionAMG : public ISTLBackend_SEQ_CG_SharedAMG_SSOR<GO>
+  {
+    using BaseT = ISTLBackend_SEQ_CG_SharedAMG_SSOR<GO>;
+    using typename BaseT::M;
+    using typename BaseT::V;
+    using typename BaseT::W;
+    using typename BaseT::Matrix;
+    using typename BaseT::Vector;
+    using typename BaseT::Real;
+    using typename BaseT::Operator;
+
+  public:
+    using MixedAMG = MixedPrecisionAMG<Matrix, Vector>;
+    using typename BaseT::Deflation;
+    using BaseT::apply;
+
+    explicit ISTLBackend_SEQ_CG_MixedPrecisionAMG(unsigned int maxiter = 5000, int verbose = 0,
+                                                  bool shareHierarchy = false,
+                                                  std::shared_ptr<Deflation> deflation = nullptr,
+                                                  bool validate = false)
+        : BaseT(maxiter, verbose, shareHierarchy, deflation)
+        , validate_(validate)
+        , mixedHierarchy_(std::make_shared<typename MixedAMG::Hierarchy>())
+    {
+    }
+
+    virtual std::unique_ptr<CGLinearSolverBackend<GO>> clone() const override
+    {
+      return std::make_unique<ISTLBackend_SEQ_CG_MixedPrecisionAMG>(*this);
+    }
+
+    virtual void apply(M& A, V& z, W& r, Real reduction) override
+    {
+      using Dune::PDELab::Backend::native;
+      // the solver overwrites the right hand side, keep copies for the validation solve
+      std::unique_ptr<V> z0;
+      std::unique_ptr<W> r0;
+      if (validate_) {
+        z0 = std::make_unique<V>(z);
+        r0 = std::make_unique<W>(r);
+      }
+      Dune::Timer watch;
+      double setupTime = 0.0;
+      if (!mixedAMG_) {
+        mixedAMG_ = this->shareHierarchy_
+                        ? std::make_shared<MixedAMG>(native(A), this->params_, mixedHierarchy_)
+                        : std::make_shared<MixedAMG>(native(A), this->params_);
+        setupTime = watch.elapsed();
+        if (this->verbose_ > 0)
+          std::cout << "=== mixed precision AMG setup " << setupTime << " s" << std::endl;
+      }
+      Operator op(native(A));
+      this->solve(op, *mixedAMG_, z, r, reduction, setupTime);
+      mixedIterations_ = this->res.iterations;
+      if (validate_) {
+        const auto mixedResult = this->res;
+        this->solveAMG(A, *z0, *r0, reduction);
+        doubleIterations_ = this->res.iterations;
+        doubleTime_ = this->res.elapsed;
+        if (this->verbose_ > 0)
+          std::cout << "=== mixed precision: " << mixedIterations_ << " iterations, double: "
+                    << doubleIterations_ << " iterations" << std::endl;
+        this->res = mixedResult;
+      }
+    }
+
+    //! store the memory of the preconditioner matrix and the iteration counts
+    virtual void report(DataTree dataTree) const override
+    {
+      auto sub = dataTree.sub("mixed_precision");
+      sub.set("preconditioner_matrix_memory", mixedAMG_ ? mixedAMG_->matrixMemory() : 0);
+      sub.set("iterations", mixedIterations_);
+      if (validate_) {
+        sub.set("iterations_double", doubleIterations_);
+        sub.set("time_double", doubleTime_);
+      }
+    }
+
+  private:
+    bool validate_;
+    std::shared_ptr<typename MixedAMG::Hierarchy> mixedHierarchy_;
+    std::shared_ptr<MixedAMG> mixedAMG_;
+    unsigned int mixedIterations_ = 0;
+    unsigned int doubleIterations_ = 0;
+    double doubleTime_ = 0.0;
+  };
+
+  /**
+   * \brief solves the assembled system by the factorization of a sparse direct solver
+   *
+   * The matrix is factorized in the setup of the first solve. The factorization is shared by all
+   * copies of the backend and by the block solver backend. If the direct solver rejects the
+   * matrix because of its memory limit, all systems are solved by the given iterative fallback
+   * backend instead.
+   */
+  template <class GO>
+  class ISTLBackend_SEQ_CG_Direct : public CGLinearSolverBackend<GO>
+  {
+    using BaseT = CGLinearSolverBackend<GO>;
+    using typename BaseT::M;
+    using typename BaseT::V;
+    using typename BaseT::W;
+    using typename BaseT::Matrix;
+    using typename BaseT::Vector;
+    using typename BaseT::Real;
+
+  public:
+    using DirectSolver = SparseDirectSolver<Matrix, Vector>;
+    using BaseT::apply;
+
+    ISTLBackend_SEQ_CG_Direct(std::shared_ptr<DirectSolver> directSolver,
+                              std::unique_ptr<BaseT> fallback, int verbose = 0)
+        : BaseT(1, verbose, nullptr), directSolver_(directSolver), fallback_(std::move(fallback))
+    {
+    }
+
+    ISTLBackend_SEQ_CG_Direct(const ISTLBackend_SEQ_CG_Direct& other)
+        : BaseT(other)
+        , directSolver_(other.directSolver_)
+        , fallback_(other.fallback_->clone())
+        , setUp_(other.setUp_)
+        , accepted_(other.accepted_)
+        , setupTime_(other.setupTime_)
+    {
+    }
+
+    virtual std::unique_ptr<BaseT> clone() const override
+    {
+      return std::make_unique<ISTLBackend_SEQ_CG_Direct>(*this);
+    }
+
+    virtual void apply(M& A, V& z, W& r, Real reduction) override
+    {
+      using Dune::PDELab::Backend::native;
+      double setupTime = 0.0;
+      if (!setUp_) {
+        setup(A);
+        setupTime = setupTime_;
+      }
+      if (!accepted_) {
+        fallback_->apply(A, z, r, reduction);
+        this->res = fallback_->result();
+        return;
+      }
+      Dune::Timer watch;
+      directSolver_->solve(native(z), native(r));
+      const double solveTime = watch.elapsed();
+      // relative residual of the direct solution
+      Vector defect(native(r));
+      native(A).mmv(native(z), defect);
+      const Real norm = native(r).two_norm();
+      if (this->verbose_ > 0)
+        std::cout << "=== direct solve " << solveTime << " s" << std::endl;
+      this->res.converged = true;
+      this->res.iterations = 1;
+      this->res.elapsed = setupTime + solveTime;
+      this->res.reduction = norm > 0 ? defect.two_norm() / norm : 0.0;
+      this->res.conv_rate = this->res.reduction;
+    }
+
+    //! store information about the direct solver and the fallback backend
+    virtual void report(DataTree dataTree) const override
+    {
+      directSolver_->report(dataTree.sub("direct"));
+      fallback_->report(dataTree);
+    }
+
+  private:
+    std::shared_ptr<DirectSolver> directSolver_;
+    std::unique_ptr<BaseT> fallback_;
+    bool setUp_ = false;
+    bool accepted_ = false;
+    double setupTime_ = 0.0;
+
+    // factorize the matrix, or find the factorization of another copy of this backend
+    void setup(const M& A)
+    {
+      using Dune::PDELab::Backend::native;
+      Dune::Timer watch;
+      accepted_ = directSolver_->factorize(native(A));
+      setupTime_ = watch.elapsed();
+      setUp_ = true;
+    }
+  };
+}
+
+#endif // DUNEURO_SHARED_AMG_BACKEND_HH
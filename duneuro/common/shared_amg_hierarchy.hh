@@ -0,0 +1,92 @@
+#ifndef DUNEURO_SHARED_AMG_HIERARCHY_HH
+#define DUNEURO_SHARED_AMG_HIERARCHY_HH
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+#include <dune/common/timer.hh>
+
+#include <dune/istl/paamg/amg.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief amg matrix hierarchy which is built once and can be shared by several threads
+   *
+   * The hierarchy only contains the coarsened matrices and the aggregation information. Both are
+   * only read while applying the amg, so the hierarchy can be used concurrently by several amg
+   * instances, each with its own smoothers, coarse solver and vectors.
+   */
+  template <class Operator, class OperatorHierarchy>
+  class SharedAMGHierarchy
+  {
+  public:
+    using Matrix = typename Operator::matrix_type;
+
+    template <class Criterion>
+    OperatorHierarchy& build(const Matrix& matrix, const Criterion& criterion, int verbose = 0)
+    {
+      std::call_once(built_, [&]() {
+        Dune::Timer timer;
+        buildHierarchy(matrix, criterion);
+        setupTime_ = timer.elapsed();
+        if (verbose > 0)
+          std::cout << "=== shared AMG hierarchy setup " << setupTime_ << " s" << std::endl;
+      });
+      return *hierarchy_;
+    }
+
+    /**
+     * \brief build the hierarchy for the matrix returned by makeMatrix
+     *
+     * makeMatrix is only called by the first caller and has to return a
+     * std::shared_ptr<const Matrix>. The matrix is kept alive by the hierarchy, which allows to
+     * share a matrix that is derived from the system matrix, e.g. a copy in lower precision.
+     */
+    template <class MakeMatrix, class Criterion>
+    OperatorHierarchy& buildOwned(MakeMatrix&& makeMatrix, const Criterion& criterion,
+                                  int verbose = 0)
+    {
+      std::call_once(built_, [&]() {
+        Dune::Timer timer;
+        matrix_ = makeMatrix();
+        buildHierarchy(*matrix_, criterion);
+        setupTime_ = timer.elapsed();
+        if (verbose > 0)
+          std::cout << "=== shared AMG hierarchy setup " << setupTime_ << " s" << std::endl;
+      });
+      return *hierarchy_;
+    }
+
+    //! the finest matrix of the hierarchy, only valid after it has been built
+    const Matrix& matrix() const
+    {
+      return operator_->getmat();
+    }
+
+    double setupTime() const
+    {
+      return setupTime_;
+    }
+
+  private:
+    std::once_flag built_;
+    Dune::Amg::SequentialInformation parallelInformation_;
+    std::shared_ptr<const Matrix> matrix_;
+    std::shared_ptr<Operator> operator_;
+    std::shared_ptr<OperatorHierarchy> hierarchy_;
+    double setupTime_ = 0.0;
+
+    template <class Criterion>
+    void buildHierarchy(const Matrix& matrix, const Criterion& criterion)
+    {
+      operator_ = std::make_shared<Operator>(matrix);
+      hierarchy_ = std::make_shared<OperatorHierarchy>(*operator_, parallelInformation_);
+      hierarchy_->template build<
+          Dune::NegateSet<typename Dune::Amg::SequentialInformation::OwnerSet>>(criterion);
+    }
+  };
+}
+
+#endif // DUNEURO_SHARED_AMG_HIERARCHY_HH
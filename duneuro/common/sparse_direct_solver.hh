@@ -0,0 +1,681 @@
+#ifndef DUNEURO_SPARSE_DIRECT_SOLVER_HH
+#define DUNEURO_SPARSE_DIRECT_SOLVER_HH
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/parametertree.hh>
+#include <dune/common/timer.hh>
+
+#include <dune/istl/bcrsmatrix.hh>
+
+#if HAVE_SUITESPARSE_CHOLMOD
+#include <cholmod.h>
+#endif
+#if HAVE_SUITESPARSE_UMFPACK
+#include <umfpack.h>
+#endif
+
+#include <duneuro/common/mesh_renumbering.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief sparse LDL^T factorization of a symmetric matrix with scalar entries
+   *
+   * The rows and columns are permuted by a fill reducing ordering of the matrix graph, either
+   * nested dissection (the default) or reverse cuthill mckee, which only reduces the profile and
+   * leads to much larger factors for three dimensional meshes. The symbolic analysis computes the elimination tree and the exact number of nonzeros of L,
+   * so that the memory of the factorization is known before the numeric factorization is
+   * started. The numeric factorization computes L row by row (up-looking), see T. Davis,
+   * Algorithm 849: A concise sparse Cholesky factorization package, ACM TOMS 31(4), 2005. L is
+   * stored column wise.
+   */
+  template <class T>
+  class SparseLDLFactorization
+  {
+  public:
+    using Index = std::size_t;
+
+    //! symbolic analysis of the symmetric pattern of the matrix
+    template <class Matrix>
+    explicit SparseLDLFactorization(const Matrix& matrix,
+                                    const std::string& ordering = "nested_dissection")
+        : n_(matrix.N())
+    {
+      static_assert(Matrix::block_type::rows == 1 && Matrix::block_type::cols == 1,
+                    "the sparse LDL factorization requires a scalar matrix");
+      if (matrix.N() != matrix.M()) {
+        DUNE_THROW(Dune::Exception, "the sparse LDL factorization requires a square matrix");
+      }
+      MeshRenumberingDetail::Adjacency graph;
+      graph.offsets.assign(n_ + 1, 0);
+      graph.indices.reserve(matrix.nonzeroes());
+      for (auto row = matrix.begin(); row != matrix.end(); ++row) {
+        for (auto col = row->begin(); col != row->end(); ++col) {
+          if (col.index() != row.index()) {
+            graph.indices.push_back(col.index());
+          }
+        }
+        graph.offsets[row.index() + 1] = graph.indices.size();
+      }
+      if (ordering == "nested_dissection") {
+        permutation_ = nested_dissection_ordering(graph);
+      } else if (ordering == "rcm") {
+        permutation_ = reverse_cuthill_mckee_ordering(graph);
+      } else {
+        DUNE_THROW(Dune::Exception, "unknown ordering \"" << ordering << "\"");
+      }
+      inverse_.resize(n_);
+      for (Index k = 0; k < n_; ++k) {
+        inverse_[permutation_[k]] = k;
+      }
+
+      // elimination tree and column counts of L
+      parent_.assign(n_, none);
+      std::vector<Index> flag(n_), count(n_, 0);
+      for (Index k = 0; k < n_; ++k) {
+        flag[k] = k;
+        for (auto j : graph[permutation_[k]]) {
+          for (Index i = inverse_[j]; i < k && flag[i] != k; i = parent_[i]) {
+            if (parent_[i] == none) {
+              parent_[i] = k;
+            }
+            ++count[i];
+            flag[i] = k;
+          }
+        }
+      }
+      columnOffsets_.assign(n_ + 1, 0);
+      for (Index k = 0; k < n_; ++k) {
+        columnOffsets_[k + 1] = columnOffsets_[k] + count[k];
+      }
+    }
+
+    //! number of nonzeros of the strictly lower triangle of L
+    std::size_t nonzeros() const
+    {
+      return columnOffsets_.back();
+    }
+
+    //! memory in bytes needed by the numeric factorization
+    std::size_t memory() const
+    {
+      return nonzeros() * (sizeof(T) + sizeof(Index)) + n_ * (3 * sizeof(Index) + sizeof(T));
+    }
+
+    template <class Matrix>
+    void factorize(const Matrix& matrix)
+    {
+      rows_.assign(nonzeros(), 0);
+      values_.assign(nonzeros(), T(0));
+      diagonal_.assign(n_, T(0));
+      std::vector<T> y(n_, T(0));
+      std::vector<Index> flag(n_), pattern(n_), filled(n_, 0);
+      for (Index k = 0; k < n_; ++k) {
+        // nonzero pattern of row k of L, given by the reach of the entries of column k in the
+        // elimination tree, in topological order
+        Index top = n_;
+        flag[k] = k;
+        const auto& row = matrix[permutation_[k]];
+        for (auto col = row.begin(); col != row.end(); ++col) {
+          Index i = inverse_[col.index()];
+          if (i > k) {
+            continue;
+          }
+          y[i] += (*col)[0][0];
+          Index length = 0;
+          for (; flag[i] != k; i = parent_[i]) {
+            pattern[length++] = i;
+            flag[i] = k;
+          }
+          while (length > 0) {
+            pattern[--top] = pattern[--length];
+          }
+        }
+        diagonal_[k] = y[k];
+        y[k] = T(0);
+        for (; top < n_; ++top) {
+          const Index i = pattern[top];
+          const T yi = y[i];
+          y[i] = T(0);
+          const Index end = columnOffsets_[i] + filled[i];
+          for (Index p = columnOffsets_[i]; p < end; ++p) {
+            y[rows_[p]] -= values_[p] * yi;
+          }
+          const T lki = yi / diagonal_[i];
+          diagonal_[k] -= lki * yi;
+          rows_[end] = k;
+          values_[end] = lki;
+          ++filled[i];
+        }
+        if (diagonal_[k] == T(0) || !std::isfinite(diagonal_[k])) {
+          DUNE_THROW(Dune::Exception, "zero pivot in row " << permutation_[k]
+                                                           << " of the sparse LDL factorization");
+        }
+      }
+    }
+
+    /**
+     * \brief solve for k right hand sides at once
+     *
+     * The panel stores the right hand sides row wise in the original numbering, i.e. entry j of
+     * row i is at panel[i * k + j], and is overwritten with the solutions. Every entry of L is
+     * loaded once for all right hand sides.
+     */
+    void solve(T* panel, std::size_t k) const
+    {
+      std::vector<T> x(n_ * k);
+      for (Index i = 0; i < n_; ++i) {
+        std::copy(panel + permutation_[i] * k, panel + (permutation_[i] + 1) * k, &x[i * k]);
+      }
+      // L y = b
+      for (Index j = 0; j < n_; ++j) {
+        const T* xj = &x[j * k];
+        for (Index p = columnOffsets_[j]; p < columnOffsets_[j + 1]; ++p) {
+          T* xi = &x[rows_[p] * k];
+          const T l = values_[p];
+          for (std::size_t c = 0; c < k; ++c) {
+            xi[c] -= l * xj[c];
+          }
+        }
+      }
+      // D z = y
+      for (Index j = 0; j < n_; ++j) {
+        const T d = T(1) / diagonal_[j];
+        for (std::size_t c = 0; c < k; ++c) {
+          x[j * k + c] *= d;
+        }
+      }
+      // L^T x = z
+      for (Index j = n_; j-- > 0;) {
+        T* xj = &x[j * k];
+        for (Index p = columnOffsets_[j]; p < columnOffsets_[j + 1]; ++p) {
+          const T* xi = &x[rows_[p] * k];
+          const T l = values_[p];
+          for (std::size_t c = 0; c < k; ++c) {
+            xj[c] -= l * xi[c];
+          }
+        }
+      }
+      for (Index i = 0; i < n_; ++i) {
+        std::copy(&x[i * k], &x[(i + 1) * k], panel + permutation_[i] * k);
+      }
+    }
+
+  private:
+    static constexpr Index none = Index(-1);
+
+    Index n_;
+    std::vector<Index> permutation_;
+    std::vector<Index> inverse_;
+    std::vector<Index> parent_;
+    std::vector<Index> columnOffsets_;
+    std::vector<Index> rows_;
+    std::vector<T> values_;
+    std::vector<T> diagonal_;
+  };
+
+#if HAVE_SUITESPARSE_CHOLMOD
+  /**
+   * \brief supernodal cholesky factorization of cholmod
+   *
+   * The analysis computes the fill reducing ordering of cholmod (AMD, or METIS if cholmod has
+   * been built with it) and the supernodal structure of the factor, which gives its exact size
+   * before the numeric factorization. The factor is only read when solving, each solve uses its
+   * own cholmod workspace, so that several threads can solve concurrently.
+   */
+  class CholmodFactorization
+  {
+  public:
+    using Index = SuiteSparse_long;
+
+    template <class Matrix>
+    explicit CholmodFactorization(const Matrix& matrix) : n_(matrix.N())
+    {
+      cholmod_l_start(&common_);
+      common_.supernodal = CHOLMOD_SUPERNODAL;
+      // cholmod uses the lower triangle, stored column wise. As the matrix is symmetric, column
+      // j of the lower triangle consists of the entries of row j right of the diagonal
+      std::size_t nonzeros = 0;
+      for (auto row = matrix.begin(); row != matrix.end(); ++row) {
+        for (auto col = row->begin(); col != row->end(); ++col) {
+          nonzeros += col.index() >= row.index();
+        }
+      }
+      matrix_ = cholmod_l_allocate_sparse(n_, n_, nonzeros, true, true, -1, CHOLMOD_REAL, &common_);
+      auto* offsets = static_cast<Index*>(matrix_->p);
+      auto* rows = static_cast<Index*>(matrix_->i);
+      auto* values = static_cast<double*>(matrix_->x);
+      Index p = 0;
+      for (auto row = matrix.begin(); row != matrix.end(); ++row) {
+        offsets[row.index()] = p;
+        for (auto col = row->begin(); col != row->end(); ++col) {
+          if (col.index() >= row.index()) {
+            rows[p] = col.index();
+            values[p] = (*col)[0][0];
+            ++p;
+          }
+        }
+      }
+      offsets[n_] = p;
+      factor_ = cholmod_l_analyze(matrix_, &common_);
+      if (!factor_) {
+        DUNE_THROW(Dune::Exception, "cholmod analysis failed with status " << common_.status);
+      }
+    }
+
+    CholmodFactorization(const CholmodFactorization&) = delete;
+    void operator=(const CholmodFactorization&) = delete;
+
+    ~CholmodFactorization()
+    {
+      cholmod_l_free_factor(&factor_, &common_);
+      cholmod_l_free_sparse(&matrix_, &common_);
+      cholmod_l_finish(&common_);
+    }
+
+    //! number of nonzeros of L
+    std::size_t nonzeros() const
+    {
+      return common_.lnz;
+    }
+
+    //! memory in bytes needed by the numeric factorization
+    std::size_t memory() const
+    {
+      if (factor_->is_super) {
+        return factor_->xsize * sizeof(double)
+               + (factor_->ssize + 4 * factor_->nsuper + 2 * n_) * sizeof(Index);
+      }
+      return nonzeros() * (sizeof(double) + sizeof(Index)) + 6 * n_ * sizeof(Index);
+    }
+
+    void factorize()
+    {
+      if (!cholmod_l_factorize(matrix_, factor_, &common_) || common_.status != CHOLMOD_OK) {
+        DUNE_THROW(Dune::Exception, "cholmod factorization failed with status "
+                                        << common_.status);
+      }
+      // the values are stored in the factor, the matrix is not needed anymore
+      cholmod_l_free_sparse(&matrix_, &common_);
+    }
+
+    //! solve for all right hand sides b at once
+    template <class Vector>
+    void solve(std::vector<Vector>& x, const std::vector<Vector>& b) const
+    {
+      cholmod_common common;
+      cholmod_l_start(&common);
+      cholmod_dense* rhs = cholmod_l_allocate_dense(n_, b.size(), n_, CHOLMOD_REAL, &common);
+      auto* values = static_cast<double*>(rhs->x);
+      for (std::size_t j = 0; j < b.size(); ++j) {
+        for (std::size_t i = 0; i < n_; ++i) {
+          values[j * n_ + i] = b[j][i][0];
+        }
+      }
+      cholmod_dense* solution = cholmod_l_solve(CHOLMOD_A, factor_, rhs, &common);
+      cholmod_l_free_dense(&rhs, &common);
+      if (!solution) {
+        cholmod_l_finish(&common);
+        DUNE_THROW(Dune::Exception, "cholmod solve failed with status " << common.status);
+      }
+      values = static_cast<double*>(solution->x);
+      for (std::size_t j = 0; j < x.size(); ++j) {
+        for (std::size_t i = 0; i < n_; ++i) {
+          x[j][i][0] = values[j * n_ + i];
+        }
+      }
+      cholmod_l_free_dense(&solution, &common);
+      cholmod_l_finish(&common);
+    }
+
+  private:
+    std::size_t n_;
+    cholmod_common common_;
+    cholmod_sparse* matrix_ = nullptr;
+    cholmod_factor* factor_ = nullptr;
+  };
+#endif
+
+#if HAVE_SUITESPARSE_UMFPACK
+  /**
+   * \brief LU factorization of umfpack
+   *
+   * The symbolic analysis computes the fill reducing ordering of umfpack and an estimate of the
+   * size of the numeric factorization. umfpack only solves for one right hand side at a time.
+   * The numeric factorization is only read when solving and each solve uses its own workspace,
+   * so that several threads can solve concurrently.
+   */
+  class UMFPackFactorization
+  {
+  public:
+    using Index = SuiteSparse_long;
+
+    template <class Matrix>
+    explicit UMFPackFactorization(const Matrix& matrix) : n_(matrix.N())
+    {
+      umfpack_dl_defaults(control_);
+      // the matrix is symmetric, so its rows can be passed as the columns umfpack expects
+      offsets_.reserve(n_ + 1);
+      rows_.reserve(matrix.nonzeroes());
+      values_.reserve(matrix.nonzeroes());
+      for (auto row = matrix.begin(); row != matrix.end(); ++row) {
+        offsets_.push_back(rows_.size());
+        for (auto col = row->begin(); col != row->end(); ++col) {
+          rows_.push_back(col.index());
+          values_.push_back((*col)[0][0]);
+        }
+      }
+      offsets_.push_back(rows_.size());
+      const Index n = n_;
+      const int status = umfpack_dl_symbolic(n, n, offsets_.data(), rows_.data(), values_.data(),
+                                             &symbolic_, control_, info_);
+      if (status != UMFPACK_OK) {
+        DUNE_THROW(Dune::Exception, "umfpack analysis failed with status " << status);
+      }
+    }
+
+    UMFPackFactorization(const UMFPackFactorization&) = delete;
+    void operator=(const UMFPackFactorization&) = delete;
+
+    ~UMFPackFactorization()
+    {
+      if (symbolic_) {
+        umfpack_dl_free_symbolic(&symbolic_);
+      }
+      if (numeric_) {
+        umfpack_dl_free_numeric(&numeric_);
+      }
+    }
+
+    //! estimated number of nonzeros of L and U
+    std::size_t nonzeros() const
+    {
+      return info_[UMFPACK_LNZ_ESTIMATE] + info_[UMFPACK_UNZ_ESTIMATE];
+    }
+
+    //! estimated memory in bytes of the numeric factorization
+    std::size_t memory() const
+    {
+      return info_[UMFPACK_NUMERIC_SIZE_ESTIMATE] * info_[UMFPACK_SIZE_OF_UNIT];
+    }
+
+    void factorize()
+    {
+      const int status = umfpack_dl_numeric(offsets_.data(), rows_.data(), values_.data(),
+                                            symbolic_, &numeric_, control_, info_);
+      umfpack_dl_free_symbolic(&symbolic_);
+      if (status != UMFPACK_OK) {
+        DUNE_THROW(Dune::Exception, "umfpack factorization failed with status " << status);
+      }
+    }
+
+    //! solve for all right hand sides b, one after another
+    template <class Vector>
+    void solve(std::vector<Vector>& x, const std::vector<Vector>& b) const
+    {
+      // workspace of umfpack_dl_wsolve with iterative refinement
+      std::vector<Index> indexWorkspace(n_);
+      std::vector<double> workspace(5 * n_), rhs(n_), solution(n_);
+      double info[UMFPACK_INFO];
+      for (std::size_t j = 0; j < b.size(); ++j) {
+        for (std::size_t i = 0; i < n_; ++i) {
+          rhs[i] = b[j][i][0];
+        }
+        const int status = umfpack_dl_wsolve(UMFPACK_A, offsets_.data(), rows_.data(),
+                                             values_.data(), solution.data(), rhs.data(),
+                                             numeric_, control_, info, indexWorkspace.data(),
+                                             workspace.data());
+        if (status != UMFPACK_OK) {
+          DUNE_THROW(Dune::Exception, "umfpack solve failed with status " << status);
+        }
+        for (std::size_t i = 0; i < n_; ++i) {
+          x[j][i][0] = solution[i];
+        }
+      }
+    }
+
+  private:
+    std::size_t n_;
+    std::vector<Index> offsets_;
+    std::vector<Index> rows_;
+    std::vector<double> values_;
+    double control_[UMFPACK_CONTROL];
+    double info_[UMFPACK_INFO];
+    void* symbolic_ = nullptr;
+    void* numeric_ = nullptr;
+  };
+#endif
+
+  /**
+   * \brief direct solver for a symmetric positive definite matrix with many right hand sides
+   *
+   * The matrix is factorized once, on the first call to factorize, and the factorization is used
+   * for all subsequent solves. The solver is meant to be shared by several solver backends, e.g.
+   * the thread local copies of a backend. Solving is thread safe.
+   *
+   * The config key "type" selects the factorization: "cholmod" (CholmodFactorization) and
+   * "umfpack" (UMFPackFactorization), if suitesparse has been found, and "builtin"
+   * (SparseLDLFactorization, whose ordering is selected by the key "ordering"). The default
+   * "auto" chooses the first available one in this order. Before factorizing, the memory of the
+   * factorization is estimated by the symbolic analysis of the chosen one. If the estimate
+   * exceeds "max_memory" megabytes (default 0, i.e. no limit), the matrix is not factorized and
+   * accepted() returns false, so that the caller can use an iterative solver instead.
+   */
+  template <class Matrix, class Vector>
+  class SparseDirectSolver
+  {
+  public:
+    using Real = typename Matrix::field_type;
+
+    explicit SparseDirectSolver(const Dune::ParameterTree& config)
+        : type_(config.get<std::string>("type", "auto"))
+        , ordering_(config.get<std::string>("ordering", "nested_dissection"))
+        , maxMemory_(config.get<double>("max_memory", 0.0))
+        , verbose_(config.get<int>("verbose", 0))
+    {
+      if (type_ == "auto") {
+#if HAVE_SUITESPARSE_CHOLMOD
+        type_ = "cholmod";
+#elif HAVE_SUITESPARSE_UMFPACK
+        type_ = "umfpack";
+#else
+        type_ = "builtin";
+#endif
+      }
+      if (type_ != "cholmod" && type_ != "umfpack" && type_ != "builtin") {
+        DUNE_THROW(Dune::Exception, "unknown direct solver \"" << type_ << "\"");
+      }
+    }
+
+    /**
+     * \brief factorize the matrix, unless it has already been factorized
+     *
+     * Returns whether the matrix has been accepted, see accepted().
+     */
+    bool factorize(const Matrix& matrix)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (analyzed_) {
+        if (&matrix != matrix_) {
+          DUNE_THROW(Dune::Exception, "the direct solver has been set up for a different matrix");
+        }
+        return accepted_;
+      }
+      Dune::Timer timer;
+      matrix_ = &matrix;
+      dimension_ = matrix.N();
+      matrixMemory_ = matrix.nonzeroes() * (sizeof(Real) + sizeof(std::size_t));
+      analyze(matrix);
+      timeAnalysis_ = timer.lap();
+      analyzed_ = true;
+      accepted_ = maxMemory_ <= 0.0 || estimatedMemory_ <= maxMemory_ * 1024.0 * 1024.0;
+      if (verbose_ > 0)
+        std::cout << "=== direct solver " << type_ << ": estimated memory "
+                  << estimatedMemory_ / (1024.0 * 1024.0) << " MB"
+                  << (accepted_ ? "" : ", exceeds limit") << std::endl;
+      if (!accepted_) {
+        release();
+        return false;
+      }
+      if (builtin_) {
+        builtin_->factorize(matrix);
+      }
+#if HAVE_SUITESPARSE_CHOLMOD
+      if (cholmod_) {
+        cholmod_->factorize();
+      }
+#endif
+#if HAVE_SUITESPARSE_UMFPACK
+      if (umfpack_) {
+        umfpack_->factorize();
+      }
+#endif
+      timeFactorization_ = timer.lap();
+      if (verbose_ > 0)
+        std::cout << "=== direct solver factorization " << timeFactorization_ << " s" << std::endl;
+      return true;
+    }
+
+    //! whether the factorization fits into the memory limit. Only valid after factorize
+    bool accepted() const
+    {
+      return accepted_;
+    }
+
+    void solve(Vector& x, const Vector& b) const
+    {
+      std::vector<Vector> xs(1, x);
+      solve(xs, std::vector<Vector>(1, b));
+      x = xs[0];
+    }
+
+    //! solve for all right hand sides b, traversing the factor once for all of them (except umfpack)
+    void solve(std::vector<Vector>& x, const std::vector<Vector>& b) const
+    {
+      if (!analyzed_ || !accepted_) {
+        DUNE_THROW(Dune::Exception, "the direct solver has not been set up");
+      }
+      if (x.size() != b.size()) {
+        DUNE_THROW(Dune::Exception, "number of solutions (" << x.size()
+                                                            << ") does not match number of right "
+                                                               "hand sides ("
+                                                            << b.size() << ")");
+      }
+      if (builtin_) {
+        const std::size_t k = b.size();
+        std::vector<Real> panel(dimension_ * k);
+        for (std::size_t j = 0; j < k; ++j) {
+          for (std::size_t i = 0; i < dimension_; ++i) {
+            panel[i * k + j] = b[j][i][0];
+          }
+        }
+        builtin_->solve(panel.data(), k);
+        for (std::size_t j = 0; j < k; ++j) {
+          for (std::size_t i = 0; i < dimension_; ++i) {
+            x[j][i][0] = panel[i * k + j];
+          }
+        }
+        return;
+      }
+#if HAVE_SUITESPARSE_CHOLMOD
+      if (cholmod_) {
+        cholmod_->solve(x, b);
+        return;
+      }
+#endif
+#if HAVE_SUITESPARSE_UMFPACK
+      if (umfpack_) {
+        umfpack_->solve(x, b);
+        return;
+      }
+#endif
+    }
+
+    //! store the type, the memory estimates and the timings
+    void report(DataTree dataTree) const
+    {
+      dataTree.set("type", type_);
+      dataTree.set("accepted", accepted_);
+      dataTree.set("matrix_memory", matrixMemory_);
+      dataTree.set("factor_nonzeros_estimate", factorNonzeros_);
+      dataTree.set("factor_memory_estimate", estimatedMemory_);
+      dataTree.set("time_analysis", timeAnalysis_);
+      dataTree.set("time_factorization", timeFactorization_);
+    }
+
+  private:
+    std::string type_;
+    std::string ordering_;
+    double maxMemory_;
+    int verbose_;
+    std::mutex mutex_;
+    const Matrix* matrix_ = nullptr;
+    bool analyzed_ = false;
+    bool accepted_ = false;
+    std::size_t dimension_ = 0;
+    std::size_t matrixMemory_ = 0;
+    std::size_t factorNonzeros_ = 0;
+    std::size_t estimatedMemory_ = 0;
+    double timeAnalysis_ = 0.0;
+    double timeFactorization_ = 0.0;
+    std::unique_ptr<SparseLDLFactorization<Real>> builtin_;
+#if HAVE_SUITESPARSE_CHOLMOD
+    std::unique_ptr<CholmodFactorization> cholmod_;
+#endif
+#if HAVE_SUITESPARSE_UMFPACK
+    std::unique_ptr<UMFPackFactorization> umfpack_;
+#endif
+
+    // symbolic analysis by the chosen factorization, which yields the memory estimate
+    void analyze(const Matrix& matrix)
+    {
+      if (type_ == "builtin") {
+        builtin_ = std::make_unique<SparseLDLFactorization<Real>>(matrix, ordering_);
+        factorNonzeros_ = builtin_->nonzeros();
+        estimatedMemory_ = builtin_->memory();
+        return;
+      }
+      if constexpr (std::is_same<Real, double>::value) {
+        if (type_ == "cholmod") {
+#if HAVE_SUITESPARSE_CHOLMOD
+          cholmod_ = std::make_unique<CholmodFactorization>(matrix);
+          factorNonzeros_ = cholmod_->nonzeros();
+          estimatedMemory_ = cholmod_->memory();
+          return;
+#endif
+        } else if (type_ == "umfpack") {
+#if HAVE_SUITESPARSE_UMFPACK
+          umfpack_ = std::make_unique<UMFPackFactorization>(matrix);
+          factorNonzeros_ = umfpack_->nonzeros();
+          estimatedMemory_ = umfpack_->memory();
+          return;
+#endif
+        }
+      }
+      DUNE_THROW(Dune::NotImplemented, "direct solver \"" << type_ << "\" is not available");
+    }
+
+    void release()
+    {
+      builtin_.reset();
+#if HAVE_SUITESPARSE_CHOLMOD
+      cholmod_.reset();
+#endif
+#if HAVE_SUITESPARSE_UMFPACK
+      umfpack_.reset();
+#endif
+    }
+  };
+}
+
+#endif // DUNEURO_SPARSE_DIRECT_SOLVER_HH
@@ -1,7 +1,11 @@
 #ifndef DUNEURO_SPARSEVECTORCONTAINER_HH
 #define DUNEURO_SPARSEVECTORCONTAINER_HH
 
+#include <algorithm>
 #include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <dune/common/typetraits.hh>
 
@@ -56,6 +60,10 @@ namespace duneuro
     {
       values_.clear();
     }
+    std::size_t size() const
+    {
+      return values_.size();
+    }
 
     template <class J, class U>
     friend std::ostream& operator<<(std::ostream&, const SparseVectorContainer<J, U>&);
@@ -73,18 +81,176 @@ namespace duneuro
     return stream;
   }
 
+  /**
+   * \brief sparse vector stored as arrays of flat indices and values, sorted by index
+   *
+   * In contrast to the SparseVectorContainer, the entries can be traversed in the order of the
+   * columns of a matrix without any hashing, which is used by the matrix vector products below.
+   */
+  template <class T>
+  struct CompactSparseVector {
+    std::vector<std::size_t> indices;
+    std::vector<T> values;
+
+    std::size_t size() const
+    {
+      return indices.size();
+    }
+  };
+
   template <class I, class T, class F>
-  std::vector<T> matrix_sparse_vector_product(const DenseMatrix<T>& matrix,
-                                              const SparseVectorContainer<I, T>& vector, F toFlat)
+  void compact_sparse_vector(const SparseVectorContainer<I, T>& vector, F toFlat,
+                             CompactSparseVector<T>& output)
+  {
+    std::vector<std::pair<std::size_t, T>> entries;
+    entries.reserve(vector.size());
+    for (const auto& entry : vector) {
+      entries.emplace_back(toFlat(entry.first), entry.second);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    output.indices.resize(entries.size());
+    output.values.resize(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+      output.indices[i] = entries[i].first;
+      output.values[i] = entries[i].second;
+    }
+  }
+
+  template <class S, class T>
+  std::vector<T> matrix_sparse_vector_product(const DenseMatrix<S>& matrix,
+                                              const CompactSparseVector<T>& vector)
   {
     std::vector<T> output(matrix.rows(), T(0));
-    for (unsigned int row = 0; row < matrix.rows(); ++row) {
-      for (const auto& entry : vector) {
-        output[row] += matrix(row, toFlat(entry.first)) * vector[entry.first];
+    const std::size_t nnz = vector.size();
+    const std::size_t* indices = vector.indices.data();
+    const T* values = vector.values.data();
+    if (!matrix.rowMajor()) {
+      // one contiguous axpy per nonzero entry
+      const std::size_t rows = matrix.rows();
+      T* out = output.data();
+      for (std::size_t k = 0; k < nnz; ++k) {
+        const S* column = matrix.data() + indices[k] * rows;
+        const T value = values[k];
+        for (std::size_t row = 0; row < rows; ++row) {
+          out[row] += T(column[row]) * value;
+        }
+      }
+      return output;
+    }
+    for (std::size_t row = 0; row < matrix.rows(); ++row) {
+      const S* matrixRow = matrix.data() + row * matrix.cols();
+      T sum(0);
+      for (std::size_t k = 0; k < nnz; ++k) {
+        sum += T(matrixRow[indices[k]]) * values[k];
+      }
+      output[row] = sum;
+    }
+    return output;
+  }
+
+  /**
+   * \brief compute the product of a dense matrix with several sparse vectors at once
+   *
+   * The union of the non zero pattern of all vectors is collected and the vectors are stored as a
+   * small dense matrix B on this union. The product is then computed as A(:, union) * B, where the
+   * columns of A are processed in tiles such that the corresponding part of B stays in cache while
+   * traversing all rows of A. Every entry of A is thus loaded once for all vectors and the
+   * innermost loop runs contiguously over the vectors. The result contains one vector per input
+   * vector. For column major matrices, every needed column of A is loaded once and added to all
+   * result vectors with a nonzero coefficient. Matrices stored in a lower precision S are widened
+   * to the precision T of the vectors while accumulating.
+   */
+  template <class S, class T>
+  std::vector<std::vector<T>>
+  matrix_sparse_vectors_product(const DenseMatrix<S>& matrix,
+                                const std::vector<CompactSparseVector<T>>& vectors)
+  {
+    const std::size_t nv = vectors.size();
+    std::vector<std::vector<T>> output(nv);
+    if (nv == 0) {
+      return output;
+    }
+    if (nv == 1) {
+      output[0] = matrix_sparse_vector_product(matrix, vectors[0]);
+      return output;
+    }
+
+    // union of all non zero indices
+    std::vector<std::size_t> columns;
+    for (const auto& v : vectors) {
+      columns.insert(columns.end(), v.indices.begin(), v.indices.end());
+    }
+    std::sort(columns.begin(), columns.end());
+    columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+    const std::size_t nc = columns.size();
+
+    // scatter the vectors into a dense nc x nv matrix
+    std::vector<T> b(nc * nv, T(0));
+    for (std::size_t j = 0; j < nv; ++j) {
+      auto position = columns.begin();
+      for (std::size_t k = 0; k < vectors[j].size(); ++k) {
+        position = std::lower_bound(position, columns.end(), vectors[j].indices[k]);
+        b[(position - columns.begin()) * nv + j] = vectors[j].values[k];
+      }
+    }
+
+    if (!matrix.rowMajor()) {
+      const std::size_t rows = matrix.rows();
+      for (std::size_t j = 0; j < nv; ++j) {
+        output[j].assign(rows, T(0));
+      }
+      for (std::size_t k = 0; k < nc; ++k) {
+        const S* column = matrix.data() + columns[k] * rows;
+        const T* bRow = b.data() + k * nv;
+        for (std::size_t j = 0; j < nv; ++j) {
+          const T value = bRow[j];
+          if (value == T(0))
+            continue;
+          T* out = output[j].data();
+          for (std::size_t row = 0; row < rows; ++row) {
+            out[row] += T(column[row]) * value;
+          }
+        }
+      }
+      return output;
+    }
+
+    // tiles of b of roughly 32kB
+    const std::size_t tileSize = std::max<std::size_t>(1, 4096 / nv);
+    std::vector<T> y(matrix.rows() * nv, T(0));
+    for (std::size_t tileBegin = 0; tileBegin < nc; tileBegin += tileSize) {
+      const std::size_t tileEnd = std::min(nc, tileBegin + tileSize);
+      for (std::size_t row = 0; row < matrix.rows(); ++row) {
+        const S* matrixRow = matrix.data() + row * matrix.cols();
+        T* yRow = y.data() + row * nv;
+        for (std::size_t k = tileBegin; k < tileEnd; ++k) {
+          const T a = T(matrixRow[columns[k]]);
+          const T* bRow = b.data() + k * nv;
+          for (std::size_t j = 0; j < nv; ++j) {
+            yRow[j] += a * bRow[j];
+          }
+        }
+      }
+    }
+
+    for (std::size_t j = 0; j < nv; ++j) {
+      output[j].resize(matrix.rows());
+      for (std::size_t row = 0; row < matrix.rows(); ++row) {
+        output[j][row] = y[row * nv + j];
       }
     }
     return output;
   }
+
+  template <class S, class I, class T, class F>
+  std::vector<T> matrix_sparse_vector_product(const DenseMatrix<S>& matrix,
+                                              const SparseVectorContainer<I, T>& vector, F toFlat)
+  {
+    CompactSparseVector<T> compact;
+    compact_sparse_vector(vector, toFlat, compact);
+    return matrix_sparse_vector_product(matrix, compact);
+  }
 }
 
 #endif // DUNEURO_SPARSEVECTORCONTAINER_HH
@@ -0,0 +1,85 @@
+#ifndef DUNEURO_SYMMETRIC_EIGEN_DECOMPOSITION_HH
+#define DUNEURO_SYMMETRIC_EIGEN_DECOMPOSITION_HH
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace duneuro
+{
+  /**
+   * \brief eigen decomposition of the symmetric n x n matrix a (row wise) using the cyclic jacobi
+   * method
+   *
+   * On return, eigenvalues holds the eigenvalues in ascending order and the columns of
+   * eigenvectors (row wise) the corresponding eigenvectors. Only intended for small matrices.
+   */
+  inline void symmetric_eigen_decomposition(std::vector<double> a, std::size_t n,
+                                            std::vector<double>& eigenvalues,
+                                            std::vector<double>& eigenvectors)
+  {
+    std::vector<double> v(n * n, 0.0);
+    for (std::size_t i = 0; i < n; ++i) {
+      v[i * n + i] = 1.0;
+    }
+    for (unsigned int sweep = 0; sweep < 100; ++sweep) {
+      double offDiagonal = 0.0;
+      double diagonal = 0.0;
+      for (std::size_t i = 0; i < n; ++i) {
+        diagonal += a[i * n + i] * a[i * n + i];
+        for (std::size_t j = i + 1; j < n; ++j) {
+          offDiagonal += a[i * n + j] * a[i * n + j];
+        }
+      }
+      if (offDiagonal <= 1e-30 * diagonal) {
+        break;
+      }
+      for (std::size_t p = 0; p < n; ++p) {
+        for (std::size_t q = p + 1; q < n; ++q) {
+          const double apq = a[p * n + q];
+          if (apq == 0.0) {
+            continue;
+          }
+          const double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+          const double t = (theta >= 0 ? 1.0 : -1.0)
+                           / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+          const double c = 1.0 / std::sqrt(t * t + 1.0);
+          const double s = t * c;
+          for (std::size_t k = 0; k < n; ++k) {
+            const double akp = a[k * n + p];
+            const double akq = a[k * n + q];
+            a[k * n + p] = c * akp - s * akq;
+            a[k * n + q] = s * akp + c * akq;
+          }
+          for (std::size_t k = 0; k < n; ++k) {
+            const double apk = a[p * n + k];
+            const double aqk = a[q * n + k];
+            a[p * n + k] = c * apk - s * aqk;
+            a[q * n + k] = s * apk + c * aqk;
+          }
+          for (std::size_t k = 0; k < n; ++k) {
+            const double vkp = v[k * n + p];
+            const double vkq = v[k * n + q];
+            v[k * n + p] = c * vkp - s * vkq;
+            v[k * n + q] = s * vkp + c * vkq;
+          }
+        }
+      }
+    }
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&a, n](std::size_t i, std::size_t j) { return a[i * n + i] < a[j * n + j]; });
+    eigenvalues.resize(n);
+    eigenvectors.resize(n * n);
+    for (std::size_t k = 0; k < n; ++k) {
+      eigenvalues[k] = a[order[k] * n + order[k]];
+      for (std::size_t i = 0; i < n; ++i) {
+        eigenvectors[i * n + k] = v[i * n + order[k]];
+      }
+    }
+  }
+}
+
+#endif // DUNEURO_SYMMETRIC_EIGEN_DECOMPOSITION_HH
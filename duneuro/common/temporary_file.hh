@@ -0,0 +1,78 @@
+#ifndef DUNEURO_TEMPORARY_FILE_HH
+#define DUNEURO_TEMPORARY_FILE_HH
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief uniquely named file next to a target file, which is renamed to the target when complete
+   *
+   * The file is created by mkstemp in the directory of the target, so that several processes or
+   * threads writing the same target never share a temporary file, and the final rename is atomic.
+   * Readers of the target thus either see no file or a complete one, even if two writers publish
+   * concurrently. If the temporary file is not published, e.g. because writing it threw an
+   * exception, it is removed.
+   */
+  class TemporaryFile
+  {
+  public:
+    explicit TemporaryFile(const std::string& target) : target_(target)
+    {
+      std::string pattern = target + ".tmp.XXXXXX";
+      std::vector<char> buffer(pattern.begin(), pattern.end());
+      buffer.push_back('\0');
+      int fd = mkstemp(buffer.data());
+      if (fd < 0) {
+        DUNE_THROW(Dune::IOError, "could not create a temporary file for "
+                                      << target << ": " << std::strerror(errno));
+      }
+      // mkstemp creates the file accessible to the owner only, use the usual permissions instead
+      fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+      close(fd);
+      name_ = buffer.data();
+    }
+
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+    ~TemporaryFile()
+    {
+      if (!published_) {
+        std::remove(name_.c_str());
+      }
+    }
+
+    const std::string& name() const
+    {
+      return name_;
+    }
+
+    //! rename the temporary file to the target
+    void publish()
+    {
+      if (std::rename(name_.c_str(), target_.c_str()) != 0) {
+        DUNE_THROW(Dune::IOError, "could not move " << name_ << " to " << target_ << ": "
+                                                    << std::strerror(errno));
+      }
+      published_ = true;
+    }
+
+  private:
+    std::string target_;
+    std::string name_;
+    bool published_ = false;
+  };
+}
+
+#endif // DUNEURO_TEMPORARY_FILE_HH
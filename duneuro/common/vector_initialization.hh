@@ -12,7 +12,11 @@ namespace duneuro
                          const Dune::ParameterTree& config)
   {
     auto bounds = config.get<std::array<T, 2>>("bounds", {-1., 1.});
-    randomize_uniform(vector, bounds[0], bounds[1]);
+    if (config.hasKey("seed")) {
+      randomize_uniform_seeded(vector, config.get<unsigned int>("seed"), bounds[0], bounds[1]);
+    } else {
+      randomize_uniform(vector, bounds[0], bounds[1]);
+    }
   }
 
   template <class T, int N>
@@ -31,6 +35,8 @@ namespace duneuro
       initialize_random(vector, config);
     } else if (type == "constant") {
       initialize_constant(vector, config);
+    } else if (type == "given") {
+      // keep the entries of the vector, e.g. an initial guess provided by the caller
     } else {
       DUNE_THROW(Dune::Exception, "unknown initialization type \"" << type << "\"");
     }
@@ -77,6 +77,32 @@ namespace duneuro
       return labels_[elementMapper_.index(entity)];
     }
 
+    const std::vector<TensorType>& tensors() const
+    {
+      return tensors_;
+    }
+
+    /**
+     * \brief user visible id of each leaf vertex
+     *
+     * If the mesh has been renumbered, vertexIds()[i] is the index of the vertex with leaf index i
+     * in the mesh provided by the user. An empty vector denotes the identity.
+     */
+    const std::vector<std::size_t>& vertexIds() const
+    {
+      return vertexIds_;
+    }
+
+    void setVertexIds(std::vector<std::size_t> ids)
+    {
+      if (ids.size() > 0 && ids.size() != std::size_t(gridView_.size(dim))) {
+        DUNE_THROW(Dune::Exception, "number of vertex ids ("
+                                        << ids.size() << ") has to match the number of vertices ("
+                                        << gridView_.size(dim) << ")");
+      }
+      vertexIds_ = std::move(ids);
+    }
+
     G* releaseGrid()
     {
       return grid_.release();
@@ -106,6 +132,7 @@ namespace duneuro
     Dune::SingleCodimSingleGeomTypeMapper<GridView, 0> elementMapper_;
     std::shared_ptr<ElementNeighborhoodMap<GridView>> elementNeighborhoodMapPtr_;
     bool elementNeighborhoodMapComputed_;
+    std::vector<std::size_t> vertexIds_;
   };
 }
 
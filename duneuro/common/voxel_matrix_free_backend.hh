@@ -0,0 +1,104 @@
+#ifndef DUNEURO_VOXEL_MATRIX_FREE_BACKEND_HH
+#define DUNEURO_VOXEL_MATRIX_FREE_BACKEND_HH
+
+#include <memory>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/timer.hh>
+
+#include <dune/pdelab/backend/interface.hh>
+
+#include <duneuro/common/cg_linear_solver_backend.hh>
+#include <duneuro/common/voxel_stiffness_operator.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief sequential cg solver for voxel meshes which does not use an assembled matrix
+   *
+   * The system is given by the voxel stencil of the setup and preconditioned by the two grid
+   * preconditioner, see VoxelTwoGridPreconditioner. Each copy of the backend creates its own
+   * operator and preconditioner from the shared setup on its first solve.
+   */
+  template <class GO>
+  class ISTLBackend_SEQ_CG_VoxelMatrixFree : public CGLinearSolverBackend<GO>
+  {
+    using BaseT = CGLinearSolverBackend<GO>;
+    using GFS = typename GO::Traits::TrialGridFunctionSpace;
+    using typename BaseT::M;
+    using typename BaseT::V;
+    using typename BaseT::W;
+    using typename BaseT::Vector;
+    using typename BaseT::Real;
+    enum { dim = GFS::Traits::GridViewType::dimension };
+    using MatrixFreeOperator = VoxelStiffnessOperator<Vector, dim>;
+    using MatrixFreePreconditioner = VoxelTwoGridPreconditioner<Vector, dim>;
+
+  public:
+    using MatrixFreeSetup = VoxelMatrixFreeSetup<Real, dim>;
+    using typename BaseT::Deflation;
+
+    ISTLBackend_SEQ_CG_VoxelMatrixFree(std::shared_ptr<const MatrixFreeSetup> matrixFreeSetup,
+                                       unsigned int maxiter = 5000, int verbose = 0,
+                                       std::shared_ptr<Deflation> deflation = nullptr)
+        : BaseT(maxiter, verbose, deflation), matrixFreeSetup_(matrixFreeSetup)
+    {
+      if (!matrixFreeSetup_) {
+        DUNE_THROW(Dune::Exception, "no matrix free setup given");
+      }
+    }
+
+    // the preconditioner contains work vectors, so copies do not share it
+    ISTLBackend_SEQ_CG_VoxelMatrixFree(const ISTLBackend_SEQ_CG_VoxelMatrixFree& other)
+        : BaseT(other), matrixFreeSetup_(other.matrixFreeSetup_)
+    {
+    }
+
+    virtual std::unique_ptr<BaseT> clone() const override
+    {
+      return std::make_unique<ISTLBackend_SEQ_CG_VoxelMatrixFree>(*this);
+    }
+
+    virtual bool matrixFree() const override
+    {
+      return true;
+    }
+
+    virtual void apply(M& A, V& z, W& r, Real reduction) override
+    {
+      DUNE_THROW(Dune::NotImplemented, "the matrix free solver backend does not use the "
+                                       "assembled matrix");
+    }
+
+    virtual void residual(const V& x, W& r) override
+    {
+      using Dune::PDELab::Backend::native;
+      setup();
+      matrixFreeOperator_->applyscaleadd(-1.0, native(x), native(r));
+    }
+
+    virtual void apply(V& z, W& r, Real reduction) override
+    {
+      Dune::Timer watch;
+      setup();
+      this->solve(*matrixFreeOperator_, *matrixFreePreconditioner_, z, r, reduction,
+                  watch.elapsed());
+    }
+
+  private:
+    std::shared_ptr<const MatrixFreeSetup> matrixFreeSetup_;
+    std::shared_ptr<MatrixFreeOperator> matrixFreeOperator_;
+    std::shared_ptr<MatrixFreePreconditioner> matrixFreePreconditioner_;
+
+    void setup()
+    {
+      if (!matrixFreeOperator_) {
+        matrixFreeOperator_ = std::make_shared<MatrixFreeOperator>(matrixFreeSetup_->fine);
+        matrixFreePreconditioner_ =
+            std::make_shared<MatrixFreePreconditioner>(*matrixFreeOperator_, matrixFreeSetup_);
+      }
+    }
+  };
+}
+
+#endif // DUNEURO_VOXEL_MATRIX_FREE_BACKEND_HH
@@ -0,0 +1,826 @@
+#ifndef DUNEURO_VOXEL_STIFFNESS_OPERATOR_HH
+#define DUNEURO_VOXEL_STIFFNESS_OPERATOR_HH
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parametertree.hh>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/paamg/amg.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvercategory.hh>
+
+#include <duneuro/common/element_neighborhood_map.hh>
+#include <duneuro/common/grid_function_space_utilities.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief stiffness matrix of multilinear elements on a voxel mesh, stored as a stencil
+   *
+   * A voxel mesh consists of axis parallel hexahedra of identical size, which are placed on a
+   * regular lattice. The element matrix of such an element only depends on its conductivity
+   * tensor. Instead of the global matrix, the stencil stores the material of each lattice cell
+   * (0 for cells outside of the mesh), the element matrix of each material and the map between
+   * lattice nodes and degrees of freedom.
+   *
+   * The operator is applied on lattice ordered copies of the vectors. The cells of a lattice row
+   * along the first axis write to consecutive nodes, so the loops along a row can be vectorized.
+   * Rows which do not share nodes are processed in parallel.
+   *
+   * If the first degree of freedom is fixed, the operator coincides with the matrix modified by
+   * TSSLPDetail::fixFirstDOF: its row and column are removed and the diagonal is set to the given
+   * value.
+   */
+  template <class Real, int dim>
+  class VoxelStencil
+  {
+  public:
+    using Index = std::size_t;
+    using Material = std::uint32_t;
+    using Tensor = Dune::FieldMatrix<Real, dim, dim>;
+    using Spacing = Dune::FieldVector<Real, dim>;
+    using Coordinates = std::array<Index, dim>;
+    enum { corners = 1 << dim };
+    static constexpr Index invalid = std::numeric_limits<Index>::max();
+
+    //! lattice ordered copies of the vectors used in apply
+    struct Workspace {
+      std::vector<Real> x;
+      std::vector<Real> y;
+    };
+
+    /**
+     * \brief extract the stencil of the stiffness matrix of a multilinear function space
+     *
+     * Throws if the mesh is not a voxel mesh or if the degrees of freedom are not the vertices.
+     */
+    template <class GFS, class VC>
+    VoxelStencil(const GFS& gfs, const VC& volumeConductor, bool fixFirstDOF, Real fixedDOFEntry)
+        : fixFirstDOF_(fixFirstDOF), fixedDOFEntry_(fixedDOFEntry)
+    {
+      check_vertex_dof_ordering(gfs);
+      const auto& gv = gfs.gridView();
+      const auto& indexSet = gv.indexSet();
+      if (gv.size(0) == 0) {
+        DUNE_THROW(Dune::Exception, "voxel stencil requires a non empty mesh");
+      }
+
+      Spacing lower(std::numeric_limits<Real>::max());
+      Spacing upper(std::numeric_limits<Real>::lowest());
+      for (const auto& vertex : Dune::vertices(gv)) {
+        const auto position = vertex.geometry().corner(0);
+        for (int d = 0; d < dim; ++d) {
+          lower[d] = std::min<Real>(lower[d], position[d]);
+          upper[d] = std::max<Real>(upper[d], position[d]);
+        }
+      }
+      {
+        const auto geometry = gv.template begin<0>()->geometry();
+        Spacing first, last;
+        extents(geometry, first, last);
+        spacing_ = last - first;
+      }
+      for (int d = 0; d < dim; ++d) {
+        cells_[d] = latticeCoordinate(upper[d], lower[d], d);
+      }
+
+      dofOfNode_.assign(numberOfNodes(), invalid);
+      nodeOfDOF_.assign(gv.size(dim), invalid);
+      for (const auto& vertex : Dune::vertices(gv)) {
+        const auto position = vertex.geometry().corner(0);
+        Coordinates c;
+        for (int d = 0; d < dim; ++d) {
+          c[d] = latticeCoordinate(position[d], lower[d], d);
+        }
+        const Index node = nodeIndex(c);
+        const Index dof = indexSet.index(vertex);
+        dofOfNode_[node] = dof;
+        nodeOfDOF_[dof] = node;
+      }
+
+      // material 0 marks cells outside of the mesh
+      std::map<std::vector<Real>, Material> materialOfTensor;
+      tensors_.push_back(Tensor(0.0));
+      materialOfCell_.assign(numberOfCells(), 0);
+      for (const auto& element : Dune::elements(gv)) {
+        if (!element.type().isCube()) {
+          DUNE_THROW(Dune::Exception, "voxel stencil requires a hexahedral mesh");
+        }
+        const auto geometry = element.geometry();
+        Spacing first, last;
+        extents(geometry, first, last);
+        Coordinates c;
+        for (int d = 0; d < dim; ++d) {
+          if (std::abs(last[d] - first[d] - spacing_[d]) > tolerance * spacing_[d]) {
+            DUNE_THROW(Dune::Exception, "voxel stencil requires elements of identical size");
+          }
+          c[d] = latticeCoordinate(first[d], lower[d], d);
+        }
+        const Tensor tensor = volumeConductor.tensor(element);
+        const auto key = tensorKey(tensor);
+        auto it = materialOfTensor.find(key);
+        if (it == materialOfTensor.end()) {
+          it = materialOfTensor.emplace(key, tensors_.size()).first;
+          tensors_.push_back(tensor);
+        }
+        materialOfCell_[cellIndex(c)] = it->second;
+      }
+      initialize();
+    }
+
+    //! number of degrees of freedom
+    Index size() const
+    {
+      return nodeOfDOF_.size();
+    }
+
+    //! number of distinct element matrices, including the empty material
+    Index materials() const
+    {
+      return tensors_.size();
+    }
+
+    //! y = A x
+    template <class X, class Y>
+    void apply(const X& x, Y& y, Workspace& workspace) const
+    {
+      using ElementNeighborhoodMapDetail::forEachIndex;
+      if (workspace.x.size() != numberOfNodes()) {
+        // nodes without degree of freedom are only touched by empty cells and stay zero
+        workspace.x.assign(numberOfNodes(), 0.0);
+        workspace.y.resize(numberOfNodes());
+      }
+      auto& xl = workspace.x;
+      auto& yl = workspace.y;
+      forEachIndex(size(), [&](Index d) { xl[nodeOfDOF_[d]] = x[d]; });
+      if (fixFirstDOF_) {
+        xl[nodeOfDOF_[0]] = 0.0;
+      }
+      std::fill(yl.begin(), yl.end(), Real(0.0));
+
+      std::array<Index, corners> offsets = cornerOffsets();
+      // rows along the first axis are colored by the parity of their remaining coordinates. Rows
+      // of the same color do not share nodes.
+      for (unsigned int color = 0; color < (1u << (dim - 1)); ++color) {
+        Coordinates first, count;
+        Index rows = 1;
+        for (int d = 1; d < dim; ++d) {
+          first[d] = (color >> (d - 1)) & 1;
+          count[d] = cells_[d] > first[d] ? (cells_[d] - first[d] + 1) / 2 : 0;
+          rows *= count[d];
+        }
+        forEachIndex(rows, [&](Index r) {
+          Coordinates c;
+          c[0] = 0;
+          for (int d = 1; d < dim; ++d) {
+            c[d] = first[d] + 2 * (r % count[d]);
+            r /= count[d];
+          }
+          applyRow(cellIndex(c), nodeIndex(c), offsets, xl, yl);
+        });
+      }
+
+      forEachIndex(size(), [&](Index d) { y[d] = yl[nodeOfDOF_[d]]; });
+      if (fixFirstDOF_) {
+        y[0] = fixedDOFEntry_ * Real(x[0]);
+      }
+    }
+
+    //! diagonal of the operator
+    const std::vector<Real>& diagonal() const
+    {
+      return diagonal_;
+    }
+
+    /**
+     * \brief stencil on the lattice with twice the spacing
+     *
+     * Each coarse cell covers up to 2^dim fine cells and uses the mean of the tensors of its
+     * non empty children.
+     */
+    VoxelStencil coarsen() const
+    {
+      VoxelStencil coarse;
+      coarse.fixFirstDOF_ = fixFirstDOF_;
+      coarse.fixedDOFEntry_ = fixedDOFEntry_;
+      for (int d = 0; d < dim; ++d) {
+        coarse.spacing_[d] = 2 * spacing_[d];
+        coarse.cells_[d] = (cells_[d] + 1) / 2;
+      }
+      std::vector<Tensor> sums(coarse.numberOfCells(), Tensor(0.0));
+      std::vector<unsigned int> children(coarse.numberOfCells(), 0);
+      for (Index cell = 0; cell < numberOfCells(); ++cell) {
+        if (materialOfCell_[cell] == 0) {
+          continue;
+        }
+        Coordinates c = cellCoordinates(cell);
+        for (int d = 0; d < dim; ++d) {
+          c[d] /= 2;
+        }
+        const Index coarseCell = coarse.cellIndex(c);
+        sums[coarseCell] += tensors_[materialOfCell_[cell]];
+        ++children[coarseCell];
+      }
+      std::map<std::vector<Real>, Material> materialOfTensor;
+      coarse.tensors_.push_back(Tensor(0.0));
+      coarse.materialOfCell_.assign(coarse.numberOfCells(), 0);
+      coarse.dofOfNode_.assign(coarse.numberOfNodes(), invalid);
+      const auto offsets = coarse.cornerOffsets();
+      for (Index cell = 0; cell < coarse.numberOfCells(); ++cell) {
+        if (children[cell] == 0) {
+          continue;
+        }
+        Tensor tensor = sums[cell];
+        tensor /= children[cell];
+        const auto key = tensorKey(tensor);
+        auto it = materialOfTensor.find(key);
+        if (it == materialOfTensor.end()) {
+          it = materialOfTensor.emplace(key, coarse.tensors_.size()).first;
+          coarse.tensors_.push_back(tensor);
+        }
+        coarse.materialOfCell_[cell] = it->second;
+        const Index node = coarse.nodeIndex(coarse.cellCoordinates(cell));
+        for (auto offset : offsets) {
+          coarse.dofOfNode_[node + offset] = 0;
+        }
+      }
+      // number the coarse degrees of freedom in lattice order
+      for (Index node = 0; node < coarse.numberOfNodes(); ++node) {
+        if (coarse.dofOfNode_[node] != invalid) {
+          coarse.dofOfNode_[node] = coarse.nodeOfDOF_.size();
+          coarse.nodeOfDOF_.push_back(node);
+        }
+      }
+      coarse.initialize();
+      return coarse;
+    }
+
+    //! assemble the operator into a scalar sparse matrix
+    template <class Matrix>
+    std::unique_ptr<Matrix> assemble() const
+    {
+      const auto offsets = cornerOffsets();
+      std::vector<std::vector<Index>> rows(size());
+      for (Index cell = 0; cell < numberOfCells(); ++cell) {
+        if (materialOfCell_[cell] == 0) {
+          continue;
+        }
+        const Index node = nodeIndex(cellCoordinates(cell));
+        for (auto a : offsets) {
+          auto& row = rows[dofOfNode_[node + a]];
+          for (auto b : offsets) {
+            row.push_back(dofOfNode_[node + b]);
+          }
+        }
+      }
+      Index nonzeros = 0;
+      for (auto& row : rows) {
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+        nonzeros += row.size();
+      }
+      auto matrix = std::make_unique<Matrix>(size(), size(), nonzeros, Matrix::row_wise);
+      for (auto row = matrix->createbegin(); row != matrix->createend(); ++row) {
+        for (auto c : rows[row.index()]) {
+          row.insert(c);
+        }
+      }
+      *matrix = 0.0;
+      for (Index cell = 0; cell < numberOfCells(); ++cell) {
+        const Material m = materialOfCell_[cell];
+        if (m == 0) {
+          continue;
+        }
+        const Index node = nodeIndex(cellCoordinates(cell));
+        for (unsigned int a = 0; a < corners; ++a) {
+          const Index row = dofOfNode_[node + offsets[a]];
+          for (unsigned int b = 0; b < corners; ++b) {
+            const Index col = dofOfNode_[node + offsets[b]];
+            if (fixFirstDOF_ && (row == 0 || col == 0)) {
+              continue;
+            }
+            (*matrix)[row][col] += matrices_[(a * corners + b) * materials() + m];
+          }
+        }
+      }
+      if (fixFirstDOF_) {
+        (*matrix)[0][0] = fixedDOFEntry_;
+      }
+      return matrix;
+    }
+
+    /**
+     * \brief y += P xc, where P is the multilinear interpolation from the coarse stencil
+     *
+     * Fixed degrees of freedom are excluded on both levels.
+     */
+    template <class XC, class Y>
+    void prolongate(const VoxelStencil& coarse, const XC& xc, Y& y) const
+    {
+      ElementNeighborhoodMapDetail::forEachIndex(size(), [&](Index dof) {
+        if (fixFirstDOF_ && dof == 0) {
+          return;
+        }
+        const Coordinates c = nodeCoordinates(nodeOfDOF_[dof]);
+        Real value = 0.0;
+        forEachCoarseNeighbor(coarse, c, [&](Index coarseDOF, Real weight) {
+          value += weight * Real(xc[coarseDOF]);
+        });
+        y[dof] += value;
+      });
+    }
+
+    //! rc = P^T r, the transpose of prolongate
+    template <class R, class RC>
+    void restrictTo(const VoxelStencil& coarse, const R& r, RC& rc) const
+    {
+      ElementNeighborhoodMapDetail::forEachIndex(coarse.size(), [&](Index coarseDOF) {
+        Real value = 0.0;
+        if (!(coarse.fixFirstDOF_ && coarseDOF == 0)) {
+          const Coordinates c = coarse.nodeCoordinates(coarse.nodeOfDOF_[coarseDOF]);
+          forEachFineNeighbor(c, [&](Index dof, Real weight) { value += weight * Real(r[dof]); });
+        }
+        rc[coarseDOF] = value;
+      });
+    }
+
+  private:
+    static constexpr Real tolerance = 1e-4;
+
+    Coordinates cells_;
+    Spacing spacing_;
+    std::vector<Material> materialOfCell_;
+    std::vector<Tensor> tensors_;
+    // entry (a, b) of the element matrix of material m at (a * corners + b) * materials() + m
+    std::vector<Real> matrices_;
+    std::vector<Index> dofOfNode_;
+    std::vector<Index> nodeOfDOF_;
+    std::vector<Real> diagonal_;
+    bool fixFirstDOF_;
+    Real fixedDOFEntry_;
+
+    VoxelStencil() = default;
+
+    template <class Geometry>
+    static void extents(const Geometry& geometry, Spacing& first, Spacing& last)
+    {
+      first = std::numeric_limits<Real>::max();
+      last = std::numeric_limits<Real>::lowest();
+      for (int i = 0; i < geometry.corners(); ++i) {
+        const auto corner = geometry.corner(i);
+        for (int d = 0; d < dim; ++d) {
+          first[d] = std::min<Real>(first[d], corner[d]);
+          last[d] = std::max<Real>(last[d], corner[d]);
+        }
+      }
+    }
+
+    static std::vector<Real> tensorKey(const Tensor& tensor)
+    {
+      std::vector<Real> key;
+      for (int r = 0; r < dim; ++r) {
+        for (int s = 0; s < dim; ++s) {
+          key.push_back(tensor[r][s]);
+        }
+      }
+      return key;
+    }
+
+    Index latticeCoordinate(Real position, Real lower, int d) const
+    {
+      const Real c = (position - lower) / spacing_[d];
+      const Real rounded = std::round(c);
+      if (std::abs(c - rounded) > tolerance) {
+        DUNE_THROW(Dune::Exception, "voxel stencil requires the vertices to lie on a lattice");
+      }
+      return static_cast<Index>(rounded);
+    }
+
+    Index numberOfCells() const
+    {
+      Index n = 1;
+      for (int d = 0; d < dim; ++d) {
+        n *= cells_[d];
+      }
+      return n;
+    }
+
+    Index numberOfNodes() const
+    {
+      Index n = 1;
+      for (int d = 0; d < dim; ++d) {
+        n *= cells_[d] + 1;
+      }
+      return n;
+    }
+
+    Index cellIndex(const Coordinates& c) const
+    {
+      Index index = 0;
+      for (int d = dim - 1; d >= 0; --d) {
+        index = index * cells_[d] + c[d];
+      }
+      return index;
+    }
+
+    Index nodeIndex(const Coordinates& c) const
+    {
+      Index index = 0;
+      for (int d = dim - 1; d >= 0; --d) {
+        index = index * (cells_[d] + 1) + c[d];
+      }
+      return index;
+    }
+
+    Coordinates cellCoordinates(Index index) const
+    {
+      Coordinates c;
+      for (int d = 0; d < dim; ++d) {
+        c[d] = index % cells_[d];
+        index /= cells_[d];
+      }
+      return c;
+    }
+
+    Coordinates nodeCoordinates(Index index) const
+    {
+      Coordinates c;
+      for (int d = 0; d < dim; ++d) {
+        c[d] = index % (cells_[d] + 1);
+        index /= cells_[d] + 1;
+      }
+      return c;
+    }
+
+    // node offsets of the corners of a cell, using the lexicographic corner numbering
+    std::array<Index, corners> cornerOffsets() const
+    {
+      std::array<Index, corners> offsets;
+      for (unsigned int a = 0; a < corners; ++a) {
+        Coordinates c;
+        for (int d = 0; d < dim; ++d) {
+          c[d] = (a >> d) & 1;
+        }
+        offsets[a] = nodeIndex(c);
+      }
+      return offsets;
+    }
+
+    void applyRow(Index cell, Index node, const std::array<Index, corners>& offsets,
+                  const std::vector<Real>& xl, std::vector<Real>& yl) const
+    {
+      const Index n = cells_[0];
+      const Index numberOfMaterials = materials();
+      const Material* material = materialOfCell_.data() + cell;
+      for (unsigned int a = 0; a < corners; ++a) {
+        Real* ya = yl.data() + node + offsets[a];
+        for (unsigned int b = 0; b < corners; ++b) {
+          const Real* xb = xl.data() + node + offsets[b];
+          const Real* k = matrices_.data() + (a * corners + b) * numberOfMaterials;
+          for (Index i = 0; i < n; ++i) {
+            ya[i] += k[material[i]] * xb[i];
+          }
+        }
+      }
+    }
+
+    // compute the element matrices and the diagonal
+    void initialize()
+    {
+      const Index numberOfMaterials = materials();
+      matrices_.assign(corners * corners * numberOfMaterials, 0.0);
+      for (Index m = 1; m < numberOfMaterials; ++m) {
+        const auto local = elementMatrix(tensors_[m]);
+        for (unsigned int ab = 0; ab < corners * corners; ++ab) {
+          matrices_[ab * numberOfMaterials + m] = local[ab];
+        }
+      }
+      diagonal_.assign(size(), 0.0);
+      const auto offsets = cornerOffsets();
+      for (Index cell = 0; cell < numberOfCells(); ++cell) {
+        const Material m = materialOfCell_[cell];
+        if (m == 0) {
+          continue;
+        }
+        const Index node = nodeIndex(cellCoordinates(cell));
+        for (unsigned int a = 0; a < corners; ++a) {
+          diagonal_[dofOfNode_[node + offsets[a]]] +=
+              matrices_[(a * corners + a) * numberOfMaterials + m];
+        }
+      }
+      if (fixFirstDOF_ && size() > 0) {
+        diagonal_[0] = fixedDOFEntry_;
+      }
+    }
+
+    // element matrix of a voxel with the given tensor, integrated with the tensor gauss rule with
+    // two points per direction, which is exact for multilinear functions
+    std::vector<Real> elementMatrix(const Tensor& tensor) const
+    {
+      std::vector<Real> local(corners * corners, 0.0);
+      Real volume = 1.0;
+      for (int d = 0; d < dim; ++d) {
+        volume *= spacing_[d];
+      }
+      const Real gauss[2] = {0.5 - 0.5 / std::sqrt(3.0), 0.5 + 0.5 / std::sqrt(3.0)};
+      std::array<Spacing, corners> gradients;
+      for (unsigned int q = 0; q < corners; ++q) {
+        Spacing xi;
+        for (int d = 0; d < dim; ++d) {
+          xi[d] = gauss[(q >> d) & 1];
+        }
+        for (unsigned int a = 0; a < corners; ++a) {
+          for (int d = 0; d < dim; ++d) {
+            Real value = ((a >> d) & 1 ? 1.0 : -1.0) / spacing_[d];
+            for (int e = 0; e < dim; ++e) {
+              if (e != d) {
+                value *= (a >> e) & 1 ? xi[e] : 1.0 - xi[e];
+              }
+            }
+            gradients[a][d] = value;
+          }
+        }
+        for (unsigned int b = 0; b < corners; ++b) {
+          Spacing flux;
+          tensor.mv(gradients[b], flux);
+          for (unsigned int a = 0; a < corners; ++a) {
+            local[a * corners + b] += volume / corners * (flux * gradients[a]);
+          }
+        }
+      }
+      return local;
+    }
+
+    // weight of the coarse node C for the fine node c along one axis
+    static Real interpolationWeight(Index c, Index C)
+    {
+      if (c == 2 * C) {
+        return 1.0;
+      }
+      return (c + 1 == 2 * C || c == 2 * C + 1) ? 0.5 : 0.0;
+    }
+
+    template <class F>
+    void forEachCoarseNeighbor(const VoxelStencil& coarse, const Coordinates& c, F&& f) const
+    {
+      for (unsigned int a = 0; a < corners; ++a) {
+        Coordinates C;
+        Real weight = 1.0;
+        for (int d = 0; d < dim; ++d) {
+          C[d] = c[d] / 2 + ((a >> d) & 1);
+          weight *= C[d] <= coarse.cells_[d] ? interpolationWeight(c[d], C[d]) : 0.0;
+        }
+        if (weight == 0.0) {
+          continue;
+        }
+        const Index coarseDOF = coarse.dofOfNode_[coarse.nodeIndex(C)];
+        if (coarseDOF == invalid || (coarse.fixFirstDOF_ && coarseDOF == 0)) {
+          continue;
+        }
+        f(coarseDOF, weight);
+      }
+    }
+
+    template <class F>
+    void forEachFineNeighbor(const Coordinates& C, F&& f) const
+    {
+      unsigned int combinations = 1;
+      for (int d = 0; d < dim; ++d) {
+        combinations *= 3;
+      }
+      for (unsigned int a = 0; a < combinations; ++a) {
+        Coordinates c;
+        Real weight = 1.0;
+        bool inside = true;
+        unsigned int digits = a;
+        for (int d = 0; d < dim; ++d) {
+          const Index shifted = 2 * C[d] + digits % 3;
+          digits /= 3;
+          if (shifted < 1 || shifted - 1 > cells_[d]) {
+            inside = false;
+            break;
+          }
+          c[d] = shifted - 1;
+          weight *= interpolationWeight(c[d], C[d]);
+        }
+        if (!inside) {
+          continue;
+        }
+        const Index dof = dofOfNode_[nodeIndex(c)];
+        if (dof == invalid || (fixFirstDOF_ && dof == 0)) {
+          continue;
+        }
+        f(dof, weight);
+      }
+    }
+  };
+
+  /**
+   * \brief linear operator applying a voxel stencil
+   *
+   * The stencil is shared, each operator holds its own work vectors.
+   */
+  template <class Vector, int dim>
+  class VoxelStiffnessOperator : public Dune::LinearOperator<Vector, Vector>
+  {
+  public:
+    using Real = typename Vector::field_type;
+    using Stencil = VoxelStencil<Real, dim>;
+
+    explicit VoxelStiffnessOperator(std::shared_ptr<const Stencil> stencil) : stencil_(stencil)
+    {
+    }
+
+    virtual void apply(const Vector& x, Vector& y) const override
+    {
+      stencil_->apply(x, y, workspace_);
+    }
+
+    virtual void applyscaleadd(Real alpha, const Vector& x, Vector& y) const override
+    {
+      tmp_.resize(y.N());
+      stencil_->apply(x, tmp_, workspace_);
+      y.axpy(alpha, tmp_);
+    }
+
+    virtual Dune::SolverCategory::Category category() const override
+    {
+      return Dune::SolverCategory::sequential;
+    }
+
+    const Stencil& stencil() const
+    {
+      return *stencil_;
+    }
+
+  private:
+    std::shared_ptr<const Stencil> stencil_;
+    mutable typename Stencil::Workspace workspace_;
+    mutable Vector tmp_;
+  };
+
+  /**
+   * \brief data of the matrix free solver which is shared by all threads
+   *
+   * Contains the stencil of the system matrix and, for the two grid preconditioner, the stencil
+   * and the assembled matrix of the coarse level.
+   */
+  template <class Real, int dim>
+  struct VoxelMatrixFreeSetup {
+    using Stencil = VoxelStencil<Real, dim>;
+    using CoarseMatrix = Dune::BCRSMatrix<Dune::FieldMatrix<Real, 1, 1>>;
+
+    template <class GFS, class VC>
+    VoxelMatrixFreeSetup(const GFS& gfs, const VC& volumeConductor,
+                         const Dune::ParameterTree& config)
+        : fine(std::make_shared<Stencil>(gfs, volumeConductor, config.get<bool>("fixDOF", true),
+                                         config.get<Real>("fixedDOFEntry", 1.0)))
+        , smoothingSteps(config.get<unsigned int>("matrix_free.smoothing_steps", 2))
+        , damping(config.get<Real>("matrix_free.damping", 0.6))
+    {
+      const auto type = config.get<std::string>("matrix_free.preconditioner", "two_grid");
+      if (type == "two_grid") {
+        coarse = std::make_shared<Stencil>(fine->coarsen());
+        coarseMatrix = coarse->template assemble<CoarseMatrix>();
+      } else if (type != "jacobi") {
+        DUNE_THROW(Dune::Exception, "unknown matrix free preconditioner \"" << type << "\"");
+      }
+    }
+
+    std::shared_ptr<const Stencil> fine;
+    std::shared_ptr<const Stencil> coarse;
+    std::shared_ptr<const CoarseMatrix> coarseMatrix;
+    unsigned int smoothingSteps;
+    Real damping;
+  };
+
+  /**
+   * \brief two grid preconditioner for voxel stencils
+   *
+   * One cycle consists of damped jacobi pre-smoothing, a coarse grid correction on the lattice
+   * with twice the spacing, approximated by one amg cycle on the assembled coarse matrix, and the
+   * same number of post-smoothing steps. Restriction and prolongation are transposed to each
+   * other, so the preconditioner is symmetric. Without coarse level, the preconditioner is the
+   * inverse of the diagonal.
+   */
+  template <class Vector, int dim>
+  class VoxelTwoGridPreconditioner : public Dune::Preconditioner<Vector, Vector>
+  {
+  public:
+    using Real = typename Vector::field_type;
+    using Setup = VoxelMatrixFreeSetup<Real, dim>;
+    using Operator = VoxelStiffnessOperator<Vector, dim>;
+    using CoarseMatrix = typename Setup::CoarseMatrix;
+    using CoarseVector = Dune::BlockVector<Dune::FieldVector<Real, 1>>;
+    using CoarseOperator = Dune::MatrixAdapter<CoarseMatrix, CoarseVector, CoarseVector>;
+    using CoarseSmoother = Dune::SeqSSOR<CoarseMatrix, CoarseVector, CoarseVector, 1>;
+    using CoarseAMG = Dune::Amg::AMG<CoarseOperator, CoarseVector, CoarseSmoother>;
+    using Criterion = Dune::Amg::CoarsenCriterion<
+        Dune::Amg::SymmetricCriterion<CoarseMatrix, Dune::Amg::FirstDiagonal>>;
+
+    VoxelTwoGridPreconditioner(const Operator& op, std::shared_ptr<const Setup> setup)
+        : op_(op), setup_(setup)
+    {
+      if (setup_->coarse) {
+        Dune::Amg::Parameters parameters(15, 2000);
+        parameters.setDefaultValuesIsotropic(dim);
+        typename Dune::Amg::SmootherTraits<CoarseSmoother>::Arguments smootherArgs;
+        smootherArgs.iterations = 1;
+        smootherArgs.relaxationFactor = 1;
+        coarseOperator_ = std::make_shared<CoarseOperator>(*setup_->coarseMatrix);
+        coarseAMG_ =
+            std::make_shared<CoarseAMG>(*coarseOperator_, Criterion(parameters), smootherArgs);
+        coarseX_.resize(setup_->coarse->size());
+        coarseR_.resize(setup_->coarse->size());
+      }
+    }
+
+    virtual void pre(Vector& x, Vector& b) override
+    {
+      if (coarseAMG_) {
+        coarseX_ = 0.0;
+        coarseR_ = 0.0;
+        coarseAMG_->pre(coarseX_, coarseR_);
+      }
+    }
+
+    virtual void apply(Vector& v, const Vector& d) override
+    {
+      const auto& diagonal = setup_->fine->diagonal();
+      if (!coarseAMG_) {
+        for (std::size_t i = 0; i < v.N(); ++i) {
+          v[i] = Real(d[i]) / diagonal[i];
+        }
+        return;
+      }
+      r_.resize(d.N());
+      v = 0.0;
+      for (unsigned int i = 0; i < setup_->smoothingSteps; ++i) {
+        smooth(v, d);
+      }
+      residual(v, d);
+      setup_->fine->restrictTo(*setup_->coarse, r_, coarseR_);
+      coarseX_ = 0.0;
+      coarseAMG_->apply(coarseX_, coarseR_);
+      setup_->fine->prolongate(*setup_->coarse, coarseX_, v);
+      for (unsigned int i = 0; i < setup_->smoothingSteps; ++i) {
+        smooth(v, d);
+      }
+    }
+
+    virtual void post(Vector& x) override
+    {
+      if (coarseAMG_) {
+        coarseAMG_->post(coarseX_);
+      }
+    }
+
+    virtual Dune::SolverCategory::Category category() const override
+    {
+      return Dune::SolverCategory::sequential;
+    }
+
+  private:
+    const Operator& op_;
+    std::shared_ptr<const Setup> setup_;
+    std::shared_ptr<CoarseOperator> coarseOperator_;
+    std::shared_ptr<CoarseAMG> coarseAMG_;
+    CoarseVector coarseX_;
+    CoarseVector coarseR_;
+    Vector r_;
+
+    // r_ = d - A v
+    void residual(const Vector& v, const Vector& d)
+    {
+      r_ = d;
+      op_.applyscaleadd(-1.0, v, r_);
+    }
+
+    // damped jacobi step
+    void smooth(Vector& v, const Vector& d)
+    {
+      residual(v, d);
+      const auto& diagonal = setup_->fine->diagonal();
+      for (std::size_t i = 0; i < v.N(); ++i) {
+        v[i] += setup_->damping * Real(r_[i]) / diagonal[i];
+      }
+    }
+  };
+}
+
+#endif // DUNEURO_VOXEL_STIFFNESS_OPERATOR_HH
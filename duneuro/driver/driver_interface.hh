@@ -6,6 +6,8 @@
 #include <duneuro/common/dense_matrix.hh>
 #include <duneuro/common/dipole.hh>
 #include <duneuro/common/function.hh>
+#include <duneuro/common/low_rank_dense_matrix.hh>
+#include <duneuro/common/reduced_precision_dense_matrix.hh>
 #include <duneuro/io/data_tree.hh>
 
 #include <duneuro/driver/volume_conductor_interface.hh>
@@ -118,6 +120,19 @@ public:
     volumeConductor_->setCoilsAndProjections(coils, projections);
   }
 
+  /**
+   * \brief set the source space used to restrict transfer matrices
+   *
+   * Transfer matrices computed with restrict_to_source_space set to true
+   * afterwards only store the columns touched by the source model for the
+   * given dipoles.
+   */
+  void setSourceSpace(const std::vector<DipoleType> &dipoles,
+                      const Dune::ParameterTree &config,
+                      DataTree dataTree = DataTree()) {
+    volumeConductor_->setSourceSpace(dipoles, config, dataTree);
+  }
+
   virtual std::unique_ptr<VolumeConductorVTKWriterInterface> volumeConductorVTKWriter(const Dune::ParameterTree& config)
   {
     return volumeConductor_->volumeConductorVTKWriter(config);
@@ -146,6 +161,40 @@ public:
     return volumeConductor_->computeMEGTransferMatrix(config, dataTree);
   }
 
+  /**
+   * \brief compute the EEG (first) and the MEG (second) transfer matrix in one sweep
+   *
+   * See VolumeConductorInterface::computeEEGAndMEGTransferMatrices.
+   */
+  std::pair<std::unique_ptr<DenseMatrix<FieldType>>,
+            std::unique_ptr<DenseMatrix<FieldType>>>
+  computeEEGAndMEGTransferMatrices(const Dune::ParameterTree &config,
+                                   DataTree dataTree = DataTree()) {
+    return volumeConductor_->computeEEGAndMEGTransferMatrices(config, dataTree);
+  }
+
+  /**
+   * \brief compute the EEG transfer matrix in reduced precision
+   *
+   * See VolumeConductorInterface::computeReducedPrecisionEEGTransferMatrix.
+   */
+  std::unique_ptr<ReducedPrecisionDenseMatrix>
+  computeReducedPrecisionEEGTransferMatrix(const Dune::ParameterTree &config,
+                                           DataTree dataTree = DataTree()) {
+    return volumeConductor_->computeReducedPrecisionEEGTransferMatrix(config,
+                                                                      dataTree);
+  }
+
+  /**
+   * \brief compute the MEG transfer matrix in reduced precision
+   */
+  std::unique_ptr<ReducedPrecisionDenseMatrix>
+  computeReducedPrecisionMEGTransferMatrix(const Dune::ParameterTree &config,
+                                           DataTree dataTree = DataTree()) {
+    return volumeConductor_->computeReducedPrecisionMEGTransferMatrix(config,
+                                                                      dataTree);
+  }
+
   /**
    * \brief apply the given EEG transfer matrix
    */
@@ -169,6 +218,54 @@ public:
     return volumeConductor_->applyMEGTransfer(transferMatrix, dipole, config,
                                               dataTree);
   }
+
+  /**
+   * \brief apply the given reduced precision EEG transfer matrix
+   */
+  std::vector<std::vector<FieldType>>
+  applyEEGTransfer(const ReducedPrecisionDenseMatrix &transferMatrix,
+                   const std::vector<DipoleType> &dipole,
+                   const Dune::ParameterTree &config,
+                   DataTree dataTree = DataTree()) {
+    return volumeConductor_->applyEEGTransfer(transferMatrix, dipole, config,
+                                              dataTree);
+  }
+
+  /**
+   * \brief apply the given reduced precision MEG transfer matrix
+   */
+  std::vector<std::vector<FieldType>>
+  applyMEGTransfer(const ReducedPrecisionDenseMatrix &transferMatrix,
+                   const std::vector<DipoleType> &dipole,
+                   const Dune::ParameterTree &config,
+                   DataTree dataTree = DataTree()) {
+    return volumeConductor_->applyMEGTransfer(transferMatrix, dipole, config,
+                                              dataTree);
+  }
+
+  /**
+   * \brief apply the given low rank EEG transfer matrix
+   */
+  std::vector<std::vector<FieldType>>
+  applyEEGTransfer(const LowRankDenseMatrix &transferMatrix,
+                   const std::vector<DipoleType> &dipole,
+                   const Dune::ParameterTree &config,
+                   DataTree dataTree = DataTree()) {
+    return volumeConductor_->applyEEGTransfer(transferMatrix, dipole, config,
+                                              dataTree);
+  }
+
+  /**
+   * \brief apply the given low rank MEG transfer matrix
+   */
+  std::vector<std::vector<FieldType>>
+  applyMEGTransfer(const LowRankDenseMatrix &transferMatrix,
+                   const std::vector<DipoleType> &dipole,
+                   const Dune::ParameterTree &config,
+                   DataTree dataTree = DataTree()) {
+    return volumeConductor_->applyMEGTransfer(transferMatrix, dipole, config,
+                                              dataTree);
+  }
   
   /**
    * \brief compute the primary B field for a given set of dipoles
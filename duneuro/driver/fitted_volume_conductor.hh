@@ -5,17 +5,23 @@
 #include <tbb/tbb.h>
 #endif
 
+#include <memory>
+#include <typeinfo>
+
 #include <duneuro/common/cg_solver.hh>
 #include <duneuro/common/cg_solver_backend.hh>
 #include <duneuro/common/default_grids.hh>
+#include <duneuro/common/dense_matrix_layout.hh>
 #include <duneuro/common/dg_solver.hh>
 #include <duneuro/common/dg_solver_backend.hh>
+#include <duneuro/common/fingerprint.hh>
 #include <duneuro/common/flags.hh>
 #if HAVE_DUNE_SUBGRID
 #include <duneuro/common/geometry_adaption.hh>
 #endif
 #include <duneuro/common/fitted_driver_data.hh>
 #include <duneuro/common/grid_function_mean.hh>
+#include <duneuro/common/grid_function_space_utilities.hh>
 #include <duneuro/common/matrix_utilities.hh>
 #include <duneuro/common/stl.hh>
 #include <duneuro/common/volume_conductor.hh>
@@ -32,10 +38,12 @@
 #include <duneuro/io/volume_conductor_reader.hh>
 #include <duneuro/io/volume_conductor_vtk_writer.hh>
 #include <duneuro/io/vtk_writer.hh>
+#include <duneuro/meg/eeg_meg_transfer_matrix_solver.hh>
 #include <duneuro/meg/fitted_meg_transfer_matrix_solver.hh>
 #include <duneuro/meg/meg_solver_factory.hh>
 #include <duneuro/meg/meg_solver_interface.hh>
 
+#include <duneuro/driver/transfer_matrix_cache.hh>
 #include <duneuro/driver/volume_conductor_interface.hh>
 namespace duneuro {
 template <FittedSolverType solverType, class VC, ElementType et, int degree>
@@ -108,15 +116,28 @@ public:
                       Dune::stackobject_to_shared_ptr(solver_->functionSpace()),
                       config.sub("meg"), config.sub("solver"))
                 : nullptr),
-        solverBackend_(solver_, config.hasSub("solver")
-                                    ? config.sub("solver")
-                                    : Dune::ParameterTree()),
+        // thread local backends are copies of a single exemplar, allowing them to share data
+        solverBackend_(typename Traits::SolverBackend(
+            solver_, config.hasSub("solver") ? config.sub("solver") : Dune::ParameterTree())),
         eegTransferMatrixSolver_(solver_, config.hasSub("solver")
                                               ? config.sub("solver")
                                               : Dune::ParameterTree()),
         megTransferMatrixSolver_(solver_, megSolver_),
-        eegForwardSolver_(solver_)
+        eegForwardSolver_(solver_),
+        transferMatrixColumns_(makeTransferMatrixColumns()),
+        transferMatrixDOFs_(makeTransferMatrixDOFs()),
+        transferMatrixUserPool_(solver_, transferMatrixColumns_)
   {
+    // reuse the assembled matrix of a previous run with the same volume conductor and solver
+    // configuration
+    if (config.get<bool>("solver.jacobian_cache.enable", false)) {
+      const Fingerprint fingerprint = jacobianFingerprint(config.sub("solver"));
+      const std::string filename =
+          config.get<std::string>("solver.jacobian_cache.directory", ".") + "/jacobian_" +
+          fingerprint.str() + ".bin";
+      dataTree.set("jacobian_cache", filename);
+      solver_->setJacobianCache(filename);
+    }
   }
 
   virtual void solveEEGForward(
@@ -240,9 +261,22 @@ public:
   virtual std::unique_ptr<DenseMatrix<double>>
   computeEEGTransferMatrix(const Dune::ParameterTree &config,
                            DataTree dataTree = DataTree()) override {
+    this->checkStoragePrecision(config, false);
     this->featureManager_->update_features("transfer_matrix");
-    return eegTransferMatrixSolver_.solve(solverBackend_, *electrodeProjection_,
-                                          config, dataTree);
+    const bool restricted = restrictToSourceSpace(config);
+    auto fingerprint = [&]() {
+      return eegTransferMatrixFingerprint(config, restricted);
+    };
+    auto transferMatrix = cachedTransferMatrix(
+        "eeg_transfer_matrix", config, fingerprint,
+        [&]() {
+          eegTransferMatrixSolver_.setColumnSelection(transferMatrixColumnSelection(restricted));
+          return eegTransferMatrixSolver_.solve(solverBackend_, *electrodeProjection_,
+                                                withCheckpointKey(config, fingerprint), dataTree);
+        },
+        dataTree);
+    markSourceSpace(*transferMatrix, restricted);
+    return withLayout(std::move(transferMatrix), config, dataTree);
   }
 
   virtual std::unique_ptr<DenseMatrix<double>>
@@ -251,8 +285,175 @@ public:
     if (!megSolver_) {
       DUNE_THROW(Dune::Exception, "no meg solver created");
     }
+    this->checkStoragePrecision(config, false);
+    this->featureManager_->update_features("transfer_matrix");
+    const bool restricted = restrictToSourceSpace(config);
+    auto fingerprint = [&]() {
+      return megTransferMatrixFingerprint(config, restricted);
+    };
+    auto transferMatrix = cachedTransferMatrix(
+        "meg_transfer_matrix", config, fingerprint,
+        [&]() {
+          megTransferMatrixSolver_.setColumnSelection(transferMatrixColumnSelection(restricted));
+          return megTransferMatrixSolver_.solve(
+              solverBackend_, withCheckpointKey(config, fingerprint), dataTree);
+        },
+        dataTree);
+    markSourceSpace(*transferMatrix, restricted);
+    return withLayout(std::move(transferMatrix), config, dataTree);
+  }
+
+  virtual std::pair<std::unique_ptr<DenseMatrix<double>>,
+                    std::unique_ptr<DenseMatrix<double>>>
+  computeEEGAndMEGTransferMatrices(const Dune::ParameterTree &config,
+                                   DataTree dataTree = DataTree()) override {
+    if (!megSolver_) {
+      DUNE_THROW(Dune::Exception, "no meg solver created");
+    }
+    if (config.get<bool>("cache.enable", false)) {
+      DUNE_THROW(Dune::NotImplemented,
+                 "the joint sweep does not use the transfer matrix cache, compute "
+                 "the matrices separately");
+    }
     this->featureManager_->update_features("transfer_matrix");
-    return megTransferMatrixSolver_.solve(solverBackend_, config, dataTree);
+    const bool restricted = restrictToSourceSpace(config);
+    const auto eegConfig = jointSweepConfig(config, "eeg");
+    const auto megConfig = jointSweepConfig(config, "meg");
+    this->checkStoragePrecision(eegConfig, false);
+    this->checkStoragePrecision(megConfig, false);
+    eegTransferMatrixSolver_.setColumnSelection(transferMatrixColumnSelection(restricted));
+    megTransferMatrixSolver_.setColumnSelection(transferMatrixColumnSelection(restricted));
+    auto transferMatrices =
+        EEGMEGTransferMatrixSolver<decltype(eegTransferMatrixSolver_),
+                                   decltype(megTransferMatrixSolver_)>(
+            eegTransferMatrixSolver_, megTransferMatrixSolver_)
+            .solve(solverBackend_, *electrodeProjection_,
+                   withCheckpointKey(eegConfig,
+                                     [&]() {
+                                       return eegTransferMatrixFingerprint(eegConfig,
+                                                                           restricted);
+                                     }),
+                   withCheckpointKey(megConfig,
+                                     [&]() {
+                                       return megTransferMatrixFingerprint(megConfig,
+                                                                           restricted);
+                                     }),
+                   config, dataTree);
+    markSourceSpace(*transferMatrices.first, restricted);
+    markSourceSpace(*transferMatrices.second, restricted);
+    transferMatrices.first =
+        withLayout(std::move(transferMatrices.first), eegConfig, dataTree.sub("eeg"));
+    transferMatrices.second =
+        withLayout(std::move(transferMatrices.second), megConfig, dataTree.sub("meg"));
+    return transferMatrices;
+  }
+
+  virtual std::unique_ptr<ReducedPrecisionDenseMatrix>
+  computeReducedPrecisionEEGTransferMatrix(const Dune::ParameterTree &config,
+                                           DataTree dataTree = DataTree()) override {
+    checkReducedPrecisionConfig(config);
+    this->featureManager_->update_features("transfer_matrix");
+    const bool restricted = restrictToSourceSpace(config);
+    eegTransferMatrixSolver_.setColumnSelection(transferMatrixColumnSelection(restricted));
+    auto transferMatrix = eegTransferMatrixSolver_.solveReducedPrecision(
+        solverBackend_, *electrodeProjection_, config, dataTree);
+    markSourceSpace(*transferMatrix, restricted);
+    transferMatrix->report(dataTree.sub("precision"));
+    return transferMatrix;
+  }
+
+  virtual std::unique_ptr<ReducedPrecisionDenseMatrix>
+  computeReducedPrecisionMEGTransferMatrix(const Dune::ParameterTree &config,
+                                           DataTree dataTree = DataTree()) override {
+    if (!megSolver_) {
+      DUNE_THROW(Dune::Exception, "no meg solver created");
+    }
+    checkReducedPrecisionConfig(config);
+    this->featureManager_->update_features("transfer_matrix");
+    const bool restricted = restrictToSourceSpace(config);
+    megTransferMatrixSolver_.setColumnSelection(transferMatrixColumnSelection(restricted));
+    auto transferMatrix =
+        megTransferMatrixSolver_.solveReducedPrecision(solverBackend_, config, dataTree);
+    markSourceSpace(*transferMatrix, restricted);
+    transferMatrix->report(dataTree.sub("precision"));
+    return transferMatrix;
+  }
+
+  virtual void setSourceSpace(
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    using User = typename Traits::TransferMatrixUser;
+    Dune::Timer timer;
+    const std::size_t numberOfDOFs =
+        solver_->functionSpace().getGFS().ordering().size();
+    // the configurations are read through const references, as the tasks below read them
+    // concurrently, and the source model configuration is identified once for all tasks
+    const Dune::ParameterTree &driverConfig = config_;
+    const auto &sourceModelConfig = config.sub("source_model");
+    const auto &solverConfig = driverConfig.sub("solver");
+    const auto userKey = TransferMatrixUserPool<User>::makeKey(sourceModelConfig, solverConfig);
+    // columns of the full transfer matrix touched by any of the dipoles
+    auto collect = [&](std::size_t begin, std::size_t end,
+                       std::vector<char> &used) {
+      User &user = transferMatrixUserPool_.get(userKey, sourceModelConfig, solverConfig);
+      for (std::size_t index = begin; index != end; ++index) {
+        user.bind(dipoles[index]);
+        user.collectColumns(used);
+      }
+    };
+    std::vector<char> used(numberOfDOFs, 0);
+#if HAVE_TBB
+    tbb::enumerable_thread_specific<std::vector<char>> localUsed(numberOfDOFs, 0);
+    int nr_threads = config.hasKey("numberOfThreads") ? config.get<int>("numberOfThreads") : tbb::task_arena::automatic;
+    tbb::task_arena arena(nr_threads);
+    arena.execute([&] {
+      tbb::parallel_for(
+          tbb::blocked_range<std::size_t>(0, dipoles.size(),
+                                          config.get<int>("grainSize", 16)),
+          [&](const tbb::blocked_range<std::size_t> &range) {
+            collect(range.begin(), range.end(), localUsed.local());
+          });
+    });
+    for (const auto &local : localUsed) {
+      for (std::size_t c = 0; c < numberOfDOFs; ++c) {
+        used[c] |= local[c];
+      }
+    }
+#else
+    collect(0, dipoles.size(), used);
+#endif
+    auto columns = std::make_shared<std::vector<std::size_t>>();
+    std::vector<std::size_t> position(numberOfDOFs, User::noColumn);
+    for (std::size_t c = 0; c < numberOfDOFs; ++c) {
+      if (used[c]) {
+        position[c] = columns->size();
+        columns->push_back(c);
+      }
+    }
+    // the restricted users map each degree of freedom to the position of its column in the
+    // source space, the transfer matrix solvers select the degree of freedom of each position
+    auto columnOfDOF = std::make_shared<std::vector<std::size_t>>(numberOfDOFs);
+    auto dofs = std::make_shared<std::vector<std::size_t>>(columns->size());
+    for (std::size_t k = 0; k < numberOfDOFs; ++k) {
+      const auto c = transferMatrixColumns_ ? (*transferMatrixColumns_)[k] : k;
+      (*columnOfDOF)[k] = position[c];
+      if (position[c] != User::noColumn) {
+        (*dofs)[position[c]] = k;
+      }
+    }
+    // source spaces with the same columns share the column map and thus the key
+    Fingerprint sourceSpaceFingerprint;
+    sourceSpaceFingerprint.add(*columns);
+    sourceSpaceColumns_ = columns;
+    sourceSpaceDOFs_ = dofs;
+    sourceSpaceKey_ = sourceSpaceFingerprint.value();
+    sourceSpaceUserPool_ =
+        std::make_unique<TransferMatrixUserPool<User>>(solver_, columnOfDOF);
+    dataTree.set("columns", columns->size());
+    dataTree.set("degrees_of_freedom", numberOfDOFs);
+    dataTree.set("time", timer.elapsed());
   }
 
   virtual std::vector<std::vector<double>> applyEEGTransfer(
@@ -264,7 +465,7 @@ public:
 
     return this->template applyEEGTransfer_impl<Traits>(
         transferMatrix, dipoles, config, dataTree, config_, solver_,
-        projectedGlobalElectrodes_);
+        projectedGlobalElectrodes_, transferMatrixUserPoolFor(transferMatrix));
   }
 
   virtual std::vector<std::vector<double>> applyMEGTransfer(
@@ -274,7 +475,8 @@ public:
       const Dune::ParameterTree &config,
       DataTree dataTree = DataTree()) override {
     return this->template applyMEGTransfer_impl<Traits>(
-        transferMatrix, dipoles, config, dataTree, config_, solver_, coils_, projections_);
+        transferMatrix, dipoles, config, dataTree, config_, solver_, coils_, projections_,
+        transferMatrixUserPoolFor(transferMatrix));
   }
   
   virtual std::vector<std::vector<double>> computeMEGPrimaryField(
@@ -287,6 +489,50 @@ public:
     return this->computeMEGPrimaryField_impl(dipoles, coils_, projections_, config);
   }
 
+  virtual std::vector<std::vector<double>> applyEEGTransfer(
+      const ReducedPrecisionDenseMatrix &transferMatrix,
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    return this->template applyEEGTransfer_impl<Traits>(
+        transferMatrix, dipoles, config, dataTree, config_, solver_,
+        projectedGlobalElectrodes_, transferMatrixUserPoolFor(transferMatrix));
+  }
+
+  virtual std::vector<std::vector<double>> applyMEGTransfer(
+      const ReducedPrecisionDenseMatrix &transferMatrix,
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    return this->template applyMEGTransfer_impl<Traits>(
+        transferMatrix, dipoles, config, dataTree, config_, solver_, coils_, projections_,
+        transferMatrixUserPoolFor(transferMatrix));
+  }
+
+  virtual std::vector<std::vector<double>> applyEEGTransfer(
+      const LowRankDenseMatrix &transferMatrix,
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    return this->template applyEEGTransfer_impl<Traits>(
+        transferMatrix, dipoles, config, dataTree, config_, solver_,
+        projectedGlobalElectrodes_, transferMatrixUserPoolFor(transferMatrix));
+  }
+
+  virtual std::vector<std::vector<double>> applyMEGTransfer(
+      const LowRankDenseMatrix &transferMatrix,
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    return this->template applyMEGTransfer_impl<Traits>(
+        transferMatrix, dipoles, config, dataTree, config_, solver_, coils_, projections_,
+        transferMatrixUserPoolFor(transferMatrix));
+  }
+
   virtual std::vector<typename VolumeConductorInterface<dim>::CoordinateType>
   getProjectedElectrodes() const override {
     std::vector<typename VolumeConductorInterface<dim>::CoordinateType> coordinates;
@@ -311,6 +557,237 @@ public:
   }
 
 private:
+  // column of each degree of freedom in the transfer matrices returned to the user. If the mesh
+  // has been renumbered, the columns are ordered by the user visible vertex ids. This is only
+  // possible if the degrees of freedom are attached to the vertices, i.e. for linear CG. For
+  // other discretizations of a renumbered mesh, transferMatrixColumnSelection refuses to compute
+  // full transfer matrices.
+  std::shared_ptr<const std::vector<std::size_t>> makeTransferMatrixColumns() const {
+    const auto &vertexIds = volumeConductorStorage_.get()->vertexIds();
+    if constexpr (solverType == FittedSolverType::cg && degree == 1) {
+      if (vertexIds.size() > 0) {
+        check_vertex_dof_ordering(solver_->functionSpace().getGFS());
+        return std::make_shared<const std::vector<std::size_t>>(vertexIds);
+      }
+    }
+    return nullptr;
+  }
+
+  // degree of freedom stored in each column of a full transfer matrix, i.e. the inverse of
+  // transferMatrixColumns_
+  std::shared_ptr<const std::vector<std::size_t>> makeTransferMatrixDOFs() const {
+    if (!transferMatrixColumns_) {
+      return nullptr;
+    }
+    auto dofs = std::make_shared<std::vector<std::size_t>>(transferMatrixColumns_->size());
+    for (std::size_t k = 0; k < dofs->size(); ++k) {
+      (*dofs)[(*transferMatrixColumns_)[k]] = k;
+    }
+    return dofs;
+  }
+
+  // The transfer matrix solvers store the rows in the final column order as they are computed,
+  // so that renumbered matrices are never permuted afterwards. A permutation would touch every
+  // page of a file backed matrix, and a checkpointed matrix, which is mapped copy-on-write,
+  // would be duplicated in anonymous memory.
+  std::shared_ptr<const std::vector<std::size_t>>
+  transferMatrixColumnSelection(bool restricted) const {
+    if (restricted) {
+      return sourceSpaceDOFs_;
+    }
+    if (!transferMatrixColumns_ && volumeConductorStorage_.get()->vertexIds().size() > 0) {
+      DUNE_THROW(Dune::NotImplemented,
+                 "the columns of a transfer matrix of a renumbered mesh can only be mapped to the "
+                 "user visible vertex ids for linear CG. Use grid.renumbering = none or "
+                 "restrict the transfer matrix to a source space");
+    }
+    return transferMatrixDOFs_;
+  }
+
+  bool restrictToSourceSpace(const Dune::ParameterTree &config) const {
+    if (!config.get<bool>("restrict_to_source_space", false)) {
+      return false;
+    }
+    if (!sourceSpaceColumns_) {
+      DUNE_THROW(Dune::Exception, "no source space set, call setSourceSpace first");
+    }
+    return true;
+  }
+
+  // store the key of the current source space in a restricted transfer matrix
+  template <class M>
+  void markSourceSpace(M &transferMatrix, bool restricted) const {
+    if (restricted) {
+      transferMatrix.setColumnKey(sourceSpaceKey_);
+    }
+  }
+
+  // users for a full transfer matrix or for one restricted to the source space. Restricted
+  // matrices computed by this driver carry the key of their source space, which has to be the
+  // current one. Other matrices are only recognized by their number of columns.
+  template <class M>
+  TransferMatrixUserPool<typename Traits::TransferMatrixUser> &
+  transferMatrixUserPoolFor(const M &transferMatrix) {
+    if (transferMatrix.columnKey() != 0) {
+      if (!sourceSpaceColumns_ || transferMatrix.columnKey() != sourceSpaceKey_) {
+        DUNE_THROW(Dune::Exception,
+                   "transfer matrix has been restricted to a different source space, "
+                   "recompute it after the last call to setSourceSpace");
+      }
+      return *sourceSpaceUserPool_;
+    }
+    const std::size_t numberOfDOFs =
+        solver_->functionSpace().getGFS().ordering().size();
+    if (transferMatrix.cols() == numberOfDOFs) {
+      return transferMatrixUserPool_;
+    }
+    if (sourceSpaceColumns_ &&
+        transferMatrix.cols() == sourceSpaceColumns_->size()) {
+      return *sourceSpaceUserPool_;
+    }
+    DUNE_THROW(Dune::Exception,
+               "transfer matrix has " << transferMatrix.cols()
+                                      << " columns, expected " << numberOfDOFs
+                                      << " or the number of source space columns");
+  }
+
+  static void checkReducedPrecisionConfig(const Dune::ParameterTree &config) {
+    VolumeConductorInterface<dim>::checkStoragePrecision(config, true);
+    if (config.get<bool>("cache.enable", false)) {
+      DUNE_THROW(Dune::NotImplemented,
+                 "reduced precision transfer matrices cannot be cached");
+    }
+    if (config.hasSub("layout")) {
+      DUNE_THROW(Dune::NotImplemented,
+                 "reduced precision transfer matrices are always stored row major");
+    }
+  }
+
+  // transfer matrices are computed and cached row by row. If layout.type is dof_major, they are
+  // converted afterwards, see convert_dense_matrix_layout
+  static std::unique_ptr<DenseMatrix<double>>
+  withLayout(std::unique_ptr<DenseMatrix<double>> transferMatrix,
+             const Dune::ParameterTree &config, DataTree dataTree) {
+    if (!config.hasSub("layout")) {
+      return transferMatrix;
+    }
+    const auto &layoutConfig = config.sub("layout");
+    const auto layout = dense_matrix_layout_from_string(
+        layoutConfig.get<std::string>("type", "sensor_major"));
+    if (layout == transferMatrix->layout()) {
+      return transferMatrix;
+    }
+    Dune::Timer timer;
+    auto converted = convert_dense_matrix_layout(*transferMatrix, layout, layoutConfig);
+    auto sub = dataTree.sub("layout");
+    sub.set("type", to_string(layout));
+    sub.set("time", timer.elapsed());
+    return converted;
+  }
+
+  // if the transfer matrix is checkpointed, identify the checkpoint by the fingerprint of the
+  // matrix, so that only a computation with identical input is resumed
+  template <class FingerprintFunction>
+  static Dune::ParameterTree withCheckpointKey(const Dune::ParameterTree &config,
+                                               FingerprintFunction &&fingerprint) {
+    Dune::ParameterTree result(config);
+    if (config.get<bool>("storage.checkpoint", false) &&
+        !config.hasKey("storage.checkpoint_key")) {
+      result["storage.checkpoint_key"] = fingerprint().str();
+    }
+    return result;
+  }
+
+  // the config of one matrix of a joint eeg and meg sweep: the common keys with the storage
+  // taken from <name>.storage, so that its fingerprint matches a separate computation
+  static Dune::ParameterTree jointSweepConfig(const Dune::ParameterTree &config,
+                                              const std::string &name) {
+    Dune::ParameterTree result;
+    for (const auto &key : config.getValueKeys()) {
+      result[key] = config[key];
+    }
+    for (const auto &key : config.getSubKeys()) {
+      if (key != "eeg" && key != "meg" && key != "storage") {
+        result.sub(key) = config.sub(key);
+      }
+    }
+    if (config.hasSub(name + ".storage")) {
+      result.sub("storage") = config.sub(name + ".storage");
+    }
+    return result;
+  }
+
+  // fingerprint of the discretization and the volume conductor, computed only once
+  const Fingerprint &volumeConductorFingerprint() {
+    if (!volumeConductorFingerprint_) {
+      Fingerprint fingerprint;
+      fingerprint.add(typeid(typename Traits::Solver).name());
+      addVolumeConductor(fingerprint, *volumeConductorStorage_.get());
+      volumeConductorFingerprint_ = std::make_unique<Fingerprint>(fingerprint);
+    }
+    return *volumeConductorFingerprint_;
+  }
+
+  // fingerprint of the data the assembled matrix depends on: the discretization, the volume
+  // conductor and the solver keys entering the local operator. Keys only used by the linear
+  // solver, e.g. reduction or the preconditioner, do not change the matrix and are skipped, as is
+  // fixDOF, since the cached matrix is stored before the first degree of freedom is fixed.
+  Fingerprint jacobianFingerprint(const Dune::ParameterTree &solverConfig) {
+    Fingerprint fingerprint = volumeConductorFingerprint();
+    for (const auto &key :
+         {"intorderadd", "scheme", "penalty", "edge_norm_type", "weights"}) {
+      fingerprint.add(key);
+      fingerprint.add(solverConfig.get<std::string>(key, ""));
+    }
+    return fingerprint;
+  }
+
+  // fingerprint of the data all transfer matrices depend on: the discretization, the volume
+  // conductor, the type of the transfer matrix right hand sides and the reduction of the linear
+  // solver. The remaining keys only change how the matrix is computed, e.g. its storage, the
+  // scheduling, the block size, the seeding or the preconditioner, and are skipped, so that they
+  // neither invalidate the cache nor the checkpoint of an interrupted computation.
+  Fingerprint transferMatrixFingerprint(const Dune::ParameterTree &config) {
+    const Dune::ParameterTree &driverConfig = config_;
+    Fingerprint fingerprint = jacobianFingerprint(
+        driverConfig.hasSub("solver") ? driverConfig.sub("solver") : Dune::ParameterTree());
+    for (const auto &key : {"solver.fixDOF", "solver.fixedDOFEntry"}) {
+      fingerprint.add(key);
+      fingerprint.add(driverConfig.get<std::string>(key, ""));
+    }
+    for (const auto &key : {"type", "solver.reduction"}) {
+      fingerprint.add(key);
+      fingerprint.add(config.get<std::string>(key, ""));
+    }
+    return fingerprint;
+  }
+
+  Fingerprint eegTransferMatrixFingerprint(const Dune::ParameterTree &config,
+                                           bool restricted) {
+    auto fingerprint = transferMatrixFingerprint(config);
+    for (const auto &projection : projectedGlobalElectrodes_) {
+      fingerprint.add(projection.element.geometry().global(projection.localPosition));
+    }
+    if (restricted) {
+      fingerprint.add(*sourceSpaceColumns_);
+    }
+    return fingerprint;
+  }
+
+  Fingerprint megTransferMatrixFingerprint(const Dune::ParameterTree &config,
+                                           bool restricted) {
+    const Dune::ParameterTree &driverConfig = config_;
+    auto fingerprint = transferMatrixFingerprint(config);
+    fingerprint.add(driverConfig.hasSub("meg") ? driverConfig.sub("meg")
+                                               : Dune::ParameterTree());
+    fingerprint.add(coils_);
+    fingerprint.add(projections_);
+    if (restricted) {
+      fingerprint.add(*sourceSpaceColumns_);
+    }
+    return fingerprint;
+  }
+
   Dune::ParameterTree config_;
   typename Traits::VCStorage volumeConductorStorage_;
   std::shared_ptr<typename Traits::ElementSearch> elementSearch_;
@@ -331,6 +808,17 @@ private:
       megTransferMatrixSolver_;
   EEGForwardSolver<typename Traits::Solver, typename Traits::SourceModelFactory>
       eegForwardSolver_;
+  std::shared_ptr<const std::vector<std::size_t>> transferMatrixColumns_;
+  std::shared_ptr<const std::vector<std::size_t>> transferMatrixDOFs_;
+  TransferMatrixUserPool<typename Traits::TransferMatrixUser>
+      transferMatrixUserPool_;
+  // columns of the transfer matrices kept for the source space, the corresponding degrees of
+  // freedom and the users for restricted transfer matrices
+  std::shared_ptr<const std::vector<std::size_t>> sourceSpaceColumns_;
+  std::shared_ptr<const std::vector<std::size_t>> sourceSpaceDOFs_;
+  std::uint64_t sourceSpaceKey_ = 0;
+  std::unique_ptr<TransferMatrixUserPool<typename Traits::TransferMatrixUser>>
+      sourceSpaceUserPool_;
   std::unique_ptr<
       duneuro::ElectrodeProjectionInterface<typename Traits::VC::GridView>>
       electrodeProjection_;
@@ -339,6 +827,7 @@ private:
   std::vector<typename VolumeConductorInterface<dim>::CoordinateType> coils_;
   std::vector<std::vector<typename VolumeConductorInterface<dim>::CoordinateType>> projections_;
   std::shared_ptr<SourceModelInterface<typename Traits::VC::GridView, double, dim, typename Traits::DomainDOFVector>> sourceModelPtr_;
+  std::unique_ptr<Fingerprint> volumeConductorFingerprint_;
 };
 
 } // namespace duneuro
@@ -0,0 +1,72 @@
+#ifndef DUNEURO_TRANSFER_MATRIX_CACHE_HH
+#define DUNEURO_TRANSFER_MATRIX_CACHE_HH
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <dune/common/exceptions.hh>
+#include <dune/common/parametertree.hh>
+#include <dune/common/timer.hh>
+
+#include <duneuro/common/dense_matrix.hh>
+#include <duneuro/common/fingerprint.hh>
+#include <duneuro/common/temporary_file.hh>
+#include <duneuro/io/data_tree.hh>
+#include <duneuro/io/hdf5_dense_matrix.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief return a transfer matrix from the on-disk cache or compute it
+   *
+   * If the key cache.enable of the given config is true, the matrix is looked up in the file
+   * <cache.directory>/<name>_<fingerprint>.h5. On a hit, the stored matrix is returned. Otherwise
+   * the matrix is computed using compute() and stored in this file. The fingerprint is only
+   * computed, by calling fingerprint(), if the cache is enabled. It has to identify all data the
+   * matrix depends on, e.g. the volume conductor, the sensors and the solver configuration.
+   */
+  template <class FingerprintFunction, class ComputeFunction>
+  std::unique_ptr<DenseMatrix<double>>
+  cachedTransferMatrix(const std::string& name, const Dune::ParameterTree& config,
+                       FingerprintFunction&& fingerprint, ComputeFunction&& compute,
+                       DataTree dataTree = DataTree())
+  {
+    if (!config.get<bool>("cache.enable", false)) {
+      return compute();
+    }
+#if HAVE_HDF5WRAP
+    Dune::Timer timer;
+    auto cacheTree = dataTree.sub("cache");
+    const std::string hash = fingerprint().str();
+    const std::string filename =
+        config.get<std::string>("cache.directory", ".") + "/" + name + "_" + hash + ".h5";
+    cacheTree.set("fingerprint", hash);
+    cacheTree.set("filename", filename);
+    cacheTree.set("time_fingerprint", timer.lap());
+    if (std::ifstream(filename).good()) {
+      auto matrix = DenseMatrixToHDF5Reader<DenseMatrix<double>>::read(filename);
+      cacheTree.set("hit", true);
+      cacheTree.set("time_read", timer.lap());
+      return matrix;
+    }
+    cacheTree.set("hit", false);
+    auto matrix = compute();
+    timer.lap();
+    // write to a unique temporary file first, so that neither an interrupted run nor another
+    // process writing the same entry leaves an incomplete matrix behind
+    TemporaryFile temporary(filename);
+    {
+      H5::H5File file(temporary.name(), H5F_ACC_TRUNC);
+      DenseMatrixToHDF5Writer<DenseMatrix<double>>::write(file, *matrix);
+    }
+    temporary.publish();
+    cacheTree.set("time_write", timer.lap());
+    return matrix;
+#else
+    DUNE_THROW(Dune::NotImplemented, "the transfer matrix cache requires hdf5wrap");
+#endif
+  }
+}
+
+#endif // DUNEURO_TRANSFER_MATRIX_CACHE_HH
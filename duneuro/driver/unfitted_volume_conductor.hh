@@ -133,6 +133,7 @@ public:
                                     : Dune::ParameterTree()),
         eegTransferMatrixSolver_(solver_, config.sub("solver")),
         eegForwardSolver_(solver_),
+        transferMatrixUserPool_(solver_),
         conductivities_(
             config.get<std::vector<double>>("solver.conductivities")) {
   }
@@ -199,6 +200,7 @@ public:
   virtual std::unique_ptr<DenseMatrix<double>>
   computeEEGTransferMatrix(const Dune::ParameterTree &config,
                            DataTree dataTree = DataTree()) override {
+    this->checkStoragePrecision(config, false);
     this->featureManager_->update_features("transfer_matrix");
     return eegTransferMatrixSolver_.solve(solverBackend_, *projectedElectrodes_,
                                           config, dataTree);
@@ -210,6 +212,38 @@ public:
     DUNE_THROW(Dune::NotImplemented, "currently not implemented");
   }
 
+  virtual std::pair<std::unique_ptr<DenseMatrix<double>>,
+                    std::unique_ptr<DenseMatrix<double>>>
+  computeEEGAndMEGTransferMatrices(const Dune::ParameterTree &config,
+                                   DataTree dataTree = DataTree()) override {
+    DUNE_THROW(Dune::NotImplemented, "currently not implemented");
+  }
+
+  virtual std::unique_ptr<ReducedPrecisionDenseMatrix>
+  computeReducedPrecisionEEGTransferMatrix(const Dune::ParameterTree &config,
+                                           DataTree dataTree = DataTree()) override {
+    this->checkStoragePrecision(config, true);
+    this->featureManager_->update_features("transfer_matrix");
+    auto transferMatrix = eegTransferMatrixSolver_.solveReducedPrecision(
+        solverBackend_, *projectedElectrodes_, config, dataTree);
+    transferMatrix->report(dataTree.sub("precision"));
+    return transferMatrix;
+  }
+
+  virtual std::unique_ptr<ReducedPrecisionDenseMatrix>
+  computeReducedPrecisionMEGTransferMatrix(const Dune::ParameterTree &config,
+                                           DataTree dataTree = DataTree()) override {
+    DUNE_THROW(Dune::NotImplemented, "currently not implemented");
+  }
+
+  virtual void setSourceSpace(
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    DUNE_THROW(Dune::NotImplemented, "currently not implemented");
+  }
+
   virtual std::vector<std::vector<double>> applyEEGTransfer(
       const DenseMatrix<double> &transferMatrix,
       const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
@@ -218,7 +252,7 @@ public:
       DataTree dataTree = DataTree()) override {
     return this->template applyEEGTransfer_impl<Traits>(
         transferMatrix, dipoles, config, dataTree, config_, solver_,
-        projectedGlobalElectrodes_);
+        projectedGlobalElectrodes_, transferMatrixUserPool_);
   }
 
   virtual std::vector<std::vector<double>> applyMEGTransfer(
@@ -228,7 +262,52 @@ public:
       const Dune::ParameterTree &config,
       DataTree dataTree = DataTree()) override {
     return this->template applyMEGTransfer_impl<Traits>(
-        transferMatrix, dipoles, config, dataTree, config_, solver_, coils_, projections_);
+        transferMatrix, dipoles, config, dataTree, config_, solver_, coils_, projections_,
+        transferMatrixUserPool_);
+  }
+
+  virtual std::vector<std::vector<double>> applyEEGTransfer(
+      const ReducedPrecisionDenseMatrix &transferMatrix,
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    return this->template applyEEGTransfer_impl<Traits>(
+        transferMatrix, dipoles, config, dataTree, config_, solver_,
+        projectedGlobalElectrodes_, transferMatrixUserPool_);
+  }
+
+  virtual std::vector<std::vector<double>> applyMEGTransfer(
+      const ReducedPrecisionDenseMatrix &transferMatrix,
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    return this->template applyMEGTransfer_impl<Traits>(
+        transferMatrix, dipoles, config, dataTree, config_, solver_, coils_, projections_,
+        transferMatrixUserPool_);
+  }
+
+  virtual std::vector<std::vector<double>> applyEEGTransfer(
+      const LowRankDenseMatrix &transferMatrix,
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    return this->template applyEEGTransfer_impl<Traits>(
+        transferMatrix, dipoles, config, dataTree, config_, solver_,
+        projectedGlobalElectrodes_, transferMatrixUserPool_);
+  }
+
+  virtual std::vector<std::vector<double>> applyMEGTransfer(
+      const LowRankDenseMatrix &transferMatrix,
+      const std::vector<typename VolumeConductorInterface<dim>::DipoleType>
+          &dipoles,
+      const Dune::ParameterTree &config,
+      DataTree dataTree = DataTree()) override {
+    return this->template applyMEGTransfer_impl<Traits>(
+        transferMatrix, dipoles, config, dataTree, config_, solver_, coils_, projections_,
+        transferMatrixUserPool_);
   }
 
   virtual std::vector<typename VolumeConductorInterface<dim>::CoordinateType>
@@ -287,6 +366,7 @@ private:
   typename Traits::EEGTransferMatrixSolver eegTransferMatrixSolver_;
   EEGForwardSolver<typename Traits::Solver, typename Traits::SourceModelFactory>
       eegForwardSolver_;
+  TransferMatrixUserPool<typename Traits::TransferMatrixUser> transferMatrixUserPool_;
   std::unique_ptr<ProjectedElectrodes<typename Traits::GridView>>
       projectedElectrodes_;
   std::vector<typename ProjectedElectrodes<typename Traits::GridView>::Projection>
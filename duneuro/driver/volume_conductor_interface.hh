@@ -9,12 +9,17 @@
 #include <duneuro/common/dipole.hh>
 #include <duneuro/common/flags.hh>
 #include <duneuro/common/function.hh>
+#include <duneuro/common/low_rank_dense_matrix.hh>
+#include <duneuro/common/reduced_precision_dense_matrix.hh>
 #include <duneuro/io/data_tree.hh>
 #include <duneuro/driver/feature_manager.hh>
+#include <duneuro/eeg/transfer_matrix_user_pool.hh>
 #include <duneuro/io/volume_conductor_vtk_writer.hh>
 
 #include <dune/pdelab/common/crossproduct.hh>
 
+#include <algorithm>
+#include <utility>
 #include <vector>
 
 namespace duneuro {
@@ -116,6 +121,21 @@ public:
       const std::vector<CoordinateType> &coils,
       const std::vector<std::vector<CoordinateType>> &projections) = 0;
 
+  /**
+   * \brief set the source space used to restrict transfer matrices
+   *
+   * The right hand sides of the source model config.source_model are assembled for all given
+   * dipoles and the union of the columns of the transfer matrices they touch is recorded.
+   * Transfer matrices computed with restrict_to_source_space set to true only store these
+   * columns and the key of the source space, see DenseMatrix::columnKey. applyEEGTransfer and
+   * applyMEGTransfer reject matrices restricted to another source space and recognize matrices
+   * without a key by their number of columns. They can only be applied to dipoles of the source
+   * space using the same source model.
+   */
+  virtual void setSourceSpace(const std::vector<DipoleType> &dipoles,
+                              const Dune::ParameterTree &config,
+                              DataTree dataTree = DataTree()) = 0;
+
   /**
    * Return a writer, which can be used to visualize the volume conductor. FEM trial functions can be associated to the writer
    * in various ways, see the interface class. By calling the write-method of the writer, a vtu file containing the volume conductor
@@ -127,6 +147,13 @@ public:
    * \brief compute the EEG transfer matrix
    *
    * Note that setElectrodes has to be called before using this method.
+   * Setting solver.block_size to a value k > 1 solves for k electrodes at once
+   * using a block cg solver (only supported by the fitted cg driver). The
+   * iterations of each block are reported in solver.block_<i>.
+   * Setting layout.type to dof_major returns the matrix in column major
+   * layout, which speeds up applying it to sparse right hand sides. The
+   * remaining keys of the layout sub tree are passed to
+   * convert_dense_matrix_layout.
    */
   virtual std::unique_ptr<DenseMatrix<FieldType>>
   computeEEGTransferMatrix(const Dune::ParameterTree &config,
@@ -136,14 +163,57 @@ public:
    * \brief compute the MEG transfer matrix
    *
    * Note that setCoilsAndProjections has to be called before using this method.
-   * The rows of the resulting matrix will be ordered coil-wise.
+   * The rows of the resulting matrix will be ordered coil-wise. The layout
+   * can be chosen as for computeEEGTransferMatrix.
    */
   virtual std::unique_ptr<DenseMatrix<FieldType>>
   computeMEGTransferMatrix(const Dune::ParameterTree &config,
                            DataTree dataTree = DataTree()) = 0;
 
+  /**
+   * \brief compute the EEG (first) and the MEG (second) transfer matrix in one sweep
+   *
+   * All electrodes and all coil projections are solved for in a single parallel
+   * loop, sharing the solver setup, the preconditioner and the work vectors of
+   * each thread. The storage of the matrices is given by the sub trees
+   * eeg.storage and meg.storage, the remaining keys are used as for
+   * computeEEGTransferMatrix. The transfer matrix cache, neighbor seeding and
+   * block solves are not supported.
+   */
+  virtual std::pair<std::unique_ptr<DenseMatrix<FieldType>>,
+                    std::unique_ptr<DenseMatrix<FieldType>>>
+  computeEEGAndMEGTransferMatrices(const Dune::ParameterTree &config,
+                                   DataTree dataTree = DataTree()) = 0;
+
+  /**
+   * \brief compute the EEG transfer matrix in reduced precision
+   *
+   * The precision is chosen by storage.precision, which has to be float32 or
+   * int16. Every row is converted as soon as it has been computed, so the
+   * matrix is never stored in double precision. The largest conversion error
+   * of each row, relative to its largest entry, is reported in precision.row_<i>.
+   * Reduced precision matrices cannot be cached, checkpointed or converted to
+   * a different layout.
+   */
+  virtual std::unique_ptr<ReducedPrecisionDenseMatrix>
+  computeReducedPrecisionEEGTransferMatrix(const Dune::ParameterTree &config,
+                                           DataTree dataTree = DataTree()) = 0;
+
+  /**
+   * \brief compute the MEG transfer matrix in reduced precision
+   *
+   * See computeReducedPrecisionEEGTransferMatrix.
+   */
+  virtual std::unique_ptr<ReducedPrecisionDenseMatrix>
+  computeReducedPrecisionMEGTransferMatrix(const Dune::ParameterTree &config,
+                                           DataTree dataTree = DataTree()) = 0;
+
   /**
    * \brief apply the given EEG transfer matrix
+   *
+   * Setting batch_size to a value k > 1 assembles the right hand sides of k
+   * dipoles and multiplies them with the transfer matrix at once, turning k
+   * matrix vector products into a single matrix matrix product.
    */
   virtual std::vector<std::vector<FieldType>>
   applyEEGTransfer(const DenseMatrix<FieldType> &transferMatrix,
@@ -160,6 +230,47 @@ public:
                    const Dune::ParameterTree &config,
                    DataTree dataTree = DataTree()) = 0;
 
+  /**
+   * \brief apply the given reduced precision EEG transfer matrix
+   *
+   * The entries are converted back to double while accumulating.
+   */
+  virtual std::vector<std::vector<FieldType>>
+  applyEEGTransfer(const ReducedPrecisionDenseMatrix &transferMatrix,
+                   const std::vector<DipoleType> &dipole,
+                   const Dune::ParameterTree &config,
+                   DataTree dataTree = DataTree()) = 0;
+
+  /**
+   * \brief apply the given reduced precision MEG transfer matrix
+   */
+  virtual std::vector<std::vector<FieldType>>
+  applyMEGTransfer(const ReducedPrecisionDenseMatrix &transferMatrix,
+                   const std::vector<DipoleType> &dipole,
+                   const Dune::ParameterTree &config,
+                   DataTree dataTree = DataTree()) = 0;
+
+  /**
+   * \brief apply the given low rank EEG transfer matrix
+   *
+   * The matrix is usually created from a transfer matrix by
+   * make_low_rank_approximation. Each product is computed as U (V x).
+   */
+  virtual std::vector<std::vector<FieldType>>
+  applyEEGTransfer(const LowRankDenseMatrix &transferMatrix,
+                   const std::vector<DipoleType> &dipole,
+                   const Dune::ParameterTree &config,
+                   DataTree dataTree = DataTree()) = 0;
+
+  /**
+   * \brief apply the given low rank MEG transfer matrix
+   */
+  virtual std::vector<std::vector<FieldType>>
+  applyMEGTransfer(const LowRankDenseMatrix &transferMatrix,
+                   const std::vector<DipoleType> &dipole,
+                   const Dune::ParameterTree &config,
+                   DataTree dataTree = DataTree()) = 0;
+
   /**
    * \brief compute the primary B field for a given set of dipoles
    */
@@ -187,6 +298,26 @@ public:
 protected:
   std::shared_ptr<FeatureManager> featureManager_;
 
+  // The precision of the storage determines the type of the computed transfer matrix, which can
+  // only be released in that precision. It is therefore checked before the sweep, instead of
+  // after all rows have been computed.
+  static void checkStoragePrecision(const Dune::ParameterTree &config, bool reduced) {
+    const auto precision = config.get<std::string>("storage.precision", "float64");
+    if (!reduced && precision != "float64") {
+      DUNE_THROW(Dune::Exception,
+                 "storage.precision = " << precision
+                                        << " requires the reduced precision transfer matrix "
+                                           "functions");
+    }
+    if (reduced) {
+      if (precision == "float64") {
+        DUNE_THROW(Dune::Exception, "reduced precision transfer matrices require "
+                                    "storage.precision = float32 or int16");
+      }
+      dense_matrix_precision_from_string(precision);
+    }
+  }
+
   template <class EEGForwardSolver, class Solver, class SolverBackend>
   void solveEEGForward_impl(const DipoleType &dipole, Function &solution,
                             Dune::ParameterTree config,
@@ -220,18 +351,63 @@ protected:
     }
   }
 
-  template <class Traits, class ProjectedGlobalElectrodesType>
+  template <class Traits, class M, class ProjectedGlobalElectrodesType>
   std::vector<std::vector<double>> applyEEGTransfer_impl(
-      const DenseMatrix<double> &transferMatrix,
+      const M &transferMatrix,
       const std::vector<DipoleType> &dipoles, Dune::ParameterTree cfg,
       DataTree dataTree, const Dune::ParameterTree &config_complete,
       std::shared_ptr<typename Traits::Solver> solver,
-      ProjectedGlobalElectrodesType &projectedGlobalElectrodes) {
+      ProjectedGlobalElectrodesType &projectedGlobalElectrodes,
+      TransferMatrixUserPool<typename Traits::TransferMatrixUser> &userPool) {
     this->featureManager_->check_feature(cfg);
     const Dune::ParameterTree& config = cfg; // necessary to ensure the following block is thread-safe
     std::vector<std::vector<double>> result(dipoles.size());
 
     using User = typename Traits::TransferMatrixUser;
+    // the source model configuration is identified once for all chunks
+    const auto& sourceModelConfig = config.sub("source_model");
+    const auto& solverConfig = config_complete.sub("solver");
+    const auto userKey =
+        TransferMatrixUserPool<User>::makeKey(sourceModelConfig, solverConfig);
+    // dipoles are either processed one by one or, if batch_size > 1, in batches sharing a
+    // single product with the transfer matrix
+    const auto batchSize = config.get<std::size_t>("batch_size", 1);
+    auto processRange = [&](User& myUser, std::size_t begin, std::size_t end) {
+      if (batchSize <= 1) {
+        for (std::size_t index = begin; index != end; ++index) {
+          auto dt = dataTree.sub("dipole_" + std::to_string(index));
+          myUser.bind(dipoles[index], dt);
+          auto current = myUser.solve(transferMatrix, dt);
+          if (config.get<bool>("post_process")) {
+            myUser.postProcessPotential(projectedGlobalElectrodes, current);
+          }
+          if (config.get<bool>("subtract_mean")) {
+            subtract_mean(current);
+          }
+          result[index] = current;
+        }
+      } else {
+        const bool postProcess = config.get<bool>("post_process");
+        for (std::size_t batchBegin = begin; batchBegin < end; batchBegin += batchSize) {
+          std::size_t batchEnd = std::min(end, batchBegin + batchSize);
+          auto currents = myUser.solveBatch(
+              transferMatrix, dipoles, batchBegin, batchEnd,
+              [&](std::size_t, std::vector<double>& contribution) {
+                if (postProcess) {
+                  myUser.postProcessPotential(projectedGlobalElectrodes, contribution);
+                }
+              },
+              dataTree);
+          for (std::size_t index = batchBegin; index < batchEnd; ++index) {
+            auto& current = currents[index - batchBegin];
+            if (config.get<bool>("subtract_mean")) {
+              subtract_mean(current);
+            }
+            result[index] = std::move(current);
+          }
+        }
+      }
+    };
 #if HAVE_TBB
     auto grainSize = config.get<int>("grainSize", 16);
     int nr_threads = config.hasKey("numberOfThreads") ? config.get<int>("numberOfThreads") : tbb::task_arena::automatic;
@@ -240,52 +416,29 @@ protected:
       tbb::parallel_for(
         tbb::blocked_range<std::size_t>(0, dipoles.size(), grainSize),
         [&](const tbb::blocked_range<std::size_t>& range) {
-          User myUser(solver);
-          myUser.setSourceModel(config.sub("source_model"), config_complete.sub("solver"));
-          for (std::size_t index = range.begin(); index != range.end(); ++index) {
-            auto dt = dataTree.sub("dipole_" + std::to_string(index));
-            myUser.bind(dipoles[index], dt);
-            auto current = myUser.solve(transferMatrix, dt);
-            if (config.get<bool>("post_process")) {
-              myUser.postProcessPotential(projectedGlobalElectrodes, current);
-            }
-            if (config.get<bool>("subtract_mean")) {
-              subtract_mean(current);
-            }
-            result[index] = current;
-          }
+          // source models are created once per thread and reused by all chunks
+          User& myUser = userPool.get(userKey, sourceModelConfig, solverConfig);
+          processRange(myUser, range.begin(), range.end());
         }
       );
     });
 #else
-    User myUser(solver);
-    myUser.setSourceModel(config.sub("source_model"),
-                          config_complete.sub("solver"));
-    for (std::size_t index = 0; index < dipoles.size(); ++index) {
-      auto dt = dataTree.sub("dipole_" + std::to_string(index));
-      myUser.bind(dipoles[index], dt);
-      auto current = myUser.solve(transferMatrix, dt);
-      if (config.get<bool>("post_process")) {
-        myUser.postProcessPotential(projectedGlobalElectrodes, current);
-      }
-      if (config.get<bool>("subtract_mean")) {
-        subtract_mean(current);
-      }
-      result[index] = current;
-    }
+    User& myUser = userPool.get(userKey, sourceModelConfig, solverConfig);
+    processRange(myUser, 0, dipoles.size());
 #endif
     return result;
   }
 
-  template <class Traits, class CoordinateType>
+  template <class Traits, class M, class CoordinateType>
   std::vector<std::vector<double>>
-  applyMEGTransfer_impl(const DenseMatrix<double> &transferMatrix,
+  applyMEGTransfer_impl(const M &transferMatrix,
                         const std::vector<DipoleType> &dipoles,
                         Dune::ParameterTree cfg, DataTree dataTree,
                         const Dune::ParameterTree &config_complete,
                         std::shared_ptr<typename Traits::Solver> solver,
                         const std::vector<CoordinateType>& coils,
-                        const std::vector<std::vector<CoordinateType>>& projections) {
+                        const std::vector<std::vector<CoordinateType>>& projections,
+                        TransferMatrixUserPool<typename Traits::TransferMatrixUser> &userPool) {
     this->featureManager_->check_feature(cfg);
     // set source model config for MEG prostprocessing
     std::string meg_postprocessing = cfg.get<std::string>("post_process_meg", "false");
@@ -294,6 +447,41 @@ protected:
     std::vector<std::vector<double>> result(dipoles.size());
 
     using User = typename Traits::TransferMatrixUser;
+    // the source model configuration is identified once for all chunks
+    const auto& sourceModelConfig = config.sub("source_model");
+    const auto& solverConfig = config_complete.sub("solver");
+    const auto userKey =
+        TransferMatrixUserPool<User>::makeKey(sourceModelConfig, solverConfig);
+    const auto batchSize = config.get<std::size_t>("batch_size", 1);
+    auto processRange = [&](User& myUser, std::size_t begin, std::size_t end) {
+      if (batchSize <= 1) {
+        for (std::size_t index = begin; index != end; ++index) {
+          auto dt = dataTree.sub("dipole_" + std::to_string(index));
+          myUser.bind(dipoles[index], dt);
+          auto current = myUser.solve(transferMatrix, dt);
+          if(config.get<bool>("post_process_meg")) {
+            myUser.postProcessMEG(coils, projections, current);
+          }
+          result[index] = current;
+        }
+      } else {
+        const bool postProcess = config.get<bool>("post_process_meg");
+        for (std::size_t batchBegin = begin; batchBegin < end; batchBegin += batchSize) {
+          std::size_t batchEnd = std::min(end, batchBegin + batchSize);
+          auto currents = myUser.solveBatch(
+              transferMatrix, dipoles, batchBegin, batchEnd,
+              [&](std::size_t, std::vector<double>& contribution) {
+                if (postProcess) {
+                  myUser.postProcessMEG(coils, projections, contribution);
+                }
+              },
+              dataTree);
+          for (std::size_t index = batchBegin; index < batchEnd; ++index) {
+            result[index] = std::move(currents[index - batchBegin]);
+          }
+        }
+      }
+    };
 
 #if HAVE_TBB
     auto grainSize = config.get<int>("grainSize", 16);
@@ -303,33 +491,15 @@ protected:
       tbb::parallel_for(
         tbb::blocked_range<std::size_t>(0, dipoles.size(), grainSize),
         [&](const tbb::blocked_range<std::size_t>& range) {
-          User myUser(solver);
-          myUser.setSourceModel(config.sub("source_model"), config_complete.sub("solver"));
-          for (std::size_t index = range.begin(); index != range.end(); ++index) {
-            auto dt = dataTree.sub("dipole_" + std::to_string(index));
-            myUser.bind(dipoles[index], dt);
-            auto current = myUser.solve(transferMatrix, dt);
-            if(config.get<bool>("post_process_meg")) {
-              myUser.postProcessMEG(coils, projections, current);
-            }
-            result[index] = current;
-          }
+          // source models are created once per thread and reused by all chunks
+          User& myUser = userPool.get(userKey, sourceModelConfig, solverConfig);
+          processRange(myUser, range.begin(), range.end());
         }
       );
     });
 #else
-    User myUser(solver);
-    myUser.setSourceModel(config.sub("source_model"),
-                          config_complete.sub("solver"));
-    for (std::size_t index = 0; index < dipoles.size(); ++index) {
-      auto dt = dataTree.sub("dipole_" + std::to_string(index));
-      myUser.bind(dipoles[index], dt);
-      auto current = myUser.solve(transferMatrix, dt);
-      if(config.get<bool>("post_process_meg")) {
-        myUser.postProcessMEG(coils, projections, current);
-      }
-      result[index] = current;
-    }
+    User& myUser = userPool.get(userKey, sourceModelConfig, solverConfig);
+    processRange(myUser, 0, dipoles.size());
 #endif
     return result;
   }
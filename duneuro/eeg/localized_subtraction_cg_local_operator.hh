@@ -11,9 +11,7 @@ namespace duneuro {
     using Tensor = typename ProblemParameters::Traits::PermTensorType;
     enum {dim = VolumeConductor::GridView::dimension};
     using LocalFunction = typename GridFunction::LocalFunction;
-    enum {diffOrder = 1};
-    using DerivativeGridFunction = typename Dune::PDELab::DiscreteGridViewFunction<typename GridFunction::GridFunctionSpace, typename GridFunction::Vector, diffOrder>;
-    using LocalDerivativeFunction = typename DerivativeGridFunction::LocalFunction;
+    using LocalDerivativeFunction = typename GridFunction::LocalDerivativeFunction;
   
     LocalizedSubtractionCGLocalOperator(std::shared_ptr<const VolumeConductor> volumeConductorPtr,
                                         std::shared_ptr<GridFunction> gridFunctionPtr,
@@ -172,8 +170,8 @@ namespace duneuro {
       const auto& elem_geo = eg.geometry();
 
       // create local functions for chi and its derivative
-      LocalFunction chi_local = localFunction(*gridFunctionPtr_);
-      LocalDerivativeFunction grad_chi_local = localFunction(derivative(*gridFunctionPtr_));
+      LocalFunction chi_local = gridFunctionPtr_->localFunction();
+      LocalDerivativeFunction grad_chi_local = gridFunctionPtr_->localDerivativeFunction();
       chi_local.bind(elem);
       grad_chi_local.bind(elem);
 
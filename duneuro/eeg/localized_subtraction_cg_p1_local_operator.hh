@@ -12,9 +12,7 @@ namespace duneuro {
     using Tensor = typename ProblemParameters::Traits::PermTensorType;
     enum {dim = VolumeConductor::GridView::dimension};
     using LocalFunction = typename GridFunction::LocalFunction;
-    enum {diffOrder = 1};
-    using DerivativeGridFunction = typename Dune::PDELab::DiscreteGridViewFunction<typename GridFunction::GridFunctionSpace, typename GridFunction::Vector, diffOrder>;
-    using LocalDerivativeFunction = typename DerivativeGridFunction::LocalFunction;
+    using LocalDerivativeFunction = typename GridFunction::LocalDerivativeFunction;
     
     using Scalar = typename ProblemParameters::Traits::RangeFieldType;
     using Coordinate = Dune::FieldVector<Scalar, dim>;
@@ -161,7 +159,7 @@ namespace duneuro {
       lhs_matrix *= 1.0 / (4.0 * Dune::StandardMathematicalConstants<Scalar>::pi() * sigma_infinity[0][0]);
       
       // get local description of chi
-      LocalFunction chi_local = localFunction(*gridFunctionPtr_);
+      LocalFunction chi_local = gridFunctionPtr_->localFunction();
       chi_local.bind(eg.entity());
       std::vector<Scalar> chi_local_expansion(lfs_size);
       std::generate(chi_local_expansion.begin(), chi_local_expansion.end(), [&ref_element, &chi_local, i = 0] () mutable {return chi_local(ref_element.position(i++, vertex_codim));});
@@ -21,6 +21,7 @@
 #include <duneuro/common/entityset_volume_conductor.hh>
 #include <duneuro/common/element_patch_assembler.hh>
 #include <duneuro/common/logged_timer.hh>
+#include <duneuro/common/patch_local_function.hh>
 #include <duneuro/common/penalty_flux_weighting.hh>
 #include <duneuro/common/sub_function_space.hh>
 #include <duneuro/common/subset_entityset.hh>
@@ -63,12 +64,9 @@ namespace duneuro
     using HostLFS = Dune::PDELab::LocalFunctionSpace<typename FS::GFS>;
     using HostLFSCache = Dune::PDELab::LFSIndexCache<HostLFS>;
     using HostProblem = SubtractionDGDefaultParameter<HostGridView, typename V::field_type, VC>;
-    using DOFVector = Dune::PDELab::Backend::Vector<typename FS::GFS, typename FS::NT>;
-    using DiscreteGridFunction = typename Dune::PDELab::DiscreteGridViewFunction<typename FS::GFS, DOFVector>;
-    using LocalFunction = typename DiscreteGridFunction::LocalFunction;
-    enum {diffOrder = 1};
-    using DerivativeGridFunction = typename Dune::PDELab::DiscreteGridViewFunction<typename DiscreteGridFunction::GridFunctionSpace, DOFVector, diffOrder>;
-    using LocalDerivativeFunction = typename DerivativeGridFunction::LocalFunction;
+    using ChiFunction = PatchLocalFunction<typename FS::GFS, typename FS::NT>;
+    using LocalFunction = typename ChiFunction::LocalFunction;
+    using LocalDerivativeFunction = typename ChiFunction::LocalDerivativeFunction;
     using Tensor = typename HostProblem::Traits::PermTensorType;
 
     LocalizedSubtractionSourceModel(std::shared_ptr<const VC> volumeConductor,
@@ -91,7 +89,7 @@ namespace duneuro
         , intorder_meg_boundary_(config.get<unsigned int>("intorder_meg_boundary", 6))
         , intorder_meg_transition_(config.get<unsigned int>("intorder_meg_transition", 5))
         , penalty_(solverConfig.get<double>("penalty"))
-        , chiFunctionPtr_(nullptr)
+        , chiFunctionPtr_(std::make_shared<ChiFunction>(functionSpace_->getGFS()))
     {
     }
 
@@ -148,23 +146,22 @@ namespace duneuro
         HostLFS lfs(functionSpace_->getGFS());
         HostLFSCache indexMapper(lfs);
 
-        // we first create the underlying vector containing the coefficients of chi when written in the FEM basis
-        chiBasisCoefficientsPtr_ = std::make_shared<DOFVector>(functionSpace_->getGFS(), 0.0);
-
-        // we now iterate over the inner region and set all coefficients corresponding to DOFs of elements contained in the inner region to 1.0
+        // chi is stored by its non zero coefficients in the FEM basis, which only live on the patch.
+        // We iterate over the inner region and set all coefficients corresponding to DOFs of elements
+        // contained in the inner region to 1.0
+        chiFunctionPtr_->clear();
         for(const auto& element : patchAssembler_.patchElements()) {
           // bind local finite element space
           lfs.bind(element);
           indexMapper.update();
 
           for(size_t i = 0; i < indexMapper.size(); ++i) {
-            auto index = indexMapper.containerIndex(i);
-            (*chiBasisCoefficientsPtr_)[index] = 1.0;
+            chiFunctionPtr_->set(indexMapper.containerIndex(i), 1.0);
           } // end inner for loop
         } //end outer for loop
-
-        // we can now wrap chi into a grid function
-        chiFunctionPtr_ = std::make_shared<DiscreteGridFunction>(functionSpace_->getGFS(), *chiBasisCoefficientsPtr_);
+        dataTree.set("chi_dofs", chiFunctionPtr_->size());
+        timer.lap("bind_chi");
+        timer.stop("bind_accumulated");
       } // end if
     } // end bind
 
@@ -180,8 +177,8 @@ namespace duneuro
       else if(continuityType == ContinuityType::continuous)
       {
         using LOP = typename std::conditional<isP1FEM<FS>::value && dim == 3,
-                                              LocalizedSubtractionCGP1LocalOperator<VC, DiscreteGridFunction, HostProblem>,
-                                              LocalizedSubtractionCGLocalOperator<VC, DiscreteGridFunction, HostProblem>>::type;
+                                              LocalizedSubtractionCGP1LocalOperator<VC, ChiFunction, HostProblem>,
+                                              LocalizedSubtractionCGLocalOperator<VC, ChiFunction, HostProblem>>::type;
         LOP cg_local_operator(volumeConductor_, chiFunctionPtr_, *hostProblem_, intorderadd_eeg_patch_, intorderadd_eeg_boundary_, intorderadd_eeg_transition_);
         patchAssembler_.assemblePatchVolume(vector, cg_local_operator);
         patchAssembler_.assemblePatchBoundary(vector, cg_local_operator);
@@ -245,7 +242,7 @@ namespace duneuro
                         std::vector<typename VectorType::field_type>& vector) const override
     {
       if constexpr(continuityType == ContinuityType::continuous) {
-        LocalFunction chi_local = localFunction(*chiFunctionPtr_);
+        LocalFunction chi_local = chiFunctionPtr_->localFunction();
         for(size_t i = 0; i < electrodes.size(); ++i) {
           chi_local.bind(electrodes[i].element);
           vector[i] += chi_local(electrodes[i].localPosition) * hostProblem_->get_u_infty(electrodes[i].element.geometry().global(electrodes[i].localPosition));
@@ -293,8 +290,7 @@ namespace duneuro
     unsigned int intorder_meg_boundary_;
     unsigned int intorder_meg_transition_;
     double penalty_;
-    std::shared_ptr<DOFVector> chiBasisCoefficientsPtr_;
-    std::shared_ptr<DiscreteGridFunction> chiFunctionPtr_;
+    std::shared_ptr<ChiFunction> chiFunctionPtr_;
     
     bool useAnalyticRHS_;
 
@@ -425,8 +421,8 @@ namespace duneuro
     {
       using GradientType = typename InfinityPotentialGradient<typename VC::GridView, CoordinateField>::RangeType;
 
-      LocalFunction chi_local = localFunction(*chiFunctionPtr_);
-      LocalDerivativeFunction grad_chi_local = localFunction(derivative(*chiFunctionPtr_));
+      LocalFunction chi_local = chiFunctionPtr_->localFunction();
+      LocalDerivativeFunction grad_chi_local = chiFunctionPtr_->localDerivativeFunction();
 
       for(const auto& element : patchAssembler_.transitionElements()) {
         Tensor sigma = volumeConductor_->tensor(element);
@@ -0,0 +1,133 @@
+#ifndef DUNEURO_NEIGHBOR_SEEDING_HH
+#define DUNEURO_NEIGHBOR_SEEDING_HH
+
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include <dune/common/dynmatrix.hh>
+#include <dune/common/dynvector.hh>
+#include <dune/common/fmatrix.hh>
+
+#include <dune/pdelab/backend/interface.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief order points along a greedy nearest neighbor path
+   *
+   * Starting with the point first, the path always continues with the closest point not yet
+   * visited. Only the points with indices in [first, points.size()) are visited.
+   */
+  template <class Coordinate>
+  std::vector<std::size_t> nearest_neighbor_ordering(const std::vector<Coordinate>& points,
+                                                     std::size_t first = 0)
+  {
+    std::vector<std::size_t> order;
+    if (first >= points.size()) {
+      return order;
+    }
+    std::vector<bool> visited(points.size(), false);
+    order.reserve(points.size() - first);
+    std::size_t current = first;
+    visited[current] = true;
+    order.push_back(current);
+    while (order.size() < points.size() - first) {
+      std::size_t next = current;
+      auto bestDistance = std::numeric_limits<typename Coordinate::field_type>::max();
+      for (std::size_t i = first; i < points.size(); ++i) {
+        if (visited[i]) {
+          continue;
+        }
+        auto distance = (points[i] - points[current]).two_norm2();
+        if (distance < bestDistance) {
+          bestDistance = distance;
+          next = i;
+        }
+      }
+      current = next;
+      visited[current] = true;
+      order.push_back(current);
+    }
+    return order;
+  }
+
+  /**
+   * \brief initial guesses computed from the solutions of previous, similar systems
+   *
+   * The last solutions x_j and right hand sides b_j of a chain of solves are stored. For a new
+   * right hand side b, the initial guess is the galerkin projection of the solution onto the span
+   * of the stored x_j, i.e. x = sum_j c_j x_j with (x_i, b_j)_ij c = ((x_j, b))_j. As A x_j = b_j,
+   * the system matrix only enters through the stored right hand sides and no additional matrix
+   * vector products are necessary. Should the small system be singular, the last solution is
+   * used.
+   */
+  template <class DomainDOFVector, class RangeDOFVector>
+  class NeighborSeeding
+  {
+  public:
+    explicit NeighborSeeding(std::size_t size) : size_(size)
+    {
+    }
+
+    //! compute an initial guess for the right hand side b. Returns false if no solution is stored
+    bool initialGuess(const RangeDOFVector& b, DomainDOFVector& x) const
+    {
+      using Dune::PDELab::Backend::native;
+      const std::size_t k = solutions_.size();
+      if (k == 0) {
+        return false;
+      }
+      Dune::DynamicMatrix<double> gram(k, k);
+      Dune::DynamicVector<double> rhs(k), coefficients(k, 0.0);
+      for (std::size_t i = 0; i < k; ++i) {
+        rhs[i] = native(solutions_[i]).dot(native(b));
+        for (std::size_t j = i; j < k; ++j) {
+          // symmetrize, as the stored systems are only solved approximately
+          gram[i][j] = gram[j][i] = 0.5
+                                    * (native(solutions_[i]).dot(native(rightHandSides_[j]))
+                                       + native(solutions_[j]).dot(native(rightHandSides_[i])));
+        }
+      }
+      try {
+        gram.solve(coefficients, rhs);
+      } catch (Dune::FMatrixError&) {
+        coefficients = 0.0;
+        coefficients[k - 1] = 1.0;
+      }
+      x = 0.0;
+      for (std::size_t i = 0; i < k; ++i) {
+        native(x).axpy(coefficients[i], native(solutions_[i]));
+      }
+      return true;
+    }
+
+    //! store the solution x of the system with right hand side b
+    void push(const DomainDOFVector& x, const RangeDOFVector& b)
+    {
+      if (size_ == 0) {
+        return;
+      }
+      if (solutions_.size() == size_) {
+        solutions_.pop_front();
+        rightHandSides_.pop_front();
+      }
+      solutions_.push_back(x);
+      rightHandSides_.push_back(b);
+    }
+
+    void clear()
+    {
+      solutions_.clear();
+      rightHandSides_.clear();
+    }
+
+  private:
+    std::size_t size_;
+    std::deque<DomainDOFVector> solutions_;
+    std::deque<RangeDOFVector> rightHandSides_;
+  };
+}
+
+#endif // DUNEURO_NEIGHBOR_SEEDING_HH
@@ -88,8 +88,10 @@ namespace duneuro
     {
       Dune::Timer timer;
       KDTreeElementSearch<GV> search(gridView_);
-      for (const auto& electrode : electrodes) {
-        const auto& element = search.findEntity(electrode);
+      auto elements = search.findEntities(electrodes);
+      for (std::size_t i = 0; i < electrodes.size(); ++i) {
+        const auto& electrode = electrodes[i];
+        const auto& element = elements[i];
         if (!subTriangulation.isHostCell(element)) {
           DUNE_THROW(Dune::Exception, "element of electrode at "
                                           << electrode << " is not a host cell for any domain");
@@ -3,6 +3,7 @@
 
 #include <Eigen/Dense>
 #include <array>
+#include <set>
 #include <vector>
 
 #include <dune/common/fvector.hh>
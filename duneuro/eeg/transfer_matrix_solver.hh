@@ -1,12 +1,19 @@
 #ifndef DUNEURO_TRANSFER_MATRIX_SOLVER_HH
 #define DUNEURO_TRANSFER_MATRIX_SOLVER_HH
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include <dune/common/parametertree.hh>
+#include <dune/common/timer.hh>
 
+#include <duneuro/common/block_cg_solver_backend.hh>
+#include <duneuro/common/checkpointed_dense_matrix.hh>
 #include <duneuro/common/make_dof_vector.hh>
+#include <duneuro/common/reduced_precision_dense_matrix.hh>
 #include <duneuro/eeg/electrode_projection_interface.hh>
+#include <duneuro/eeg/neighbor_seeding.hh>
 #include <duneuro/io/data_tree.hh>
 
 namespace duneuro
@@ -23,6 +30,20 @@ namespace duneuro
     using ProjectedPosition = duneuro::ProjectedElectrode<typename Solver::Traits::GridView>;
   };
 
+  /**
+   * \brief compute the eeg transfer matrix by solving one system per electrode
+   *
+   * If neighbor_seeding.enable is set in the config, the electrodes are processed along a nearest
+   * neighbor path and the initial guess of each solve is computed from the solutions of the
+   * neighbor_seeding.size (default 3) previous electrodes on the path, see NeighborSeeding. With
+   * tbb, the path is split into neighbor_seeding.chains (default: number of threads) parts which
+   * are processed in parallel. Neighbor seeding is not used for block solves.
+   *
+   * If storage.checkpoint is set, each row is written to the file backed storage as soon as it
+   * is finished and a computation which has been interrupted is resumed, see
+   * CheckpointedDenseMatrix. If storage.precision is float32 or int16, the matrix has to be
+   * computed by solveReducedPrecision.
+   */
   template <class S, class RHSFactory>
   class TransferMatrixSolver
   {
@@ -37,6 +58,17 @@ namespace duneuro
     {
     }
 
+    /**
+     * \brief store only the given entries of each row in subsequently computed matrices
+     *
+     * Entry columns[i] of each solution is stored in column i of the transfer matrix. A null
+     * pointer stores all entries.
+     */
+    void setColumnSelection(std::shared_ptr<const std::vector<std::size_t>> columns)
+    {
+      columns_ = columns;
+    }
+
     template <class SolverBackend>
     std::unique_ptr<DenseMatrix<double>>
     solve(SolverBackend& solverBackend,
@@ -44,31 +76,158 @@ namespace duneuro
               projectedElectrodes,
           const Dune::ParameterTree& config, DataTree dataTree = DataTree())
     {
-      auto transferMatrix = std::make_unique<DenseMatrix<double>>(
-          projectedElectrodes.size(), solver_->functionSpace().getGFS().ordering().size());
+      return compute(solverBackend, projectedElectrodes, config, dataTree)->release();
+    }
+
+    /**
+     * \brief compute the transfer matrix in the reduced precision storage.precision
+     *
+     * The rows are converted as soon as they are computed, see ReducedPrecisionDenseMatrix.
+     */
+    template <class SolverBackend>
+    std::unique_ptr<ReducedPrecisionDenseMatrix>
+    solveReducedPrecision(SolverBackend& solverBackend,
+                          const ElectrodeProjectionInterface<
+                              typename Traits::Solver::Traits::GridView>& projectedElectrodes,
+                          const Dune::ParameterTree& config, DataTree dataTree = DataTree())
+    {
+      return compute(solverBackend, projectedElectrodes, config, dataTree)
+          ->releaseReducedPrecision();
+    }
+
+    /**
+     * \brief create the transfer matrix for a sweep which is performed by calling solveRow
+     *
+     * The matrix has one row per electrode, the row of the reference electrode 0 stays zero.
+     */
+    std::unique_ptr<CheckpointedDenseMatrix<double>> makeTransferMatrix(
+        const ElectrodeProjectionInterface<typename Traits::Solver::Traits::GridView>&
+            projectedElectrodes,
+        const Dune::ParameterTree& config, DataTree dataTree) const
+    {
+      auto transferMatrix = std::make_unique<CheckpointedDenseMatrix<double>>(
+          projectedElectrodes.size(), solver_->functionSpace().getGFS().ordering().size(),
+          config.hasSub("storage") ? config.sub("storage") : Dune::ParameterTree(), columns_);
+      dataTree.set("resumed_rows", transferMatrix->resumedRows());
+      return transferMatrix;
+    }
+
+    /**
+     * \brief solve for the given electrode and store the solution in its row
+     *
+     * Rows which have been finished in a previous run are skipped. Allows scheduling the
+     * electrodes together with other right hand sides, see EEGMEGTransferMatrixSolver.
+     */
+    template <class SolverBackend>
+    void solveRow(SolverBackend& solverBackend,
+                  const ElectrodeProjectionInterface<typename Traits::Solver::Traits::GridView>&
+                      projectedElectrodes,
+                  std::size_t index, typename Traits::DomainDOFVector& solution,
+                  typename Traits::RangeDOFVector& rightHandSideVector,
+                  CheckpointedDenseMatrix<double>& transferMatrix,
+                  const Dune::ParameterTree& solverConfig, DataTree dataTree = DataTree()) const
+    {
+      if (transferMatrix.finished(index)) {
+        return;
+      }
+      solve(solverBackend.get(), projectedElectrodes.getProjection(0),
+            projectedElectrodes.getProjection(index), solution, rightHandSideVector, solverConfig,
+            dataTree.sub("solver.electrode_" + std::to_string(index)));
+      transferMatrix.setRow(index, Dune::PDELab::Backend::native(solution));
+    }
+
+  private:
+    template <class SolverBackend>
+    std::unique_ptr<CheckpointedDenseMatrix<double>>
+    compute(SolverBackend& solverBackend,
+            const ElectrodeProjectionInterface<typename Traits::Solver::Traits::GridView>&
+                projectedElectrodes,
+            const Dune::ParameterTree& config, DataTree dataTree)
+    {
+      auto transferMatrix = makeTransferMatrix(projectedElectrodes, config, dataTree);
       auto solver_config = config.sub("solver");
+      const auto blockSize = solver_config.get<std::size_t>("block_size", 1);
+      if (blockSize > 1) {
+        for (std::size_t begin = 1; begin < projectedElectrodes.size(); begin += blockSize) {
+          std::size_t end = std::min(begin + blockSize, projectedElectrodes.size());
+          solveBlock(solverBackend, projectedElectrodes, begin, end, *transferMatrix,
+                     solver_config, dataTree.sub("solver.block_" + std::to_string(begin / blockSize)));
+        }
+        return transferMatrix;
+      }
+      if (config.get<bool>("neighbor_seeding.enable", false)) {
+        auto order = electrodeOrdering(projectedElectrodes);
+        solveChain(solverBackend.get(), projectedElectrodes, order.begin(), order.end(),
+                   *transferMatrix, solver_config,
+                   config.get<std::size_t>("neighbor_seeding.size", 3), dataTree);
+        return transferMatrix;
+      }
       typename Traits::DomainDOFVector solution(solver_->functionSpace().getGFS(), 0.0);
       for (std::size_t index = 1; index < projectedElectrodes.size(); ++index) {
+        if (transferMatrix->finished(index)) {
+          continue;
+        }
         solve(solverBackend.get(), projectedElectrodes.getProjection(0),
               projectedElectrodes.getProjection(index), solution, rightHandSideVector_,
               solver_config, dataTree.sub("solver.electrode_" + std::to_string(index)));
-        set_matrix_row(*transferMatrix, index, Dune::PDELab::Backend::native(solution));
+        transferMatrix->setRow(index, Dune::PDELab::Backend::native(solution));
       }
       return transferMatrix;
     }
 
 #if HAVE_TBB
     template <class SolverBackend>
-    std::unique_ptr<DenseMatrix<double>>
-    solve(tbb::enumerable_thread_specific<SolverBackend>& solverBackend,
-          const ElectrodeProjectionInterface<typename Traits::Solver::Traits::GridView>&
-              projectedElectrodes,
-          const Dune::ParameterTree& config, DataTree dataTree = DataTree())
+    std::unique_ptr<CheckpointedDenseMatrix<double>>
+    compute(tbb::enumerable_thread_specific<SolverBackend>& solverBackend,
+            const ElectrodeProjectionInterface<typename Traits::Solver::Traits::GridView>&
+                projectedElectrodes,
+            const Dune::ParameterTree& config, DataTree dataTree)
     {
-      auto transferMatrix = std::make_unique<DenseMatrix<double>>(projectedElectrodes.size(), solver_->functionSpace().getGFS().ordering().size());
+      auto transferMatrix = makeTransferMatrix(projectedElectrodes, config, dataTree);
       int nr_threads = config.hasKey("numberOfThreads") ? config.get<int>("numberOfThreads") : tbb::task_arena::automatic;
       int grainSize = config.get<int>("grainSize", 16);
       auto solver_config = config.sub("solver");
+      const auto blockSize = solver_config.get<std::size_t>("block_size", 1);
+      if (blockSize > 1) {
+        std::size_t numberOfBlocks = (projectedElectrodes.size() - 1 + blockSize - 1) / blockSize;
+        tbb::task_arena arena(nr_threads);
+        arena.execute([&]{
+          tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, numberOfBlocks, 1),
+            [&](const tbb::blocked_range<std::size_t>& range) {
+              for (std::size_t block = range.begin(); block != range.end(); ++block) {
+                std::size_t begin = 1 + block * blockSize;
+                std::size_t end = std::min(begin + blockSize, projectedElectrodes.size());
+                solveBlock(solverBackend.local(), projectedElectrodes, begin, end, *transferMatrix,
+                           solver_config, dataTree.sub("solver.block_" + std::to_string(block)));
+              }
+            }
+          );
+        });
+        return transferMatrix;
+      }
+      if (config.get<bool>("neighbor_seeding.enable", false)) {
+        auto order = electrodeOrdering(projectedElectrodes);
+        const auto seedingSize = config.get<std::size_t>("neighbor_seeding.size", 3);
+        tbb::task_arena arena(nr_threads);
+        arena.execute([&] {
+          std::size_t chains = config.get<std::size_t>(
+              "neighbor_seeding.chains", tbb::this_task_arena::max_concurrency());
+          chains = std::max<std::size_t>(1, std::min(chains, order.size()));
+          dataTree.set("neighbor_seeding.chains", chains);
+          tbb::parallel_for(
+              tbb::blocked_range<std::size_t>(0, chains, 1),
+              [&](const tbb::blocked_range<std::size_t>& range) {
+                for (std::size_t chain = range.begin(); chain != range.end(); ++chain) {
+                  solveChain(solverBackend.local().get(), projectedElectrodes,
+                             order.begin() + chain * order.size() / chains,
+                             order.begin() + (chain + 1) * order.size() / chains,
+                             *transferMatrix, solver_config, seedingSize, dataTree);
+                }
+              });
+        });
+        return transferMatrix;
+      }
       tbb::enumerable_thread_specific<typename Traits::DomainDOFVector> solution(solver_->functionSpace().getGFS(), 0.0);
       
       tbb::task_arena arena(nr_threads);
@@ -78,11 +237,14 @@ namespace duneuro
           [&](const tbb::blocked_range<std::size_t>& range) {
             auto& mySolution = solution.local();
             for (std::size_t index = range.begin(); index != range.end(); ++index) {
+              if (transferMatrix->finished(index)) {
+                continue;
+              }
               solve(solverBackend.local().get(), projectedElectrodes.getProjection(0),
                     projectedElectrodes.getProjection(index), mySolution,
                     rightHandSideVector_.local(), solver_config,
                     dataTree.sub("solver.electrode_" + std::to_string(index)));
-            set_matrix_row(*transferMatrix, index, Dune::PDELab::Backend::native(mySolution));
+              transferMatrix->setRow(index, Dune::PDELab::Backend::native(mySolution));
             }
           }
         );
@@ -91,7 +253,6 @@ namespace duneuro
     }
 #endif
 
-  private:
     std::shared_ptr<typename Traits::Solver> solver_;
 #if HAVE_TBB
     tbb::enumerable_thread_specific<typename Traits::RangeDOFVector> rightHandSideVector_;
@@ -99,6 +260,126 @@ namespace duneuro
     typename Traits::RangeDOFVector rightHandSideVector_;
 #endif
     Dune::ParameterTree config_;
+    std::shared_ptr<const std::vector<std::size_t>> columns_;
+
+    void assembleRightHandSide(const typename Traits::ProjectedPosition& reference,
+                               const typename Traits::ProjectedPosition& electrode,
+                               typename Traits::RangeDOFVector& rightHandSideVector,
+                               const Dune::ParameterTree& config) const
+    {
+      rightHandSideVector = 0.0;
+      auto rhsAssembler =
+          RHSFactory::template create<typename Traits::RangeDOFVector>(*solver_, config);
+      rhsAssembler->bind(reference.element, reference.localPosition, electrode.element,
+                         electrode.localPosition);
+      rhsAssembler->assembleRightHandSide(rightHandSideVector);
+    }
+
+    // the electrodes except the reference electrode along a nearest neighbor path
+    std::vector<std::size_t> electrodeOrdering(
+        const ElectrodeProjectionInterface<typename Traits::Solver::Traits::GridView>&
+            projectedElectrodes) const
+    {
+      std::vector<typename Traits::Coordinate> positions;
+      for (std::size_t i = 0; i < projectedElectrodes.size(); ++i) {
+        const auto& projection = projectedElectrodes.getProjection(i);
+        positions.push_back(projection.element.geometry().global(projection.localPosition));
+      }
+      return nearest_neighbor_ordering(positions, 1);
+    }
+
+    // solve for the electrodes given by the range [begin, end) of electrode indices one after
+    // another, seeding each solve with the previous solutions of the chain
+    template <class SolverBackend, class It>
+    void solveChain(SolverBackend& solverBackend,
+                    const ElectrodeProjectionInterface<typename Traits::Solver::Traits::GridView>&
+                        projectedElectrodes,
+                    It begin, It end, CheckpointedDenseMatrix<double>& transferMatrix,
+                    const Dune::ParameterTree& config, std::size_t seedingSize,
+                    DataTree dataTree) const
+    {
+      const auto& gfs = solver_->functionSpace().getGFS();
+      typename Traits::DomainDOFVector solution(gfs, 0.0);
+      typename Traits::RangeDOFVector rightHandSideVector(gfs, 0.0);
+      NeighborSeeding<typename Traits::DomainDOFVector, typename Traits::RangeDOFVector> seeding(
+          seedingSize);
+      Dune::ParameterTree seededConfig(config);
+      seededConfig["initialization.type"] = "given";
+      for (It it = begin; it != end; ++it) {
+        const auto index = *it;
+        if (transferMatrix.finished(index)) {
+          continue;
+        }
+        auto electrodeTree = dataTree.sub("solver.electrode_" + std::to_string(index));
+        Dune::Timer timer;
+        assembleRightHandSide(projectedElectrodes.getProjection(0),
+                              projectedElectrodes.getProjection(index), rightHandSideVector,
+                              config);
+        timer.stop();
+        electrodeTree.set("time_rhs_assembly", timer.lastElapsed());
+        timer.start();
+        bool seeded = seeding.initialGuess(rightHandSideVector, solution);
+        timer.stop();
+        electrodeTree.set("seeded", seeded);
+        electrodeTree.set("time_seeding", timer.lastElapsed());
+        timer.start();
+        solver_->solve(solverBackend, rightHandSideVector, solution, seeded ? seededConfig : config,
+                       electrodeTree.sub("linear_system_solver"));
+        timer.stop();
+        electrodeTree.set("time_solution", timer.lastElapsed());
+        seeding.push(solution, rightHandSideVector);
+        transferMatrix.setRow(index, Dune::PDELab::Backend::native(solution));
+        electrodeTree.set("time", timer.elapsed());
+      }
+    }
+
+    // solve for the electrodes [begin, end) at once and store the results in the transfer matrix
+    template <class SolverBackend>
+    void solveBlock(SolverBackend& solverBackend,
+                    const ElectrodeProjectionInterface<typename Traits::Solver::Traits::GridView>&
+                        projectedElectrodes,
+                    std::size_t begin, std::size_t end,
+                    CheckpointedDenseMatrix<double>& transferMatrix,
+                    const Dune::ParameterTree& config, DataTree dataTree = DataTree()) const
+    {
+      if constexpr (HasBlockSolverBackend<SolverBackend>::value) {
+        bool finished = true;
+        for (std::size_t index = begin; index < end; ++index) {
+          finished = finished && transferMatrix.finished(index);
+        }
+        if (finished) {
+          return;
+        }
+        Dune::Timer timer;
+        const auto& gfs = solver_->functionSpace().getGFS();
+        std::vector<typename Traits::RangeDOFVector> rightHandSideVectors(
+            end - begin, typename Traits::RangeDOFVector(gfs, 0.0));
+        std::vector<typename Traits::DomainDOFVector> solutions(
+            end - begin, typename Traits::DomainDOFVector(gfs, 0.0));
+        for (std::size_t index = begin; index < end; ++index) {
+          assembleRightHandSide(projectedElectrodes.getProjection(0),
+                                projectedElectrodes.getProjection(index),
+                                rightHandSideVectors[index - begin], config);
+        }
+        timer.stop();
+        dataTree.set("first_electrode", begin);
+        dataTree.set("last_electrode", end - 1);
+        dataTree.set("time_rhs_assembly", timer.lastElapsed());
+        timer.start();
+        // solve systems
+        solver_->solveBlock(solverBackend.getBlock(), rightHandSideVectors, solutions, config,
+                            dataTree.sub("linear_system_solver"));
+        timer.stop();
+        dataTree.set("time_solution", timer.lastElapsed());
+        for (std::size_t index = begin; index < end; ++index) {
+          transferMatrix.setRow(index, Dune::PDELab::Backend::native(solutions[index - begin]));
+        }
+        dataTree.set("time", timer.elapsed());
+      } else {
+        DUNE_THROW(Dune::NotImplemented,
+                   "the solver backend does not support block solves, use solver.block_size = 1");
+      }
+    }
 
     template <class SolverBackend>
     void solve(SolverBackend& solverBackend, const typename Traits::ProjectedPosition& reference,
@@ -108,13 +389,8 @@ namespace duneuro
                const Dune::ParameterTree& config, DataTree dataTree = DataTree()) const
     {
       Dune::Timer timer;
-      rightHandSideVector = 0.0;
       // assemble right hand side
-      auto rhsAssembler =
-          RHSFactory::template create<typename Traits::RangeDOFVector>(*solver_, config);
-      rhsAssembler->bind(reference.element, reference.localPosition, electrode.element,
-                         electrode.localPosition);
-      rhsAssembler->assembleRightHandSide(rightHandSideVector);
+      assembleRightHandSide(reference, electrode, rightHandSideVector, config);
       timer.stop();
       dataTree.set("time_rhs_assembly", timer.lastElapsed());
       timer.start();
@@ -1,13 +1,20 @@
 #ifndef DUNEURO_TRANSFER_MATRIX_USER_HH
 #define DUNEURO_TRANSFER_MATRIX_USER_HH
 
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <dune/common/parametertree.hh>
 #include <dune/common/timer.hh>
 
 #include <duneuro/common/dipole.hh>
 #include <duneuro/common/flags.hh>
+#include <duneuro/common/low_rank_dense_matrix.hh>
 #include <duneuro/common/make_dof_vector.hh>
 #include <duneuro/common/matrix_utilities.hh>
+#include <duneuro/common/reduced_precision_dense_matrix.hh>
 #include <duneuro/common/sparse_vector_container.hh>
 #include <duneuro/common/vector_density.hh>
 #include <duneuro/io/data_tree.hh>
@@ -34,11 +41,27 @@ namespace duneuro
   public:
     using Traits = TransferMatrixUserTraits<S, SMF>;
 
+    //! entry of a column map for degrees of freedom without a column in the transfer matrix
+    static constexpr std::size_t noColumn = std::size_t(-1);
+
     explicit TransferMatrixUser(std::shared_ptr<const typename Traits::Solver> solver)
         : solver_(solver)
     {
     }
 
+    /**
+     * \brief set the column of the transfer matrix belonging to each flat degree of freedom
+     *
+     * Used if the degrees of freedom have been renumbered while the transfer matrices are stored
+     * in the user visible order, or if the transfer matrices only store the columns of a source
+     * space. Degrees of freedom mapped to noColumn must not be touched by the source model. A
+     * null pointer denotes the identity.
+     */
+    void setColumnMap(std::shared_ptr<const std::vector<std::size_t>> columnOfDOF)
+    {
+      columnOfDOF_ = columnOfDOF;
+    }
+
     void setSourceModel(const Dune::ParameterTree& config, const Dune::ParameterTree& solverConfig,
                         DataTree dataTree = DataTree())
     {
@@ -91,6 +114,40 @@ namespace duneuro
       }
     }
 
+    /**
+     * \brief mark the columns of the transfer matrix used by the source model bound last
+     *
+     * The right hand side of the bound dipole is assembled and used[c] is set for every column c
+     * belonging to a nonzero entry.
+     */
+    void collectColumns(std::vector<char>& used) const
+    {
+      const auto column = columnIndex();
+      if (density_ == VectorDensity::sparse) {
+        typename Traits::SparseRHSVector rhs;
+        sparseSourceModel_->assembleRightHandSide(rhs);
+        for (const auto& entry : rhs) {
+          used[column(entry.first)] = 1;
+        }
+      } else {
+        if (!denseRHSVector_) {
+          denseRHSVector_ = make_range_dof_vector(*solver_, 0.0);
+        } else {
+          *denseRHSVector_ = 0.0;
+        }
+        denseSourceModel_->assembleRightHandSide(*denseRHSVector_);
+        std::size_t k = 0;
+        for (const auto& block : Dune::PDELab::Backend::native(*denseRHSVector_)) {
+          for (const auto& value : block) {
+            if (value != 0.0) {
+              used[mapColumn(k)] = 1;
+            }
+            ++k;
+          }
+        }
+      }
+    }
+
     template <class M>
     std::vector<typename Traits::DomainField> solve(const M& transferMatrix,
                                                     DataTree dataTree = DataTree()) const
@@ -108,24 +165,95 @@ namespace duneuro
       return result;
     }
 
+    /**
+     * \brief bind the source model to the dipoles in [begin, end) and solve for all of them
+     *
+     * The right hand sides of all dipoles are assembled first and then multiplied by the transfer
+     * matrix at once, which loads every matrix entry only once for the whole batch. Sparse right
+     * hand sides are multiplied using matrix_sparse_vectors_product, dense ones are collected in a
+     * panel and multiplied using matrix_dense_panel_product. As the source model is only bound to
+     * a dipole while its right hand side is assembled, post processing has to be performed by the
+     * callback postProcess(i, vector). It is called directly after binding the i-th dipole and has
+     * to add its contribution to the given zero initialized vector, which is then added to the
+     * result.
+     */
+    template <class M, class PostProcess>
+    std::vector<std::vector<typename Traits::DomainField>>
+    solveBatch(const M& transferMatrix, const std::vector<typename Traits::DipoleType>& dipoles,
+               std::size_t begin, std::size_t end, PostProcess&& postProcess,
+               DataTree dataTree = DataTree())
+    {
+      Dune::Timer timer;
+      std::vector<std::vector<typename Traits::DomainField>> result(end - begin);
+      std::vector<std::vector<typename Traits::DomainField>> postProcessed(end - begin);
+      if (density_ == VectorDensity::sparse) {
+        std::vector<CompactSparseVector<typename Traits::DomainField>> rhs(end - begin);
+        typename Traits::SparseRHSVector svc;
+        for (std::size_t i = begin; i < end; ++i) {
+          auto dt = dataTree.sub("dipole_" + std::to_string(i));
+          bind(dipoles[i], dt);
+          dt.set("density", "sparse");
+          svc.clear();
+          sparseSourceModel_->assembleRightHandSide(svc);
+          compact_sparse_vector(svc, columnIndex(), rhs[i - begin]);
+          postProcessed[i - begin].assign(transferMatrix.rows(), 0.0);
+          postProcess(i, postProcessed[i - begin]);
+        }
+        result = matrix_sparse_vectors_product(transferMatrix, rhs);
+      } else {
+        // assemble the right hand sides into a column major panel and multiply it at once
+        const std::size_t cols = transferMatrix.cols();
+        const std::size_t rows = transferMatrix.rows();
+        std::vector<typename Traits::DomainField> panel((end - begin) * cols);
+        if (!denseRHSVector_) {
+          denseRHSVector_ = make_range_dof_vector(*solver_, 0.0);
+        }
+        const auto& rhs = Dune::PDELab::Backend::native(*denseRHSVector_);
+        if (!columnOfDOF_ && rhs.dim() != cols) {
+          DUNE_THROW(Dune::Exception, "transfer matrix has " << cols << " columns, but right hand side has "
+                                                             << rhs.dim() << " entries");
+        }
+        for (std::size_t i = begin; i < end; ++i) {
+          auto dt = dataTree.sub("dipole_" + std::to_string(i));
+          bind(dipoles[i], dt);
+          dt.set("density", "dense");
+          *denseRHSVector_ = 0.0;
+          denseSourceModel_->assembleRightHandSide(*denseRHSVector_);
+          auto column = panel.begin() + (i - begin) * cols;
+          if (columnOfDOF_) {
+            scatterDense(rhs, &*column);
+          } else {
+            for (const auto& block : rhs) {
+              column = std::copy(block.begin(), block.end(), column);
+            }
+          }
+          postProcessed[i - begin].assign(rows, 0.0);
+          postProcess(i, postProcessed[i - begin]);
+        }
+        std::vector<typename Traits::DomainField> product((end - begin) * rows);
+        matrix_dense_panel_product(transferMatrix, panel.data(), end - begin, product.data());
+        for (std::size_t i = begin; i < end; ++i) {
+          auto column = product.begin() + (i - begin) * rows;
+          result[i - begin].assign(column, column + rows);
+        }
+      }
+      for (std::size_t j = 0; j < result.size(); ++j) {
+        for (std::size_t k = 0; k < result[j].size(); ++k) {
+          result[j][k] += postProcessed[j][k];
+        }
+      }
+      auto dt = dataTree.sub("batch_" + std::to_string(begin));
+      dt.set("batch_size", end - begin);
+      dt.set("time", timer.elapsed());
+      return result;
+    }
+
     template <class M>
     std::vector<typename Traits::DomainField> solveSparse(const M& transferMatrix) const
     {
-      using SVC = typename Traits::SparseRHSVector;
-      SVC rhs;
+      typename Traits::SparseRHSVector rhs;
       sparseSourceModel_->assembleRightHandSide(rhs);
-
-      const auto blockSize = Traits::DenseRHSVector::block_type::dimension;
-
-      std::vector<typename Traits::DomainField> output;
-      if (blockSize == 1) {
-        return matrix_sparse_vector_product(transferMatrix, rhs,
-                                            [](const typename SVC::Index& c) { return c[0]; });
-      } else {
-        return matrix_sparse_vector_product(
-            transferMatrix, rhs,
-            [blockSize](const typename SVC::Index& c) { return c[1] * blockSize + c[0]; });
-      }
+      return matrix_sparse_vector_product(transferMatrix, rhs, columnIndex());
     }
 
     template <class M>
@@ -138,12 +266,65 @@ namespace duneuro
       }
       denseSourceModel_->assembleRightHandSide(*denseRHSVector_);
 
-      return matrix_dense_vector_product(transferMatrix,
-                                         Dune::PDELab::Backend::native(*denseRHSVector_));
+      const auto& rhs = Dune::PDELab::Backend::native(*denseRHSVector_);
+      if (!columnOfDOF_) {
+        return matrix_dense_vector_product(transferMatrix, rhs);
+      }
+      std::vector<typename Traits::DomainField> mapped(transferMatrix.cols(), 0.0);
+      scatterDense(rhs, mapped.data());
+      std::vector<typename Traits::DomainField> result(transferMatrix.rows());
+      matrix_dense_panel_product(transferMatrix, mapped.data(), 1, result.data());
+      return result;
     }
 
   private:
+    // index of an entry of the sparse right hand side in the flat dof numbering
+    static std::size_t flatIndex(const typename Traits::SparseRHSVector::Index& c)
+    {
+      const std::size_t blockSize = Traits::DenseRHSVector::block_type::dimension;
+      return blockSize == 1 ? c[0] : c[1] * blockSize + c[0];
+    }
+
+    // column of the transfer matrix belonging to a flat degree of freedom
+    std::size_t mapColumn(std::size_t k) const
+    {
+      if (!columnOfDOF_) {
+        return k;
+      }
+      const auto c = (*columnOfDOF_)[k];
+      if (c == noColumn) {
+        DUNE_THROW(Dune::Exception, "degree of freedom "
+                                        << k << " is not stored in the transfer matrix, the "
+                                                "dipole is not part of the source space");
+      }
+      return c;
+    }
+
+    // index of an entry of the sparse right hand side in the columns of the transfer matrix
+    auto columnIndex() const
+    {
+      return [this](const typename Traits::SparseRHSVector::Index& c) {
+        return mapColumn(flatIndex(c));
+      };
+    }
+
+    // copy the nonzero entries of a dense right hand side to the mapped columns
+    template <class Vector>
+    void scatterDense(const Vector& rhs, typename Traits::DomainField* output) const
+    {
+      std::size_t k = 0;
+      for (const auto& block : rhs) {
+        for (const auto& value : block) {
+          if (value != 0.0) {
+            output[mapColumn(k)] = value;
+          }
+          ++k;
+        }
+      }
+    }
+
     std::shared_ptr<const typename Traits::Solver> solver_;
+    std::shared_ptr<const std::vector<std::size_t>> columnOfDOF_;
     VectorDensity density_;
     std::shared_ptr<SourceModelInterface<typename S::Traits::GridView, typename Traits::DomainField, Traits::dimension,
                                          typename Traits::SparseRHSVector>>
@@ -0,0 +1,117 @@
+#ifndef DUNEURO_TRANSFER_MATRIX_USER_POOL_HH
+#define DUNEURO_TRANSFER_MATRIX_USER_POOL_HH
+
+#if HAVE_TBB
+#include <tbb/enumerable_thread_specific.h>
+#endif
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dune/common/parametertree.hh>
+
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief pool of transfer matrix users with an already created source model
+   *
+   * Creating a source model can be expensive, e.g. the localized subtraction source model sets up
+   * a patch assembler including local function spaces. The pool stores one user per thread and per
+   * source model configuration, so that a sweep over many dipoles only creates the source model
+   * once per thread. As the pool is owned by the driver, the users are also reused by subsequent
+   * sweeps with the same configuration. Each thread keeps the users of at most capacity
+   * configurations, the least recently used one is removed first.
+   *
+   * The user returned by get is only accessed by the calling thread. It must not be used after
+   * clear has been called or after the same thread requested a user for a different
+   * configuration.
+   */
+  template <class User>
+  class TransferMatrixUserPool
+  {
+  public:
+    using Solver = typename User::Traits::Solver;
+
+    /**
+     * \brief create an empty pool
+     *
+     * If columnOfDOF is set, it is passed to every user, see TransferMatrixUser::setColumnMap.
+     */
+    explicit TransferMatrixUserPool(
+        std::shared_ptr<const Solver> solver,
+        std::shared_ptr<const std::vector<std::size_t>> columnOfDOF = nullptr,
+        std::size_t capacity = 4)
+        : solver_(solver), columnOfDOF_(columnOfDOF), capacity_(std::max<std::size_t>(capacity, 1))
+    {
+    }
+
+    //! identifies a source model configuration, compute it once per sweep and pass it to get
+    static std::string makeKey(const Dune::ParameterTree& sourceModelConfig,
+                               const Dune::ParameterTree& solverConfig)
+    {
+      std::stringstream stream;
+      sourceModelConfig.report(stream, "source_model.");
+      solverConfig.report(stream, "solver.");
+      return stream.str();
+    }
+
+    User& get(const std::string& key, const Dune::ParameterTree& sourceModelConfig,
+              const Dune::ParameterTree& solverConfig, DataTree dataTree = DataTree())
+    {
+#if HAVE_TBB
+      auto& users = users_.local();
+#else
+      auto& users = users_;
+#endif
+      auto it = std::find_if(users.begin(), users.end(),
+                             [&](const auto& entry) { return entry.first == key; });
+      if (it != users.end()) {
+        users.splice(users.begin(), users, it);
+        return *(users.front().second);
+      }
+      auto user = std::make_unique<User>(solver_);
+      user->setColumnMap(columnOfDOF_);
+      user->setSourceModel(sourceModelConfig, solverConfig, dataTree);
+      users.emplace_front(key, std::move(user));
+      if (users.size() > capacity_) {
+        users.pop_back();
+      }
+      return *(users.front().second);
+    }
+
+    User& get(const Dune::ParameterTree& sourceModelConfig, const Dune::ParameterTree& solverConfig,
+              DataTree dataTree = DataTree())
+    {
+      return get(makeKey(sourceModelConfig, solverConfig), sourceModelConfig, solverConfig,
+                 dataTree);
+    }
+
+    //! remove all users of all threads. Must not be called concurrently to get
+    void clear()
+    {
+      users_.clear();
+    }
+
+  private:
+    // most recently used first
+    using UserMap = std::list<std::pair<std::string, std::unique_ptr<User>>>;
+
+    std::shared_ptr<const Solver> solver_;
+    std::shared_ptr<const std::vector<std::size_t>> columnOfDOF_;
+    std::size_t capacity_;
+#if HAVE_TBB
+    tbb::enumerable_thread_specific<UserMap> users_;
+#else
+    UserMap users_;
+#endif
+  };
+}
+
+#endif // DUNEURO_TRANSFER_MATRIX_USER_POOL_HH
@@ -83,6 +83,38 @@ namespace duneuro
     }
   };
 
+  template <class T>
+  struct DenseMatrixToHDF5Writer<DenseMatrix<T>> {
+    typedef hdf5wrap::AttributeTraits<T> Traits;
+    static H5::DataSet write(H5::CommonFG& parent, const DenseMatrix<T>& matrix,
+                             const std::string& name = "matrix")
+    {
+      // the hdf5 dataset is stored row wise
+      hsize_t dims[] = {matrix.rows(), matrix.cols()};
+      H5::DataSpace dataSpace(2, dims);
+
+      typename Traits::Type dataType(Traits::constructType(T(0)));
+      dataType.setOrder(H5T_ORDER_LE);
+
+      H5::DataSet dataSet = parent.createDataSet(name, dataType, dataSpace);
+      if (matrix.rowMajor()) {
+        dataSet.write(matrix.data(), Traits::predType);
+      } else {
+        // column major matrices are written row wise as well, so that the file does not
+        // depend on the layout
+        std::vector<T> data;
+        data.reserve(matrix.rows() * matrix.cols());
+        for (std::size_t row = 0; row < matrix.rows(); ++row) {
+          for (std::size_t col = 0; col < matrix.cols(); ++col) {
+            data.push_back(matrix(row, col));
+          }
+        }
+        dataSet.write(data.data(), Traits::predType);
+      }
+      return dataSet;
+    }
+  };
+
 #if HAVE_EIGEN
   template <class T, int Rows, int Cols>
   struct DenseMatrixToHDF5Writer<Eigen::Matrix<T, Rows, Cols>> {
@@ -270,14 +302,9 @@ namespace duneuro
       hsize_t dims[2];
       dataSpace.getSimpleExtentDims(dims, NULL);
 
+      // both the dataset and the dense matrix are stored row wise, read directly into the matrix
       std::unique_ptr<MatrixType> matrix(new MatrixType(dims[0], dims[1]));
-      std::cout << "starting to read dense matrix from HDF" << std::endl;
-      std::vector<T> data(dims[0] * dims[1]);
-      dataSet.read(data.data(), Traits::predType);
-      for (unsigned int r = 0; r < dims[0]; ++r)
-        for (unsigned int c = 0; c < dims[1]; ++c)
-          (*matrix)(r, c) = data[r * dims[1] + c];
-      std::cout << "done reading dense matrix from HDF" << std::endl;
+      dataSet.read(matrix->data(), Traits::predType);
 
       return matrix;
     }
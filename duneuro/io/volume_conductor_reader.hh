@@ -8,6 +8,7 @@
 #include <dune/grid/io/file/gmshreader.hh>
 
 #include <duneuro/common/fitted_driver_data.hh>
+#include <duneuro/common/mesh_renumbering.hh>
 #include <duneuro/common/volume_conductor.hh>
 #include <duneuro/io/cauchy_grid_reader.hh>
 #include <duneuro/io/cauchy_tensor_reader.hh>
@@ -32,18 +33,71 @@ namespace duneuro
       // if the user provided nodes in the data struct, we assume a mesh from the struct should be
       // used. If there are no nodes, read the mesh and tensors from disk.
       auto refinements = config.get<unsigned int>("grid.refinements", 0);
+      // optionally renumber the vertices and elements before creating the grid in order to
+      // obtain a cache friendly ordering of the degrees of freedom
+      auto renumbering = config.get<std::string>("grid.renumbering", "none");
+      // the vertices created by the refinement have no user visible id, so the transfer matrix
+      // columns of a refined mesh could not be mapped back to the user order
+      if (renumbering != "none" && refinements > 0) {
+        DUNE_THROW(Dune::NotImplemented,
+                   "grid.renumbering = " << renumbering << " cannot be combined with "
+                                         << "grid.refinements = " << refinements);
+      }
       if (data.nodes.size() > 0) {
-        return read(data, dataTree, refinements);
+        if (renumbering == "none") {
+          return read(data, dataTree, refinements);
+        }
+        auto renumbered = renumber_mesh(data, renumbering, dataTree.sub("renumbering"));
+        return read(renumbered.data, dataTree, refinements, renumbered.originalVertex);
       } else {
-        return read(config.get<std::string>("grid.filename"),
-                    config.get<std::string>("tensors.filename"), dataTree,
-                    config.get<unsigned int>("tensors.offset", 0), refinements);
+        auto volumeConductor = read(config.get<std::string>("grid.filename"),
+                                    config.get<std::string>("tensors.filename"), dataTree,
+                                    config.get<unsigned int>("tensors.offset", 0), refinements);
+        if (renumbering == "none") {
+          return volumeConductor;
+        }
+        // the index sets of the grid cannot be permuted, so the leaf mesh is extracted and a new
+        // grid is created from the renumbered mesh
+        auto renumbered = renumber_mesh(extractMesh(*volumeConductor), renumbering,
+                                        dataTree.sub("renumbering"));
+        volumeConductor.reset();
+        return read(renumbered.data, dataTree.sub("renumbered"), 0, renumbered.originalVertex);
       }
     }
 
-    static std::shared_ptr<VolumeConductor<G>> read(const FittedDriverData<dim>& data,
-                                                    DataTree dataTree = DataTree(),
-                                                    unsigned int refinements = 0)
+    //! extract the leaf mesh of a volume conductor, with the nodes ordered by their leaf index
+    static FittedDriverData<dim> extractMesh(const VolumeConductor<G>& volumeConductor)
+    {
+      const auto& gv = volumeConductor.gridView();
+      const auto& indexSet = gv.indexSet();
+      FittedDriverData<dim> data;
+      data.nodes.resize(gv.size(dim));
+      for (const auto& vertex : Dune::vertices(gv)) {
+        data.nodes[indexSet.index(vertex)] = vertex.geometry().corner(0);
+      }
+      data.elements.reserve(gv.size(0));
+      data.labels.reserve(gv.size(0));
+      for (const auto& element : Dune::elements(gv)) {
+        std::vector<unsigned int> corners;
+        for (unsigned int i = 0; i < element.subEntities(dim); ++i) {
+          corners.push_back(indexSet.subIndex(element, i, dim));
+        }
+        data.elements.push_back(std::move(corners));
+        data.labels.push_back(volumeConductor.label(element));
+      }
+      data.tensors.assign(volumeConductor.tensors().begin(), volumeConductor.tensors().end());
+      return data;
+    }
+
+    /**
+     * \brief create a volume conductor from mesh data
+     *
+     * If originalVertex is not empty, it contains the user visible id of each node of the given
+     * mesh. Without refinement, these ids are stored in the volume conductor for each leaf vertex.
+     */
+    static std::shared_ptr<VolumeConductor<G>>
+    read(const FittedDriverData<dim>& data, DataTree dataTree = DataTree(),
+         unsigned int refinements = 0, const std::vector<std::size_t>& originalVertex = {})
     {
       Dune::Timer timer;
       Dune::GridFactory<G> factory;
@@ -62,6 +116,19 @@ namespace duneuro
       using Mapper = Dune::SingleCodimSingleGeomTypeMapper<GV, 0>;
       GV gv = grid->leafGridView();
       Mapper mapper(gv);
+      std::vector<std::size_t> vertexIds;
+      if (originalVertex.size() > 0 && refinements == 0) {
+        if (originalVertex.size() != data.nodes.size()) {
+          DUNE_THROW(Dune::Exception, "number of original vertex ids ("
+                                          << originalVertex.size()
+                                          << ") has to match the number of nodes ("
+                                          << data.nodes.size() << ")");
+        }
+        vertexIds.resize(gv.size(dim));
+        for (const auto& vertex : Dune::vertices(gv)) {
+          vertexIds[gv.indexSet().index(vertex)] = originalVertex[factory.insertionIndex(vertex)];
+        }
+      }
       if (data.tensors.size() > 0) {
         std::vector<std::size_t> reordered_labels(gv.size(0));
         if (std::size_t(mapper.size()) != reordered_labels.size()) {
@@ -88,8 +155,10 @@ namespace duneuro
         timer.stop();
         dataTree.set("time_reordering_labels", timer.lastElapsed());
         dataTree.set("time", timer.elapsed());
-        return std::make_shared<VolumeConductor<G>>(std::move(grid), reordered_labels,
-                                                    data.tensors);
+        auto volumeConductor =
+            std::make_shared<VolumeConductor<G>>(std::move(grid), reordered_labels, data.tensors);
+        volumeConductor->setVertexIds(std::move(vertexIds));
+        return volumeConductor;
       } else if (data.labels.size() > 0) {
         std::vector<std::size_t> reordered_labels(gv.size(0));
         if (std::size_t(mapper.size()) != reordered_labels.size()) {
@@ -127,7 +196,10 @@ namespace duneuro
           tensors.push_back(t);
         }
         dataTree.set("time", timer.elapsed());
-        return std::make_shared<VolumeConductor<G>>(std::move(grid), reordered_labels, tensors);
+        auto volumeConductor =
+            std::make_shared<VolumeConductor<G>>(std::move(grid), reordered_labels, tensors);
+        volumeConductor->setVertexIds(std::move(vertexIds));
+        return volumeConductor;
       } else {
         DUNE_THROW(Dune::Exception, "you have to provide labels or tensors");
       }
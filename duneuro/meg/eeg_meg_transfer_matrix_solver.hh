@@ -0,0 +1,181 @@
+#ifndef DUNEURO_EEG_MEG_TRANSFER_MATRIX_SOLVER_HH
+#define DUNEURO_EEG_MEG_TRANSFER_MATRIX_SOLVER_HH
+
+#if HAVE_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <dune/common/parametertree.hh>
+#include <dune/common/timer.hh>
+
+#include <duneuro/common/checkpointed_dense_matrix.hh>
+#include <duneuro/common/dense_matrix.hh>
+#include <duneuro/eeg/electrode_projection_interface.hh>
+#include <duneuro/io/data_tree.hh>
+
+namespace duneuro
+{
+  /**
+   * \brief compute the eeg and the meg transfer matrix in a single sweep
+   *
+   * The rows of both matrices, one per electrode except the reference and one per pair of coil
+   * and projection, are scheduled as one range in a single task arena. Thus the solver backend of
+   * each thread, including its preconditioner, and the solution and right hand side vectors are
+   * shared by both matrices, and no thread idles at the end of the eeg sweep while the meg sweep
+   * has not started yet.
+   *
+   * The storage of the matrices is given by eegConfig.sub("storage") and
+   * megConfig.sub("storage"), including checkpointing. The solver config, numberOfThreads and
+   * grainSize are taken from the common config. Neighbor seeding and block solves are not used.
+   */
+  template <class EEGSolver, class MEGSolver>
+  class EEGMEGTransferMatrixSolver
+  {
+  public:
+    using DomainDOFVector = typename EEGSolver::Traits::DomainDOFVector;
+    using RangeDOFVector = typename EEGSolver::Traits::RangeDOFVector;
+    using GridView = typename EEGSolver::Traits::Solver::Traits::GridView;
+    using TransferMatrices =
+        std::pair<std::unique_ptr<DenseMatrix<double>>, std::unique_ptr<DenseMatrix<double>>>;
+
+    EEGMEGTransferMatrixSolver(const EEGSolver& eegSolver, const MEGSolver& megSolver)
+        : eegSolver_(eegSolver), megSolver_(megSolver)
+    {
+    }
+
+    //! compute the eeg (first) and the meg (second) transfer matrix
+    template <class SolverBackend>
+    TransferMatrices solve(SolverBackend& solverBackend,
+                           const ElectrodeProjectionInterface<GridView>& projectedElectrodes,
+                           const Dune::ParameterTree& eegConfig,
+                           const Dune::ParameterTree& megConfig, const Dune::ParameterTree& config,
+                           DataTree dataTree = DataTree()) const
+    {
+      Dune::Timer timer;
+      Sweep sweep(*this, projectedElectrodes, eegConfig, megConfig, config, dataTree);
+      DomainDOFVector solution(megSolver_.functionSpace().getGFS(), 0.0);
+      RangeDOFVector rightHandSideVector(megSolver_.functionSpace().getGFS(), 0.0);
+      for (std::size_t task = 0; task < sweep.size(); ++task) {
+        sweep.solve(solverBackend, task, solution, rightHandSideVector);
+      }
+      return sweep.release(timer.elapsed());
+    }
+
+#if HAVE_TBB
+    template <class SolverBackend>
+    TransferMatrices solve(tbb::enumerable_thread_specific<SolverBackend>& solverBackend,
+                           const ElectrodeProjectionInterface<GridView>& projectedElectrodes,
+                           const Dune::ParameterTree& eegConfig,
+                           const Dune::ParameterTree& megConfig, const Dune::ParameterTree& config,
+                           DataTree dataTree = DataTree()) const
+    {
+      Dune::Timer timer;
+      Sweep sweep(*this, projectedElectrodes, eegConfig, megConfig, config, dataTree);
+      int nr_threads = config.hasKey("numberOfThreads") ? config.get<int>("numberOfThreads")
+                                                        : tbb::task_arena::automatic;
+      int grainSize = config.get<int>("grainSize", 16);
+      const auto& gfs = megSolver_.functionSpace().getGFS();
+      tbb::enumerable_thread_specific<DomainDOFVector> solution(gfs, 0.0);
+      tbb::enumerable_thread_specific<RangeDOFVector> rightHandSideVector(gfs, 0.0);
+      tbb::task_arena arena(nr_threads);
+      arena.execute([&] {
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, sweep.size(), grainSize),
+                          [&](const tbb::blocked_range<std::size_t>& range) {
+                            auto& backend = solverBackend.local();
+                            auto& mySolution = solution.local();
+                            auto& myRightHandSideVector = rightHandSideVector.local();
+                            for (std::size_t task = range.begin(); task != range.end(); ++task) {
+                              sweep.solve(backend, task, mySolution, myRightHandSideVector);
+                            }
+                          });
+      });
+      return sweep.release(timer.elapsed());
+    }
+#endif
+
+  private:
+    const EEGSolver& eegSolver_;
+    const MEGSolver& megSolver_;
+
+    /**
+     * \brief the matrices and rows of one sweep
+     *
+     * Task i < number of electrodes - 1 computes the row of electrode i + 1, the following tasks
+     * compute the meg rows in the order of the coils.
+     */
+    class Sweep
+    {
+    public:
+      Sweep(const EEGMEGTransferMatrixSolver& parent,
+            const ElectrodeProjectionInterface<GridView>& projectedElectrodes,
+            const Dune::ParameterTree& eegConfig, const Dune::ParameterTree& megConfig,
+            const Dune::ParameterTree& config, DataTree dataTree)
+          : parent_(parent)
+          , projectedElectrodes_(projectedElectrodes)
+          , offsets_(parent.megSolver_.computeOffsets())
+          , eegMatrix_(parent.eegSolver_.makeTransferMatrix(projectedElectrodes, eegConfig,
+                                                            dataTree.sub("eeg")))
+          , megMatrix_(parent.megSolver_.makeTransferMatrix(offsets_.back(), megConfig,
+                                                            dataTree.sub("meg")))
+          , solverConfig_(config.sub("solver"))
+          , dataTree_(dataTree)
+      {
+        dataTree_.set("eeg.rows", eegRows());
+        dataTree_.set("meg.rows", offsets_.back());
+      }
+
+      std::size_t size() const
+      {
+        return eegRows() + offsets_.back();
+      }
+
+      template <class SolverBackend>
+      void solve(SolverBackend& solverBackend, std::size_t task, DomainDOFVector& solution,
+                 RangeDOFVector& rightHandSideVector) const
+      {
+        if (task < eegRows()) {
+          parent_.eegSolver_.solveRow(solverBackend, projectedElectrodes_, task + 1, solution,
+                                      rightHandSideVector, *eegMatrix_, solverConfig_,
+                                      dataTree_.sub("eeg"));
+          return;
+        }
+        const std::size_t row = task - eegRows();
+        const std::size_t coil =
+            std::upper_bound(offsets_.begin(), offsets_.end(), row) - offsets_.begin() - 1;
+        parent_.megSolver_.solveRow(solverBackend, offsets_, coil, row - offsets_[coil],
+                                    solution, rightHandSideVector, *megMatrix_, solverConfig_,
+                                    dataTree_.sub("meg"));
+      }
+
+      TransferMatrices release(double time)
+      {
+        dataTree_.set("time", time);
+        return {eegMatrix_->release(), megMatrix_->release()};
+      }
+
+    private:
+      const EEGMEGTransferMatrixSolver& parent_;
+      const ElectrodeProjectionInterface<GridView>& projectedElectrodes_;
+      std::vector<std::size_t> offsets_;
+      std::unique_ptr<CheckpointedDenseMatrix<double>> eegMatrix_;
+      std::unique_ptr<CheckpointedDenseMatrix<double>> megMatrix_;
+      Dune::ParameterTree solverConfig_;
+      mutable DataTree dataTree_;
+
+      std::size_t eegRows() const
+      {
+        return projectedElectrodes_.size() > 0 ? projectedElectrodes_.size() - 1 : 0;
+      }
+    };
+  };
+}
+
+#endif // DUNEURO_EEG_MEG_TRANSFER_MATRIX_SOLVER_HH
@@ -2,12 +2,15 @@
 #define DUNEURO_FITTED_MEG_TRANSFER_MATRIX_SOLVER_HH
 
 #include <memory>
+#include <vector>
 
 #include <dune/common/parametertree.hh>
 #include <dune/common/timer.hh>
 
+#include <duneuro/common/checkpointed_dense_matrix.hh>
 #include <duneuro/common/flags.hh>
 #include <duneuro/common/make_dof_vector.hh>
+#include <duneuro/common/reduced_precision_dense_matrix.hh>
 #include <duneuro/eeg/projection_utilities.hh>
 #include <duneuro/io/data_tree.hh>
 #include <duneuro/meg/meg_solver.hh>
@@ -42,26 +45,108 @@ namespace duneuro
     {
     }
 
+    /**
+     * \brief store only the given entries of each row in subsequently computed matrices
+     *
+     * Entry columns[i] of each solution is stored in column i of the transfer matrix. A null
+     * pointer stores all entries.
+     */
+    void setColumnSelection(std::shared_ptr<const std::vector<std::size_t>> columns)
+    {
+      columns_ = columns;
+    }
+
     template <class SolverBackend>
     std::unique_ptr<DenseMatrix<double>> solve(SolverBackend& solverBackend,
                                                const Dune::ParameterTree& config,
                                                DataTree dataTree = DataTree())
     {
-      auto offsets = computeOffsets();
-      std::size_t numberOfProjections = offsets.back();
+      return compute(solverBackend, config, dataTree)->release();
+    }
+
+    //! compute the transfer matrix in the reduced precision storage.precision
+    template <class SolverBackend>
+    std::unique_ptr<ReducedPrecisionDenseMatrix>
+    solveReducedPrecision(SolverBackend& solverBackend, const Dune::ParameterTree& config,
+                          DataTree dataTree = DataTree())
+    {
+      return compute(solverBackend, config, dataTree)->releaseReducedPrecision();
+    }
+
+    const typename Traits::FunctionSpace& functionSpace() const
+    {
+      return solver_->functionSpace();
+    }
+
+    /**
+     * \brief create the transfer matrix for a sweep which is performed by calling solveRow
+     *
+     * The matrix has one row per pair of coil and projection. The rows of coil i start at
+     * computeOffsets()[i].
+     */
+    std::unique_ptr<CheckpointedDenseMatrix<double>>
+    makeTransferMatrix(std::size_t numberOfProjections, const Dune::ParameterTree& config,
+                       DataTree dataTree) const
+    {
+      auto transferMatrix = std::make_unique<CheckpointedDenseMatrix<double>>(
+          numberOfProjections, solver_->functionSpace().getGFS().ordering().size(),
+          config.hasSub("storage") ? config.sub("storage") : Dune::ParameterTree(), columns_);
+      dataTree.set("resumed_rows", transferMatrix->resumedRows());
+      return transferMatrix;
+    }
+
+    //! first row of each coil, followed by the total number of rows
+    std::vector<std::size_t> computeOffsets() const
+    {
+      std::vector<std::size_t> offsets(megSolver_->numberOfCoils() + 1, 0);
+      for (unsigned int i = 0; i < megSolver_->numberOfCoils(); ++i)
+        offsets[i + 1] = offsets[i] + megSolver_->numberOfProjections(i);
+      return offsets;
+    }
 
-      auto transferMatrix = std::make_unique<DenseMatrix<double>>(
-          numberOfProjections, solver_->functionSpace().getGFS().ordering().size());
+    /**
+     * \brief solve for the given coil and projection and store the solution in its row
+     *
+     * Rows which have been finished in a previous run are skipped. Allows scheduling the coils
+     * together with other right hand sides, see EEGMEGTransferMatrixSolver.
+     */
+    template <class SolverBackend>
+    void solveRow(SolverBackend& solverBackend, const std::vector<std::size_t>& offsets,
+                  std::size_t coil, std::size_t projection,
+                  typename Traits::DomainDOFVector& solution,
+                  typename Traits::RangeDOFVector& rightHandSideVector,
+                  CheckpointedDenseMatrix<double>& transferMatrix,
+                  const Dune::ParameterTree& solverConfig, DataTree dataTree = DataTree()) const
+    {
+      const std::size_t row = offsets[coil] + projection;
+      if (transferMatrix.finished(row)) {
+        return;
+      }
+      solve(solverBackend.get(), coil, projection, solution, rightHandSideVector, solverConfig,
+            dataTree.sub("solver.coil_" + std::to_string(coil))
+                .sub("projection_" + std::to_string(projection)));
+      transferMatrix.setRow(row, Dune::PDELab::Backend::native(solution));
+    }
+
+  private:
+    template <class SolverBackend>
+    std::unique_ptr<CheckpointedDenseMatrix<double>>
+    compute(SolverBackend& solverBackend, const Dune::ParameterTree& config, DataTree dataTree)
+    {
+      auto offsets = computeOffsets();
+      auto transferMatrix = makeTransferMatrix(offsets.back(), config, dataTree);
 
       auto solver_config = config.sub("solver");
       typename Traits::DomainDOFVector solution(solver_->functionSpace().getGFS(), 0.0);
       for (std::size_t index = 0; index < megSolver_->numberOfCoils(); ++index) {
         auto coilDT = dataTree.sub("solver.coil_" + std::to_string(index));
         for (unsigned int j = 0; j < megSolver_->numberOfProjections(index); ++j) {
+          if (transferMatrix->finished(offsets[index] + j)) {
+            continue;
+          }
           solve(solverBackend.get(), index, j, solution, rightHandSideVector_, solver_config,
                 coilDT.sub("projection_" + std::to_string(j)));
-          set_matrix_row(*transferMatrix, offsets[index] + j,
-                         Dune::PDELab::Backend::native(solution));
+          transferMatrix->setRow(offsets[index] + j, Dune::PDELab::Backend::native(solution));
         }
       }
       return transferMatrix;
@@ -69,14 +154,12 @@ namespace duneuro
 
 #if HAVE_TBB
     template <class SolverBackend>
-    std::unique_ptr<DenseMatrix<double>>
-    solve(tbb::enumerable_thread_specific<SolverBackend>& solverBackend,
-          const Dune::ParameterTree& config, DataTree dataTree = DataTree())
+    std::unique_ptr<CheckpointedDenseMatrix<double>>
+    compute(tbb::enumerable_thread_specific<SolverBackend>& solverBackend,
+            const Dune::ParameterTree& config, DataTree dataTree)
     {
       auto offsets = computeOffsets();
-      std::size_t numberOfProjections = offsets.back();
-
-      auto transferMatrix = std::make_unique<DenseMatrix<double>>(numberOfProjections, solver_->functionSpace().getGFS().ordering().size());
+      auto transferMatrix = makeTransferMatrix(offsets.back(), config, dataTree);
       int nr_threads = config.hasKey("numberOfThreads") ? config.get<int>("numberOfThreads") : tbb::task_arena::automatic;
       int grainSize = config.get<int>("grainSize", 16);
       auto solver_config = config.sub("solver");
@@ -92,42 +175,23 @@ namespace duneuro
             for (std::size_t index = range.begin(); index != range.end(); ++index) {
               auto coilDT = dataTree.sub("solver.coil_" + std::to_string(index));
               for (unsigned int j = 0; j < megSolver_->numberOfProjections(index); ++j) {
+                if (transferMatrix->finished(offsets[index] + j)) {
+                  continue;
+                }
                 solve(solverBackend.local().get(), index, j, mySolution,
                       rightHandSideVector_.local(), solver_config,
                       coilDT.sub("projection_" + std::to_string(j)));
-                set_matrix_row(*transferMatrix, offsets[index] + j, Dune::PDELab::Backend::native(mySolution));
+                transferMatrix->setRow(offsets[index] + j, Dune::PDELab::Backend::native(mySolution));
               }
             }
           }
         );
       });
-      
-      tbb::parallel_for(tbb::blocked_range<std::size_t>(0, megSolver_->numberOfCoils(), grainSize),
-                        [&](const tbb::blocked_range<std::size_t>& range) {
-                          auto& mySolution = solution.local();
-                          for (std::size_t index = range.begin(); index != range.end(); ++index) {
-                            auto coilDT = dataTree.sub("solver.coil_" + std::to_string(index));
-                            for (unsigned int j = 0; j < megSolver_->numberOfProjections(index);
-                                 ++j) {
-                              solve(solverBackend.local().get(), index, j, mySolution,
-                                    rightHandSideVector_.local(), solver_config,
-                                    coilDT.sub("projection_" + std::to_string(j)));
-                              set_matrix_row(*transferMatrix, offsets[index] + j,
-                                             Dune::PDELab::Backend::native(mySolution));
-                            }
-                          }
-                        });
 
       return transferMatrix;
     }
 #endif
 
-    const typename Traits::FunctionSpace& functionSpace() const
-    {
-      return solver_->functionSpace();
-    }
-
-  private:
     std::shared_ptr<typename Traits::VolumeConductor> volumeConductor_;
     std::shared_ptr<typename Traits::Solver> solver_;
     std::shared_ptr<MEGSolverInterface<typename Traits::VolumeConductor,
@@ -138,6 +202,7 @@ namespace duneuro
 #else
     typename Traits::RangeDOFVector rightHandSideVector_;
 #endif
+    std::shared_ptr<const std::vector<std::size_t>> columns_;
 
     template <class V>
     friend struct MakeDOFVectorHelper;
@@ -163,14 +228,6 @@ namespace duneuro
       dataTree.set("time_solution", timer.lastElapsed());
       dataTree.set("time", timer.elapsed());
     }
-
-    std::vector<std::size_t> computeOffsets() const
-    {
-      std::vector<std::size_t> offsets(megSolver_->numberOfCoils() + 1, 0);
-      for (unsigned int i = 0; i < megSolver_->numberOfCoils(); ++i)
-        offsets[i + 1] = offsets[i] + megSolver_->numberOfProjections(i);
-      return offsets;
-    }
   };
 }
 #endif // DUNEURO_FITTED_MEG_TRANSFER_MATRIX_SOLVER_HH
@@ -0,0 +1,173 @@
+#include <config.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/grid/common/gridfactory.hh>
+#include <dune/grid/uggrid.hh>
+
+#include <duneuro/common/block_cg_solver_backend.hh>
+#include <duneuro/common/cg_solver.hh>
+#include <duneuro/common/shared_amg_backend.hh>
+#include <duneuro/common/volume_conductor.hh>
+
+using Grid = Dune::UGGrid<3>;
+using VC = duneuro::VolumeConductor<Grid>;
+using Coordinate = Dune::FieldVector<double, 3>;
+using Traits = duneuro::CGSolverTraits<VC, duneuro::ElementType::tetrahedron, 1>;
+using GO = Traits::Assembler::GO;
+
+/**
+ * volume conductor on a grid of n^3 cubes of the unit cube, each cube split into 6 tetrahedra.
+ * The two conductivities are assigned alternately to the elements.
+ */
+std::shared_ptr<VC> create_volume_conductor(unsigned int n)
+{
+  auto vertex = [n](unsigned int i, unsigned int j, unsigned int k) {
+    return (k * (n + 1) + j) * (n + 1) + i;
+  };
+  std::vector<Coordinate> vertices;
+  for (unsigned int k = 0; k <= n; ++k) {
+    for (unsigned int j = 0; j <= n; ++j) {
+      for (unsigned int i = 0; i <= n; ++i) {
+        vertices.push_back(Coordinate({double(i) / n, double(j) / n, double(k) / n}));
+      }
+    }
+  }
+  Dune::GridFactory<Grid> factory;
+  for (const auto& x : vertices) {
+    factory.insertVertex(x);
+  }
+  // the 6 tetrahedra along the paths from corner 0 to corner 7 of a cube
+  const std::array<std::array<unsigned int, 3>, 6> axes = {
+      {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}}};
+  for (unsigned int k = 0; k < n; ++k) {
+    for (unsigned int j = 0; j < n; ++j) {
+      for (unsigned int i = 0; i < n; ++i) {
+        for (const auto& path : axes) {
+          std::array<unsigned int, 3> corner = {i, j, k};
+          std::vector<unsigned int> element = {vertex(i, j, k)};
+          for (auto axis : path) {
+            ++corner[axis];
+            element.push_back(vertex(corner[0], corner[1], corner[2]));
+          }
+          // orient positively
+          Dune::FieldMatrix<double, 3, 3> jacobian;
+          for (unsigned int c = 0; c < 3; ++c) {
+            jacobian[c] = vertices[element[c + 1]];
+            jacobian[c] -= vertices[element[0]];
+          }
+          if (jacobian.determinant() < 0) {
+            std::swap(element[2], element[3]);
+          }
+          factory.insertElement(Dune::GeometryTypes::tetrahedron, element);
+        }
+      }
+    }
+  }
+  std::unique_ptr<Grid> grid(factory.createGrid());
+  std::vector<VC::TensorType> tensors(2);
+  for (unsigned int t = 0; t < 2; ++t) {
+    tensors[t] = 0.0;
+    for (unsigned int r = 0; r < 3; ++r) {
+      tensors[t][r][r] = t == 0 ? 1.0 : 0.1;
+    }
+  }
+  std::vector<std::size_t> labels(grid->leafGridView().size(0));
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    labels[i] = i % 2;
+  }
+  return std::make_shared<VC>(std::move(grid), labels, tensors);
+}
+
+/**
+ * test if solving several right hand sides at once yields the solutions of the single right hand
+ * side backend used for the individual electrodes. The matrix is made regular by adding to its
+ * first diagonal entry, so that both solutions are unique.
+ */
+bool matches_single_solves(const GO& go, std::size_t blockSize, bool mixedPrecision)
+{
+  using Dune::PDELab::Backend::native;
+  const double reduction = 1e-12;
+  typename GO::Traits::Domain zero(go.trialGridFunctionSpace(), 0.0);
+  typename GO::Traits::Jacobian matrix(go);
+  matrix = 0.0;
+  go.jacobian(zero, matrix);
+  native(matrix)[0][0] += native(matrix)[0][0];
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::vector<typename GO::Traits::Range> rightHandSides;
+  for (std::size_t j = 0; j < blockSize; ++j) {
+    rightHandSides.emplace_back(go.testGridFunctionSpace(), 0.0);
+    for (auto& value : native(rightHandSides.back())) {
+      value = uniform(generator);
+    }
+  }
+
+  duneuro::ISTLBackend_SEQ_BlockCG_AMG_SSOR<GO> blockBackend;
+  blockBackend.setMixedPrecision(mixedPrecision);
+  std::vector<typename GO::Traits::Domain> solutions(blockSize, zero);
+  // the backends may overwrite the right hand sides by the residuals
+  auto blockRightHandSides = rightHandSides;
+  blockBackend.apply(matrix, solutions, blockRightHandSides, reduction);
+  const std::string name = "block size " + std::to_string(blockSize)
+                           + (mixedPrecision ? ", mixed precision" : "");
+  if (!blockBackend.result().converged) {
+    std::cout << name << ": block cg did not converge" << std::endl;
+    return false;
+  }
+
+  std::unique_ptr<duneuro::CGLinearSolverBackend<GO>> singleBackend;
+  if (mixedPrecision) {
+    singleBackend = std::make_unique<duneuro::ISTLBackend_SEQ_CG_MixedPrecisionAMG<GO>>();
+  } else {
+    singleBackend = std::make_unique<duneuro::ISTLBackend_SEQ_CG_SharedAMG_SSOR<GO>>();
+  }
+  for (std::size_t j = 0; j < blockSize; ++j) {
+    auto solution = zero;
+    auto rightHandSide = rightHandSides[j];
+    singleBackend->apply(matrix, solution, rightHandSide, reduction);
+    const auto& x = native(solution);
+    const auto& y = native(solutions[j]);
+    double maxValue = 0.0;
+    double maxDifference = 0.0;
+    for (std::size_t i = 0; i < x.N(); ++i) {
+      maxValue = std::max(maxValue, std::abs(double(x[i])));
+      maxDifference = std::max(maxDifference, std::abs(double(x[i] - y[i])));
+    }
+    // both solutions are only accurate up to the reduction, scaled by the condition number
+    if (maxDifference > 1e-6 * maxValue) {
+      std::cout << name << ": column " << j << " differs by " << maxDifference
+                << " from the single solve, maximum " << maxValue << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  Dune::MPIHelper::instance(argc, argv);
+
+  auto volumeConductor = create_volume_conductor(12);
+  Traits::Problem problem(volumeConductor);
+  Traits::BoundaryCondition boundaryCondition(volumeConductor->gridView(), problem);
+  Traits::FunctionSpace functionSpace(volumeConductor->grid(), boundaryCondition);
+  Traits::LocalOperator localOperator(problem, 0);
+  Traits::Assembler assembler(functionSpace, localOperator, 27);
+
+  bool passed = true;
+  for (bool mixedPrecision : {false, true}) {
+    passed &= matches_single_solves(assembler.getGO(), 1, mixedPrecision);
+    passed &= matches_single_solves(assembler.getGO(), 5, mixedPrecision);
+  }
+  return !passed;
+}
@@ -0,0 +1,56 @@
+#include <config.h>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/grid/utility/structuredgridfactory.hh>
+#include <dune/grid/yaspgrid.hh>
+
+#include <duneuro/common/kdtree.hh>
+
+/**
+ * test if the kd-tree finds the element center closest to a point, by comparing its distance to
+ * the one found by a linear search over all elements
+ */
+template <class GV>
+bool finds_nearest_center(const GV& gridView, unsigned int numberOfPoints)
+{
+  using Coordinate = Dune::FieldVector<typename GV::ctype, GV::dimension>;
+  duneuro::KDTree<GV> tree(gridView);
+  std::mt19937 generator(42);
+  // include points outside of the domain
+  std::uniform_real_distribution<double> distribution(-0.2, 1.2);
+  for (unsigned int i = 0; i < numberOfPoints; ++i) {
+    Coordinate x;
+    for (unsigned int d = 0; d < GV::dimension; ++d) {
+      x[d] = distribution(generator);
+    }
+    double bruteForce = std::numeric_limits<double>::max();
+    for (const auto& element : elements(gridView)) {
+      bruteForce = std::min(bruteForce, (element.geometry().center() - x).two_norm());
+    }
+    const auto found = gridView.grid().entity(tree.find(x));
+    const double distance = (found.geometry().center() - x).two_norm();
+    if (distance > bruteForce + 1e-12) {
+      std::cout << "kd-tree found a center at distance " << distance << " from " << x
+                << ", the closest center has distance " << bruteForce << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  Dune::MPIHelper::instance(argc, argv);
+
+  using Grid = Dune::YaspGrid<3>;
+  // an uneven number of cells per direction, so that the medians are not aligned with the cells
+  auto grid = Dune::StructuredGridFactory<Grid>::createCubeGrid({0, 0, 0}, {1, 1, 1}, {9, 7, 5});
+  bool passed = true;
+  passed &= finds_nearest_center(grid->leafGridView(), 1000);
+  return !passed;
+}
@@ -0,0 +1,159 @@
+#include <config.h>
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/parametertree.hh>
+
+#include <duneuro/common/dense_matrix.hh>
+#include <duneuro/common/low_rank_dense_matrix.hh>
+#include <duneuro/io/data_tree.hh>
+
+// keeps the values stored in a data tree, so that the reported values can be checked
+class MapStorage : public duneuro::StorageInterface
+{
+public:
+  virtual void store(const std::string& name, const std::string& value) override
+  {
+    values[name] = value;
+  }
+
+  virtual void storeMatrix(const std::string& name,
+                           std::shared_ptr<duneuro::MatrixInterface<double>> matrix) override
+  {
+  }
+
+  virtual void storeMatrix(const std::string& name,
+                           std::shared_ptr<duneuro::MatrixInterface<unsigned int>> matrix) override
+  {
+  }
+
+  std::map<std::string, std::string> values;
+};
+
+/**
+ * sum of rank random outer products with weights 0.5^k plus gaussian noise of the given standard
+ * deviation, i.e. a matrix of the given rank if noise is zero
+ */
+duneuro::DenseMatrix<double> create_matrix(std::size_t rows, std::size_t cols, std::size_t rank,
+                                           double noise, duneuro::DenseMatrixLayout layout)
+{
+  std::mt19937 generator(42);
+  std::normal_distribution<double> normal;
+  std::vector<double> x(rank * rows), y(rank * cols);
+  for (auto& value : x) {
+    value = normal(generator);
+  }
+  for (auto& value : y) {
+    value = normal(generator);
+  }
+  duneuro::DenseMatrix<double> result(rows, cols, 0.0, layout);
+  for (std::size_t r = 0; r < rows; ++r) {
+    for (std::size_t c = 0; c < cols; ++c) {
+      double sum = noise * normal(generator);
+      for (std::size_t k = 0; k < rank; ++k) {
+        sum += std::pow(0.5, k) * x[k * rows + r] * y[k * cols + c];
+      }
+      result(r, c) = sum;
+    }
+  }
+  return result;
+}
+
+/**
+ * test if the reported relative error of the approximation is |A - U V|_F / |A|_F, if it reaches
+ * the tolerance and if U has orthonormal columns. If initialRank is below the rank of the matrix,
+ * the sample has to be extended.
+ */
+bool approximates(duneuro::DenseMatrixLayout layout, std::size_t rank, double noise,
+                  double tolerance, std::size_t initialRank)
+{
+  const std::size_t rows = 60;
+  const std::size_t cols = 500;
+  const auto a = create_matrix(rows, cols, rank, noise, layout);
+  Dune::ParameterTree config;
+  config["tolerance"] = std::to_string(tolerance);
+  config["initial_rank"] = std::to_string(initialRank);
+  config["oversampling"] = "2";
+  // several blocks, the last one incomplete
+  config["block_size"] = "97";
+  auto storage = std::make_shared<MapStorage>();
+  auto approximation = duneuro::make_low_rank_approximation(a, config, duneuro::DataTree(storage));
+  const std::string name =
+      std::string(layout == duneuro::DenseMatrixLayout::rowMajor ? "row" : "column")
+      + " major, rank " + std::to_string(rank) + ", noise " + std::to_string(noise);
+
+  double errorSquared = 0.0;
+  double normSquared = 0.0;
+  for (std::size_t r = 0; r < rows; ++r) {
+    for (std::size_t c = 0; c < cols; ++c) {
+      const double difference = a(r, c) - (*approximation)(r, c);
+      errorSquared += difference * difference;
+      normSquared += a(r, c) * a(r, c);
+    }
+  }
+  const double error = std::sqrt(errorSquared / normSquared);
+  const double reported = std::stod(storage->values.at("relative_error"));
+  // the reported error is computed from |A|^2 - |U^T A|^2, which cancels below sqrt(eps)
+  if (std::abs(reported - error) > 1e-5 * error + 1e-7) {
+    std::cout << name << ": reported relative_error " << reported << ", actual " << error
+              << std::endl;
+    return false;
+  }
+  if (error > tolerance) {
+    std::cout << name << ": relative error " << error << " exceeds " << tolerance << std::endl;
+    return false;
+  }
+  if (noise == 0.0 && approximation->rank() > rank) {
+    std::cout << name << ": rank " << approximation->rank() << " of a matrix of rank " << rank
+              << std::endl;
+    return false;
+  }
+  if (std::stoul(storage->values.at("rank")) != approximation->rank()) {
+    std::cout << name << ": reported rank " << storage->values.at("rank") << ", actual "
+              << approximation->rank() << std::endl;
+    return false;
+  }
+  if (initialRank < rank && std::stoul(storage->values.at("sample_size")) <= initialRank + 2) {
+    std::cout << name << ": the sample has not been extended" << std::endl;
+    return false;
+  }
+  const auto& u = approximation->u();
+  for (std::size_t i = 0; i < u.cols(); ++i) {
+    for (std::size_t j = 0; j < u.cols(); ++j) {
+      double dot = 0.0;
+      for (std::size_t r = 0; r < rows; ++r) {
+        dot += u(r, i) * u(r, j);
+      }
+      if (std::abs(dot - (i == j ? 1.0 : 0.0)) > 1e-12) {
+        std::cout << name << ": columns " << i << " and " << j << " of U have product " << dot
+                  << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  Dune::MPIHelper::instance(argc, argv);
+
+  bool passed = true;
+  for (auto layout :
+       {duneuro::DenseMatrixLayout::rowMajor, duneuro::DenseMatrixLayout::columnMajor}) {
+    // exact rank, reached by the initial sample and after extending it twice
+    passed &= approximates(layout, 8, 0.0, 1e-6, 16);
+    passed &= approximates(layout, 8, 0.0, 1e-6, 2);
+    // noisy matrix, whose error is well above the cancellation of the reported error
+    passed &= approximates(layout, 12, 1e-3, 1e-2, 2);
+    passed &= approximates(layout, 12, 1e-3, 1e-3, 2);
+  }
+  return !passed;
+}
@@ -0,0 +1,155 @@
+#include <config.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/grid/common/gridfactory.hh>
+#include <dune/grid/uggrid.hh>
+
+#include <duneuro/common/cg_solver.hh>
+#include <duneuro/common/p1_tetrahedron_stiffness_assembler.hh>
+#include <duneuro/common/volume_conductor.hh>
+
+using Grid = Dune::UGGrid<3>;
+using VC = duneuro::VolumeConductor<Grid>;
+using Coordinate = Dune::FieldVector<double, 3>;
+
+/**
+ * create a tetrahedral mesh of the unit cube with n^3 cubes split into 6 tetrahedra each. The
+ * interior vertices are moved randomly, so that the element jacobians are not symmetric.
+ */
+std::unique_ptr<Grid> create_distorted_grid(unsigned int n)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(-0.15 / n, 0.15 / n);
+  std::vector<Coordinate> vertices;
+  for (unsigned int k = 0; k <= n; ++k) {
+    for (unsigned int j = 0; j <= n; ++j) {
+      for (unsigned int i = 0; i <= n; ++i) {
+        Coordinate x = {double(i) / n, double(j) / n, double(k) / n};
+        if (i > 0 && i < n && j > 0 && j < n && k > 0 && k < n) {
+          for (auto& c : x) {
+            c += distribution(generator);
+          }
+        }
+        vertices.push_back(x);
+      }
+    }
+  }
+  Dune::GridFactory<Grid> factory;
+  for (const auto& x : vertices) {
+    factory.insertVertex(x);
+  }
+  auto vertex = [n](unsigned int i, unsigned int j, unsigned int k) {
+    return (k * (n + 1) + j) * (n + 1) + i;
+  };
+  // the 6 tetrahedra along the paths from corner 0 to corner 7 of a cube
+  const std::array<std::array<unsigned int, 3>, 6> axes = {
+      {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}}};
+  for (unsigned int k = 0; k < n; ++k) {
+    for (unsigned int j = 0; j < n; ++j) {
+      for (unsigned int i = 0; i < n; ++i) {
+        for (const auto& path : axes) {
+          std::array<unsigned int, 3> corner = {i, j, k};
+          std::vector<unsigned int> element = {vertex(i, j, k)};
+          for (auto axis : path) {
+            ++corner[axis];
+            element.push_back(vertex(corner[0], corner[1], corner[2]));
+          }
+          // orient positively
+          Dune::FieldMatrix<double, 3, 3> jacobian;
+          for (unsigned int c = 0; c < 3; ++c) {
+            jacobian[c] = vertices[element[c + 1]];
+            jacobian[c] -= vertices[element[0]];
+          }
+          if (jacobian.determinant() < 0) {
+            std::swap(element[2], element[3]);
+          }
+          factory.insertElement(Dune::GeometryTypes::tetrahedron, element);
+        }
+      }
+    }
+  }
+  return std::unique_ptr<Grid>(factory.createGrid());
+}
+
+/**
+ * test if the closed form assembly yields the matrix assembled by the ConvectionDiffusionFEM
+ * local operator, on a distorted mesh with two anisotropic conductivities
+ */
+bool matches_grid_operator_assembly()
+{
+  auto grid = create_distorted_grid(4);
+  const double entries[2][3][3] = {{{1.0, 0.2, 0.1}, {0.2, 0.5, -0.3}, {0.1, -0.3, 2.0}},
+                                   {{0.3, -0.1, 0.0}, {-0.1, 1.5, 0.4}, {0.0, 0.4, 0.8}}};
+  std::vector<VC::TensorType> tensors(2);
+  for (unsigned int t = 0; t < 2; ++t) {
+    for (unsigned int r = 0; r < 3; ++r) {
+      for (unsigned int c = 0; c < 3; ++c) {
+        tensors[t][r][c] = entries[t][r][c];
+      }
+    }
+  }
+  std::vector<std::size_t> labels(grid->leafGridView().size(0));
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    labels[i] = i % 2;
+  }
+  auto volumeConductor = std::make_shared<VC>(std::move(grid), labels, tensors);
+
+  using Traits = duneuro::CGSolverTraits<VC, duneuro::ElementType::tetrahedron, 1>;
+  Traits::Problem problem(volumeConductor);
+  Traits::BoundaryCondition boundaryCondition(volumeConductor->gridView(), problem);
+  Traits::FunctionSpace functionSpace(volumeConductor->grid(), boundaryCondition);
+  Traits::LocalOperator localOperator(problem, 0);
+  Traits::Assembler assembler(functionSpace, localOperator, 27);
+
+  Traits::Assembler::MAT reference(assembler.getGO());
+  reference = 0.0;
+  Traits::DomainDOFVector x(functionSpace.getGFS(), 0.0);
+  assembler->jacobian(x, reference);
+
+  using ClosedForm = duneuro::P1TetrahedronStiffnessAssembler<Traits::Assembler::GO, VC>;
+  auto closedForm = ClosedForm(assembler.getGO(), volumeConductor).assemble();
+
+  using Dune::PDELab::Backend::native;
+  const auto& a = native(reference);
+  const auto& b = native(*closedForm);
+  double maxEntry = 0.0;
+  for (auto row = a.begin(); row != a.end(); ++row) {
+    for (auto entry = row->begin(); entry != row->end(); ++entry) {
+      maxEntry = std::max(maxEntry, std::abs(double(*entry)));
+    }
+  }
+  const double tolerance = 1e-12 * maxEntry;
+  // compare all entries of both patterns, entries missing in one of them have to vanish
+  auto compare = [&](const auto& first, const auto& second) {
+    for (auto row = first.begin(); row != first.end(); ++row) {
+      for (auto entry = row->begin(); entry != row->end(); ++entry) {
+        auto other = second[row.index()].find(entry.index());
+        const double value = other != second[row.index()].end() ? double(*other) : 0.0;
+        if (std::abs(double(*entry) - value) > tolerance) {
+          std::cout << "entry (" << row.index() << ", " << entry.index() << ") differs: " << *entry
+                    << " vs " << value << std::endl;
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+  return compare(a, b) && compare(b, a);
+}
+
+int main(int argc, char** argv)
+{
+  Dune::MPIHelper::instance(argc, argv);
+
+  bool passed = true;
+  passed &= matches_grid_operator_assembly();
+  return !passed;
+}
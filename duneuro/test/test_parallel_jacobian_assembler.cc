@@ -0,0 +1,181 @@
+#include <config.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/grid/common/gridfactory.hh>
+#include <dune/grid/uggrid.hh>
+
+#include <duneuro/common/cg_solver.hh>
+#include <duneuro/common/dg_solver.hh>
+#include <duneuro/common/parallel_jacobian_assembler.hh>
+#include <duneuro/common/volume_conductor.hh>
+
+using Grid = Dune::UGGrid<3>;
+using VC = duneuro::VolumeConductor<Grid>;
+using Coordinate = Dune::FieldVector<double, 3>;
+
+/**
+ * volume conductor on a grid of n^3 cubes of the unit cube, each cube split into 6 tetrahedra if
+ * simplices is set. The two anisotropic conductivities are assigned alternately to the elements.
+ */
+std::shared_ptr<VC> create_volume_conductor(unsigned int n, bool simplices)
+{
+  auto vertex = [n](unsigned int i, unsigned int j, unsigned int k) {
+    return (k * (n + 1) + j) * (n + 1) + i;
+  };
+  std::vector<Coordinate> vertices;
+  for (unsigned int k = 0; k <= n; ++k) {
+    for (unsigned int j = 0; j <= n; ++j) {
+      for (unsigned int i = 0; i <= n; ++i) {
+        vertices.push_back(Coordinate({double(i) / n, double(j) / n, double(k) / n}));
+      }
+    }
+  }
+  Dune::GridFactory<Grid> factory;
+  for (const auto& x : vertices) {
+    factory.insertVertex(x);
+  }
+  // the 6 tetrahedra along the paths from corner 0 to corner 7 of a cube
+  const std::array<std::array<unsigned int, 3>, 6> axes = {
+      {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}}};
+  for (unsigned int k = 0; k < n; ++k) {
+    for (unsigned int j = 0; j < n; ++j) {
+      for (unsigned int i = 0; i < n; ++i) {
+        if (!simplices) {
+          std::vector<unsigned int> element;
+          for (unsigned int c = 0; c < 8; ++c) {
+            element.push_back(vertex(i + (c & 1), j + ((c >> 1) & 1), k + ((c >> 2) & 1)));
+          }
+          factory.insertElement(Dune::GeometryTypes::hexahedron, element);
+          continue;
+        }
+        for (const auto& path : axes) {
+          std::array<unsigned int, 3> corner = {i, j, k};
+          std::vector<unsigned int> element = {vertex(i, j, k)};
+          for (auto axis : path) {
+            ++corner[axis];
+            element.push_back(vertex(corner[0], corner[1], corner[2]));
+          }
+          // orient positively
+          Dune::FieldMatrix<double, 3, 3> jacobian;
+          for (unsigned int c = 0; c < 3; ++c) {
+            jacobian[c] = vertices[element[c + 1]];
+            jacobian[c] -= vertices[element[0]];
+          }
+          if (jacobian.determinant() < 0) {
+            std::swap(element[2], element[3]);
+          }
+          factory.insertElement(Dune::GeometryTypes::tetrahedron, element);
+        }
+      }
+    }
+  }
+  std::unique_ptr<Grid> grid(factory.createGrid());
+  const double entries[2][3][3] = {{{1.0, 0.2, 0.1}, {0.2, 0.5, -0.3}, {0.1, -0.3, 2.0}},
+                                   {{0.3, -0.1, 0.0}, {-0.1, 1.5, 0.4}, {0.0, 0.4, 0.8}}};
+  std::vector<VC::TensorType> tensors(2);
+  for (unsigned int t = 0; t < 2; ++t) {
+    for (unsigned int r = 0; r < 3; ++r) {
+      for (unsigned int c = 0; c < 3; ++c) {
+        tensors[t][r][c] = entries[t][r][c];
+      }
+    }
+  }
+  std::vector<std::size_t> labels(grid->leafGridView().size(0));
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    labels[i] = i % 2;
+  }
+  return std::make_shared<VC>(std::move(grid), labels, tensors);
+}
+
+/**
+ * test if the parallel assembly yields the matrix assembled by GO::jacobian. Entries which are
+ * only present in one of the patterns have to vanish.
+ */
+template <class GO>
+bool matches_grid_operator(const GO& go, const std::string& name)
+{
+  typename GO::Traits::Domain x(go.trialGridFunctionSpace(), 0.0);
+  typename GO::Traits::Jacobian reference(go);
+  reference = 0.0;
+  go.jacobian(x, reference);
+  auto parallel = duneuro::ParallelJacobianAssembler<GO>(go).assemble(x);
+
+  using Dune::PDELab::Backend::native;
+  const auto& a = native(reference);
+  const auto& b = native(*parallel);
+  if (a.N() != b.N() || a.M() != b.M()) {
+    std::cout << name << ": matrix has size " << b.N() << "x" << b.M() << ", expected " << a.N()
+              << "x" << a.M() << std::endl;
+    return false;
+  }
+  double maxEntry = 0.0;
+  for (auto row = a.begin(); row != a.end(); ++row) {
+    for (auto entry = row->begin(); entry != row->end(); ++entry) {
+      maxEntry = std::max(maxEntry, std::abs(double(*entry)));
+    }
+  }
+  const double tolerance = 1e-12 * maxEntry;
+  auto compare = [&](const auto& first, const auto& second) {
+    for (auto row = first.begin(); row != first.end(); ++row) {
+      for (auto entry = row->begin(); entry != row->end(); ++entry) {
+        auto other = second[row.index()].find(entry.index());
+        const double value = other != second[row.index()].end() ? double(*other) : 0.0;
+        if (std::abs(double(*entry) - value) > tolerance) {
+          std::cout << name << ": entry (" << row.index() << ", " << entry.index()
+                    << ") differs: " << *entry << " vs " << value << std::endl;
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+  return compare(a, b) && compare(b, a);
+}
+
+// linear conforming elements on tetrahedra, only volume terms
+bool matches_cg_assembly()
+{
+  auto volumeConductor = create_volume_conductor(4, true);
+  using Traits = duneuro::CGSolverTraits<VC, duneuro::ElementType::tetrahedron, 1>;
+  Traits::Problem problem(volumeConductor);
+  Traits::BoundaryCondition boundaryCondition(volumeConductor->gridView(), problem);
+  Traits::FunctionSpace functionSpace(volumeConductor->grid(), boundaryCondition);
+  Traits::LocalOperator localOperator(problem, 0);
+  Traits::Assembler assembler(functionSpace, localOperator, 27);
+  return matches_grid_operator(assembler.getGO(), "cg");
+}
+
+// discontinuous galerkin on hexahedra, with skeleton and boundary terms
+bool matches_dg_assembly()
+{
+  auto volumeConductor = create_volume_conductor(4, false);
+  using Traits = duneuro::DGSolverTraits<VC, duneuro::ElementType::hexahedron, 1,
+                                         duneuro::ConvectionDiffusion_DG_DefaultParameter<VC>,
+                                         double, double, double>;
+  Traits::Problem problem(volumeConductor);
+  Traits::FunctionSpace functionSpace(volumeConductor->gridView());
+  Traits::EdgeNormProvider edgeNormProvider("houston", 1.0);
+  Traits::PenaltyFluxWeighting weighting("tensorOnly");
+  Traits::LocalOperator localOperator(problem, edgeNormProvider, weighting,
+                                      duneuro::ConvectionDiffusion_DG_Scheme::SIPG, 20.0);
+  Traits::Assembler assembler(functionSpace, localOperator, 7);
+  return matches_grid_operator(assembler.getGO(), "dg");
+}
+
+int main(int argc, char** argv)
+{
+  Dune::MPIHelper::instance(argc, argv);
+
+  bool passed = true;
+  passed &= matches_cg_assembly();
+  passed &= matches_dg_assembly();
+  return !passed;
+}
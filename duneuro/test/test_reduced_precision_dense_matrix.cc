@@ -0,0 +1,171 @@
+#include <config.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/common/parametertree.hh>
+#include <dune/istl/bvector.hh>
+
+#include <duneuro/common/checkpointed_dense_matrix.hh>
+#include <duneuro/common/reduced_precision_dense_matrix.hh>
+#include <duneuro/io/data_tree.hh>
+
+using Vector = Dune::BlockVector<Dune::FieldVector<double, 1>>;
+
+// keeps the values stored in a data tree, so that the reported values can be checked
+class MapStorage : public duneuro::StorageInterface
+{
+public:
+  virtual void store(const std::string& name, const std::string& value) override
+  {
+    values[name] = value;
+  }
+
+  virtual void storeMatrix(const std::string& name,
+                           std::shared_ptr<duneuro::MatrixInterface<double>> matrix) override
+  {
+  }
+
+  virtual void storeMatrix(const std::string& name,
+                           std::shared_ptr<duneuro::MatrixInterface<unsigned int>> matrix) override
+  {
+  }
+
+  std::map<std::string, std::string> values;
+};
+
+/**
+ * random rows whose magnitudes span several orders of magnitude, including a zero row and a row
+ * with a single large entry
+ */
+std::vector<Vector> create_rows(std::size_t rows, std::size_t cols)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  std::vector<Vector> result(rows, Vector(cols));
+  for (std::size_t r = 0; r < rows; ++r) {
+    const double magnitude = std::pow(10.0, double(r) - 3.0);
+    for (std::size_t c = 0; c < cols; ++c) {
+      result[r][c] = r == 2 ? 0.0 : magnitude * distribution(generator);
+    }
+  }
+  result[rows - 1][cols / 2] = 1e3;
+  return result;
+}
+
+double max_abs(const Vector& row)
+{
+  double result = 0.0;
+  for (std::size_t c = 0; c < row.N(); ++c) {
+    result = std::max(result, std::abs(row[c][0]));
+  }
+  return result;
+}
+
+/**
+ * test if the conversion errors reported for each row and for the whole matrix are the errors of
+ * the stored entries relative to the double precision rows, if they are below the given bound
+ * and if they bound the error of products with the matrix
+ */
+bool round_trip(duneuro::DenseMatrixPrecision precision, double bound)
+{
+  const std::size_t rows = 8;
+  const std::size_t cols = 37;
+  const auto exact = create_rows(rows, cols);
+  Dune::ParameterTree storageConfig;
+  storageConfig["precision"] = duneuro::to_string(precision);
+  duneuro::CheckpointedDenseMatrix<double> checkpointed(rows, cols, storageConfig);
+  for (std::size_t r = 0; r < rows; ++r) {
+    checkpointed.setRow(r, exact[r]);
+  }
+  try {
+    checkpointed.release();
+    std::cout << "a reduced precision matrix was released in double precision" << std::endl;
+    return false;
+  } catch (Dune::Exception&) {
+  }
+  auto matrix = checkpointed.releaseReducedPrecision();
+  const std::string name = duneuro::to_string(precision);
+
+  double maxError = 0.0;
+  for (std::size_t r = 0; r < rows; ++r) {
+    const double maxAbs = max_abs(exact[r]);
+    double error = 0.0;
+    for (std::size_t c = 0; c < cols; ++c) {
+      error = std::max(error, std::abs((*matrix)(r, c) - exact[r][c][0]));
+    }
+    const double relativeError = maxAbs > 0.0 ? error / maxAbs : 0.0;
+    if (std::abs(relativeError - matrix->maxRelativeError(r)) > 1e-15) {
+      std::cout << name << ": row " << r << " has relative error " << relativeError
+                << ", reported " << matrix->maxRelativeError(r) << std::endl;
+      return false;
+    }
+    if (relativeError > bound * (1.0 + 1e-12)) {
+      std::cout << name << ": relative error " << relativeError << " of row " << r
+                << " exceeds " << bound << std::endl;
+      return false;
+    }
+    maxError = std::max(maxError, relativeError);
+  }
+
+  auto storage = std::make_shared<MapStorage>();
+  matrix->report(duneuro::DataTree(storage));
+  const double reported = std::stod(storage->values.at("max_relative_error"));
+  if (std::abs(reported - maxError) > 1e-5 * maxError) {
+    std::cout << name << ": reported max_relative_error " << reported << ", actual " << maxError
+              << std::endl;
+    return false;
+  }
+  if (storage->values.at("type") != name) {
+    std::cout << name << ": reported type " << storage->values.at("type") << std::endl;
+    return false;
+  }
+
+  // the error of a product is bounded by the relative error of the row times the product of the
+  // absolute values
+  const std::size_t numberOfVectors = 3;
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  std::vector<double> panel(cols * numberOfVectors);
+  for (auto& value : panel) {
+    value = distribution(generator);
+  }
+  std::vector<double> output(rows * numberOfVectors);
+  duneuro::matrix_dense_panel_product(*matrix, panel.data(), numberOfVectors, output.data());
+  for (std::size_t j = 0; j < numberOfVectors; ++j) {
+    for (std::size_t r = 0; r < rows; ++r) {
+      double product = 0.0;
+      double absoluteProduct = 0.0;
+      for (std::size_t c = 0; c < cols; ++c) {
+        product += exact[r][c][0] * panel[j * cols + c];
+        absoluteProduct += std::abs(panel[j * cols + c]);
+      }
+      absoluteProduct *= max_abs(exact[r]);
+      const double difference = std::abs(output[j * rows + r] - product);
+      if (difference > (matrix->maxRelativeError(r) + 1e-12) * absoluteProduct) {
+        std::cout << name << ": product of row " << r << " differs by " << difference
+                  << " from the double precision product" << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  Dune::MPIHelper::instance(argc, argv);
+
+  bool passed = true;
+  // half a unit in the last place of a float, and half a quantization step of the scaled integers
+  passed &= round_trip(duneuro::DenseMatrixPrecision::float32, std::ldexp(1.0, -24));
+  passed &= round_trip(duneuro::DenseMatrixPrecision::int16, 0.5 / 32767.0);
+  return !passed;
+}
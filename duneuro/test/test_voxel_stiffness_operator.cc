@@ -0,0 +1,177 @@
+#include <config.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/grid/common/gridfactory.hh>
+#include <dune/grid/uggrid.hh>
+#include <dune/istl/bvector.hh>
+
+#include <duneuro/common/cg_solver.hh>
+#include <duneuro/common/linear_problem_solver.hh>
+#include <duneuro/common/voxel_stiffness_operator.hh>
+#include <duneuro/common/volume_conductor.hh>
+
+using Grid = Dune::UGGrid<3>;
+using VC = duneuro::VolumeConductor<Grid>;
+using Coordinate = Dune::FieldVector<double, 3>;
+using Vector = Dune::BlockVector<Dune::FieldVector<double, 1>>;
+
+/**
+ * create a voxel mesh of n^3 cubes of the unit cube, without the cubes of the octant at the upper
+ * corner, so that the lattice contains empty cells
+ */
+std::unique_ptr<Grid> create_voxel_grid(unsigned int n)
+{
+  auto vertex = [n](unsigned int i, unsigned int j, unsigned int k) {
+    return (k * (n + 1) + j) * (n + 1) + i;
+  };
+  auto removed = [n](unsigned int i, unsigned int j, unsigned int k) {
+    return 2 * i >= n && 2 * j >= n && 2 * k >= n;
+  };
+  std::vector<std::vector<unsigned int>> elements;
+  for (unsigned int k = 0; k < n; ++k) {
+    for (unsigned int j = 0; j < n; ++j) {
+      for (unsigned int i = 0; i < n; ++i) {
+        if (removed(i, j, k)) {
+          continue;
+        }
+        std::vector<unsigned int> element;
+        for (unsigned int c = 0; c < 8; ++c) {
+          element.push_back(vertex(i + (c & 1), j + ((c >> 1) & 1), k + ((c >> 2) & 1)));
+        }
+        elements.push_back(element);
+      }
+    }
+  }
+  // only insert the vertices used by an element
+  const unsigned int unused = std::numeric_limits<unsigned int>::max();
+  std::vector<unsigned int> index((n + 1) * (n + 1) * (n + 1), unused);
+  for (const auto& element : elements) {
+    for (auto v : element) {
+      index[v] = 0;
+    }
+  }
+  Dune::GridFactory<Grid> factory;
+  unsigned int numberOfVertices = 0;
+  for (unsigned int k = 0; k <= n; ++k) {
+    for (unsigned int j = 0; j <= n; ++j) {
+      for (unsigned int i = 0; i <= n; ++i) {
+        auto& v = index[vertex(i, j, k)];
+        if (v != unused) {
+          factory.insertVertex(Coordinate({double(i) / n, double(j) / n, double(k) / n}));
+          v = numberOfVertices++;
+        }
+      }
+    }
+  }
+  for (auto element : elements) {
+    for (auto& v : element) {
+      v = index[v];
+    }
+    factory.insertElement(Dune::GeometryTypes::hexahedron, element);
+  }
+  return std::unique_ptr<Grid>(factory.createGrid());
+}
+
+double max_difference(const Vector& a, const Vector& b)
+{
+  double difference = 0.0;
+  for (std::size_t i = 0; i < a.N(); ++i) {
+    difference = std::max(difference, std::abs(a[i][0] - b[i][0]));
+  }
+  return difference;
+}
+
+/**
+ * test if applying the voxel stencil to random vectors yields the product with the matrix
+ * assembled by the ConvectionDiffusionFEM local operator, on a mesh with conductivity jumps and
+ * with or without the modification of the first degree of freedom
+ */
+bool matches_assembled_operator(bool fixFirstDOF)
+{
+  auto grid = create_voxel_grid(6);
+  // three anisotropic conductivities, separated along the first and the last axis
+  const double entries[3][3][3] = {{{1.0, 0.2, 0.1}, {0.2, 0.5, -0.3}, {0.1, -0.3, 2.0}},
+                                   {{0.01, 0.0, 0.0}, {0.0, 0.01, 0.0}, {0.0, 0.0, 0.01}},
+                                   {{0.3, -0.1, 0.0}, {-0.1, 1.5, 0.4}, {0.0, 0.4, 0.8}}};
+  std::vector<VC::TensorType> tensors(3);
+  for (unsigned int t = 0; t < 3; ++t) {
+    for (unsigned int r = 0; r < 3; ++r) {
+      for (unsigned int c = 0; c < 3; ++c) {
+        tensors[t][r][c] = entries[t][r][c];
+      }
+    }
+  }
+  const auto gv = grid->leafGridView();
+  std::vector<std::size_t> labels(gv.size(0));
+  for (const auto& element : elements(gv)) {
+    const auto center = element.geometry().center();
+    labels[gv.indexSet().index(element)] = center[0] < 0.5 ? 0 : (center[2] < 0.3 ? 1 : 2);
+  }
+  auto volumeConductor = std::make_shared<VC>(std::move(grid), labels, tensors);
+
+  using Traits = duneuro::CGSolverTraits<VC, duneuro::ElementType::hexahedron, 1>;
+  Traits::Problem problem(volumeConductor);
+  Traits::BoundaryCondition boundaryCondition(volumeConductor->gridView(), problem);
+  Traits::FunctionSpace functionSpace(volumeConductor->grid(), boundaryCondition);
+  Traits::LocalOperator localOperator(problem, 0);
+  Traits::Assembler assembler(functionSpace, localOperator, 27);
+
+  Traits::Assembler::MAT matrix(assembler.getGO());
+  matrix = 0.0;
+  Traits::DomainDOFVector zero(functionSpace.getGFS(), 0.0);
+  assembler->jacobian(zero, matrix);
+  using Dune::PDELab::Backend::native;
+  const double fixedDOFEntry = 2.5;
+  if (fixFirstDOF) {
+    duneuro::TSSLPDetail::fixFirstDOF(native(matrix), fixedDOFEntry);
+  }
+
+  duneuro::VoxelStencil<double, 3> stencil(functionSpace.getGFS(), *volumeConductor,
+                                           fixFirstDOF, fixedDOFEntry);
+  duneuro::VoxelStencil<double, 3>::Workspace workspace;
+  const std::size_t size = native(matrix).N();
+  if (stencil.size() != size) {
+    std::cout << "stencil has " << stencil.size() << " degrees of freedom, the matrix " << size
+              << std::endl;
+    return false;
+  }
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  for (unsigned int run = 0; run < 5; ++run) {
+    Vector x(size), assembled(size), matrixFree(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      x[i] = distribution(generator);
+    }
+    native(matrix).mv(x, assembled);
+    stencil.apply(x, matrixFree, workspace);
+    const double difference = max_difference(assembled, matrixFree);
+    if (difference > 1e-12 * assembled.infinity_norm()) {
+      std::cout << "matrix free and assembled operator differ by " << difference
+                << " (fixFirstDOF = " << fixFirstDOF << ")" << std::endl;
+      return false;
+    }
+    if (fixFirstDOF && std::abs(matrixFree[0][0] - fixedDOFEntry * x[0][0]) > 1e-14) {
+      std::cout << "wrong entry of the fixed degree of freedom" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  Dune::MPIHelper::instance(argc, argv);
+
+  bool passed = true;
+  passed &= matches_assembled_operator(false);
+  passed &= matches_assembled_operator(true);
+  return !passed;
+}